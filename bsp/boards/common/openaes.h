@@ -10,8 +10,39 @@ Source: http://is.gd/o9RSPq
 #ifndef __OPENAES_H__
 #define __OPENAES_H__
 
+//=========================== define ==========================================
+
+// number of expanded keys kept, e.g. one per link-layer key and OSCORE context
+#ifndef OPENAES_KEYCACHE_SIZE
+#define OPENAES_KEYCACHE_SIZE 4
+#endif
+
+//=========================== typedef =========================================
+
+/**
+\brief A key, along with its expanded key schedule.
+*/
+typedef struct {
+   uint8_t         key[16];
+   uint8_t         expandedKey[176];
+#ifdef OPENAES_TTABLE
+   uint32_t        roundKey[44];     // expandedKey, as big-endian words
+#endif
+} openaes_ctx_t;
+
+//=========================== module variables ================================
+
+typedef struct {
+   openaes_ctx_t   keyCache[OPENAES_KEYCACHE_SIZE];
+   uint8_t         numKeys;          // number of keyCache entries filled
+   uint8_t         nextKey;          // keyCache entry to replace next
+} openaes_vars_t;
+
 //=========================== prototypes ======================================
 
 owerror_t openaes_enc(uint8_t* buffer, uint8_t* key);
+void      openaes_ctxInit(openaes_ctx_t* ctx, uint8_t* key);
+owerror_t openaes_ctxEnc(uint8_t* buffer, openaes_ctx_t* ctx);
+openaes_ctx_t* openaes_lookupCtx(uint8_t* key);
 
 #endif /* __OPENAES_H__ */
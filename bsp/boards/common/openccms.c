@@ -16,10 +16,10 @@
 
 //=========================== prototypes ======================================
 
-static owerror_t aes_cbc_mac(uint8_t* a, uint8_t len_a, uint8_t* m, uint8_t len_m, uint8_t* nonce, uint8_t key[16], uint8_t* mac, uint8_t len_mac, uint8_t l);
-static owerror_t aes_ctr_enc(uint8_t* m, uint8_t len_m, uint8_t* nonce, uint8_t key[16], uint8_t* mac, uint8_t len_mac, uint8_t l);
-owerror_t aes_cbc_enc_raw(uint8_t* buffer, uint8_t len, uint8_t key[16], uint8_t iv[16]); 
-owerror_t aes_ctr_enc_raw(uint8_t* buffer, uint8_t len, uint8_t key[16], uint8_t iv[16]);
+static owerror_t aes_cbc_mac(uint8_t* a, uint8_t len_a, uint8_t* m, uint8_t len_m, uint8_t* nonce, openaes_ctx_t* ctx, uint8_t* mac, uint8_t len_mac, uint8_t l);
+static owerror_t aes_ctr_enc(uint8_t* m, uint8_t len_m, uint8_t* nonce, openaes_ctx_t* ctx, uint8_t* mac, uint8_t len_mac, uint8_t l);
+owerror_t aes_cbc_enc_raw(uint8_t* buffer, uint8_t len, openaes_ctx_t* ctx, uint8_t iv[16]); 
+owerror_t aes_ctr_enc_raw(uint8_t* buffer, uint8_t len, openaes_ctx_t* ctx, uint8_t iv[16]);
 static void inc_counter(uint8_t* counter); 
 
 //=========================== public ==========================================
@@ -50,13 +50,17 @@ owerror_t openccms_enc(uint8_t* a,
          uint8_t len_mac) {
 
    uint8_t mac[CBC_MAX_MAC_SIZE];
+   openaes_ctx_t* ctx;
 
    if ((len_mac > CBC_MAX_MAC_SIZE) || (l != 2)) {
       return E_FAIL;
    }
 
-   if (aes_cbc_mac(a, len_a, m, *len_m, nonce, key, mac, len_mac, l) == E_SUCCESS) {
-      if (aes_ctr_enc(m, *len_m, nonce, key, mac, len_mac, l) == E_SUCCESS) {
+   // expand the key once for all blocks
+   ctx = openaes_lookupCtx(key);
+
+   if (aes_cbc_mac(a, len_a, m, *len_m, nonce, ctx, mac, len_mac, l) == E_SUCCESS) {
+      if (aes_ctr_enc(m, *len_m, nonce, ctx, mac, len_mac, l) == E_SUCCESS) {
          memcpy(&m[*len_m], mac, len_mac);
          *len_m += len_mac;
 
@@ -95,16 +99,20 @@ owerror_t openccms_dec(uint8_t* a,
 
    uint8_t mac[CBC_MAX_MAC_SIZE];
    uint8_t orig_mac[CBC_MAX_MAC_SIZE];
+   openaes_ctx_t* ctx;
 
    if ((len_mac > CBC_MAX_MAC_SIZE) || (l != 2)) {
       return E_FAIL;
    }
 
+   // expand the key once for all blocks
+   ctx = openaes_lookupCtx(key);
+
    *len_m -= len_mac;
    memcpy(mac, &m[*len_m], len_mac);
 
-   if (aes_ctr_enc(m, *len_m, nonce, key, mac, len_mac, l) == E_SUCCESS) {
-      if (aes_cbc_mac(a, len_a, m, *len_m, nonce, key, orig_mac, len_mac, l) == E_SUCCESS) {
+   if (aes_ctr_enc(m, *len_m, nonce, ctx, mac, len_mac, l) == E_SUCCESS) {
+      if (aes_cbc_mac(a, len_a, m, *len_m, nonce, ctx, orig_mac, len_mac, l) == E_SUCCESS) {
          if (memcmp(mac, orig_mac, len_mac) == 0) {
             return E_SUCCESS;
          }
@@ -123,7 +131,7 @@ owerror_t openccms_dec(uint8_t* a,
 \param[in] m Pointer to the data that is both authenticated and encrypted.
 \param[in] len_m Length of data that is both authenticated and encrypted.
 \param[in] nonce Buffer containing nonce (13 octets).
-\param[in] key Buffer containing the secret key (16 octets).
+\param[in] ctx Context holding the expanded secret key.
 \param[out] mac Buffer where the value of the CBC-MAC tag will be written.
 \param[in] len_mac Length of the CBC-MAC tag. Must be 4, 8 or 16 octets.
 \param[in] l CCM parameter L that allows selection of different nonce length.
@@ -135,7 +143,7 @@ static owerror_t aes_cbc_mac(uint8_t* a,
          uint8_t* m,
          uint8_t len_m,
          uint8_t* nonce,
-         uint8_t key[16],
+         openaes_ctx_t* ctx,
          uint8_t* mac,
          uint8_t len_mac,
          uint8_t l) {
@@ -202,7 +210,7 @@ static owerror_t aes_cbc_mac(uint8_t* a,
    memset(&buffer[len], 0, pad_len);
    len += pad_len;
 
-   aes_cbc_enc_raw(buffer, len, key, cbc_mac_iv);
+   aes_cbc_enc_raw(buffer, len, ctx, cbc_mac_iv);
 
    // copy MAC
    memcpy(mac, &buffer[len - 16], len_mac);
@@ -216,7 +224,7 @@ static owerror_t aes_cbc_mac(uint8_t* a,
    overwritten by ciphertext (i.e. plaintext in case of inverse CCM*).
 \param[in] len_m Length of data that is both authenticated and encrypted.
 \param[in] nonce Buffer containing nonce (13 octets).
-\param[in] key Buffer containing the secret key (16 octets).
+\param[in] ctx Context holding the expanded secret key.
 \param[in,out] mac Buffer containing the unencrypted or encrypted CBC-MAC tag, which depends
    on weather the function is called as part of CCM* forward or inverse transformation. It
    is overwrriten by the encrypted, i.e unencrypted, tag on return.
@@ -228,7 +236,7 @@ static owerror_t aes_cbc_mac(uint8_t* a,
 static owerror_t aes_ctr_enc(uint8_t* m,
          uint8_t len_m,
          uint8_t* nonce,
-         uint8_t key[16],
+         openaes_ctx_t* ctx,
          uint8_t* mac,
          uint8_t len_mac,
          uint8_t l) {
@@ -269,7 +277,7 @@ static owerror_t aes_ctr_enc(uint8_t* m,
    memset(&buffer[len], 0, pad_len);
    len += pad_len;
 
-   aes_ctr_enc_raw(buffer, len, key, iv);
+   aes_ctr_enc_raw(buffer, len, ctx, iv);
 
    memcpy(m, &buffer[16], len_m);
    memcpy(mac, buffer, len_mac);
@@ -281,12 +289,12 @@ static owerror_t aes_ctr_enc(uint8_t* m,
 \brief Raw AES-CBC encryption.
 \param[in,out] buffer Message to be encrypted. Will be overwritten by ciphertext.
 \param[in] len Message length. Must be multiple of 16 octets.
-\param[in] key Buffer containing the secret key (16 octets).
+\param[in] ctx Context holding the expanded secret key.
 \param[in] iv Buffer containing the Initialization Vector (16 octets).
 
 \returns E_SUCCESS when the encryption was successful. 
 */
-owerror_t aes_cbc_enc_raw(uint8_t* buffer, uint8_t len, uint8_t key[16], uint8_t iv[16]) {
+owerror_t aes_cbc_enc_raw(uint8_t* buffer, uint8_t len, openaes_ctx_t* ctx, uint8_t iv[16]) {
    uint8_t  n;
    uint8_t  k;
    uint8_t  nb;
@@ -301,7 +309,7 @@ owerror_t aes_cbc_enc_raw(uint8_t* buffer, uint8_t len, uint8_t key[16], uint8_t
       for (k = 0; k < 16; k++) {
             pbuf[k] ^= pxor[k];
       }
-      openaes_enc(pbuf,key);
+      openaes_ctxEnc(pbuf,ctx);
       pxor = pbuf;
    }
    return E_SUCCESS;
@@ -311,12 +319,12 @@ owerror_t aes_cbc_enc_raw(uint8_t* buffer, uint8_t len, uint8_t key[16], uint8_t
 \brief Raw AES-CTR encryption.
 \param[in,out] buffer Message to be encrypted. Will be overwritten by ciphertext.
 \param[in] len Message length. Must be multiple of 16 octets.
-\param[in] key Buffer containing the secret key (16 octets).
+\param[in] ctx Context holding the expanded secret key.
 \param[in] iv Buffer containing the Initialization Vector (16 octets).
 
 \returns E_SUCCESS when the encryption was successful. 
 */
-owerror_t aes_ctr_enc_raw(uint8_t* buffer, uint8_t len, uint8_t key[16], uint8_t iv[16]) {
+owerror_t aes_ctr_enc_raw(uint8_t* buffer, uint8_t len, openaes_ctx_t* ctx, uint8_t iv[16]) {
    uint8_t n;
    uint8_t k;
    uint8_t nb;
@@ -327,7 +335,7 @@ owerror_t aes_ctr_enc_raw(uint8_t* buffer, uint8_t len, uint8_t key[16], uint8_t
    for (n = 0; n < nb; n++) {
       pbuf = &buffer[16 * n];
       memcpy(eiv, iv, 16);
-      openaes_enc(eiv, key); 
+      openaes_ctxEnc(eiv, ctx);
       // may be faster if vector are aligned to 4 bytes (use long instead char in xor)
       for (k = 0; k < 16; k++) {
          pbuf[k] ^= eiv[k];
@@ -0,0 +1,42 @@
+/**
+\brief Native definition of the "board" bsp module.
+*/
+
+#include "board_obj.h"
+// bsp modules
+#include "debugpins_obj.h"
+#include "leds_obj.h"
+#include "uart_obj.h"
+#include "radio_obj.h"
+#include "eui64_obj.h"
+#include "sctimer_obj.h"
+#include "simengine.h"
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void board_init(OpenMote* self) {
+   
+   // initialize bsp modules
+   debugpins_init(self);
+   leds_init(self);
+   sctimer_init(self);
+   uart_init(self);
+   radio_init(self);
+}
+
+/**
+\brief Hand the CPU back to the engine until the next interrupt.
+*/
+void board_sleep(OpenMote* self) {
+   simengine_sleep(self);
+}
+
+void board_reset(OpenMote* self) {
+   simengine_reset(self);
+}
+
+//=========================== private =========================================
@@ -0,0 +1,56 @@
+/**
+\brief Native definition of the "debugpins" bsp module.
+
+There are no pins to observe in a native simulation, so these are no-ops
+rather than notifications to a front-end.
+*/
+
+#include "debugpins_obj.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void debugpins_init(OpenMote* self) {}
+
+void debugpins_frame_toggle(OpenMote* self) {}
+void debugpins_frame_clr(OpenMote* self) {}
+void debugpins_frame_set(OpenMote* self) {}
+
+void debugpins_slot_toggle(OpenMote* self) {}
+void debugpins_slot_clr(OpenMote* self) {}
+void debugpins_slot_set(OpenMote* self) {}
+
+void debugpins_fsm_toggle(OpenMote* self) {}
+void debugpins_fsm_clr(OpenMote* self) {}
+void debugpins_fsm_set(OpenMote* self) {}
+
+void debugpins_task_toggle(OpenMote* self) {}
+void debugpins_task_clr(OpenMote* self) {}
+void debugpins_task_set(OpenMote* self) {}
+
+void debugpins_isr_toggle(OpenMote* self) {}
+void debugpins_isr_clr(OpenMote* self) {}
+void debugpins_isr_set(OpenMote* self) {}
+
+void debugpins_radio_toggle(OpenMote* self) {}
+void debugpins_radio_clr(OpenMote* self) {}
+void debugpins_radio_set(OpenMote* self) {}
+
+void debugpins_ka_clr(OpenMote* self) {}
+void debugpins_ka_set(OpenMote* self) {}
+
+void debugpins_syncPacket_clr(OpenMote* self) {}
+void debugpins_syncPacket_set(OpenMote* self) {}
+
+void debugpins_syncAck_clr(OpenMote* self) {}
+void debugpins_syncAck_set(OpenMote* self) {}
+
+void debugpins_debug_clr(OpenMote* self) {}
+void debugpins_debug_set(OpenMote* self) {}
+
+//=========================== private =========================================
@@ -0,0 +1,31 @@
+/**
+\brief Native definition of the "eui64" bsp module.
+*/
+
+#include "eui64_obj.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+static const uint8_t eui64_prefix[6] = {0x14,0x15,0x92,0xcc,0x00,0x00};
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+/**
+\brief Derive the EUI-64 of a mote from its index in the simulation.
+
+Mote 0 gets 14-15-92-cc-00-00-00-01, mote 1 14-15-92-cc-00-00-00-02, etc.
+*/
+void eui64_get(OpenMote* self, uint8_t* addressToWrite) {
+   uint16_t moteNumber;
+   
+   moteNumber = self->board_vars.id+1;
+   memcpy(addressToWrite,eui64_prefix,sizeof(eui64_prefix));
+   addressToWrite[6] = (uint8_t)(moteNumber>>8);
+   addressToWrite[7] = (uint8_t)(moteNumber&0xff);
+}
+
+//=========================== private =========================================
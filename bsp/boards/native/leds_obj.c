@@ -0,0 +1,114 @@
+/**
+\brief Native definition of the "leds" bsp module.
+
+The LEDs are bits of the mote's leds_vars, which an observer can read.
+*/
+
+#include "leds_obj.h"
+
+//=========================== defines =========================================
+
+#define LED_ERROR    0x01
+#define LED_RADIO    0x02
+#define LED_SYNC     0x04
+#define LED_DEBUG    0x08
+#define LED_ALL      0x0f
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void leds_init(OpenMote* self) {
+   self->leds_vars.state  = 0;
+}
+
+// error
+void leds_error_on(OpenMote* self) {
+   self->leds_vars.state |=  LED_ERROR;
+}
+void leds_error_off(OpenMote* self) {
+   self->leds_vars.state &= ~LED_ERROR;
+}
+void leds_error_toggle(OpenMote* self) {
+   self->leds_vars.state ^=  LED_ERROR;
+}
+uint8_t leds_error_isOn(OpenMote* self) {
+   return (self->leds_vars.state & LED_ERROR)!=0;
+}
+void leds_error_blink(OpenMote* self) {
+   // no time elapses while the mote runs, leave the error LED on
+   self->leds_vars.state  =  LED_ERROR;
+}
+
+// radio
+void leds_radio_on(OpenMote* self) {
+   self->leds_vars.state |=  LED_RADIO;
+}
+void leds_radio_off(OpenMote* self) {
+   self->leds_vars.state &= ~LED_RADIO;
+}
+void leds_radio_toggle(OpenMote* self) {
+   self->leds_vars.state ^=  LED_RADIO;
+}
+uint8_t leds_radio_isOn(OpenMote* self) {
+   return (self->leds_vars.state & LED_RADIO)!=0;
+}
+
+// sync
+void leds_sync_on(OpenMote* self) {
+   self->leds_vars.state |=  LED_SYNC;
+}
+void leds_sync_off(OpenMote* self) {
+   self->leds_vars.state &= ~LED_SYNC;
+}
+void leds_sync_toggle(OpenMote* self) {
+   self->leds_vars.state ^=  LED_SYNC;
+}
+uint8_t leds_sync_isOn(OpenMote* self) {
+   return (self->leds_vars.state & LED_SYNC)!=0;
+}
+
+// debug
+void leds_debug_on(OpenMote* self) {
+   self->leds_vars.state |=  LED_DEBUG;
+}
+void leds_debug_off(OpenMote* self) {
+   self->leds_vars.state &= ~LED_DEBUG;
+}
+void leds_debug_toggle(OpenMote* self) {
+   self->leds_vars.state ^=  LED_DEBUG;
+}
+uint8_t leds_debug_isOn(OpenMote* self) {
+   return (self->leds_vars.state & LED_DEBUG)!=0;
+}
+
+// all
+void leds_all_on(OpenMote* self) {
+   self->leds_vars.state  =  LED_ALL;
+}
+void leds_all_off(OpenMote* self) {
+   self->leds_vars.state  =  0;
+}
+void leds_all_toggle(OpenMote* self) {
+   self->leds_vars.state ^=  LED_ALL;
+}
+
+void leds_circular_shift(OpenMote* self) {
+   uint8_t leds_on;
+   
+   leds_on = self->leds_vars.state & LED_ALL;
+   if (leds_on==0) {                             // if no LEDs on, switch on one
+      leds_on = 0x01;
+   } else {
+      leds_on = ((leds_on<<1) | (leds_on>>3)) & LED_ALL;
+   }
+   self->leds_vars.state  = leds_on;
+}
+
+void leds_increment(OpenMote* self) {
+   self->leds_vars.state  = (self->leds_vars.state+1) & LED_ALL;
+}
+
+//=========================== private =========================================
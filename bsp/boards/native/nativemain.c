@@ -0,0 +1,233 @@
+/**
+\brief Standalone simulator running many motes of a project in one process.
+
+Usage: <project>_prog [-n motes] [-t seconds] [-l mesh|linear] [-p pdr] [-s seed] [-j threads]
+
+Mote 0 is made DAG root through the same serial command OpenVisualizer sends.
+There is no JRC in the process, so the other motes are provisioned with the
+network key at boot, as a join response would, and then join the network over
+the simulated medium. At the end, the
+state of each mote and the simulation speed are printed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "simengine.h"
+#include "supply_obj.h"
+
+//=========================== defines =========================================
+
+#define NATIVEMAIN_RSSI          -50
+#define NATIVEMAIN_HDLC_FLAG     0x7e
+#define NATIVEMAIN_HDLC_ESCAPE   0x7d
+#define NATIVEMAIN_HDLC_MASK     0x20
+
+//=========================== variables =======================================
+
+static const uint8_t nativemain_prefix[8]    = {0xbb,0xbb,0x00,0x00,0x00,0x00,0x00,0x00};
+static const uint8_t nativemain_key[16]      = {
+   0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11
+};
+
+//=========================== prototypes ======================================
+
+void     nativemain_setRoot(OpenMote* self);
+void     nativemain_provision(OpenMote* self);
+uint16_t nativemain_hdlcEncode(uint8_t* frame, uint8_t* payload, uint16_t len);
+uint16_t nativemain_fcs(uint16_t crc, uint8_t b);
+void     nativemain_report(double wallSeconds, uint32_t seconds);
+
+//=========================== main ============================================
+
+int main(int argc, char** argv) {
+   uint16_t        numMotes;
+   uint16_t        numThreads;
+   uint32_t        seconds;
+   uint32_t        seed;
+   uint8_t         pdr;
+   bool            linear;
+   uint16_t        i;
+   uint16_t        j;
+   struct timespec start;
+   struct timespec end;
+   int             opt;
+
+   numMotes   = 10;
+   numThreads = 1;
+   seconds    = 60;
+   seed       = 1;
+   pdr        = 100;
+   linear     = FALSE;
+   while ((opt=getopt(argc,argv,"n:t:l:p:s:j:"))!=-1) {
+      switch (opt) {
+         case 'n': numMotes   = (uint16_t)atoi(optarg);       break;
+         case 't': seconds    = (uint32_t)atoi(optarg);       break;
+         case 'l': linear     = (strcmp(optarg,"linear")==0); break;
+         case 'p': pdr        = (uint8_t)atoi(optarg);        break;
+         case 's': seed       = (uint32_t)atoi(optarg);       break;
+         case 'j': numThreads = (uint16_t)atoi(optarg);       break;
+         default:
+            fprintf(stderr,"usage: %s [-n motes] [-t seconds] [-l mesh|linear] [-p pdr] [-s seed] [-j threads]\n",argv[0]);
+            return 1;
+      }
+   }
+
+   simengine_init(numMotes,numThreads,seed);
+
+   // topology
+   for (i=0;i<numMotes;i++) {
+      for (j=0;j<numMotes;j++) {
+         if (i==j) {
+            continue;
+         }
+         if (linear==FALSE || i==j+1 || j==i+1) {
+            simengine_addLink(i,j,pdr,NATIVEMAIN_RSSI);
+         }
+      }
+   }
+
+   clock_gettime(CLOCK_MONOTONIC,&start);
+
+   // power all motes on, then make mote 0 DAG root
+   for (i=0;i<numMotes;i++) {
+      supply_on(simengine_getMote(i));
+   }
+   simengine_run(1);
+   nativemain_setRoot(simengine_getMote(0));
+   for (i=1;i<numMotes;i++) {
+      nativemain_provision(simengine_getMote(i));
+   }
+
+   simengine_run((simtime_t)seconds*SIMENGINE_TICKS_PER_S);
+   clock_gettime(CLOCK_MONOTONIC,&end);
+
+   nativemain_report(
+      (end.tv_sec-start.tv_sec)+(end.tv_nsec-start.tv_nsec)/1e9,
+      seconds
+   );
+   return 0;
+}
+
+//=========================== private =========================================
+
+/**
+\brief Send the 'R' serial command to a mote, as OpenVisualizer does.
+*/
+void nativemain_setRoot(OpenMote* self) {
+   uint8_t  payload[1+1+8+1+16];
+   uint8_t  frame[2*sizeof(payload)+6];
+   uint16_t len;
+
+   payload[0]  = SERFRAME_PC2MOTE_SETROOT;
+   payload[1]  = ACTION_YES;
+   memcpy(&payload[2],nativemain_prefix,sizeof(nativemain_prefix));
+   payload[10] = 1; // key index
+   memcpy(&payload[11],nativemain_key,sizeof(nativemain_key));
+
+   len = nativemain_hdlcEncode(frame,payload,sizeof(payload));
+   simengine_uartInput(self,frame,len);
+}
+
+/**
+\brief Install the network key in a booted mote, as a CoJP join response does.
+*/
+void nativemain_provision(OpenMote* self) {
+   IEEE802154_security_setBeaconKey(self,1,(uint8_t*)nativemain_key);
+   IEEE802154_security_setDataKey(self,1,(uint8_t*)nativemain_key);
+   self->cjoin_vars.isJoined = TRUE;
+   opentimers_destroy(self,self->cjoin_vars.timerId);
+}
+
+/**
+\brief HDLC-frame a payload the way openserial expects it.
+
+\returns The length of the frame written.
+*/
+uint16_t nativemain_hdlcEncode(uint8_t* frame, uint8_t* payload, uint16_t len) {
+   uint16_t crc;
+   uint16_t i;
+   uint16_t j;
+   uint8_t  b;
+
+   crc = 0xffff;
+   for (i=0;i<len;i++) {
+      crc = nativemain_fcs(crc,payload[i]);
+   }
+   crc = ~crc;
+
+   j = 0;
+   frame[j++] = NATIVEMAIN_HDLC_FLAG;
+   for (i=0;i<len+2;i++) {
+      if (i<len) {
+         b = payload[i];
+      } else if (i==len) {
+         b = (uint8_t)(crc>>0);
+      } else {
+         b = (uint8_t)(crc>>8);
+      }
+      if (b==NATIVEMAIN_HDLC_FLAG || b==NATIVEMAIN_HDLC_ESCAPE) {
+         frame[j++] = NATIVEMAIN_HDLC_ESCAPE;
+         b         ^= NATIVEMAIN_HDLC_MASK;
+      }
+      frame[j++] = b;
+   }
+   frame[j++] = NATIVEMAIN_HDLC_FLAG;
+   return j;
+}
+
+/**
+\brief One byte of the HDLC FCS-16 (RFC1662), bit by bit.
+*/
+uint16_t nativemain_fcs(uint16_t crc, uint8_t b) {
+   uint8_t i;
+
+   crc ^= b;
+   for (i=0;i<8;i++) {
+      crc = (crc & 0x0001)?((crc>>1)^0x8408):(crc>>1);
+   }
+   return crc;
+}
+
+void nativemain_report(double wallSeconds, uint32_t seconds) {
+   OpenMote* mote;
+   uint16_t  numSync;
+   uint16_t  i;
+
+   numSync = 0;
+   printf("mote  root  sync   rank  dutycycle  dao B/min\n");
+   for (i=0;i<simengine_vars.numMotes;i++) {
+      mote = simengine_getMote(i);
+      if (mote->ieee154e_vars.isSync) {
+         numSync++;
+      }
+      printf(
+         "%4d  %4d  %4d  %5d  %8.2f%%  %9d\n",
+         i,
+         mote->idmanager_vars.isDAGroot,
+         mote->ieee154e_vars.isSync,
+         mote->icmpv6rpl_vars.myDAGrank,
+         (mote->ieee154e_stats.numTicsTotal==0)?0.0:
+            100.0*mote->ieee154e_stats.numTicsOn/mote->ieee154e_stats.numTicsTotal,
+         (mote->icmpv6rpl_vars.daoStats.numMinutes==0)?0:
+            (int)(mote->icmpv6rpl_vars.daoStats.totalBytes/mote->icmpv6rpl_vars.daoStats.numMinutes)
+      );
+   }
+   printf(
+      "%d/%d motes synchronized after %us simulated in %.3fs (%.1fx real time)\n",
+      numSync,
+      simengine_vars.numMotes,
+      seconds,
+      wallSeconds,
+      (wallSeconds>0)?seconds/wallSeconds:0.0
+   );
+   printf(
+      "%llu events, %llu context switches, %llu windows on %d threads\n",
+      (unsigned long long)simengine_getNumEvents(),
+      (unsigned long long)simengine_getNumSwitches(),
+      (unsigned long long)simengine_vars.numWindows,
+      simengine_vars.numWorkers
+   );
+}
@@ -0,0 +1,208 @@
+/**
+\brief Memory footprint of a mote running on the native board.
+
+The stack is objectified exactly as for the python board, so every module
+operates on an OpenMote instance. Instead of a Python object forwarding the
+BSP calls to the interpreter, the native OpenMote also holds the state of the
+emulated hardware, driven by the discrete-event engine in simengine.c.
+*/
+
+#ifndef __OPENWSNMODULE_H
+#define __OPENWSNMODULE_H
+
+#include <ucontext.h>
+// OpenWSN
+#include "openserial_obj.h"
+#include "opentimers_obj.h"
+#include "scheduler_obj.h"
+#include "IEEE802154E_obj.h"
+#include "IEEE802154_security_obj.h"
+#include "adaptive_sync_obj.h"
+#include "iphc_obj.h"
+#include "neighbors_obj.h"
+#include "sixtop_obj.h"
+#include "msf_obj.h"
+#include "schedule_obj.h"
+#include "icmpv6echo_obj.h"
+#include "icmpv6rpl_obj.h"
+#include "opencoap_obj.h"
+#include "openoscoap_obj.h"
+#include "openudp_obj.h"
+#include "idmanager_obj.h"
+#include "openqueue_obj.h"
+#include "openrandom_obj.h"
+#include "frag_obj.h"
+#include "openaes_obj.h"
+// applications
+#include "c6t_obj.h"
+#include "cexample_obj.h"
+#include "cjoin_obj.h"
+#include "cinfo_obj.h"
+#include "cleds_obj.h"
+#include "cstorm_obj.h"
+#include "cwellknown_obj.h"
+#include "rrt_obj.h"
+#include "uecho_obj.h"
+#include "uexpiration_obj.h"
+#include "uexpiration_monitor_obj.h"
+#include "uinject_obj.h"
+#include "userialbridge_obj.h"
+
+//=========================== define ==========================================
+
+#define NATIVE_RADIO_BUFSIZE      128 // largest 802.15.4 PSDU, including CRC
+#define NATIVE_UART_RXBUFSIZE     256
+
+//=========================== prototypes ======================================
+
+// radio
+void radio_intr_startOfFrame(OpenMote* self, uint32_t capturedTime);
+void radio_intr_endOfFrame(OpenMote* self, uint32_t capturedTime);
+
+// sctimer
+void sctimer_intr_compare(OpenMote* self);
+
+// uart
+void uart_intr_tx(OpenMote* self);
+void uart_intr_rx(OpenMote* self);
+void uart_writeBufferByLen_FASTSIM(OpenMote* self, uint8_t* buffer, uint16_t len);
+
+// supply
+void supply_on(OpenMote* self);
+void supply_off(OpenMote* self);
+
+//=========================== typedef =========================================
+
+typedef void    (*uart_tx_cbt)(OpenMote* self);
+typedef uint8_t (*uart_rx_cbt)(OpenMote* self);
+
+typedef struct {
+   uart_tx_cbt     txCb;
+   uart_rx_cbt     rxCb;
+} uart_icb_t;
+
+typedef void (*radio_capture_cbt)(OpenMote* self, PORT_TIMER_WIDTH timestamp);
+
+typedef struct {
+   radio_capture_cbt      startFrame_cb;
+   radio_capture_cbt      endFrame_cb;
+} radio_icb_t;
+
+typedef void (*sctimer_cbt)(OpenMote* self);
+
+typedef struct {
+   sctimer_cbt      compare_cb;
+} sctimer_icb_t;
+
+//===== emulated hardware
+
+typedef struct {
+   uint16_t             id;                 // index of this mote in the engine
+   uint16_t             worker;             // index of the thread running it
+   uint16_t             bootCount;          // events of a previous boot are stale
+   bool                 isOn;
+   bool                 resetPending;
+   ucontext_t           context;            // where the mote's code runs
+   uint8_t*             stack;
+} board_vars_t;
+
+typedef struct {
+   PORT_TIMER_WIDTH     counterOffset;      // counter value at engine time 0
+   PORT_TIMER_WIDTH     compareValue;
+   uint32_t             generation;         // invalidates superseded compares
+   bool                 armed;
+} sctimer_vars_t;
+
+typedef struct {
+   uint8_t              state;              // a radio_state_t
+   uint8_t              frequency;
+   uint8_t              txBuf[NATIVE_RADIO_BUFSIZE];
+   uint8_t              txLen;
+   uint32_t             txSeq;              // identifies the frame on the air
+   uint8_t              rxBuf[NATIVE_RADIO_BUFSIZE];
+   uint8_t              rxLen;
+   int8_t               rxRssi;
+   bool                 rxCrc;              // FALSE after a collision
+   uint16_t             rxFrom;             // mote whose frame is being received
+   uint32_t             rxSeq;
+} radio_vars_t;
+
+typedef struct {
+   bool                 interruptsEnabled;
+   uint8_t              rxByte;             // returned by uart_readByte()
+   uint8_t              rxBuf[NATIVE_UART_RXBUFSIZE];
+   uint16_t             rxLen;
+} uart_vars_t;
+
+typedef struct {
+   uint8_t              state;              // one bit per LED
+} leds_vars_t;
+
+//=========================== struct ==========================================
+
+/**
+\brief Memory footprint of an OpenMote instance.
+*/
+struct OpenMote {
+   //===== internal C callbacks
+   uart_icb_t           uart_icb;
+   sctimer_icb_t        sctimer_icb;
+   radio_icb_t          radio_icb;
+   //===== emulated hardware
+   board_vars_t         board_vars;
+   sctimer_vars_t       sctimer_vars;
+   radio_vars_t         radio_vars;
+   uart_vars_t          uart_vars;
+   leds_vars_t          leds_vars;
+   //===== openstack
+   // l4
+   icmpv6echo_vars_t    icmpv6echo_vars;
+   icmpv6rpl_vars_t     icmpv6rpl_vars;
+   openudp_vars_t       openudp_vars;
+   // l3
+   monitor_expiration_vars_t        monitor_expiration_vars;
+   iphc_vars_t          iphc_vars;
+   frag_vars_t          frag_vars;
+   // l2b
+   sixtop_vars_t        sixtop_vars;
+   neighbors_vars_t     neighbors_vars;
+   schedule_vars_t      schedule_vars;
+   msf_vars_t           msf_vars;
+   // l2a
+   adaptive_sync_vars_t adaptive_sync_vars;
+   ieee802154_security_vars_t ieee802154_security_vars;
+   ieee154e_vars_t      ieee154e_vars;
+   ieee154e_stats_t     ieee154e_stats;
+   ieee154e_dbg_t       ieee154e_dbg;
+   // cross-layer
+   idmanager_vars_t     idmanager_vars;
+   openqueue_vars_t     openqueue_vars;
+   // drivers
+   opentimers_vars_t    opentimers_vars;
+   random_vars_t        random_vars;
+   openserial_vars_t    openserial_vars;
+   // kernel
+   scheduler_vars_t     scheduler_vars;
+   scheduler_dbg_t      scheduler_dbg;
+   // bsp
+   openaes_vars_t       openaes_vars;
+   //===== openapps
+   //
+   opencoap_vars_t      opencoap_vars;
+   openoscoap_vars_t    openoscoap_vars;
+   c6t_vars_t           c6t_vars;
+   cexample_vars_t      cexample_vars;
+   cinfo_vars_t         cinfo_vars;
+   cleds_vars_t         cleds_vars;
+   cstorm_vars_t        cstorm_vars;
+   cwellknown_vars_t    cwellknown_vars;
+   rrt_vars_t           rrt_vars;
+   cjoin_vars_t         cjoin_vars;
+   uecho_vars_t         uecho_vars;
+   uexpiration_vars_t   uexpiration_vars;
+   umonitor_vars_t      umonitor_vars;
+   uinject_vars_t       uinject_vars;
+   userialbridge_vars_t userialbridge_vars;
+};
+
+#endif
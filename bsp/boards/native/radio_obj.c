@@ -0,0 +1,126 @@
+/**
+\brief Native definition of the "radio" bsp module.
+
+The radio only keeps its state, frequency and buffers; the engine's medium
+delivers the frames to the motes listening on the same frequency.
+*/
+
+#include "radio_obj.h"
+#include "simengine.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+void radio_setStartFrameCb(OpenMote* self, radio_capture_cbt cb) {
+   self->radio_icb.startFrame_cb  = cb;
+}
+
+void radio_setEndFrameCb(OpenMote* self, radio_capture_cbt cb) {
+   self->radio_icb.endFrame_cb    = cb;
+}
+
+//=========================== public ==========================================
+
+//===== admin
+
+void radio_init(OpenMote* self) {
+   uint32_t txSeq;
+   
+   // keep numbering frames across reboots, stale receptions are ignored
+   txSeq = self->radio_vars.txSeq;
+   memset(&self->radio_vars,0,sizeof(radio_vars_t));
+   self->radio_vars.txSeq = txSeq;
+   self->radio_vars.state = RADIOSTATE_RFOFF;
+}
+
+//===== reset
+
+void radio_reset(OpenMote* self) {
+   self->radio_vars.state = RADIOSTATE_RFOFF;
+}
+
+//===== RF admin
+
+void radio_setFrequency(OpenMote* self, uint8_t frequency, radio_freq_t tx_or_rx) {
+   self->radio_vars.frequency = frequency;
+   self->radio_vars.state     = RADIOSTATE_FREQUENCY_SET;
+}
+
+void radio_rfOn(OpenMote* self) {
+   // the RF chain is switched on by radio_txEnable() or radio_rxEnable()
+}
+
+void radio_rfOff(OpenMote* self) {
+   // aborts any reception in progress
+   self->radio_vars.state = RADIOSTATE_RFOFF;
+}
+
+//===== TX
+
+void radio_loadPacket(OpenMote* self, uint8_t* packet, uint16_t len) {
+   if (len>NATIVE_RADIO_BUFSIZE) {
+      len = NATIVE_RADIO_BUFSIZE;
+   }
+   memcpy(self->radio_vars.txBuf,packet,len);
+   self->radio_vars.txLen = (uint8_t)len;
+   self->radio_vars.state = RADIOSTATE_PACKET_LOADED;
+}
+
+void radio_txEnable(OpenMote* self) {
+   self->radio_vars.state = RADIOSTATE_TX_ENABLED;
+}
+
+void radio_txNow(OpenMote* self) {
+   self->radio_vars.state = RADIOSTATE_TRANSMITTING;
+   simengine_schedule(self,simengine_now(self)+PORT_delayTx,SIMENGINE_EVT_TXSTART,0);
+}
+
+//===== RX
+
+void radio_rxEnable(OpenMote* self) {
+   self->radio_vars.state = RADIOSTATE_ENABLING_RX;
+}
+
+void radio_rxNow(OpenMote* self) {
+   // only frames starting from now on are received
+   self->radio_vars.state = RADIOSTATE_LISTENING;
+}
+
+void radio_getReceivedFrame(OpenMote* self,
+                             uint8_t* pBufRead,
+                             uint8_t* pLenRead,
+                             uint8_t  maxBufLen,
+                              int8_t* pRssi,
+                             uint8_t* pLqi,
+                                bool* pCrc) {
+   uint8_t len;
+   
+   len        = self->radio_vars.rxLen;
+   if (len>maxBufLen) {
+      len     = maxBufLen;
+   }
+   memcpy(pBufRead,self->radio_vars.rxBuf,len);
+   *pLenRead  = len;
+   *pRssi     = self->radio_vars.rxRssi;
+   *pLqi      = 0;
+   *pCrc      = self->radio_vars.rxCrc;
+}
+
+//=========================== interrupts ======================================
+
+void radio_intr_startOfFrame(OpenMote* self, uint32_t capturedTime) {
+   if (self->radio_icb.startFrame_cb!=NULL) {
+      self->radio_icb.startFrame_cb(self, capturedTime);
+   }
+}
+
+void radio_intr_endOfFrame(OpenMote* self, uint32_t capturedTime) {
+   if (self->radio_icb.endFrame_cb!=NULL) {
+      self->radio_icb.endFrame_cb(self, capturedTime);
+   }
+}
+
+//=========================== private =========================================
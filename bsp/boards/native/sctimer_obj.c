@@ -0,0 +1,73 @@
+/**
+\brief Native definition of the "sctimer" bsp module.
+
+The counter is the engine's virtual clock, shifted by a per-mote offset. A
+compare is an event in the engine's queue.
+*/
+
+#include "sctimer_obj.h"
+#include "simengine.h"
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== callback ========================================
+
+void sctimer_set_callback(OpenMote* self, sctimer_cbt cb) {
+   self->sctimer_icb.compare_cb = cb;
+}
+
+//=========================== public ==========================================
+
+//===== admin
+
+void sctimer_init(OpenMote* self) {
+   self->sctimer_vars.armed = FALSE;
+   self->sctimer_vars.generation++;
+}
+
+//===== direct access
+
+PORT_RADIOTIMER_WIDTH sctimer_readCounter(OpenMote* self) {
+   return (PORT_RADIOTIMER_WIDTH)(simengine_now(self)+self->sctimer_vars.counterOffset);
+}
+
+//===== compare
+
+void sctimer_setCompare(OpenMote* self, PORT_RADIOTIMER_WIDTH value) {
+   PORT_RADIOTIMER_WIDTH counter;
+   simtime_t             fireTime;
+   
+   counter = sctimer_readCounter(self);
+   if (counter-value<TIMERLOOP_THRESHOLD) {
+      // the compare value is already passed, fire right away
+      fireTime = simengine_now(self);
+   } else {
+      fireTime = simengine_now(self)+(PORT_RADIOTIMER_WIDTH)(value-counter);
+   }
+   
+   // only the last compare value set fires
+   self->sctimer_vars.compareValue = value;
+   self->sctimer_vars.armed        = TRUE;
+   self->sctimer_vars.generation++;
+   simengine_schedule(self,fireTime,SIMENGINE_EVT_SCTIMER,self->sctimer_vars.generation);
+}
+
+void sctimer_enable(OpenMote* self) {
+   // the compare is enabled when set
+}
+
+void sctimer_disable(OpenMote* self) {
+   self->sctimer_vars.armed = FALSE;
+}
+
+//=========================== interrupt handlers ==============================
+
+void sctimer_intr_compare(OpenMote* self) {
+   if (self->sctimer_icb.compare_cb!=NULL) {
+      self->sctimer_icb.compare_cb(self);
+   }
+}
+
+//=========================== private =========================================
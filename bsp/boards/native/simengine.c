@@ -0,0 +1,742 @@
+/**
+\brief Discrete-event engine of the native board.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "simengine.h"
+#include "radio_obj.h"
+#include "sctimer_obj.h"
+
+//=========================== defines =========================================
+
+#define SIMENGINE_HEAP_INITSIZE     1024
+
+//=========================== variables =======================================
+
+simengine_vars_t simengine_vars;
+
+//=========================== prototypes ======================================
+
+extern int mote_main(OpenMote* self);
+
+// heap
+void     simengine_heapInit(simengine_heap_t* heap);
+void     simengine_heapPush(simengine_heap_t* heap, simengine_event_t* event);
+void     simengine_heapPop(simengine_heap_t* heap, simengine_event_t* event);
+bool     simengine_eventBefore(simengine_event_t* a, simengine_event_t* b);
+// workers
+void*    simengine_workerMain(void* arg);
+void     simengine_runWindow(simengine_worker_t* worker);
+void     simengine_barrier(simengine_worker_t* worker);
+// execution contexts
+void     simengine_moteEntry(int moteId);
+void     simengine_restart(OpenMote* self);
+void     simengine_resume(OpenMote* self);
+void     simengine_afterInterrupt(OpenMote* self);
+// event handlers
+void     simengine_handleEvent(simengine_event_t* event);
+void     simengine_interrupt(OpenMote* self, uint8_t type);
+void     simengine_txStart(OpenMote* self);
+void     simengine_txEnd(OpenMote* self);
+void     simengine_uartRx(OpenMote* self);
+// helpers
+uint32_t simengine_random(void);
+void     simengine_fatal(const char* reason);
+
+//=========================== public ==========================================
+
+//===== admin
+
+/**
+\brief Create the motes, an empty medium and the worker threads.
+
+\param[in] numMotes   Number of motes to simulate; motes are powered off.
+\param[in] numWorkers Number of threads running the motes, the calling thread
+   included.
+\param[in] seed       Seed of the random generator used by the medium.
+*/
+void simengine_init(uint16_t numMotes, uint16_t numWorkers, uint32_t seed) {
+   uint16_t i;
+
+   if (numMotes==0 || numMotes>SIMENGINE_MAXNUMMOTES) {
+      fprintf(stderr,"[simengine] FATAL: %d motes, at most %d supported\n",numMotes,SIMENGINE_MAXNUMMOTES);
+      exit(1);
+   }
+   if (numWorkers==0 || numWorkers>SIMENGINE_MAXNUMWORKERS) {
+      fprintf(stderr,"[simengine] FATAL: %d threads, at most %d supported\n",numWorkers,SIMENGINE_MAXNUMWORKERS);
+      exit(1);
+   }
+   if (numWorkers>numMotes) {
+      numWorkers = numMotes;
+   }
+
+   memset(&simengine_vars,0,sizeof(simengine_vars_t));
+   simengine_vars.numMotes    = numMotes;
+   simengine_vars.numWorkers  = numWorkers;
+   simengine_vars.motes       = calloc(numMotes,sizeof(OpenMote));
+   simengine_vars.nodes       = calloc(numMotes,sizeof(simengine_node_t));
+   simengine_vars.workers     = calloc(numWorkers,sizeof(simengine_worker_t));
+   simengine_vars.randomState = (seed!=0)?seed:1;
+   if (
+      simengine_vars.motes==NULL   ||
+      simengine_vars.nodes==NULL   ||
+      simengine_vars.workers==NULL
+   ) {
+      simengine_fatal("out of memory");
+   }
+   simengine_heapInit(&simengine_vars.medium);
+   pthread_mutex_init(&simengine_vars.hooksLock,NULL);
+
+   for (i=0;i<numMotes;i++) {
+      simengine_vars.motes[i].board_vars.id     = i;
+      simengine_vars.motes[i].board_vars.worker = i%numWorkers;
+      // motes do not share the same counter value
+      simengine_vars.motes[i].sctimer_vars.counterOffset = simengine_random();
+   }
+
+   for (i=0;i<numWorkers;i++) {
+      simengine_heapInit(&simengine_vars.workers[i].heap);
+      simengine_heapInit(&simengine_vars.workers[i].outbox);
+   }
+   // worker 0 is the calling thread
+   for (i=1;i<numWorkers;i++) {
+      if (pthread_create(&simengine_vars.workers[i].thread,NULL,simengine_workerMain,&simengine_vars.workers[i])!=0) {
+         simengine_fatal("cannot create a worker thread");
+      }
+   }
+}
+
+OpenMote* simengine_getMote(uint16_t moteId) {
+   return &simengine_vars.motes[moteId];
+}
+
+/**
+\brief Let mote 'to' hear the frames transmitted by mote 'from'.
+
+\param[in] from Transmitting mote.
+\param[in] to   Receiving mote.
+\param[in] pdr  Probability, in percent, that a frame is received.
+\param[in] rssi RSSI reported for the frames received over this link.
+*/
+void simengine_addLink(uint16_t from, uint16_t to, uint8_t pdr, int8_t rssi) {
+   simengine_node_t* node;
+   simengine_link_t* links;
+
+   node = &simengine_vars.nodes[from];
+   if (node->numLinks==node->maxLinks) {
+      node->maxLinks = (node->maxLinks==0)?8:2*node->maxLinks;
+      links = realloc(node->links,node->maxLinks*sizeof(simengine_link_t));
+      if (links==NULL) {
+         simengine_fatal("out of memory");
+      }
+      node->links = links;
+   }
+   node->links[node->numLinks].moteId = to;
+   node->links[node->numLinks].pdr    = pdr;
+   node->links[node->numLinks].rssi   = rssi;
+   node->numLinks++;
+}
+
+/**
+\brief Process events until the virtual clock reaches the given time.
+
+\param[in] until Time, in 32kHz ticks, at which to stop.
+*/
+void simengine_run(simtime_t until) {
+   simengine_worker_t* worker;
+   simengine_event_t   event;
+   simtime_t           start;
+   simtime_t           end;
+   uint16_t            i;
+
+   while (1) {
+      // the window starts at the earliest pending event
+      start = until;
+      if (simengine_vars.medium.len>0 && simengine_vars.medium.events[0].time<start) {
+         start = simengine_vars.medium.events[0].time;
+      }
+      for (i=0;i<simengine_vars.numWorkers;i++) {
+         worker = &simengine_vars.workers[i];
+         if (worker->heap.len>0 && worker->heap.events[0].time<start) {
+            start = worker->heap.events[0].time;
+         }
+      }
+      if (start>=until) {
+         break;
+      }
+      simengine_vars.now = start;
+
+      // frames going on or leaving the air now
+      while (
+         simengine_vars.medium.len>0 &&
+         simengine_vars.medium.events[0].time==start
+      ) {
+         simengine_heapPop(&simengine_vars.medium,&event);
+         if (event.type==SIMENGINE_EVT_TXSTART) {
+            simengine_txStart(&simengine_vars.motes[event.moteId]);
+         } else {
+            simengine_txEnd(&simengine_vars.motes[event.moteId]);
+         }
+      }
+
+      // no frame sent from now on goes on the air before the window ends
+      end = start+SIMENGINE_LOOKAHEAD;
+      if (simengine_vars.medium.len>0 && simengine_vars.medium.events[0].time<end) {
+         end = simengine_vars.medium.events[0].time;
+      }
+      if (until<end) {
+         end = until;
+      }
+      simengine_vars.windowEnd = end;
+      simengine_vars.numWindows++;
+
+      if (simengine_vars.numWorkers>1) {
+         simengine_barrier(&simengine_vars.workers[0]);
+      }
+      simengine_runWindow(&simengine_vars.workers[0]);
+      if (simengine_vars.numWorkers>1) {
+         simengine_barrier(&simengine_vars.workers[0]);
+      }
+
+      // collect the frames sent during the window
+      for (i=0;i<simengine_vars.numWorkers;i++) {
+         worker = &simengine_vars.workers[i];
+         while (worker->outbox.len>0) {
+            simengine_heapPop(&worker->outbox,&event);
+            simengine_heapPush(&simengine_vars.medium,&event);
+         }
+      }
+   }
+
+   simengine_vars.now = until;
+   for (i=0;i<simengine_vars.numWorkers;i++) {
+      simengine_vars.workers[i].now = until;
+   }
+}
+
+uint64_t simengine_getNumEvents(void) {
+   uint64_t numEvents;
+   uint16_t i;
+
+   numEvents = 0;
+   for (i=0;i<simengine_vars.numWorkers;i++) {
+      numEvents += simengine_vars.workers[i].numEvents;
+   }
+   return numEvents;
+}
+
+uint64_t simengine_getNumSwitches(void) {
+   uint64_t numSwitches;
+   uint16_t i;
+
+   numSwitches = 0;
+   for (i=0;i<simengine_vars.numWorkers;i++) {
+      numSwitches += simengine_vars.workers[i].numSwitches;
+   }
+   return numSwitches;
+}
+
+//===== from the emulated hardware
+
+simtime_t simengine_now(OpenMote* self) {
+   return simengine_vars.workers[self->board_vars.worker].now;
+}
+
+/**
+\brief Schedule a hardware event of a mote.
+
+Events scheduled before the mote reboots are discarded.
+*/
+void simengine_schedule(OpenMote* self, simtime_t time, uint8_t type, uint32_t arg) {
+   simengine_worker_t* worker;
+   simengine_event_t   event;
+
+   worker          = &simengine_vars.workers[self->board_vars.worker];
+   event.time      = time;
+   event.seq       = worker->seq++;
+   event.arg       = arg;
+   event.moteId    = self->board_vars.id;
+   event.bootCount = self->board_vars.bootCount;
+   event.type      = type;
+   if (type==SIMENGINE_EVT_TXSTART) {
+      // handed over to the medium at the end of the window
+      simengine_heapPush(&worker->outbox,&event);
+   } else {
+      simengine_heapPush(&worker->heap,&event);
+   }
+}
+
+/**
+\brief Power a mote on, it starts executing at the current time.
+*/
+void simengine_boot(OpenMote* self) {
+   self->board_vars.isOn = TRUE;
+   self->board_vars.bootCount++;
+   self->uart_vars.rxLen = 0;
+   simengine_schedule(self,simengine_now(self),SIMENGINE_EVT_BOOT,0);
+}
+
+/**
+\brief Called by the mote when it has no more task to execute.
+
+Returns when the mote has to run again, i.e. after an interrupt handler posted
+a task.
+*/
+void simengine_sleep(OpenMote* self) {
+   swapcontext(
+      &self->board_vars.context,
+      &simengine_vars.workers[self->board_vars.worker].context
+   );
+}
+
+/**
+\brief Reboot a mote.
+
+The mote restarts from mote_main() as soon as its current interrupt handler
+or task returns control to the engine.
+*/
+void simengine_reset(OpenMote* self) {
+   self->board_vars.resetPending = TRUE;
+   if (simengine_vars.workers[self->board_vars.worker].current==self) {
+      // called from a task, never return to it
+      simengine_sleep(self);
+   }
+}
+
+/**
+\brief Feed bytes to the UART of a mote, e.g. an HDLC frame from a PC.
+*/
+void simengine_uartInput(OpenMote* self, uint8_t* buf, uint16_t len) {
+   uart_vars_t* uart;
+
+   uart = &self->uart_vars;
+   if (uart->rxLen+len>NATIVE_UART_RXBUFSIZE) {
+      fprintf(stderr,"[simengine] mote %d: UART input dropped\n",self->board_vars.id);
+      return;
+   }
+   if (uart->rxLen==0) {
+      simengine_schedule(self,simengine_now(self)+SIMENGINE_UART_TICKS_PER_BYTE,SIMENGINE_EVT_UARTRX,0);
+   }
+   memcpy(&uart->rxBuf[uart->rxLen],buf,len);
+   uart->rxLen += len;
+}
+
+/**
+\brief Time on the air of a PSDU, from the SFD to the last byte.
+
+\param[in] len Length of the PSDU, CRC included.
+
+\returns The duration, in 32kHz ticks, rounded up.
+*/
+uint8_t simengine_frameDuration(uint8_t len) {
+   uint32_t us;
+
+   // PHY header byte, then the PSDU
+   us = (1+len)*SIMENGINE_US_PER_BYTE;
+   return (uint8_t)((us*SIMENGINE_TICKS_PER_S+999999)/1000000);
+}
+
+//=========================== private =========================================
+
+//===== heap
+
+void simengine_heapInit(simengine_heap_t* heap) {
+   heap->len    = 0;
+   heap->size   = SIMENGINE_HEAP_INITSIZE;
+   heap->events = malloc(heap->size*sizeof(simengine_event_t));
+   if (heap->events==NULL) {
+      simengine_fatal("out of memory");
+   }
+}
+
+/**
+\brief Order of the events: by time, then by mote, then FIFO.
+
+Simultaneous events of different motes are independent. Ordering them by mote
+rather than by creation keeps the result the same for any number of workers.
+*/
+bool simengine_eventBefore(simengine_event_t* a, simengine_event_t* b) {
+   if (a->time!=b->time) {
+      return a->time<b->time;
+   }
+   if (a->moteId!=b->moteId) {
+      return a->moteId<b->moteId;
+   }
+   return (int32_t)(a->seq-b->seq)<0;
+}
+
+void simengine_heapPush(simengine_heap_t* heap, simengine_event_t* event) {
+   simengine_event_t* events;
+   uint32_t           i;
+   uint32_t           parent;
+
+   if (heap->len==heap->size) {
+      events = realloc(heap->events,2*heap->size*sizeof(simengine_event_t));
+      if (events==NULL) {
+         simengine_fatal("out of memory");
+      }
+      heap->events  = events;
+      heap->size   *= 2;
+   }
+
+   // sift up
+   events = heap->events;
+   i      = heap->len++;
+   while (i>0) {
+      parent = (i-1)/2;
+      if (simengine_eventBefore(&events[parent],event)) {
+         break;
+      }
+      events[i] = events[parent];
+      i         = parent;
+   }
+   events[i] = *event;
+}
+
+void simengine_heapPop(simengine_heap_t* heap, simengine_event_t* event) {
+   simengine_event_t* events;
+   simengine_event_t  last;
+   uint32_t           i;
+   uint32_t           child;
+
+   events = heap->events;
+   *event = events[0];
+   last   = events[--heap->len];
+
+   // sift the last event down from the root
+   i = 0;
+   while ((child=2*i+1)<heap->len) {
+      if (
+         child+1<heap->len &&
+         simengine_eventBefore(&events[child+1],&events[child])
+      ) {
+         child++;
+      }
+      if (simengine_eventBefore(&last,&events[child])) {
+         break;
+      }
+      events[i] = events[child];
+      i         = child;
+   }
+   events[i] = last;
+}
+
+//===== workers
+
+void* simengine_workerMain(void* arg) {
+   simengine_worker_t* worker;
+
+   worker = (simengine_worker_t*)arg;
+   while (1) {
+      simengine_barrier(worker);
+      simengine_runWindow(worker);
+      simengine_barrier(worker);
+   }
+   return NULL;
+}
+
+/**
+\brief Process the events of the motes of a worker, up to the end of the window.
+*/
+void simengine_runWindow(simengine_worker_t* worker) {
+   simengine_event_t event;
+
+   while (
+      worker->heap.len>0 &&
+      worker->heap.events[0].time<simengine_vars.windowEnd
+   ) {
+      simengine_heapPop(&worker->heap,&event);
+      worker->now = event.time;
+      worker->numEvents++;
+      simengine_handleEvent(&event);
+   }
+}
+
+/**
+\brief Wait until all the workers reach that point.
+
+Windows are short, so a worker spins for a while before giving the CPU away.
+*/
+void simengine_barrier(simengine_worker_t* worker) {
+   uint32_t spins;
+
+   worker->barrierSense = !worker->barrierSense;
+   if (__sync_add_and_fetch(&simengine_vars.barrierCount,1)==simengine_vars.numWorkers) {
+      // last one in, release the others
+      simengine_vars.barrierCount = 0;
+      __sync_synchronize();
+      simengine_vars.barrierSense = worker->barrierSense;
+   } else {
+      spins = 0;
+      while (simengine_vars.barrierSense!=worker->barrierSense) {
+         if (++spins==SIMENGINE_BARRIER_SPINS) {
+            sched_yield();
+            spins = 0;
+         }
+      }
+      __sync_synchronize();
+   }
+}
+
+//===== execution contexts
+
+void simengine_moteEntry(int moteId) {
+   OpenMote* self;
+
+   self = &simengine_vars.motes[moteId];
+   mote_main(self);
+
+   // mote_main() is not expected to return; if it does, the mote is halted
+   self->board_vars.isOn = FALSE;
+   while (1) {
+      simengine_sleep(self);
+   }
+}
+
+/**
+\brief Start the code of a mote from mote_main(), on a fresh stack.
+*/
+void simengine_restart(OpenMote* self) {
+   board_vars_t* board;
+
+   board = &self->board_vars;
+   if (board->stack==NULL) {
+      board->stack = malloc(SIMENGINE_STACKSIZE);
+      if (board->stack==NULL) {
+         simengine_fatal("out of memory");
+      }
+   }
+   board->resetPending = FALSE;
+
+   getcontext(&board->context);
+   board->context.uc_stack.ss_sp   = board->stack;
+   board->context.uc_stack.ss_size = SIMENGINE_STACKSIZE;
+   board->context.uc_link          = &simengine_vars.workers[board->worker].context;
+   makecontext(&board->context,(void (*)(void))simengine_moteEntry,1,(int)board->id);
+
+   simengine_resume(self);
+}
+
+/**
+\brief Run the tasks of a mote until it sleeps again.
+*/
+void simengine_resume(OpenMote* self) {
+   simengine_worker_t* worker;
+
+   worker          = &simengine_vars.workers[self->board_vars.worker];
+   worker->current = self;
+   worker->numSwitches++;
+   swapcontext(&worker->context,&self->board_vars.context);
+   worker->current = NULL;
+
+   if (self->board_vars.resetPending==TRUE) {
+      // the stale context is dropped, as are the pending events
+      self->board_vars.bootCount++;
+      simengine_restart(self);
+   }
+}
+
+/**
+\brief Give the CPU to a mote after one of its interrupt handlers ran.
+
+Interrupt handlers run on the worker's stack; the mote is only resumed when
+its handler posted a task, which saves a context switch for most frames and
+timer compares.
+*/
+void simengine_afterInterrupt(OpenMote* self) {
+   if (self->board_vars.resetPending==TRUE) {
+      self->board_vars.bootCount++;
+      simengine_restart(self);
+   } else if (self->scheduler_vars.prioBitmap!=0) {
+      simengine_resume(self);
+   }
+}
+
+//===== event handlers
+
+void simengine_handleEvent(simengine_event_t* event) {
+   OpenMote* self;
+
+   self = &simengine_vars.motes[event->moteId];
+   if (
+      self->board_vars.isOn==FALSE ||
+      event->bootCount!=self->board_vars.bootCount
+   ) {
+      // the mote was switched off or rebooted since
+      return;
+   }
+
+   switch (event->type) {
+      case SIMENGINE_EVT_BOOT:
+         simengine_restart(self);
+         break;
+      case SIMENGINE_EVT_SCTIMER:
+         if (
+            self->sctimer_vars.armed==TRUE &&
+            event->arg==self->sctimer_vars.generation
+         ) {
+            self->sctimer_vars.armed = FALSE;
+            sctimer_intr_compare(self);
+            simengine_afterInterrupt(self);
+         }
+         break;
+      case SIMENGINE_EVT_UARTTX:
+         if (self->uart_vars.interruptsEnabled==TRUE) {
+            uart_intr_tx(self);
+            simengine_afterInterrupt(self);
+         }
+         break;
+      case SIMENGINE_EVT_UARTRX:
+         simengine_uartRx(self);
+         break;
+      case SIMENGINE_EVT_STARTOFFRAME:
+         radio_intr_startOfFrame(self,sctimer_readCounter(self));
+         simengine_afterInterrupt(self);
+         break;
+      case SIMENGINE_EVT_ENDOFFRAME:
+         radio_intr_endOfFrame(self,sctimer_readCounter(self));
+         simengine_afterInterrupt(self);
+         break;
+   }
+}
+
+/**
+\brief Queue a radio interrupt of a mote, at the current time.
+
+Called between windows; the worker of the mote runs the handler in the next
+one.
+*/
+void simengine_interrupt(OpenMote* self, uint8_t type) {
+   simengine_schedule(self,simengine_vars.now,type,0);
+}
+
+/**
+\brief The SFD of the frame loaded in a mote goes on the air.
+*/
+void simengine_txStart(OpenMote* self) {
+   simengine_node_t* node;
+   simengine_link_t* link;
+   simengine_event_t event;
+   OpenMote*         rx;
+   radio_vars_t*     tx;
+   uint16_t          i;
+
+   tx = &self->radio_vars;
+   if (self->board_vars.isOn==FALSE || tx->state!=RADIOSTATE_TRANSMITTING) {
+      return;
+   }
+   tx->txSeq++;
+   if (simengine_vars.hooks.radioTx!=NULL) {
+      simengine_vars.hooks.radioTx(self->board_vars.id,tx->frequency,tx->txBuf,tx->txLen);
+   }
+   event.time      = simengine_vars.now+simengine_frameDuration(tx->txLen);
+   event.seq       = simengine_vars.seq++;
+   event.arg       = tx->txSeq;
+   event.moteId    = self->board_vars.id;
+   event.bootCount = self->board_vars.bootCount;
+   event.type      = SIMENGINE_EVT_TXEND;
+   simengine_heapPush(&simengine_vars.medium,&event);
+   simengine_interrupt(self,SIMENGINE_EVT_STARTOFFRAME);
+
+   // neighbors listening on that frequency lock onto the frame
+   node = &simengine_vars.nodes[self->board_vars.id];
+   for (i=0;i<node->numLinks;i++) {
+      link = &node->links[i];
+      rx   = &simengine_vars.motes[link->moteId];
+      if (rx->board_vars.isOn==FALSE || rx->radio_vars.frequency!=tx->frequency) {
+         continue;
+      }
+      if (rx->radio_vars.state==RADIOSTATE_RECEIVING) {
+         // overlapping frames, neither is received correctly
+         rx->radio_vars.rxCrc = FALSE;
+         continue;
+      }
+      if (
+         rx->radio_vars.state!=RADIOSTATE_LISTENING ||
+         simengine_random()%100>=link->pdr
+      ) {
+         continue;
+      }
+      rx->radio_vars.state  = RADIOSTATE_RECEIVING;
+      rx->radio_vars.rxFrom = self->board_vars.id;
+      rx->radio_vars.rxSeq  = tx->txSeq;
+      rx->radio_vars.rxRssi = link->rssi;
+      rx->radio_vars.rxCrc  = TRUE;
+      simengine_interrupt(rx,SIMENGINE_EVT_STARTOFFRAME);
+   }
+}
+
+/**
+\brief The last byte of the frame of a mote leaves the air.
+*/
+void simengine_txEnd(OpenMote* self) {
+   simengine_node_t* node;
+   OpenMote*         rx;
+   radio_vars_t*     tx;
+   uint16_t          i;
+
+   tx = &self->radio_vars;
+   if (self->board_vars.isOn==TRUE && tx->state==RADIOSTATE_TRANSMITTING) {
+      tx->state = RADIOSTATE_TXRX_DONE;
+      simengine_interrupt(self,SIMENGINE_EVT_ENDOFFRAME);
+   }
+
+   node = &simengine_vars.nodes[self->board_vars.id];
+   for (i=0;i<node->numLinks;i++) {
+      rx = &simengine_vars.motes[node->links[i].moteId];
+      if (
+         rx->radio_vars.state!=RADIOSTATE_RECEIVING ||
+         rx->radio_vars.rxFrom!=self->board_vars.id ||
+         rx->radio_vars.rxSeq!=tx->txSeq
+      ) {
+         // stopped listening before the end of the frame
+         continue;
+      }
+      memcpy(rx->radio_vars.rxBuf,tx->txBuf,tx->txLen);
+      rx->radio_vars.rxLen = tx->txLen;
+      rx->radio_vars.state = RADIOSTATE_TXRX_DONE;
+      simengine_interrupt(rx,SIMENGINE_EVT_ENDOFFRAME);
+   }
+}
+
+/**
+\brief Deliver the pending UART input of a mote, one interrupt per byte.
+*/
+void simengine_uartRx(OpenMote* self) {
+   uart_vars_t* uart;
+   uint16_t     i;
+
+   uart = &self->uart_vars;
+   for (i=0;i<uart->rxLen;i++) {
+      if (uart->interruptsEnabled==FALSE) {
+         break;
+      }
+      uart->rxByte = uart->rxBuf[i];
+      uart_intr_rx(self);
+   }
+   uart->rxLen = 0;
+   simengine_afterInterrupt(self);
+}
+
+//===== helpers
+
+/**
+\brief xorshift32 pseudo-random generator.
+*/
+uint32_t simengine_random(void) {
+   uint32_t x;
+
+   x  = simengine_vars.randomState;
+   x ^= x<<13;
+   x ^= x>>17;
+   x ^= x<<5;
+   simengine_vars.randomState = x;
+   return x;
+}
+
+void simengine_fatal(const char* reason) {
+   fprintf(stderr,"[simengine] FATAL: %s\n",reason);
+   exit(1);
+}
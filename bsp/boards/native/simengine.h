@@ -0,0 +1,173 @@
+/**
+\brief Discrete-event engine of the native board.
+
+The engine owns every simulated mote and a single virtual clock. Pending
+hardware events (timer compares, frame starts and ends, UART bytes) sit in a
+binary min-heap ordered by time. The engine pops the earliest one, runs the
+corresponding interrupt handler of the mote, and, if that handler posted a
+task, resumes the mote's code until it goes back to sleep in board_sleep().
+
+Each mote's code runs in its own execution context (a ucontext with its own
+stack), since scheduler_start() never returns. Switching between motes and
+the engine is hence a user-space stack switch, not a call into Python.
+
+The radio medium is a directed graph of links, each with a packet delivery
+ratio and an RSSI. A frame is received by every neighbor listening on the
+same frequency when its SFD goes on the air; two overlapping frames corrupt
+each other at a receiver that hears both.
+
+The motes can be partitioned across worker threads. Simulation then advances
+in windows, following a conservative parallel discrete-event scheme:
+- a mote only affects the others through the frames it sends, and a frame
+  goes on the air SIMENGINE_LOOKAHEAD ticks after radio_txNow() at the
+  earliest. Within a window shorter than that, the workers process the events
+  of their motes independently;
+- frame starts and ends are handled by the calling thread between windows,
+  and turned into start/end of frame interrupts queued for the motes.
+Windows start at the earliest pending event, so idle time is skipped, and,
+since TSCH keeps motes synchronized, the activity of every mote at a given
+offset in the slot falls in the same window. The result of a simulation does
+not depend on the number of threads.
+*/
+
+#ifndef __SIMENGINE_H
+#define __SIMENGINE_H
+
+#include <pthread.h>
+#include "openwsnmodule_obj.h"
+
+//=========================== define ==========================================
+
+#ifndef SIMENGINE_MAXNUMMOTES
+#define SIMENGINE_MAXNUMMOTES          1024
+#endif
+
+#ifndef SIMENGINE_MAXNUMWORKERS
+#define SIMENGINE_MAXNUMWORKERS        64
+#endif
+
+#ifndef SIMENGINE_STACKSIZE
+#define SIMENGINE_STACKSIZE            (64*1024)
+#endif
+
+#define SIMENGINE_TICKS_PER_S          32768
+#define SIMENGINE_US_PER_BYTE          32    // 250kbps O-QPSK PHY
+#define SIMENGINE_UART_TICKS_PER_BYTE  3     // 115200 baud
+#define SIMENGINE_LOOKAHEAD            PORT_delayTx // from radio_txNow() to the SFD
+#define SIMENGINE_BARRIER_SPINS        1000  // before yielding the CPU
+
+typedef uint64_t simtime_t;
+
+typedef enum {
+   // events of a mote, handled by its worker
+   SIMENGINE_EVT_BOOT             = 0,
+   SIMENGINE_EVT_SCTIMER          = 1,
+   SIMENGINE_EVT_UARTTX           = 2,
+   SIMENGINE_EVT_UARTRX           = 3,
+   SIMENGINE_EVT_STARTOFFRAME     = 4,
+   SIMENGINE_EVT_ENDOFFRAME       = 5,
+   // events of the medium, handled between windows
+   SIMENGINE_EVT_TXSTART          = 6,
+   SIMENGINE_EVT_TXEND            = 7,
+} simengine_evt_t;
+
+//=========================== typedef =========================================
+
+typedef struct {
+   simtime_t            time;
+   uint32_t             seq;                // FIFO order among simultaneous events of a mote
+   uint32_t             arg;                // e.g. the sctimer generation
+   uint16_t             moteId;
+   uint16_t             bootCount;          // boot of the mote the event belongs to
+   uint8_t              type;               // a simengine_evt_t
+} simengine_event_t;
+
+typedef struct {
+   uint16_t             moteId;             // receiving end of the link
+   uint8_t              pdr;                // packet delivery ratio, in percent
+   int8_t               rssi;
+} simengine_link_t;
+
+typedef struct {
+   simengine_event_t*   events;             // binary min-heap
+   uint32_t             len;
+   uint32_t             size;
+} simengine_heap_t;
+
+typedef struct {
+   simengine_link_t*    links;
+   uint16_t             numLinks;
+   uint16_t             maxLinks;
+} simengine_node_t;
+
+/**
+\brief Optional observation hooks, e.g. for a Python front-end.
+
+The motes never wait on a hook: they are called synchronously with the data
+the mote outputs, and may be left NULL. The uartTx hook is called from the
+worker threads, one call at a time.
+*/
+typedef struct {
+   void (*uartTx)(uint16_t moteId, uint8_t* buf, uint16_t len);
+   void (*radioTx)(uint16_t moteId, uint8_t frequency, uint8_t* buf, uint8_t len);
+} simengine_hooks_t;
+
+/**
+\brief A thread running the motes of one partition.
+*/
+typedef struct {
+   simtime_t            now;
+   OpenMote*            current;            // mote running its task context, if any
+   ucontext_t           context;            // the worker's own context
+   simengine_heap_t     heap;               // events of the motes of this worker
+   simengine_heap_t     outbox;             // frames sent during the current window
+   uint32_t             seq;
+   uint32_t             barrierSense;
+   pthread_t            thread;
+   // statistics
+   uint64_t             numEvents;
+   uint64_t             numSwitches;
+} simengine_worker_t;
+
+typedef struct {
+   simtime_t            now;
+   simtime_t            windowEnd;          // end of the window being run
+   OpenMote*            motes;
+   simengine_node_t*    nodes;
+   uint16_t             numMotes;
+   simengine_worker_t*  workers;
+   uint16_t             numWorkers;
+   simengine_heap_t     medium;             // frame starts and ends
+   uint32_t             seq;
+   volatile uint32_t    barrierCount;
+   volatile uint32_t    barrierSense;
+   pthread_mutex_t      hooksLock;
+   uint32_t             randomState;
+   simengine_hooks_t    hooks;
+   // statistics
+   uint64_t             numWindows;
+} simengine_vars_t;
+
+//=========================== variables =======================================
+
+extern simengine_vars_t simengine_vars;
+
+//=========================== prototypes ======================================
+
+// admin
+void       simengine_init(uint16_t numMotes, uint16_t numWorkers, uint32_t seed);
+OpenMote*  simengine_getMote(uint16_t moteId);
+void       simengine_addLink(uint16_t from, uint16_t to, uint8_t pdr, int8_t rssi);
+void       simengine_run(simtime_t until);
+uint64_t   simengine_getNumEvents(void);
+uint64_t   simengine_getNumSwitches(void);
+// from the emulated hardware
+simtime_t  simengine_now(OpenMote* self);
+void       simengine_schedule(OpenMote* self, simtime_t time, uint8_t type, uint32_t arg);
+void       simengine_boot(OpenMote* self);
+void       simengine_sleep(OpenMote* self);
+void       simengine_reset(OpenMote* self);
+void       simengine_uartInput(OpenMote* self, uint8_t* buf, uint16_t len);
+uint8_t    simengine_frameDuration(uint8_t len);
+
+#endif
@@ -0,0 +1,35 @@
+/**
+\brief Emulation of the mote's power supply on the native board.
+*/
+
+#include "supply_obj.h"
+#include "simengine.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void supply_init(OpenMote* self) {
+   // nothing to do
+}
+
+/**
+\brief Power the mote on, it runs mote_main() at the current time.
+*/
+void supply_on(OpenMote* self) {
+   simengine_boot(self);
+}
+
+/**
+\brief Power the mote off, its pending events are dropped.
+*/
+void supply_off(OpenMote* self) {
+   self->board_vars.isOn = FALSE;
+   self->board_vars.bootCount++;
+}
+
+//=========================== interrupt handlers ==============================
@@ -0,0 +1,23 @@
+/**
+\brief Emulation of the mote's power supply on the native board.
+*/
+
+#ifndef __SUPPLY_H
+#define __SUPPLY_H
+
+//=========================== define ==========================================
+
+//=========================== typedef =========================================
+
+//=========================== variables =======================================
+
+#include "openwsnmodule_obj.h"
+typedef struct OpenMote OpenMote;
+
+//=========================== prototypes ======================================
+
+void supply_init(OpenMote* self);
+void supply_on(OpenMote* self);
+void supply_off(OpenMote* self);
+
+#endif
@@ -0,0 +1,110 @@
+/**
+\brief Native definition of the "uart" bsp module.
+
+The bytes written by the mote go to the engine's uartTx hook, if any. Input
+bytes are injected with simengine_uartInput().
+*/
+
+#include "uart_obj.h"
+#include "simengine.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+void uart_output(OpenMote* self, uint8_t* buffer, uint16_t len);
+
+//=========================== callbacks =======================================
+
+void uart_setCallbacks(OpenMote* self, uart_tx_cbt txCb, uart_rx_cbt rxCb) {
+   self->uart_icb.txCb = txCb;
+   self->uart_icb.rxCb = rxCb;
+}
+
+//=========================== public ==========================================
+
+void uart_init(OpenMote* self) {
+   // bytes already on the wire (uart_vars.rxBuf) are kept
+   self->uart_vars.interruptsEnabled = FALSE;
+}
+
+void uart_enableInterrupts(OpenMote* self) {
+   self->uart_vars.interruptsEnabled = TRUE;
+}
+
+void uart_disableInterrupts(OpenMote* self) {
+   self->uart_vars.interruptsEnabled = FALSE;
+}
+
+void uart_clearRxInterrupts(OpenMote* self) {
+}
+
+void uart_clearTxInterrupts(OpenMote* self) {
+}
+
+void uart_writeByte(OpenMote* self, uint8_t byteToWrite) {
+   uart_output(self,&byteToWrite,1);
+   
+   // the TX interrupt fires once the byte is on the wire
+   simengine_schedule(
+      self,
+      simengine_now(self)+SIMENGINE_UART_TICKS_PER_BYTE,
+      SIMENGINE_EVT_UARTTX,
+      0
+   );
+}
+
+void uart_writeCircularBuffer_FASTSIM(OpenMote* self, uint8_t* buffer, uint16_t* outputBufIdxR, uint16_t* outputBufIdxW) {
+   uint16_t idxR;
+   uint16_t idxW;
+   
+   idxR = OUTPUT_BUFFER_MASK & (*outputBufIdxR);
+   idxW = OUTPUT_BUFFER_MASK & (*outputBufIdxW);
+   
+   // the pending bytes are at most two contiguous chunks
+   if (idxW<idxR) {
+      uart_output(self,&buffer[idxR],OUTPUT_BUFFER_MASK+1-idxR);
+      idxR = 0;
+   }
+   uart_output(self,&buffer[idxR],idxW-idxR);
+   
+   *outputBufIdxR = *outputBufIdxW;
+}
+
+void uart_writeBufferByLen_FASTSIM(OpenMote* self, uint8_t* buffer, uint16_t len) {
+   uart_output(self,buffer,len);
+}
+
+uint8_t uart_readByte(OpenMote* self) {
+   return self->uart_vars.rxByte;
+}
+
+void uart_setCTS(OpenMote* self, bool state) {
+   // the engine never sends faster than the mote reads
+}
+
+//=========================== interrupt handlers ==============================
+
+void uart_intr_tx(OpenMote* self) {
+   if (self->uart_icb.txCb!=NULL) {
+      self->uart_icb.txCb(self);
+   }
+}
+
+void uart_intr_rx(OpenMote* self) {
+   if (self->uart_icb.rxCb!=NULL) {
+      self->uart_icb.rxCb(self);
+   }
+}
+
+//=========================== private =========================================
+
+void uart_output(OpenMote* self, uint8_t* buffer, uint16_t len) {
+   if (len>0 && simengine_vars.hooks.uartTx!=NULL) {
+      pthread_mutex_lock(&simengine_vars.hooksLock);
+      simengine_vars.hooks.uartTx(self->board_vars.id,buffer,len);
+      pthread_mutex_unlock(&simengine_vars.hooksLock);
+   }
+}
@@ -50,6 +50,11 @@
 //===== sctimer scheduling
 #define TIMERTHRESHOLD                     10  
 
+//===== software crypto
+
+// use the 32-bit T-table AES implementation of openaes
+#define OPENAES_TTABLE
+
 //=========================== typedef  ========================================
 
 //=========================== variables =======================================
@@ -54,8 +54,16 @@ void board_sleep(OpenMote* self) {
    printf("C@0x%x: board_sleep()... \n",self);
 #endif
    
-   // forward to Python
-   result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_sleep],NULL);
+   // forward to Python, along with the commands queued when batching
+   if (self->bspcmd_vars.enabled==TRUE) {
+      result  = PyObject_CallFunction(
+         self->callback[MOTE_NOTIF_board_sleep],
+         "(N)",
+         bspcmd_drain(self)
+      );
+   } else {
+      result  = PyObject_CallObject(self->callback[MOTE_NOTIF_board_sleep],NULL);
+   }
    if (result == NULL) {
       printf("[CRITICAL] board_sleep() returned NULL\r\n");
       return;
@@ -74,6 +82,10 @@ void board_reset(OpenMote* self) {
    printf("C@0x%x: board_reset()... \n",self);
 #endif
    
+   // commands queued before the reset are void
+   self->bspcmd_vars.numCmds      = 0;
+   self->bspcmd_vars.packetQueued = FALSE;
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_reset],NULL);
    if (result == NULL) {
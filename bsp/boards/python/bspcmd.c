@@ -0,0 +1,218 @@
+/**
+\brief Batched notifications from the C mote to the Python BSP.
+
+Every radio and timer command otherwise crosses into the interpreter on its
+own, building an argument tuple each time; a TSCH slot issues tens of them.
+Once the Python BSP calls set_batching(1), fire-and-forget commands are
+queued here instead, and handed over as a single list:
+- as the return value of the interrupt handlers Python calls, and
+- as the argument of the board_sleep notification.
+
+Each element of the list is a tuple whose first item is the MOTE_NOTIF_*
+identifier of the command, followed by the arguments its callback takes
+otherwise, so the Python BSP can dispatch it to the same handler.
+
+The radio and sctimer calls Python answers synchronously (init, reset,
+radio_getReceivedFrame, sctimer_readCounter) first go through bspcmd_sync(),
+so they observe the effect of the commands queued before them. The other BSP
+notifications (leds, debugpins, uart, eui64) do not touch the radio or timer
+state and are not ordered against the queued commands.
+*/
+
+#include "openwsnmodule_obj.h"
+#include "radio_obj.h"
+#include "sctimer_obj.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+PyObject* bspcmd_packetToList(OpenMote* self);
+
+//=========================== public ==========================================
+
+/**
+\brief Queue a command for the Python BSP.
+
+\returns TRUE if the command was queued, FALSE if batching is off and the
+   caller needs to notify Python right away.
+*/
+bool bspcmd_push(OpenMote* self, uint8_t cmdId, PORT_TIMER_WIDTH arg) {
+   bspcmd_vars_t* vars;
+
+   vars = &self->bspcmd_vars;
+   if (vars->enabled==FALSE) {
+      return FALSE;
+   }
+   if (vars->numCmds==BSPCMD_QUEUESIZE) {
+      bspcmd_flush(self);
+   }
+   vars->cmds[vars->numCmds].cmdId = cmdId;
+   vars->cmds[vars->numCmds].arg   = arg;
+   vars->numCmds++;
+   return TRUE;
+}
+
+/**
+\brief Queue a radio_loadPacket command, along with a copy of the frame.
+*/
+bool bspcmd_loadPacket(OpenMote* self, uint8_t* packet, uint16_t len) {
+   bspcmd_vars_t* vars;
+
+   vars = &self->bspcmd_vars;
+   if (vars->enabled==FALSE) {
+      return FALSE;
+   }
+   if (
+      len>BSPCMD_MAXPACKETLEN            ||
+      vars->packetQueued==TRUE           ||
+      vars->numCmds==BSPCMD_QUEUESIZE
+   ) {
+      // only one frame is kept, hand over what is queued
+      bspcmd_flush(self);
+   }
+   if (len>BSPCMD_MAXPACKETLEN) {
+      return FALSE;
+   }
+   memcpy(vars->packet,packet,len);
+   vars->packetLen    = (uint8_t)len;
+   vars->packetQueued = TRUE;
+   return bspcmd_push(self,MOTE_NOTIF_radio_loadPacket,len);
+}
+
+/**
+\brief Notify Python of the queued commands one by one, through their callbacks.
+
+Used when the queue is full, before Python had a chance to drain it.
+*/
+void bspcmd_flush(OpenMote* self) {
+   bspcmd_vars_t* vars;
+   bspcmd_t*      cmd;
+   uint8_t        i;
+
+   vars          = &self->bspcmd_vars;
+   vars->enabled = FALSE;
+   for (i=0;i<vars->numCmds;i++) {
+      cmd = &vars->cmds[i];
+      switch (cmd->cmdId) {
+         case MOTE_NOTIF_radio_setFrequency:
+            radio_setFrequency(self,(uint8_t)cmd->arg,FREQ_RX);
+            break;
+         case MOTE_NOTIF_radio_rfOn:
+            radio_rfOn(self);
+            break;
+         case MOTE_NOTIF_radio_rfOff:
+            radio_rfOff(self);
+            break;
+         case MOTE_NOTIF_radio_loadPacket:
+            radio_loadPacket(self,vars->packet,vars->packetLen);
+            break;
+         case MOTE_NOTIF_radio_txEnable:
+            radio_txEnable(self);
+            break;
+         case MOTE_NOTIF_radio_txNow:
+            radio_txNow(self);
+            break;
+         case MOTE_NOTIF_radio_rxEnable:
+            radio_rxEnable(self);
+            break;
+         case MOTE_NOTIF_radio_rxNow:
+            radio_rxNow(self);
+            break;
+         case MOTE_NOTIF_sctimer_setCompare:
+            sctimer_setCompare(self,cmd->arg);
+            break;
+         case MOTE_NOTIF_sctimer_enable:
+            sctimer_enable(self);
+            break;
+         case MOTE_NOTIF_sctimer_disable:
+            sctimer_disable(self);
+            break;
+      }
+   }
+   vars->numCmds      = 0;
+   vars->packetQueued = FALSE;
+   vars->enabled      = TRUE;
+}
+
+/**
+\brief Notify Python of the queued commands, if any, before a synchronous call.
+*/
+void bspcmd_sync(OpenMote* self) {
+   if (self->bspcmd_vars.numCmds>0) {
+      bspcmd_flush(self);
+   }
+}
+
+/**
+\brief Hand the queued commands over to Python, and empty the queue.
+
+\returns A new reference to a list of tuples, see the top of this file, or
+   NULL with the Python error set if it could not be built. The queue is
+   left untouched in that case.
+*/
+PyObject* bspcmd_drain(OpenMote* self) {
+   bspcmd_vars_t* vars;
+   bspcmd_t*      cmd;
+   PyObject*      cmds;
+   PyObject*      item;
+   uint8_t        i;
+
+   vars = &self->bspcmd_vars;
+   cmds = PyList_New(vars->numCmds);
+   if (cmds==NULL) {
+      return NULL;
+   }
+   for (i=0;i<vars->numCmds;i++) {
+      cmd = &vars->cmds[i];
+      switch (cmd->cmdId) {
+         case MOTE_NOTIF_radio_setFrequency:
+         case MOTE_NOTIF_sctimer_setCompare:
+            item = Py_BuildValue("(ii)",cmd->cmdId,cmd->arg);
+            break;
+         case MOTE_NOTIF_radio_loadPacket:
+            item = Py_BuildValue("(iN)",cmd->cmdId,bspcmd_packetToList(self));
+            break;
+         default:
+            item = Py_BuildValue("(i)",cmd->cmdId);
+            break;
+      }
+      if (item==NULL) {
+         Py_DECREF(cmds);
+         return NULL;
+      }
+      PyList_SET_ITEM(cmds,i,item);
+   }
+   vars->numCmds      = 0;
+   vars->packetQueued = FALSE;
+   return cmds;
+}
+
+//=========================== private =========================================
+
+/**
+\brief The queued frame, as the list of bytes radio_loadPacket passes.
+
+\returns A new reference, or NULL with the Python error set.
+*/
+PyObject* bspcmd_packetToList(OpenMote* self) {
+   PyObject* pkt;
+   PyObject* byte;
+   uint8_t   i;
+
+   pkt = PyList_New(self->bspcmd_vars.packetLen);
+   if (pkt==NULL) {
+      return NULL;
+   }
+   for (i=0;i<self->bspcmd_vars.packetLen;i++) {
+      byte = PyInt_FromLong(self->bspcmd_vars.packet[i]);
+      if (byte==NULL) {
+         Py_DECREF(pkt);
+         return NULL;
+      }
+      PyList_SET_ITEM(pkt,i,byte);
+   }
+   return pkt;
+}
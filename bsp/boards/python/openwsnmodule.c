@@ -11,6 +11,21 @@
 
 //===== members
 
+//===== helpers
+
+/**
+\brief Return value of the interrupt handlers.
+
+\returns The commands queued for the Python BSP when it batches them, None
+   otherwise.
+*/
+static PyObject* OpenMote_commands(OpenMote* self) {
+   if (self->bspcmd_vars.enabled==TRUE) {
+      return bspcmd_drain(self);
+   }
+   Py_RETURN_NONE;
+}
+
 //===== methods
 
 static PyObject* OpenMote_set_callback(OpenMote* self, PyObject* args) {
@@ -70,6 +85,12 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    PyObject* openserial_vars;
    PyObject* scheduler_vars;
    PyObject* scheduler_dbg;
+#ifdef IEEE802154E_PROFILE_ENABLED
+   PyObject* ieee154e_profile;
+   PyObject* histogram;
+   uint8_t   i;
+   uint8_t   j;
+#endif
    
    returnVal = PyDict_New();
    
@@ -148,6 +169,24 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    // ieee154e_dbg
    ieee154e_dbg = PyDict_New();
    // TODO
+#ifdef IEEE802154E_PROFILE_ENABLED
+   // one entry per activity, indexed by ieee154e_activity_t
+   ieee154e_profile = PyList_New(ACTIVITY_MAX);
+   for (i=0;i<ACTIVITY_MAX;i++) {
+      histogram = PyList_New(PROFILE_NUMBINS);
+      for (j=0;j<PROFILE_NUMBINS;j++) {
+         PyList_SET_ITEM(histogram, j, PyInt_FromLong(self->ieee154e_dbg.profile[i].histogram[j]));
+      }
+      PyList_SET_ITEM(ieee154e_profile, i, Py_BuildValue(
+         "{s:i,s:i,s:i,s:N}",
+         "count",       self->ieee154e_dbg.profile[i].count,
+         "minDuration", self->ieee154e_dbg.profile[i].minDuration,
+         "maxDuration", self->ieee154e_dbg.profile[i].maxDuration,
+         "histogram",   histogram
+      ));
+   }
+   PyDict_SetItemString(ieee154e_dbg, "profile", ieee154e_profile);
+#endif
    PyDict_SetItemString(returnVal, "ieee154e_dbg", ieee154e_dbg);
    
    // idmanager_vars
@@ -188,6 +227,33 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    return returnVal;
 }
 
+static PyObject* OpenMote_set_batching(OpenMote* self, PyObject* args) {
+   int enabled;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "i:set_batching", &enabled)) {
+      return NULL;
+   }
+   
+   if (enabled) {
+      self->bspcmd_vars.enabled = TRUE;
+   } else if (self->bspcmd_vars.enabled==TRUE) {
+      // hand over what is still queued, through the callbacks
+      bspcmd_flush(self);
+      self->bspcmd_vars.enabled = FALSE;
+   }
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
+static PyObject* OpenMote_get_commands(OpenMote* self) {
+   
+   // no arguments
+   
+   return bspcmd_drain(self);
+}
+
 static PyObject* OpenMote_radio_isr_startFrame(OpenMote* self, PyObject* args) {
    int capturedTime;
    
@@ -207,8 +273,8 @@ static PyObject* OpenMote_radio_isr_startFrame(OpenMote* self, PyObject* args) {
       (uint32_t)capturedTime
    );
    
-   // return successfully
-   Py_RETURN_NONE;
+   // return successfully, with the commands queued meanwhile
+   return OpenMote_commands(self);
 }
 
 static PyObject* OpenMote_radio_isr_endFrame(OpenMote* self, PyObject* args) {
@@ -230,8 +296,8 @@ static PyObject* OpenMote_radio_isr_endFrame(OpenMote* self, PyObject* args) {
       (uint32_t)capturedTime
    );
    
-   // return successfully
-   Py_RETURN_NONE;
+   // return successfully, with the commands queued meanwhile
+   return OpenMote_commands(self);
 }
 
 static PyObject* OpenMote_sctimer_isr(OpenMote* self) {
@@ -241,8 +307,54 @@ static PyObject* OpenMote_sctimer_isr(OpenMote* self) {
    // call the callback
    sctimer_intr_compare(self);
    
-   // return successfully
-   Py_RETURN_NONE;
+   // return successfully, with the commands queued meanwhile
+   return OpenMote_commands(self);
+}
+
+static PyObject* OpenMote_isr_bulk(OpenMote* self, PyObject* args) {
+   PyObject*  isrs;
+   PyObject*  seq;
+   PyObject*  item;
+   Py_ssize_t i;
+   int        isrId;
+   long       capturedTime;
+   
+   // parse the arguments
+   if (!PyArg_ParseTuple(args, "O:isr_bulk", &isrs)) {
+      return NULL;
+   }
+   seq = PySequence_Fast(isrs,"isr_bulk expects a sequence of (isrId,capturedTime)");
+   if (seq==NULL) {
+      return NULL;
+   }
+   
+   // call the callbacks, in order
+   for (i=0;i<PySequence_Fast_GET_SIZE(seq);i++) {
+      item = PySequence_Fast_GET_ITEM(seq,i);
+      if (!PyArg_ParseTuple(item, "il", &isrId, &capturedTime)) {
+         Py_DECREF(seq);
+         return NULL;
+      }
+      switch (isrId) {
+         case MOTE_ISR_radio_startFrame:
+            radio_intr_startOfFrame(self,(uint32_t)capturedTime);
+            break;
+         case MOTE_ISR_radio_endFrame:
+            radio_intr_endOfFrame(self,(uint32_t)capturedTime);
+            break;
+         case MOTE_ISR_sctimer_compare:
+            sctimer_intr_compare(self);
+            break;
+         default:
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "wrong isrId");
+            return NULL;
+      }
+   }
+   Py_DECREF(seq);
+   
+   // return successfully, with the commands queued meanwhile
+   return OpenMote_commands(self);
 }
 
 static PyObject* OpenMote_uart_isr_tx(OpenMote* self) {
@@ -252,8 +364,8 @@ static PyObject* OpenMote_uart_isr_tx(OpenMote* self) {
    // call the callback
    uart_intr_tx(self);
    
-   // return successfully
-   Py_RETURN_NONE;
+   // return successfully, with the commands queued meanwhile
+   return OpenMote_commands(self);
 }
 
 static PyObject* OpenMote_uart_isr_rx(OpenMote* self) {
@@ -263,8 +375,8 @@ static PyObject* OpenMote_uart_isr_rx(OpenMote* self) {
    // call the callback
    uart_intr_rx(self);
    
-   // return successfully
-   Py_RETURN_NONE;
+   // return successfully, with the commands queued meanwhile
+   return OpenMote_commands(self);
 }
 
 static PyObject* OpenMote_supply_on(OpenMote* self) {
@@ -299,10 +411,13 @@ static PyMethodDef OpenMote_methods[] = {
    //=== admin
    {  "set_callback",             (PyCFunction)OpenMote_set_callback,               METH_VARARGS,  ""},
    {  "getState",                 (PyCFunction)OpenMote_getState,                   METH_NOARGS,   ""},
+   {  "set_batching",             (PyCFunction)OpenMote_set_batching,               METH_VARARGS,  ""},
+   {  "get_commands",             (PyCFunction)OpenMote_get_commands,               METH_NOARGS,   ""},
    //=== BSP
    {  "radio_isr_startFrame",     (PyCFunction)OpenMote_radio_isr_startFrame,       METH_VARARGS,  ""},
    {  "radio_isr_endFrame",       (PyCFunction)OpenMote_radio_isr_endFrame,         METH_VARARGS,  ""},
    {  "sctimer_isr",              (PyCFunction)OpenMote_sctimer_isr,                METH_NOARGS,   ""},
+   {  "isr_bulk",                 (PyCFunction)OpenMote_isr_bulk,                   METH_VARARGS,  ""},
    {  "uart_isr_tx",              (PyCFunction)OpenMote_uart_isr_tx,                METH_NOARGS,   ""},
    {  "uart_isr_rx",              (PyCFunction)OpenMote_uart_isr_rx,                METH_NOARGS,   ""},
    {  "supply_on",                (PyCFunction)OpenMote_supply_on,                  METH_NOARGS,   ""},
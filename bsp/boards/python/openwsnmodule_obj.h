@@ -31,6 +31,7 @@
 #include "openqueue_obj.h"
 #include "openrandom_obj.h"
 #include "frag_obj.h"
+#include "openaes_obj.h"
 // applications
 #include "c6t_obj.h"
 #include "cexample_obj.h"
@@ -41,6 +42,8 @@
 #include "cwellknown_obj.h"
 #include "rrt_obj.h"
 #include "uecho_obj.h"
+#include "uexpiration_obj.h"
+#include "uexpiration_monitor_obj.h"
 #include "uinject_obj.h"
 #include "userialbridge_obj.h"
 
@@ -62,6 +65,13 @@ void uart_writeBufferByLen_FASTSIM(OpenMote* self, uint8_t* buffer, uint16_t len
 void supply_on(OpenMote* self);
 void supply_off(OpenMote* self);
 
+// bspcmd
+bool      bspcmd_push(OpenMote* self, uint8_t cmdId, PORT_TIMER_WIDTH arg);
+bool      bspcmd_loadPacket(OpenMote* self, uint8_t* packet, uint16_t len);
+void      bspcmd_flush(OpenMote* self);
+void      bspcmd_sync(OpenMote* self);
+PyObject* bspcmd_drain(OpenMote* self);
+
 //=========================== enums ===========================================
 
 // notifications sent from the C mote to the Python BSP
@@ -158,6 +168,18 @@ enum {
    MOTE_NOTIF_LAST
 };
 
+// interrupts the Python BSP feeds back in bulk, see OpenMote_isr_bulk()
+enum {
+   MOTE_ISR_radio_startFrame = 0,
+   MOTE_ISR_radio_endFrame,
+   MOTE_ISR_sctimer_compare,
+};
+
+//=========================== defines =========================================
+
+#define BSPCMD_QUEUESIZE          16
+#define BSPCMD_MAXPACKETLEN       128
+
 //=========================== typedef =========================================
 
 typedef void    (*uart_tx_cbt)(OpenMote* self);
@@ -181,6 +203,26 @@ typedef struct {
    sctimer_cbt      compare_cb;
 } sctimer_icb_t;
 
+typedef struct {
+   uint8_t          cmdId;                  // a MOTE_NOTIF_* identifier
+   PORT_TIMER_WIDTH arg;                    // e.g. frequency or compare value
+} bspcmd_t;
+
+/**
+\brief Notifications queued for the Python BSP while batching is on.
+
+Instead of calling into Python for every radio and timer command, the mote
+queues them and the Python BSP drains the queue when it gets control back.
+*/
+typedef struct {
+   bool             enabled;
+   bspcmd_t         cmds[BSPCMD_QUEUESIZE];
+   uint8_t          numCmds;
+   uint8_t          packet[BSPCMD_MAXPACKETLEN]; // of the queued radio_loadPacket
+   uint8_t          packetLen;
+   bool             packetQueued;
+} bspcmd_vars_t;
+
 
 //=========================== struct ==========================================
 
@@ -195,6 +237,8 @@ struct OpenMote {
    uart_icb_t           uart_icb;
    sctimer_icb_t        sctimer_icb;
    radio_icb_t          radio_icb;
+   //===== batched notifications to Python
+   bspcmd_vars_t        bspcmd_vars;
    //===== openstack
    // l4
    icmpv6echo_vars_t    icmpv6echo_vars;
@@ -202,6 +246,7 @@ struct OpenMote {
    openudp_vars_t       openudp_vars;
    // l3
    monitor_expiration_vars_t        monitor_expiration_vars;
+   iphc_vars_t          iphc_vars;
    frag_vars_t          frag_vars;
    // l2b
    sixtop_vars_t        sixtop_vars;
@@ -224,6 +269,8 @@ struct OpenMote {
    // kernel
    scheduler_vars_t     scheduler_vars;
    scheduler_dbg_t      scheduler_dbg;
+   // bsp
+   openaes_vars_t       openaes_vars;
    //===== openapps
    //
    opencoap_vars_t      opencoap_vars;
@@ -237,6 +284,8 @@ struct OpenMote {
    rrt_vars_t           rrt_vars;
    cjoin_vars_t         cjoin_vars;
    uecho_vars_t         uecho_vars;
+   uexpiration_vars_t   uexpiration_vars;
+   umonitor_vars_t      umonitor_vars;
    uinject_vars_t       uinject_vars;
    userialbridge_vars_t userialbridge_vars;
 };
@@ -50,6 +50,9 @@ void radio_init(OpenMote* self) {
    printf("C@0x%x: radio_init()... \n",self);
 #endif
    
+   // hand over the queued commands first, Python answers this call right away
+   bspcmd_sync(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_init],NULL);
    if (result == NULL) {
@@ -72,6 +75,9 @@ void radio_reset(OpenMote* self) {
    printf("C@0x%x: radio_reset()... \n",self);
 #endif
    
+   // hand over the queued commands first, Python answers this call right away
+   bspcmd_sync(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_reset],NULL);
    if (result == NULL) {
@@ -95,6 +101,11 @@ void radio_setFrequency(OpenMote* self, uint8_t frequency, radio_freq_t tx_or_rx
    printf("C@0x%x: radio_setFrequency(frequency=%d)... \n",self,frequency);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_radio_setFrequency,frequency)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",frequency);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_setFrequency],arglist);
@@ -117,6 +128,11 @@ void radio_rfOn(OpenMote* self) {
    printf("C@0x%x: radio_rfOn()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_radio_rfOn,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOn],NULL);
    if (result == NULL) {
@@ -137,6 +153,11 @@ void radio_rfOff(OpenMote* self) {
    printf("C@0x%x: radio_rfOff()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_radio_rfOff,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOff],NULL);
    if (result == NULL) {
@@ -164,6 +185,11 @@ void radio_loadPacket(OpenMote* self, uint8_t* packet, uint16_t len) {
    printf("C@0x%x: radio_loadPacket(len=%d)... \n",self,len);
 #endif
    
+   // queued when batching
+   if (bspcmd_loadPacket(self,packet,len)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    pkt        = PyList_New(len);
    for (i=0;i<len;i++) {
@@ -192,6 +218,11 @@ void radio_txEnable(OpenMote* self) {
    printf("C@0x%x: radio_txEnable()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_radio_txEnable,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txEnable],NULL);
    if (result == NULL) {
@@ -212,6 +243,11 @@ void radio_txNow(OpenMote* self) {
    printf("C@0x%x: radio_txNow()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_radio_txNow,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txNow],NULL);
    if (result == NULL) {
@@ -234,6 +270,11 @@ void radio_rxEnable(OpenMote* self) {
    printf("C@0x%x: radio_rxEnable()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_radio_rxEnable,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxEnable],NULL);
    if (result == NULL) {
@@ -254,6 +295,11 @@ void radio_rxNow(OpenMote* self) {
    printf("C@0x%x: radio_rxNow()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_radio_rxNow,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxNow],NULL);
    if (result == NULL) {
@@ -284,6 +330,9 @@ void radio_getReceivedFrame(OpenMote* self,
    printf("C@0x%x: radio_getReceivedFrame()... \n",self);
 #endif
    
+   // hand over the queued commands first, Python answers this call right away
+   bspcmd_sync(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getReceivedFrame],NULL);
    if (result == NULL) {
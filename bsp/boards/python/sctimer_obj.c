@@ -36,6 +36,9 @@ void sctimer_init(OpenMote* self) {
    printf("C@0x%x: sctimer_init()... \n",self,self);
 #endif
    
+   // hand over the queued commands first, Python answers this call right away
+   bspcmd_sync(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_init],NULL);
    if (result == NULL) {
@@ -59,6 +62,9 @@ PORT_RADIOTIMER_WIDTH sctimer_readCounter(OpenMote* self) {
    printf("C@0x%x: sctimer_readCounter()... \n",self);
 #endif
    
+   // hand over the queued commands first, Python answers this call right away
+   bspcmd_sync(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_readCounter],NULL);
    if (result == NULL) {
@@ -85,6 +91,11 @@ void sctimer_setCompare(OpenMote* self, PORT_RADIOTIMER_WIDTH value) {
    printf("C@0x%x: sctimer_setCompare(value=%d)... \n",self,value);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_sctimer_setCompare,value)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",value);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_setCompare],arglist);
@@ -107,6 +118,11 @@ void sctimer_enable(OpenMote* self) {
    printf("C@0x%x: sctimer_enable()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_sctimer_enable,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_enable],NULL);
    if (result == NULL) {
@@ -127,6 +143,11 @@ void sctimer_disable(OpenMote* self) {
    printf("C@0x%x: sctimer_disable()... \n",self);
 #endif
    
+   // queued when batching
+   if (bspcmd_push(self,MOTE_NOTIF_sctimer_disable,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_disable],NULL);
    if (result == NULL) {
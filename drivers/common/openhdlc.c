@@ -17,4 +17,14 @@ uint16_t crcIteration(uint16_t crc, uint8_t byte) {
    return (crc >> 8) ^ fcstab[(crc ^ byte) & 0xff];
 }
 
+/**
+\brief Run the CRC calculator over a whole buffer.
+*/
+uint16_t crcIterationBuffer(uint16_t crc, uint8_t* buffer, uint16_t len) {
+   while (len--) {
+      crc = (crc >> 8) ^ fcstab[(crc ^ *buffer++) & 0xff];
+   }
+   return crc;
+}
+
 //=========================== private =========================================
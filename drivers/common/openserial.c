@@ -27,6 +27,7 @@
 #include "icmpv6rpl.h"
 #include "icmpv6echo.h"
 #include "msf.h"
+#include "iphc.h"
 #include "debugpins.h"
 
 //=========================== variables =======================================
@@ -39,6 +40,7 @@ enum{
 };
 
 #define DEBUGPRINT_PERIOD 100 // in ms
+#define OUTPUT_HDLC_CHUNK  16  // bytes encoded by outputHdlcWriteBuffer() per critical section
 
 //=========================== prototypes ======================================
 
@@ -61,10 +63,14 @@ void openserial_handleCommands(void);
 // misc
 void openserial_debugPrint_timer_cb(opentimers_id_t id);
 void openserial_board_reset_cb(opentimers_id_t id);
+#ifdef OPENSERIAL_STATUS_DELTA
+bool openserial_statusChanged(uint8_t statusElement, uint8_t* buffer, uint8_t length);
+#endif
 
 // HDLC output
 void outputHdlcOpen(void);
 void outputHdlcWrite(uint8_t b);
+void outputHdlcWriteBuffer(uint8_t* buffer, uint8_t length);
 void outputHdlcClose(void);
 
 // HDLC input
@@ -129,16 +135,23 @@ owerror_t openserial_printStatus(
     uint8_t*            buffer,
     uint8_t             length
 ) {
-    uint8_t i;
+    uint8_t header[4];
 
-    outputHdlcOpen();
-    outputHdlcWrite(SERFRAME_MOTE2PC_STATUS);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-    outputHdlcWrite(statusElement);
-    for (i=0;i<length;i++){
-        outputHdlcWrite(buffer[i]);
+#ifdef OPENSERIAL_STATUS_DELTA
+    if (openserial_statusChanged(statusElement,buffer,length)==FALSE) {
+        // the PC already has this one
+        return E_SUCCESS;
     }
+#endif
+
+    header[0] = SERFRAME_MOTE2PC_STATUS;
+    header[1] = idmanager_getMyID(ADDR_16B)->addr_16b[0];
+    header[2] = idmanager_getMyID(ADDR_16B)->addr_16b[1];
+    header[3] = statusElement;
+
+    outputHdlcOpen();
+    outputHdlcWriteBuffer(header,sizeof(header));
+    outputHdlcWriteBuffer(buffer,length);
     outputHdlcClose();
 
     // start TX'ing
@@ -217,24 +230,17 @@ owerror_t openserial_printCritical(
 }
 
 owerror_t openserial_printData(uint8_t* buffer, uint8_t length) {
-    uint8_t  i;
-    uint8_t  asn[5];
+    uint8_t  header[1+2+5];
 
+    header[0] = SERFRAME_MOTE2PC_DATA;
+    header[1] = idmanager_getMyID(ADDR_16B)->addr_16b[0];
+    header[2] = idmanager_getMyID(ADDR_16B)->addr_16b[1];
     // retrieve ASN
-    ieee154e_getAsn(asn);
+    ieee154e_getAsn(&header[3]);
 
     outputHdlcOpen();
-    outputHdlcWrite(SERFRAME_MOTE2PC_DATA);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-    outputHdlcWrite(asn[0]);
-    outputHdlcWrite(asn[1]);
-    outputHdlcWrite(asn[2]);
-    outputHdlcWrite(asn[3]);
-    outputHdlcWrite(asn[4]);
-    for (i=0;i<length;i++){
-        outputHdlcWrite(buffer[i]);
-    }
+    outputHdlcWriteBuffer(header,sizeof(header));
+    outputHdlcWriteBuffer(buffer,length);
     outputHdlcClose();
 
     // start TX'ing
@@ -244,15 +250,15 @@ owerror_t openserial_printData(uint8_t* buffer, uint8_t length) {
 }
 
 owerror_t openserial_printSniffedPacket(uint8_t* buffer, uint8_t length, uint8_t channel) {
-    uint8_t  i;
+    uint8_t  header[3];
+
+    header[0] = SERFRAME_MOTE2PC_SNIFFED_PACKET;
+    header[1] = idmanager_getMyID(ADDR_16B)->addr_16b[0];
+    header[2] = idmanager_getMyID(ADDR_16B)->addr_16b[1];
 
     outputHdlcOpen();
-    outputHdlcWrite(SERFRAME_MOTE2PC_SNIFFED_PACKET);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-    for (i=0;i<length;i++){
-       outputHdlcWrite(buffer[i]);
-    }
+    outputHdlcWriteBuffer(header,sizeof(header));
+    outputHdlcWriteBuffer(buffer,length);
     outputHdlcWrite(channel);
     outputHdlcClose();
 
@@ -264,16 +270,13 @@ owerror_t openserial_printSniffedPacket(uint8_t* buffer, uint8_t length, uint8_t
 
 owerror_t openserial_print_uint32_t(uint32_t value) {
 #ifdef OPENSERIAL_PRINTF
-    uint8_t  i;
     uint8_t  pvalue[4];
 
     outputHdlcOpen();
     outputHdlcWrite(SERFRAME_MOTE2PC_PRINTF);
     outputHdlcWrite(TYPE_INT);
     memcpy(pvalue, &value, 4);
-    for (i=0;i<4;i++) {
-        outputHdlcWrite(pvalue[i]);
-    }
+    outputHdlcWriteBuffer(pvalue,sizeof(pvalue));
     outputHdlcClose();
 
     // start TX'ing
@@ -284,23 +287,18 @@ owerror_t openserial_print_uint32_t(uint32_t value) {
 
 owerror_t openserial_print_str(char* buffer, uint8_t length) {
 #ifdef OPENSERIAL_PRINTF
-    uint8_t  i;
-    uint8_t  asn[5];
+    uint8_t  header[1+1+2+5];
 
+    header[0] = SERFRAME_MOTE2PC_PRINTF;
+    header[1] = TYPE_STR;
+    header[2] = idmanager_getMyID(ADDR_16B)->addr_16b[0];
+    header[3] = idmanager_getMyID(ADDR_16B)->addr_16b[1];
     // retrieve ASN
-    ieee154e_getAsn(asn);
+    ieee154e_getAsn(&header[4]);
 
     outputHdlcOpen();
-    outputHdlcWrite(SERFRAME_MOTE2PC_PRINTF);
-    outputHdlcWrite(TYPE_STR);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-    for(i=0; i<5;i++) {
-        outputHdlcWrite(asn[i]);
-    }
-    for (i=0;i<length;i++){
-        outputHdlcWrite(buffer[i]);
-    }
+    outputHdlcWriteBuffer(header,sizeof(header));
+    outputHdlcWriteBuffer((uint8_t*)buffer,length);
     outputHdlcClose();
 
     // start TX'ing
@@ -325,6 +323,15 @@ void task_openserial_debugPrint(void) {
         return;
     }
 
+#ifdef OPENSERIAL_STATUS_DELTA
+    openserial_vars.statusResyncCounter++;
+    if (openserial_vars.statusResyncCounter==OPENSERIAL_STATUS_RESYNC_PERIOD) {
+        // forget what was printed, the next rounds are a full snapshot
+        memset(openserial_vars.statusHash,0,sizeof(openserial_vars.statusHash));
+        openserial_vars.statusResyncCounter = 0;
+    }
+#endif
+
     debugPrintCounter++;
     if (debugPrintCounter==STATUS_MAX) {
        debugPrintCounter = 0;
@@ -379,6 +386,10 @@ void task_openserial_debugPrint(void) {
             if (debugPrint_joined()==TRUE) {
                 break;
             }
+        case STATUS_MACPROFILE:
+            if (debugPrint_macProfile()==TRUE) {
+                break;
+            }
         default:
             debugPrintCounter=0;
     }
@@ -554,17 +565,20 @@ owerror_t openserial_printInfoErrorCritical(
     errorparameter_t arg1,
     errorparameter_t arg2
 ) {
+    uint8_t  frame[9];
+
+    frame[0] = severity;
+    frame[1] = idmanager_getMyID(ADDR_16B)->addr_16b[0];
+    frame[2] = idmanager_getMyID(ADDR_16B)->addr_16b[1];
+    frame[3] = calling_component;
+    frame[4] = error_code;
+    frame[5] = (uint8_t)((arg1 & 0xff00)>>8);
+    frame[6] = (uint8_t) (arg1 & 0x00ff);
+    frame[7] = (uint8_t)((arg2 & 0xff00)>>8);
+    frame[8] = (uint8_t) (arg2 & 0x00ff);
 
     outputHdlcOpen();
-    outputHdlcWrite(severity);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-    outputHdlcWrite(calling_component);
-    outputHdlcWrite(error_code);
-    outputHdlcWrite((uint8_t)((arg1 & 0xff00)>>8));
-    outputHdlcWrite((uint8_t) (arg1 & 0x00ff));
-    outputHdlcWrite((uint8_t)((arg2 & 0xff00)>>8));
-    outputHdlcWrite((uint8_t) (arg2 & 0x00ff));
+    outputHdlcWriteBuffer(frame,sizeof(frame));
     outputHdlcClose();
 
     // start TX'ing
@@ -729,6 +743,7 @@ void openserial_handleCommands(void){
 
     open_addr_t neighbor;
     bool        foundNeighbor;
+    open_addr_t prefix;
 
     ptr = 0;
     memset(celllist_add,0,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
@@ -850,6 +865,20 @@ void openserial_handleCommands(void){
             if (commandLen != 16) { break; }
             idmanager_setJoinKey(&openserial_vars.inputBuf[ptr]);
             break;
+        case COMMAND_SET_CONTEXT:
+            // flags and CID as in a 6CO option, then the 64-bit prefix, or nothing to remove it
+            comandParam_8 = openserial_vars.inputBuf[ptr];
+            ptr++;
+            if (commandLen == 1) {
+                iphc_setContext(comandParam_8 & IPHC_CONTEXT_ID_MASK, NULL, FALSE);
+                break;
+            }
+            if (commandLen != 9) { break; }
+            memset(&prefix, 0, sizeof(open_addr_t));
+            prefix.type = ADDR_PREFIX;
+            memcpy(prefix.prefix, &openserial_vars.inputBuf[ptr], sizeof(prefix.prefix));
+            iphc_setContext(comandParam_8 & IPHC_CONTEXT_ID_MASK, &prefix, (comandParam_8 & RPL_6CO_C_FLAG) != 0);
+            break;
         default:
             // wrong command ID
             break;
@@ -869,6 +898,54 @@ void openserial_board_reset_cb(opentimers_id_t id) {
     board_reset();
 }
 
+#ifdef OPENSERIAL_STATUS_DELTA
+/**
+\brief Record the status about to be printed, telling whether it changed.
+
+Singleton status elements are tracked one slot each, the schedule and neighbor
+ones one slot per row (their first byte).
+
+\returns TRUE if it differs from the last one printed for that element and row,
+   FALSE otherwise.
+*/
+bool openserial_statusChanged(uint8_t statusElement, uint8_t* buffer, uint8_t length) {
+    uint16_t hash;
+    uint8_t  idx;
+    uint8_t  i;
+
+    // find the slot of that element and row
+    if (statusElement>=STATUS_MAX) {
+        return TRUE;
+    }
+    idx = statusElement;
+    if (statusElement==STATUS_SCHEDULE || statusElement==STATUS_NEIGHBORS) {
+        if (buffer[0]>=OPENSERIAL_STATUS_MAXROWS) {
+            // not tracked
+            return TRUE;
+        }
+        idx = STATUS_MAX+buffer[0];
+        if (statusElement==STATUS_NEIGHBORS) {
+            idx += OPENSERIAL_STATUS_MAXROWS;
+        }
+    }
+
+    hash = HDLC_CRCINIT;
+    for (i=0;i<length;i++) {
+        hash = crcIteration(hash,buffer[i]);
+    }
+    if (hash==0) {
+        // 0 stands for "never printed"
+        hash = 1;
+    }
+
+    if (openserial_vars.statusHash[idx]==hash) {
+        return FALSE;
+    }
+    openserial_vars.statusHash[idx] = hash;
+    return TRUE;
+}
+#endif
+
 //===== hdlc (output)
 
 /**
@@ -913,10 +990,51 @@ port_INLINE void outputHdlcWrite(uint8_t b) {
     //>>>>>>>>>>>>>>>>>>>>>>>
 }
 /**
+\brief Add a buffer to the outgoing HDLC frame being built.
+
+Same as calling outputHdlcWrite() on each byte, but escapes and runs the CRC
+in a single pass, with the buffer index and CRC kept in locals. Interrupts are
+disabled once every OUTPUT_HDLC_CHUNK bytes, so that encoding a long frame does
+not hold off the slot timer.
+*/
+port_INLINE void outputHdlcWriteBuffer(uint8_t* buffer, uint8_t length) {
+    uint16_t   idxW;
+    uint16_t   crc;
+    uint8_t    chunk;
+    uint8_t    b;
+    INTERRUPT_DECLARATION();
+
+    while (length>0) {
+        chunk   = (length>OUTPUT_HDLC_CHUNK) ? OUTPUT_HDLC_CHUNK : length;
+        length -= chunk;
+
+        //<<<<<<<<<<<<<<<<<<<<<<<
+        DISABLE_INTERRUPTS();
+
+        idxW = openserial_vars.outputBufIdxW;
+        crc  = openserial_vars.hdlcOutputCrc;
+        while (chunk--) {
+            b    = *buffer++;
+            crc  = (crc >> 8) ^ fcstab[(crc ^ b) & 0xff];
+            if (b==HDLC_FLAG || b==HDLC_ESCAPE) {
+                openserial_vars.outputBuf[OUTPUT_BUFFER_MASK & (idxW++)]  = HDLC_ESCAPE;
+                b                                                          = b^HDLC_ESCAPE_MASK;
+            }
+            openserial_vars.outputBuf[OUTPUT_BUFFER_MASK & (idxW++)]      = b;
+        }
+        openserial_vars.outputBufIdxW = idxW;
+        openserial_vars.hdlcOutputCrc = crc;
+
+        ENABLE_INTERRUPTS();
+        //>>>>>>>>>>>>>>>>>>>>>>>
+    }
+}
+/**
 \brief Finalize the outgoing HDLC frame.
 */
 port_INLINE void outputHdlcClose(void) {
     uint16_t   finalCrc;
+    uint8_t    crc[2];
     INTERRUPT_DECLARATION();
 
     //<<<<<<<<<<<<<<<<<<<<<<<
@@ -926,8 +1044,9 @@ port_INLINE void outputHdlcClose(void) {
     finalCrc   = ~openserial_vars.hdlcOutputCrc;
 
     // write the CRC value
-    outputHdlcWrite((finalCrc>>0)&0xff);
-    outputHdlcWrite((finalCrc>>8)&0xff);
+    crc[0]     = (finalCrc>>0)&0xff;
+    crc[1]     = (finalCrc>>8)&0xff;
+    outputHdlcWriteBuffer(crc,sizeof(crc));
 
     // write the closing HDLC flag
     openserial_vars.outputBuf[OUTPUT_BUFFER_MASK & (openserial_vars.outputBufIdxW++)]       = HDLC_FLAG;
@@ -944,9 +1063,6 @@ port_INLINE void outputHdlcClose(void) {
 port_INLINE void inputHdlcOpen(void) {
     // reset the input buffer index
     openserial_vars.inputBufFillLevel                                = 0;
-
-    // initialize the value of the CRC
-    openserial_vars.hdlcInputCrc                                     = HDLC_CRCINIT;
 }
 /**
 \brief Add a byte to the incoming HDLC frame.
@@ -960,12 +1076,9 @@ port_INLINE void inputHdlcWrite(uint8_t b) {
             openserial_vars.hdlcInputEscaping = FALSE;
         }
 
-        // add byte to input buffer
+        // add byte to input buffer, the CRC is checked over the whole frame
         openserial_vars.inputBuf[openserial_vars.inputBufFillLevel] = b;
         openserial_vars.inputBufFillLevel++;
-
-        // iterate through CRC calculator
-        openserial_vars.hdlcInputCrc = crcIteration(openserial_vars.hdlcInputCrc,b);
     }
 }
 /**
@@ -974,7 +1087,13 @@ port_INLINE void inputHdlcWrite(uint8_t b) {
 port_INLINE void inputHdlcClose(void) {
 
     // verify the validity of the frame
-    if (openserial_vars.hdlcInputCrc==HDLC_CRCGOOD) {
+    if (
+        crcIterationBuffer(
+            HDLC_CRCINIT,
+            openserial_vars.inputBuf,
+            openserial_vars.inputBufFillLevel
+        )==HDLC_CRCGOOD
+    ) {
         // the CRC is correct
 
         // remove the CRC from the input buffer
@@ -40,6 +40,19 @@
 */
 #define SERIAL_INPUT_BUFFER_SIZE  200
 
+/**
+\brief Rows of the schedule and neighbor status tracked in delta mode.
+
+Rows past this are printed every time.
+*/
+#define OPENSERIAL_STATUS_MAXROWS         32
+#define OPENSERIAL_STATUS_NUMHASHES       (STATUS_MAX+2*OPENSERIAL_STATUS_MAXROWS)
+/**
+\brief Number of debugPrint rounds between two full status snapshots, in delta
+       mode.
+*/
+#define OPENSERIAL_STATUS_RESYNC_PERIOD   300 // 30s at DEBUGPRINT_PERIOD=100ms
+
 // frames sent mote->PC
 #define SERFRAME_MOTE2PC_DATA                    ((uint8_t)'D')
 #define SERFRAME_MOTE2PC_STATUS                  ((uint8_t)'S')
@@ -80,7 +93,8 @@ enum {
     COMMAND_SET_UINJECTPERIOD     = 17,
     COMMAND_SET_ECHO_REPLY_STATUS = 18,
     COMMAND_SET_JOIN_KEY          = 19,
-    COMMAND_MAX                   = 20,
+    COMMAND_SET_CONTEXT           = 20,
+    COMMAND_MAX                   = 21,
 };
 
 //=========================== variables =======================================
@@ -101,14 +115,17 @@ typedef struct {
     uint8_t             ctsStateChanged;
     uint8_t             debugPrintCounter;
     openserial_rsvpt*   registeredCmd;
-    uint8_t             reset_timerId;
-    uint8_t             debugPrint_timerId;
+    uint16_t            reset_timerId;       // wide enough for any opentimers_id_t
+    uint16_t            debugPrint_timerId;
+#ifdef OPENSERIAL_STATUS_DELTA
+    uint16_t            statusHash[OPENSERIAL_STATUS_NUMHASHES]; ///< hash of the last status printed, 0 if none
+    uint16_t            statusResyncCounter;
+#endif
     // input
     uint8_t             inputBuf[SERIAL_INPUT_BUFFER_SIZE];
     uint8_t             inputBufFillLevel;
     uint8_t             hdlcLastRxByte;
     bool                hdlcBusyReceiving;
-    uint16_t            hdlcInputCrc;
     bool                hdlcInputEscaping;
     // output
     uint8_t             outputBuf[SERIAL_OUTPUT_BUFFER_SIZE];
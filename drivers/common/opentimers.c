@@ -4,6 +4,13 @@
 This driver uses a single hardware timer, which it virtualizes to support
 at most MAX_NUM_TIMERS timers.
 
+The running timers are kept in a binary min-heap, ordered by the number of
+ticks between lastCompareValue and their compare value. Because all running
+timers expire after lastCompareValue, this order is not affected by the
+timer counter wrapping around. Scheduling, cancelling and firing a timer
+hence takes O(log MAX_NUM_TIMERS), and the next timer to fire is always at
+the root of the heap.
+
 \author Tengfei Chang <tengfei.chang@inria.fr>, April 2017.
  */
 
@@ -24,6 +31,15 @@ opentimers_vars_t opentimers_vars;
 //=========================== prototypes ======================================
 
 void  opentimers_timer_callback(void);
+// heap of running timers
+void  opentimers_heapInsert(opentimers_id_t id);
+void  opentimers_heapRemove(opentimers_id_t id);
+void  opentimers_heapSiftUp(opentimers_id_t pos);
+void  opentimers_heapSiftDown(opentimers_id_t pos);
+bool  opentimers_heapIsEarlier(opentimers_id_t id1, opentimers_id_t id2);
+void  opentimers_heapSwap(opentimers_id_t pos1, opentimers_id_t pos2);
+void  opentimers_preCallWithinWindow(void);
+void  opentimers_setNextCompare(void);
 
 //=========================== public ==========================================
 
@@ -50,7 +66,7 @@ task_prio gives a priority when opentimer push a task.
 \returns the id of the timer will be returned
  */
 opentimers_id_t opentimers_create(uint8_t timer_id, uint8_t task_prio){
-    uint8_t id;
+    opentimers_id_t id;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
@@ -60,6 +76,7 @@ opentimers_id_t opentimers_create(uint8_t timer_id, uint8_t task_prio){
             opentimers_vars.timersBuf[timer_id].isUsed   = TRUE;
             // the TSCH timer and inhibit timer won't push a task,
             // hence task_prio is not used
+            ENABLE_INTERRUPTS();
             return timer_id;
         }
     }
@@ -69,6 +86,7 @@ opentimers_id_t opentimers_create(uint8_t timer_id, uint8_t task_prio){
             if (opentimers_vars.timersBuf[id].isUsed  == FALSE){
                 opentimers_vars.timersBuf[id].isUsed   = TRUE;
                 opentimers_vars.timersBuf[id].timer_task_prio = task_prio;
+                ENABLE_INTERRUPTS();
                 return id;
             }
         }
@@ -97,25 +115,18 @@ void opentimers_scheduleIn(opentimers_id_t    id,
                            time_type_t        uint_type,
                            timer_type_t       timer_type,
                            opentimers_cbt     cb){
-    uint8_t  i;
-    uint8_t  idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
-
     INTERRUPT_DECLARATION();
     // 1. make sure the timer exist
-    for (i=0;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isUsed && i == id){
-            break;
-        }
-    }
-    if (i==MAX_NUM_TIMERS){
+    if (id>=MAX_NUM_TIMERS || opentimers_vars.timersBuf[id].isUsed==FALSE){
         // doesn't find the timer
         return;
     }
 
     DISABLE_INTERRUPTS();
 
+    // a running timer is re-inserted in the heap with its new compare value
+    opentimers_heapRemove(id);
+
     opentimers_vars.timersBuf[id].timerType = timer_type;
 
     // 2. updat the timer content
@@ -136,33 +147,14 @@ void opentimers_scheduleIn(opentimers_id_t    id,
         opentimers_vars.timersBuf[id].currentCompareValue = MAX_TICKS_IN_SINGLE_CLOCK+sctimer_readCounter();
     }
 
-    opentimers_vars.timersBuf[id].isrunning           = TRUE;
     opentimers_vars.timersBuf[id].callback            = cb;
+    opentimers_heapInsert(id);
 
     // 3. find the next timer to fire
 
     // only execute update the currentCompareValue if I am not inside of ISR or the ISR itself will do this.
     if (opentimers_vars.insideISR==FALSE){
-        i = 0;
-        while (opentimers_vars.timersBuf[i].isrunning==FALSE){
-            i++;
-        }
-        timerGap     = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue;
-        idToSchedule = i;
-        for (i=idToSchedule+1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue;
-                if (tempTimerGap < timerGap){
-                    // timer "i" is more close to lastCompare value
-                    timerGap     = tempTimerGap;
-                    idToSchedule = i;
-                }
-            }
-        }
-
-        // if I got here, assign the next to be fired timer to given timer
-        opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
-        sctimer_setCompare(opentimers_vars.currentCompareValue);
+        opentimers_setNextCompare();
     }
     opentimers_vars.running        = TRUE;
 
@@ -187,26 +179,19 @@ void opentimers_scheduleAbsolute(opentimers_id_t    id,
                                  PORT_TIMER_WIDTH   reference ,
                                  time_type_t        uint_type,
                                  opentimers_cbt     cb){
-    uint8_t  i;
-    uint8_t idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
-
     INTERRUPT_DECLARATION();
 
     // 1. make sure the timer exist
-    for (i=0;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isUsed && i == id){
-            break;
-        }
-    }
-    if (i==MAX_NUM_TIMERS){
+    if (id>=MAX_NUM_TIMERS || opentimers_vars.timersBuf[id].isUsed==FALSE){
         // doesn't find the timer
         return;
     }
 
     DISABLE_INTERRUPTS();
 
+    // a running timer is re-inserted in the heap with its new compare value
+    opentimers_heapRemove(id);
+
     // absolute scheduling is for one shot timer
     opentimers_vars.timersBuf[id].timerType = TIMER_ONESHOT;
 
@@ -228,33 +213,14 @@ void opentimers_scheduleAbsolute(opentimers_id_t    id,
         opentimers_vars.timersBuf[id].currentCompareValue = MAX_TICKS_IN_SINGLE_CLOCK+reference;
     }
 
-    opentimers_vars.timersBuf[id].isrunning = TRUE;
     opentimers_vars.timersBuf[id].callback  = cb;
+    opentimers_heapInsert(id);
 
     // 3. find the next timer to fire
 
     // only execute update the currentCompareValue if I am not inside of ISR or the ISR itself will do this.
     if (opentimers_vars.insideISR==FALSE){
-        i = 0;
-        while (opentimers_vars.timersBuf[i].isrunning==FALSE){
-            i++;
-        }
-        timerGap     = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue;
-        idToSchedule = i;
-        for (i=idToSchedule+1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue;
-                if (tempTimerGap < timerGap){
-                    // timer "i" is more close to lastCompare value
-                    timerGap     = tempTimerGap;
-                    idToSchedule = i;
-                }
-            }
-        }
-
-        // if I got here, assign the next to be fired timer to given timer
-        opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
-        sctimer_setCompare(opentimers_vars.currentCompareValue);
+        opentimers_setNextCompare();
     }
     opentimers_vars.running = TRUE;
 
@@ -291,7 +257,7 @@ void opentimers_cancel(opentimers_id_t id){
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    opentimers_vars.timersBuf[id].isrunning = FALSE;
+    opentimers_heapRemove(id);
     opentimers_vars.timersBuf[id].callback  = NULL;
 
     ENABLE_INTERRUPTS();
@@ -307,8 +273,17 @@ Reset the whole entry of given timer including the id.
 \returns False if the given can't be found or return Success
  */
 bool opentimers_destroy(opentimers_id_t id){
+    opentimers_id_t next;
+    INTERRUPT_DECLARATION();
+
     if (id<MAX_NUM_TIMERS){
+        DISABLE_INTERRUPTS();
+        opentimers_heapRemove(id);
+        // keep the link in the list of expired timers, which may be walked right now
+        next = opentimers_vars.timersBuf[id].nextExpired;
         memset(&opentimers_vars.timersBuf[id],0,sizeof(opentimers_t));
+        opentimers_vars.timersBuf[id].nextExpired = next;
+        ENABLE_INTERRUPTS();
         return TRUE;
     } else {
         return FALSE;
@@ -348,21 +323,20 @@ bool opentimers_isRunning(opentimers_id_t id){
 /**
 \brief this is the callback function of opentimer.
 
-This function is called when sctimer interrupt happens. The function looks the
-whole timer buffer and find out the correct timer responding to the interrupt
-and call the callback recorded for that timer.
+This function is called when sctimer interrupt happens. The timers responding
+to the interrupt are popped from the root of the heap, and the callback
+recorded for each of them is called, by increasing timer id.
  */
 void opentimers_timer_callback(void){
-    uint8_t i;
-    uint8_t idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
+    opentimers_id_t i;
+    opentimers_id_t expiredHead;
+    opentimers_id_t expiredTail;
 
     if (
         opentimers_vars.timersBuf[TIMER_INHIBIT].isrunning==TRUE &&
         opentimers_vars.currentCompareValue == opentimers_vars.timersBuf[TIMER_INHIBIT].currentCompareValue
     ){
-        opentimers_vars.timersBuf[TIMER_INHIBIT].isrunning  = FALSE;
+        opentimers_heapRemove(TIMER_INHIBIT);
         opentimers_vars.timersBuf[TIMER_INHIBIT].callback(TIMER_INHIBIT);
         // the next timer selection will be done after SPLITE_TIMER_DURATION ticks
         sctimer_setCompare(sctimer_readCounter()+SPLITE_TIMER_DURATION);
@@ -370,27 +344,60 @@ void opentimers_timer_callback(void){
     } else {
         if (opentimers_vars.timersBuf[TIMER_INHIBIT].currentCompareValue == opentimers_vars.currentCompareValue){
             // this is the timer interrupt right after inhibit timer, pre call the non-tsch, non-inhibit timer interrupt here to avoid interrupt during receiving serial bytes
-            for (i=0;i<MAX_NUM_TIMERS;i++){
-                if (opentimers_vars.timersBuf[i].isrunning==TRUE){
-                    if (i!=TIMER_TSCH && i!=TIMER_INHIBIT && opentimers_vars.timersBuf[i].currentCompareValue - opentimers_vars.currentCompareValue < PRE_CALL_TIMER_WINDOW){
-                        opentimers_vars.timersBuf[i].currentCompareValue = opentimers_vars.currentCompareValue;
-                    }
-                }
+            opentimers_preCallWithinWindow();
+        }
+
+        // pop all the timers expiring now, they come out of the heap by increasing id
+        expiredHead = ERROR_NO_AVAILABLE_ENTRIES;
+        expiredTail = ERROR_NO_AVAILABLE_ENTRIES;
+        while (
+            opentimers_vars.heapSize>0 &&
+            opentimers_vars.timersBuf[opentimers_vars.heap[0]].currentCompareValue == opentimers_vars.currentCompareValue
+        ){
+            i = opentimers_vars.heap[0];
+            opentimers_heapRemove(i);
+            // this timer expired, mark as expired
+            opentimers_vars.timersBuf[i].hasExpired  = TRUE;
+            opentimers_vars.timersBuf[i].nextExpired = ERROR_NO_AVAILABLE_ENTRIES;
+            if (expiredHead==ERROR_NO_AVAILABLE_ENTRIES){
+                expiredHead = i;
+            } else {
+                opentimers_vars.timersBuf[expiredTail].nextExpired = i;
             }
+            expiredTail = i;
         }
-        for (i=0;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning==TRUE){
-                if (opentimers_vars.currentCompareValue == opentimers_vars.timersBuf[i].currentCompareValue){
-                    // this timer expired, mark as expired
-                    opentimers_vars.timersBuf[i].lastCompareValue    = opentimers_vars.timersBuf[i].currentCompareValue;
-                    if (i==TIMER_TSCH){
+
+        for (i=expiredHead;i!=ERROR_NO_AVAILABLE_ENTRIES;i=opentimers_vars.timersBuf[i].nextExpired){
+            if (opentimers_vars.timersBuf[i].hasExpired==FALSE){
+                // this timer was cancelled or re-scheduled by a callback called before
+                continue;
+            }
+            opentimers_vars.timersBuf[i].hasExpired          = FALSE;
+            opentimers_vars.timersBuf[i].lastCompareValue    = opentimers_vars.timersBuf[i].currentCompareValue;
+            if (i==TIMER_TSCH){
+                opentimers_vars.insideISR = TRUE;
+                opentimers_vars.timersBuf[i].callback(i);
+                opentimers_vars.insideISR = FALSE;
+            } else {
+                if (opentimers_vars.timersBuf[i].wraps_remaining==0){
+                    scheduler_push_task((task_cbt)(opentimers_vars.timersBuf[i].callback),(task_prio_t)opentimers_vars.timersBuf[i].timer_task_prio);
+                    if (opentimers_vars.timersBuf[i].timerType==TIMER_PERIODIC){
                         opentimers_vars.insideISR = TRUE;
-                        opentimers_vars.timersBuf[i].isrunning  = FALSE;
-                        opentimers_vars.timersBuf[i].callback(i);
+                        opentimers_scheduleIn(
+                            i,
+                            opentimers_vars.timersBuf[i].duration,
+                            TIME_TICS,
+                            TIMER_PERIODIC,
+                            opentimers_vars.timersBuf[i].callback
+                        );
                         opentimers_vars.insideISR = FALSE;
-                    } else {
-                        if (opentimers_vars.timersBuf[i].wraps_remaining==0){
-                            opentimers_vars.timersBuf[i].isrunning = FALSE;
+                    }
+                } else {
+                    opentimers_vars.timersBuf[i].wraps_remaining--;
+                    if (opentimers_vars.timersBuf[i].wraps_remaining == 0){
+                        opentimers_vars.timersBuf[i].currentCompareValue = (opentimers_vars.timersBuf[i].duration+opentimers_vars.timersBuf[i].lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+                        if (opentimers_vars.timersBuf[i].currentCompareValue - opentimers_vars.currentCompareValue < PRE_CALL_TIMER_WINDOW){
+                            // pre-call the timer here if it will be fired within PRE_CALL_TIMER_WINDOW, when wraps_remaining decrease to 0
                             scheduler_push_task((task_cbt)(opentimers_vars.timersBuf[i].callback),(task_prio_t)opentimers_vars.timersBuf[i].timer_task_prio);
                             if (opentimers_vars.timersBuf[i].timerType==TIMER_PERIODIC){
                                 opentimers_vars.insideISR = TRUE;
@@ -404,29 +411,11 @@ void opentimers_timer_callback(void){
                                 opentimers_vars.insideISR = FALSE;
                             }
                         } else {
-                            opentimers_vars.timersBuf[i].wraps_remaining--;
-                            if (opentimers_vars.timersBuf[i].wraps_remaining == 0){
-                                opentimers_vars.timersBuf[i].currentCompareValue = (opentimers_vars.timersBuf[i].duration+opentimers_vars.timersBuf[i].lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-                                if (opentimers_vars.timersBuf[i].currentCompareValue - opentimers_vars.currentCompareValue < PRE_CALL_TIMER_WINDOW){
-                                    // pre-call the timer here if it will be fired within PRE_CALL_TIMER_WINDOW, when wraps_remaining decrease to 0
-                                    opentimers_vars.timersBuf[i].isrunning  = FALSE;
-                                    scheduler_push_task((task_cbt)(opentimers_vars.timersBuf[i].callback),(task_prio_t)opentimers_vars.timersBuf[i].timer_task_prio);
-                                    if (opentimers_vars.timersBuf[i].timerType==TIMER_PERIODIC){
-                                        opentimers_vars.insideISR = TRUE;
-                                        opentimers_scheduleIn(
-                                            i,
-                                            opentimers_vars.timersBuf[i].duration,
-                                            TIME_TICS,
-                                            TIMER_PERIODIC,
-                                            opentimers_vars.timersBuf[i].callback
-                                        );
-                                        opentimers_vars.insideISR = FALSE;
-                                    }
-                                }
-                            } else {
-                                opentimers_vars.timersBuf[i].currentCompareValue = opentimers_vars.timersBuf[i].lastCompareValue + MAX_TICKS_IN_SINGLE_CLOCK;
-                            }
+                            opentimers_heapInsert(i);
                         }
+                    } else {
+                        opentimers_vars.timersBuf[i].currentCompareValue = opentimers_vars.timersBuf[i].lastCompareValue + MAX_TICKS_IN_SINGLE_CLOCK;
+                        opentimers_heapInsert(i);
                     }
                 }
             }
@@ -434,28 +423,195 @@ void opentimers_timer_callback(void){
     }
     opentimers_vars.lastCompareValue = opentimers_vars.currentCompareValue;
 
-    // find the next timer to be fired
-    i = 0;
-    while (opentimers_vars.timersBuf[i].isrunning==FALSE && i<MAX_NUM_TIMERS){
-        i++;
+    // reschedule the timer
+    if (opentimers_vars.heapSize>0){
+        opentimers_setNextCompare();
+    } else {
+        opentimers_vars.running        = FALSE;
     }
-    if(i<MAX_NUM_TIMERS){
-        timerGap     = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue;
-        idToSchedule = i;
-        for (i=idToSchedule+1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue;
-                if (tempTimerGap < timerGap){
-                    timerGap     = tempTimerGap;
-                    idToSchedule = i;
-                }
-            }
+}
+
+//=========================== private =========================================
+
+/**
+\brief Add a timer to the heap of running timers.
+
+\param[in] id the timer id, which is marked as running.
+ */
+void opentimers_heapInsert(opentimers_id_t id){
+    opentimers_vars.timersBuf[id].isrunning  = TRUE;
+    opentimers_vars.timersBuf[id].hasExpired = FALSE;
+    opentimers_vars.timersBuf[id].heapIndex  = opentimers_vars.heapSize;
+    opentimers_vars.heap[opentimers_vars.heapSize] = id;
+    opentimers_vars.heapSize++;
+    opentimers_heapSiftUp(opentimers_vars.timersBuf[id].heapIndex);
+}
+
+/**
+\brief Remove a timer from the heap of running timers, if it is running.
+
+\param[in] id the timer id, which is marked as not running.
+ */
+void opentimers_heapRemove(opentimers_id_t id){
+    opentimers_id_t pos;
+
+    opentimers_vars.timersBuf[id].hasExpired = FALSE;
+    if (opentimers_vars.timersBuf[id].isrunning==FALSE){
+        return;
+    }
+    opentimers_vars.timersBuf[id].isrunning  = FALSE;
+
+    pos = opentimers_vars.timersBuf[id].heapIndex;
+    opentimers_vars.heapSize--;
+    if (pos==opentimers_vars.heapSize){
+        // this was the last element of the heap
+        return;
+    }
+    // move the last element of the heap in the hole, and restore the heap order
+    opentimers_heapSwap(pos,opentimers_vars.heapSize);
+    opentimers_heapSiftUp(pos);
+    opentimers_heapSiftDown(pos);
+}
+
+/**
+\brief Move the element at the given heap position toward the root.
+ */
+void opentimers_heapSiftUp(opentimers_id_t pos){
+    opentimers_id_t parent;
+
+    while (pos>0){
+        parent = (pos-1)/2;
+        if (
+            opentimers_heapIsEarlier(
+                opentimers_vars.heap[pos],
+                opentimers_vars.heap[parent]
+            )==FALSE
+        ){
+            break;
         }
+        opentimers_heapSwap(pos,parent);
+        pos = parent;
+    }
+}
 
-        // reschedule the timer
-        opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
-        sctimer_setCompare(opentimers_vars.currentCompareValue);
-    } else {
-        opentimers_vars.running        = FALSE;
+/**
+\brief Move the element at the given heap position toward the leaves.
+ */
+void opentimers_heapSiftDown(opentimers_id_t pos){
+    opentimers_id_t child;
+
+    while ((uint32_t)2*pos+1<opentimers_vars.heapSize){
+        child = 2*pos+1;
+        if (
+            child+1<opentimers_vars.heapSize &&
+            opentimers_heapIsEarlier(
+                opentimers_vars.heap[child+1],
+                opentimers_vars.heap[child]
+            )
+        ){
+            child++;
+        }
+        if (
+            opentimers_heapIsEarlier(
+                opentimers_vars.heap[child],
+                opentimers_vars.heap[pos]
+            )==FALSE
+        ){
+            break;
+        }
+        opentimers_heapSwap(pos,child);
+        pos = child;
+    }
+}
+
+/**
+\brief Does a timer expire before another one?
+
+Timers are compared on the number of ticks between lastCompareValue and their
+compare value, which is immune to the counter wrapping around. Timers expiring
+at the same time are ordered by id.
+
+\returns TRUE if timer id1 expires before timer id2.
+ */
+bool opentimers_heapIsEarlier(opentimers_id_t id1, opentimers_id_t id2){
+    PORT_TIMER_WIDTH gap1;
+    PORT_TIMER_WIDTH gap2;
+
+    gap1 = opentimers_vars.timersBuf[id1].currentCompareValue-opentimers_vars.lastCompareValue;
+    gap2 = opentimers_vars.timersBuf[id2].currentCompareValue-opentimers_vars.lastCompareValue;
+    if (gap1!=gap2){
+        return gap1<gap2;
     }
-}
\ No newline at end of file
+    return id1<id2;
+}
+
+/**
+\brief Swap two elements of the heap, keeping the timers' heapIndex in sync.
+ */
+void opentimers_heapSwap(opentimers_id_t pos1, opentimers_id_t pos2){
+    opentimers_id_t id;
+
+    id                              = opentimers_vars.heap[pos1];
+    opentimers_vars.heap[pos1]      = opentimers_vars.heap[pos2];
+    opentimers_vars.heap[pos2]      = id;
+    opentimers_vars.timersBuf[opentimers_vars.heap[pos1]].heapIndex = pos1;
+    opentimers_vars.timersBuf[opentimers_vars.heap[pos2]].heapIndex = pos2;
+}
+
+/**
+\brief Pre-call the timers expiring within PRE_CALL_TIMER_WINDOW.
+
+The compare value of the running non-tsch, non-inhibit timers expiring within
+PRE_CALL_TIMER_WINDOW ticks of currentCompareValue is set to
+currentCompareValue.
+
+The heap is walked depth-first without a stack, skipping the sub-trees whose
+root expires after the window: their descendants expire even later. The
+selected timers are chained through nextExpired, and only moved up the heap
+once the walk is over.
+ */
+void opentimers_preCallWithinWindow(void){
+    opentimers_id_t pos;
+    opentimers_id_t id;
+    opentimers_id_t selectedHead;
+    bool            inWindow;
+
+    selectedHead = ERROR_NO_AVAILABLE_ENTRIES;
+    pos          = 0;
+    while (pos<opentimers_vars.heapSize){
+        id       = opentimers_vars.heap[pos];
+        inWindow = (opentimers_vars.timersBuf[id].currentCompareValue - opentimers_vars.currentCompareValue < PRE_CALL_TIMER_WINDOW);
+        if (inWindow && id!=TIMER_TSCH && id!=TIMER_INHIBIT){
+            opentimers_vars.timersBuf[id].nextExpired = selectedHead;
+            selectedHead = id;
+        }
+        if (inWindow && (uint32_t)2*pos+1<opentimers_vars.heapSize){
+            // descend to the left child
+            pos = 2*pos+1;
+            continue;
+        }
+        // go up while on a right child or a left child without sibling, then move to the right sibling
+        while (pos>0 && (pos%2==0 || (uint32_t)pos+1>=opentimers_vars.heapSize)){
+            pos = (pos-1)/2;
+        }
+        if (pos==0){
+            break;
+        }
+        pos++;
+    }
+
+    for (id=selectedHead;id!=ERROR_NO_AVAILABLE_ENTRIES;id=opentimers_vars.timersBuf[id].nextExpired){
+        opentimers_vars.timersBuf[id].currentCompareValue = opentimers_vars.currentCompareValue;
+        opentimers_heapSiftUp(opentimers_vars.timersBuf[id].heapIndex);
+    }
+}
+
+/**
+\brief Arm the sctimer for the timer at the root of the heap.
+
+\pre The heap is not empty.
+ */
+void opentimers_setNextCompare(void){
+    opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[opentimers_vars.heap[0]].currentCompareValue;
+    sctimer_setCompare(opentimers_vars.currentCompareValue);
+}
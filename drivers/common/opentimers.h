@@ -18,12 +18,19 @@
 
 //=========================== define ==========================================
 
-/// Maximum number of timers that can run concurrently
+/// Maximum number of timers that can run concurrently (can be overridden at build time)
+#ifndef MAX_NUM_TIMERS
 #define MAX_NUM_TIMERS             15
+#endif
 #define MAX_TICKS_IN_SINGLE_CLOCK  (uint32_t)(((PORT_TIMER_WIDTH)0xFFFFFFFF)>>1)
-#define ERROR_NO_AVAILABLE_ENTRIES 255
 #define MAX_DURATION_ISR           33 // 33@32768Hz = 1ms
+#if MAX_NUM_TIMERS<255
+#define ERROR_NO_AVAILABLE_ENTRIES 255
 #define opentimers_id_t            uint8_t
+#else
+#define ERROR_NO_AVAILABLE_ENTRIES 0xffff
+#define opentimers_id_t            uint16_t
+#endif
 
 #define TIMER_INHIBIT              0
 #define TIMER_TSCH                 1
@@ -59,12 +66,16 @@ typedef struct {
    bool                 hasExpired;         // in case there are more than one interrupt occur at same time
    opentimers_cbt       callback;           // function to call when elapses
    uint8_t              timer_task_prio;    // when opentimer push a task, use timer_task_prio to mark the priority
+   opentimers_id_t      heapIndex;          // position in the heap of running timers, valid when isrunning
+   opentimers_id_t      nextExpired;        // next timer in the list of timers expiring at the same time
 } opentimers_t;
 
 //=========================== module variables ================================
 
 typedef struct {
    opentimers_t         timersBuf[MAX_NUM_TIMERS];
+   opentimers_id_t      heap[MAX_NUM_TIMERS];// running timers, min-heap ordered by compare value since lastCompareValue
+   opentimers_id_t      heapSize;           // number of running timers
    bool                 running;
    PORT_TIMER_WIDTH     currentCompareValue;// current timeout, in ticks
    PORT_TIMER_WIDTH     lastCompareValue;   // last timeout, in ticks. This is the reference time to calculate the next to be expired timer.
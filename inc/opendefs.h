@@ -36,7 +36,9 @@ static const uint8_t infoStackName[] = "OpenWSN ";
 #define LENGTH_ADDR64b   8
 #define LENGTH_ADDR128b  16
 
+#ifndef MAXNUMNEIGHBORS
 #define MAXNUMNEIGHBORS  30
+#endif
 
 // maximum celllist length
 #define CELLLIST_MAX_LEN 5
@@ -113,7 +115,8 @@ enum {
    STATUS_NEIGHBORS                    =  9,
    STATUS_KAPERIOD                     = 10,
    STATUS_JOINED                       = 11,
-   STATUS_MAX                          = 12,
+   STATUS_MACPROFILE                   = 12,
+   STATUS_MAX                          = 13,
 };
 
 //component identifiers
@@ -277,6 +280,10 @@ enum {
    ERR_UNSUPPORTED_METADATA            = 0x51, // the metadata type is not suppored
    ERR_MAXRETRIES_REACHED              = 0x52, // maxretries reached (counter: {0})
    ERR_EMPTY_QUEUE_OR_UNKNOWN_TIMER    = 0x53, // empty queue or trying to remove unknown timer id (code location {0})
+   ERR_FRAG_RECOVERED                  = 0x54, // sending again the fragments lost of the datagram with tag {0} (number of fragments: {1})
+   ERR_UNKNOWN_CONTEXT                 = 0x55, // unknown 6LoWPAN context {0} (code location {1})
+   ERR_ROUTING_TABLE_FULL              = 0x56, // no room in the routing table for the route to {0}:{1}
+   ERR_DAO_BYTES                       = 0x57, // sent {0} bytes of DAO over the last minute, relayed {1}
 };
 
 //=========================== typedef =========================================
@@ -356,6 +363,7 @@ typedef struct {
    uint8_t       l2_sixtop_command;                             // command of the received 6p request, recorded in 6p response
    uint8_t       l2_sixtop_cellOptions;                         // celloptions, used when 6p response senddone. (it's the same with cellOptions in 6p request but with TX and RX bits have been flipped)
    uint8_t       l2_sixtop_returnCode;                          // return code in 6P response
+   uint8_t       l2_sixtop_seqNum;                              // sequence number of the 6P request, matched to its transaction upon senddone
    uint8_t*      l2_ASNpayload;                                 // pointer to the ASN in EB
    uint8_t*      l2_nextHop_payload;                            // pointer to the nexthop address in frame
    uint8_t       l2_joinPriority;                               // the join priority received in EB
@@ -1,6 +1,13 @@
 /**
 \brief OpenOS scheduler.
 
+Pending tasks are kept in one FIFO per priority level, and a bitmap records
+which of those FIFOs are non-empty. Unused task containers are chained in a
+free list. Pushing and popping a task are hence constant-time operations,
+keeping the interrupt-off windows short regardless of the number of pending
+tasks. Tasks are executed by increasing priority value, in FIFO order within
+a priority level.
+
 \author Thomas Watteyne <watteyne@eecs.berkeley.edu>, February 2012.
 */
 
@@ -15,47 +22,76 @@
 scheduler_vars_t scheduler_vars;
 scheduler_dbg_t  scheduler_dbg;
 
+/**
+\brief Index of the least significant bit set in a 4-bit value.
+
+Entry 0 is never used, as the bitmap is only looked up when not empty.
+*/
+static const uint8_t scheduler_lsbNibble[16] = {
+    0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
 //=========================== prototypes ======================================
 
-void consumeTask(uint8_t taskId);
+uint8_t scheduler_highestPrio(void);
 
 //=========================== public ==========================================
 
 void scheduler_init(void) {
+    uint8_t i;
 
     // initialization module variables
     memset(&scheduler_vars,0,sizeof(scheduler_vars_t));
     memset(&scheduler_dbg,0,sizeof(scheduler_dbg_t));
 
+    // chain all task containers in the free list
+    for (i=0;i<TASK_LIST_DEPTH-1;i++) {
+        scheduler_vars.taskBuf[i].next = &scheduler_vars.taskBuf[i+1];
+    }
+    scheduler_vars.freeList = &scheduler_vars.taskBuf[0];
+
     // enable the scheduler's interrupt so SW can wake up the scheduler
     SCHEDULER_ENABLE_INTERRUPT();
 }
 
 void scheduler_start(void) {
     taskList_item_t* pThisTask;
+    taskFifo_t*      fifo;
+    uint8_t          prio;
     while (1) {
-        while(scheduler_vars.task_list!=NULL) {
-         // there is still at least one task in the linked-list of tasks
+        while(scheduler_vars.prioBitmap!=0) {
+         // there is still at least one task pending
 
          INTERRUPT_DECLARATION();
          DISABLE_INTERRUPTS();
 
-         // the task to execute is the one at the head of the queue
-         pThisTask                = scheduler_vars.task_list;
+         // the task to execute is the head of the highest priority FIFO
+         prio                     = scheduler_highestPrio();
+         fifo                     = &scheduler_vars.fifo[prio];
+         pThisTask                = fifo->head;
 
-         // shift the queue by one task
-         scheduler_vars.task_list = pThisTask->next;
+         // shift that FIFO by one task
+         fifo->head               = pThisTask->next;
+         if (fifo->head==NULL) {
+            fifo->tail                    = NULL;
+            scheduler_vars.prioBitmap    &= ~(((uint32_t)1)<<prio);
+         }
 
          ENABLE_INTERRUPTS();
 
          // execute the current task
          pThisTask->cb();
 
+         DISABLE_INTERRUPTS();
+
          // free up this task container
          pThisTask->cb            = NULL;
          pThisTask->prio          = TASKPRIO_NONE;
-         pThisTask->next          = NULL;
+         pThisTask->next          = scheduler_vars.freeList;
+         scheduler_vars.freeList  = pThisTask;
          scheduler_dbg.numTasksCur--;
+
+         ENABLE_INTERRUPTS();
       }
       debugpins_task_clr();
       board_sleep();
@@ -65,18 +101,14 @@ void scheduler_start(void) {
 
 void scheduler_push_task(task_cbt cb, task_prio_t prio) {
     taskList_item_t*  taskContainer;
-    taskList_item_t** taskListWalker;
+    taskFifo_t*       fifo;
     INTERRUPT_DECLARATION();
 
     DISABLE_INTERRUPTS();
 
-    // find an empty task container
-    taskContainer = &scheduler_vars.taskBuf[0];
-    while (taskContainer->cb!=NULL &&
-          taskContainer<=&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-       taskContainer++;
-    }
-    if (taskContainer>&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
+    // take an empty task container
+    taskContainer = scheduler_vars.freeList;
+    if (taskContainer==NULL) {
        // task list has overflown. This should never happpen!
 
        // we can not print from within the kernel. Instead:
@@ -84,20 +116,26 @@ void scheduler_push_task(task_cbt cb, task_prio_t prio) {
        leds_error_blink();
        // reset the board
        board_reset();
+       ENABLE_INTERRUPTS();
+       return;
     }
+    scheduler_vars.freeList        = taskContainer->next;
+
     // fill that task container with this task
     taskContainer->cb              = cb;
     taskContainer->prio            = prio;
-
-    // find position in queue
-    taskListWalker                 = &scheduler_vars.task_list;
-    while (*taskListWalker!=NULL &&
-          (*taskListWalker)->prio <= taskContainer->prio) {
-       taskListWalker              = (taskList_item_t**)&((*taskListWalker)->next);
+    taskContainer->next            = NULL;
+
+    // append at the tail of the FIFO of that priority
+    fifo                           = &scheduler_vars.fifo[prio];
+    if (fifo->tail==NULL) {
+       fifo->head                  = taskContainer;
+    } else {
+       fifo->tail->next            = taskContainer;
     }
-    // insert at that position
-    taskContainer->next            = *taskListWalker;
-    *taskListWalker                = taskContainer;
+    fifo->tail                     = taskContainer;
+    scheduler_vars.prioBitmap     |= (((uint32_t)1)<<prio);
+
     // maintain debug stats
     scheduler_dbg.numTasksCur++;
     if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
@@ -108,3 +146,31 @@ void scheduler_push_task(task_cbt cb, task_prio_t prio) {
 }
 
 //=========================== private =========================================
+
+/**
+\brief Retrieve the highest priority (lowest value) with pending tasks.
+
+\pre Interrupts are disabled and scheduler_vars.prioBitmap is not 0.
+
+\returns The priority level of the task to execute next.
+*/
+uint8_t scheduler_highestPrio(void) {
+    uint32_t bitmap;
+    uint8_t  offset;
+
+    bitmap = scheduler_vars.prioBitmap;
+    offset = 0;
+    if ((bitmap & 0x0000ffff)==0) {
+        bitmap >>= 16;
+        offset  += 16;
+    }
+    if ((bitmap & 0x00ff)==0) {
+        bitmap >>= 8;
+        offset  += 8;
+    }
+    if ((bitmap & 0x000f)==0) {
+        bitmap >>= 4;
+        offset  += 4;
+    }
+    return offset + scheduler_lsbNibble[bitmap & 0x000f];
+}
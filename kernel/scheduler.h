@@ -31,8 +31,10 @@ typedef enum {
     TASKPRIO_BUTTON                = 0x0c,
     TASKPRIO_SIXTOP_TIMEOUT        = 0x0d,
     TASKPRIO_SNIFFER               = 0x0e,
-    TASKPRIO_OPENSERIAL            = 0X0f,
-    TASKPRIO_MAX                   = 0x10,
+    // background work
+    TASKPRIO_SLOTPLAN              = 0x0f,
+    TASKPRIO_OPENSERIAL            = 0x10,
+    TASKPRIO_MAX                   = 0x11,
 } task_prio_t;
 
 #define TASK_LIST_DEPTH           10
@@ -47,13 +49,21 @@ typedef struct task_llist_t {
    void*                          next;
 } taskList_item_t;
 
+/**
+\brief FIFO of the pending tasks sharing one priority level.
+*/
+typedef struct {
+   taskList_item_t*               head;
+   taskList_item_t*               tail;
+} taskFifo_t;
+
 //=========================== module variables ================================
 
 typedef struct {
    taskList_item_t                taskBuf[TASK_LIST_DEPTH];
-   taskList_item_t*               task_list;
-   uint8_t                        numTasksCur;
-   uint8_t                        numTasksMax;
+   taskList_item_t*               freeList;             // unused task containers
+   taskFifo_t                     fifo[TASKPRIO_MAX];   // pending tasks, one FIFO per priority
+   uint32_t                       prioBitmap;           // bit i set iff fifo[i] is not empty
 } scheduler_vars_t;
 
 typedef struct {
@@ -63,11 +63,12 @@
 /*
  * Add "length" to the length.
  * Set Corrupted when overflow has occurred.
+ * The sum wraps around iff it ends up smaller than "length"; unlike a
+ * shared temporary, this keeps concurrent contexts independent.
  */
-static uint32_t addTemp;
 #define SHA224_256AddLength(context, length)               \
-  (addTemp = (context)->Length_Low, (context)->Corrupted = \
-    (((context)->Length_Low += (length)) < addTemp) &&     \
+  ((context)->Corrupted =                                  \
+    (((context)->Length_Low += (length)) < (uint32_t)(length)) && \
     (++(context)->Length_High == 0) ? shaInputTooLong :    \
                                       (context)->Corrupted )
 
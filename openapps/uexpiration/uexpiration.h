@@ -20,6 +20,12 @@ typedef struct {
    opentimers_id_t        timerId;  ///< periodic timer which triggers transmission
    uint16_t               period;  ///< uinject packet sending period>
    udp_resource_desc_t    desc;  ///< resource descriptor for this module, used to register at UDP stack
+   uint16_t               seqno;  ///< sequence number of the next packet
+   uint16_t               d_flag;  ///< drop the packets once their deadline expires
+   uint16_t               delay;  ///< max delay of the packets, in ms
+   uint16_t               max_num_pkts;  ///< number of packets to send
+   uint16_t               pkt_interval;  ///< packet sending period, in ms
+   OpenQueueEntry_t       req;  ///< request which triggered the transmissions
 } uexpiration_vars_t;
 
 //=========================== prototypes ======================================
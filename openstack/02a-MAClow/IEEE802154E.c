@@ -90,8 +90,40 @@ void     notif_receive(OpenQueueEntry_t* packetReceived);
 // statistics
 void     resetStats(void);
 void     updateStats(PORT_SIGNED_INT_WIDTH timeCorrection);
+// look-ahead
+OpenQueueEntry_t* prepareTxFrame(void);
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+slotPlan_t* findSlotPlan(OpenQueueEntry_t* dataToSend);
+bool     isSameSlotPlanKey(slotPlanKey_t* key1, slotPlanKey_t* key2);
+#endif
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+// aggregation
+uint8_t  selectAggregatedPackets(OpenQueueEntry_t* dataToSend, OpenQueueEntry_t** aggregated);
+bool     isAggregatable(OpenQueueEntry_t* dataToSend, OpenQueueEntry_t* packet);
+void     aggregateTxFrame(
+    OpenQueueEntry_t*  frame,
+    OpenQueueEntry_t*  dataToSend,
+    OpenQueueEntry_t** aggregated,
+    uint8_t            numAggregated
+);
+void     notif_sendDoneAggregated(owerror_t error);
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+// burst
+bool     isBurstPending(OpenQueueEntry_t* lastInFrame, slotOffset_t slotOffset, uint8_t burstLength);
+bool     isBurstAccepted(open_addr_t* neighbor);
+void     setFramePending(OpenQueueEntry_t* frame);
+void     armBurst(burstRole_t role, open_addr_t* neighbor);
+#endif
+#ifdef IEEE802154E_PROFILE_ENABLED
+// profiling
+ieee154e_activity_t profileActivity(ieee154e_profileEvent_t event);
+void     profileRecord(ieee154e_activity_t activity, PORT_TIMER_WIDTH startTime);
+#endif
 // misc
 uint8_t  calculateFrequency(uint8_t channelOffset);
+uint8_t  calculateFrequencyAt(uint8_t asnOffset, uint8_t channelOffset);
+bool     isScheduledSlot(void);
 void     changeState(ieee154e_state_t newstate);
 void     endSlot(void);
 bool     debugPrint_asn(void);
@@ -280,6 +312,13 @@ void ieee154e_orderToASNStructure(uint8_t* in,asn_t* val_asn) {
 This function executes in ISR mode, when the new slot timer fires.
 */
 void isr_ieee154e_newSlot(opentimers_id_t id) {
+#ifdef IEEE802154E_PROFILE_ENABLED
+    ieee154e_activity_t activity;
+    PORT_TIMER_WIDTH    startTime;
+
+    activity  = profileActivity(PROFILE_EVENT_NEWSLOT);
+    startTime = IEEE802154E_PROFILE_COUNTER();
+#endif
 
     ieee154e_vars.startOfSlotReference = opentimers_getCurrentCompareValue();
     
@@ -308,6 +347,9 @@ void isr_ieee154e_newSlot(opentimers_id_t id) {
 #endif
         activity_ti1ORri1();
     }
+#ifdef IEEE802154E_PROFILE_ENABLED
+    profileRecord(activity,startTime);
+#endif
     ieee154e_dbg.num_newSlot++;
 }
 
@@ -317,6 +359,14 @@ void isr_ieee154e_newSlot(opentimers_id_t id) {
 This function executes in ISR mode, when the FSM timer fires.
 */
 void isr_ieee154e_timer(opentimers_id_t id) {
+#ifdef IEEE802154E_PROFILE_ENABLED
+    ieee154e_activity_t activity;
+    PORT_TIMER_WIDTH    startTime;
+
+    activity  = profileActivity(PROFILE_EVENT_TIMER);
+    startTime = IEEE802154E_PROFILE_COUNTER();
+#endif
+
     switch (ieee154e_vars.state) {
         case S_TXDATAOFFSET:
             activity_ti2();
@@ -392,6 +442,9 @@ void isr_ieee154e_timer(opentimers_id_t id) {
             endSlot();
             break;
     }
+#ifdef IEEE802154E_PROFILE_ENABLED
+    profileRecord(activity,startTime);
+#endif
     ieee154e_dbg.num_timer++;
 }
 
@@ -414,6 +467,14 @@ This function executes in ISR mode.
 */
 void ieee154e_startOfFrame(PORT_TIMER_WIDTH capturedTime) {
     PORT_TIMER_WIDTH referenceTime = capturedTime - ieee154e_vars.startOfSlotReference;
+#ifdef IEEE802154E_PROFILE_ENABLED
+    ieee154e_activity_t activity;
+    PORT_TIMER_WIDTH    startTime;
+
+    activity  = profileActivity(PROFILE_EVENT_STARTOFFRAME);
+    startTime = IEEE802154E_PROFILE_COUNTER();
+#endif
+
     if (ieee154e_vars.isSync==FALSE) {
         activity_synchronize_startOfFrame(referenceTime);
     } else {
@@ -453,6 +514,9 @@ void ieee154e_startOfFrame(PORT_TIMER_WIDTH capturedTime) {
                 break;
         }
     }
+#ifdef IEEE802154E_PROFILE_ENABLED
+    profileRecord(activity,startTime);
+#endif
     ieee154e_dbg.num_startOfFrame++;
 }
 
@@ -463,6 +527,14 @@ This function executes in ISR mode.
 */
 void ieee154e_endOfFrame(PORT_TIMER_WIDTH capturedTime) {
     PORT_TIMER_WIDTH referenceTime = capturedTime - ieee154e_vars.startOfSlotReference;
+#ifdef IEEE802154E_PROFILE_ENABLED
+    ieee154e_activity_t activity;
+    PORT_TIMER_WIDTH    startTime;
+
+    activity  = profileActivity(PROFILE_EVENT_ENDOFFRAME);
+    startTime = IEEE802154E_PROFILE_COUNTER();
+#endif
+
     if (ieee154e_vars.isSync==FALSE) {
         activity_synchronize_endOfFrame(referenceTime);
     } else {
@@ -491,9 +563,241 @@ void ieee154e_endOfFrame(PORT_TIMER_WIDTH capturedTime) {
                 break;
         }
     }
+#ifdef IEEE802154E_PROFILE_ENABLED
+    profileRecord(activity,startTime);
+#endif
     ieee154e_dbg.num_endOfFrame++;
 }
 
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+//======= look-ahead
+
+/**
+\brief Have the transmissions of the next active slots prepared again.
+
+Called when a packet is handed over to the MAC, and at the end of each active
+slot.
+*/
+void ieee154e_planSlots(void) {
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    if (ieee154e_vars.isSync && ieee154e_vars.slotPlanTaskPending==FALSE) {
+        ieee154e_vars.slotPlanTaskPending = TRUE;
+        scheduler_push_task(task_ieee154eSlotPlan,TASKPRIO_SLOTPLAN);
+    }
+
+    ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Prepare the transmissions of the next active slots.
+
+Posted by ieee154e_planSlots(), this task looks at the next SLOTPLAN_LENGTH
+active slots. For each Tx cell, it picks the packet activity_ti1ORri1() would
+pick there and prepares the frame, secured at the ASN of that slot, so the
+slot only has to load it into the radio.
+
+A plan is only used if, at the start of its slot, the MAC picks the same
+packet, in the same state, on the same frequency, with the same packets
+aggregated in its frame. Otherwise the frame is prepared in the slot as
+before. EBs are not planned, since their ASN and join priority are written at
+the start of the slot.
+*/
+void task_ieee154eSlotPlan(void) {
+    slotPlanKey_t      upcoming[SLOTPLAN_LENGTH];
+    uint8_t            numUpcoming;
+    slotinfo_element_t info;
+    frameLength_t      frameLength;
+    slotOffset_t       slotOffset;
+    uint16_t           numSlots;
+    uint16_t           delta;
+    OpenQueueEntry_t*  candidate;
+#ifdef IEEE802154E_BURST_ENABLED
+    OpenQueueEntry_t*  lastInFrame;
+#endif
+    slotPlan_t*        plan;
+    uint8_t            asn[5];
+    bool               isPlanned;
+    uint8_t            i;
+    uint8_t            j;
+
+    INTERRUPT_DECLARATION();
+
+    DISABLE_INTERRUPTS();
+
+    ieee154e_vars.slotPlanTaskPending = FALSE;
+
+    frameLength = schedule_getFrameLength();
+    numUpcoming = 0;
+    if (
+        ieee154e_vars.isSync                                         &&
+        frameLength > 0                                              &&
+        (idmanager_getIsSlotSkip()==FALSE || idmanager_getIsDAGroot())
+    ) {
+        // list the transmissions of the next active slots, at the current ASN
+        slotOffset = ieee154e_vars.slotOffset;
+        numSlots   = 0;
+        for (i=0;i<SLOTPLAN_LENGTH;i++) {
+            schedule_getNextActiveSlotInfo(i+1,&info);
+            if (info.link_type==CELLTYPE_OFF) {
+                // empty schedule
+                break;
+            }
+            delta = (info.slotOffset+frameLength-slotOffset)%frameLength;
+            if (delta==0) {
+                delta = frameLength;
+            }
+            numSlots   += delta;
+            slotOffset  = info.slotOffset;
+
+            if (info.link_type!=CELLTYPE_TX && info.link_type!=CELLTYPE_TXRX) {
+                continue;
+            }
+            if (packetfunctions_isBroadcastMulticast(&info.address)==FALSE) {
+                candidate = openqueue_macGetUnicastPakcet(&info.address);
+                if (candidate==NULL) {
+                    candidate = openqueue_macGetKaPacket(&info.address);
+                }
+            } else {
+                candidate = openqueue_macGetDIOPacket();
+            }
+            if (candidate==NULL) {
+                continue;
+            }
+
+            memcpy(&upcoming[numUpcoming].asn,&ieee154e_vars.asn,sizeof(asn_t));
+            upcoming[numUpcoming].asn.bytes0and1 += numSlots;
+            if (upcoming[numUpcoming].asn.bytes0and1 < numSlots) {
+                upcoming[numUpcoming].asn.bytes2and3++;
+                if (upcoming[numUpcoming].asn.bytes2and3==0) {
+                    upcoming[numUpcoming].asn.byte4++;
+                }
+            }
+            upcoming[numUpcoming].freq          = calculateFrequencyAt(
+                (ieee154e_vars.asnOffset+numSlots)%NUM_CHANNELS,
+                info.channelOffset
+            );
+            upcoming[numUpcoming].dataToSend    = candidate;
+            upcoming[numUpcoming].dsn           = candidate->l2_dsn;
+            upcoming[numUpcoming].numTxAttempts = candidate->l2_numTxAttempts;
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+            upcoming[numUpcoming].numAggregated = selectAggregatedPackets(
+                candidate,
+                upcoming[numUpcoming].aggregated
+            );
+            for (j=0;j<upcoming[numUpcoming].numAggregated;j++) {
+                upcoming[numUpcoming].aggregatedDsn[j] = upcoming[numUpcoming].aggregated[j]->l2_dsn;
+            }
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+            // as activity_ti1ORri1() would decide it outside of a burst
+            lastInFrame = candidate;
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+            if (upcoming[numUpcoming].numAggregated>0) {
+                lastInFrame = upcoming[numUpcoming].aggregated[upcoming[numUpcoming].numAggregated-1];
+            }
+#endif
+            upcoming[numUpcoming].framePending =
+                info.shared==FALSE &&
+                isBurstPending(lastInFrame,info.slotOffset,0);
+#endif
+            numUpcoming++;
+        }
+    }
+
+    // drop the plans which are not for one of those
+    for (j=0;j<SLOTPLAN_LENGTH;j++) {
+        plan = &ieee154e_vars.slotPlans[j];
+        if (plan->state!=SLOTPLAN_READY) {
+            continue;
+        }
+        isPlanned = FALSE;
+        for (i=0;i<numUpcoming;i++) {
+            if (isSameSlotPlanKey(&plan->key,&upcoming[i])) {
+                isPlanned = TRUE;
+                break;
+            }
+        }
+        if (isPlanned==FALSE) {
+            plan->state = SLOTPLAN_FREE;
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+
+    // prepare the missing ones
+    for (i=0;i<numUpcoming;i++) {
+        DISABLE_INTERRUPTS();
+        plan = NULL;
+        isPlanned = FALSE;
+        for (j=0;j<SLOTPLAN_LENGTH;j++) {
+            if (
+                ieee154e_vars.slotPlans[j].state==SLOTPLAN_READY &&
+                isSameSlotPlanKey(&ieee154e_vars.slotPlans[j].key,&upcoming[i])
+            ) {
+                isPlanned = TRUE;
+            }
+            if (plan==NULL && ieee154e_vars.slotPlans[j].state==SLOTPLAN_FREE) {
+                plan = &ieee154e_vars.slotPlans[j];
+            }
+        }
+        if (isPlanned==FALSE && plan!=NULL) {
+            plan->state = SLOTPLAN_BUILDING;
+        }
+        ENABLE_INTERRUPTS();
+
+        if (isPlanned) {
+            continue;
+        }
+        if (plan==NULL) {
+            // ring full
+            break;
+        }
+
+        // the packet stays in the queue, owned by COMPONENT_SIXTOP_TO_IEEE802154E
+        memcpy(&plan->key,&upcoming[i],sizeof(slotPlanKey_t));
+        packetfunctions_duplicatePacket(&plan->frame,upcoming[i].dataToSend);
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+        aggregateTxFrame(
+            &plan->frame,
+            upcoming[i].dataToSend,
+            upcoming[i].aggregated,
+            upcoming[i].numAggregated
+        );
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+        if (upcoming[i].framePending) {
+            setFramePending(&plan->frame);
+        }
+#endif
+
+        if (plan->frame.l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) {
+            asn[0] = (upcoming[i].asn.bytes0and1     & 0xff);
+            asn[1] = (upcoming[i].asn.bytes0and1/256 & 0xff);
+            asn[2] = (upcoming[i].asn.bytes2and3     & 0xff);
+            asn[3] = (upcoming[i].asn.bytes2and3/256 & 0xff);
+            asn[4] =  upcoming[i].asn.byte4;
+            // with interrupts enabled, a slot needing the crypto engine meanwhile
+            // goes without its frame rather than corrupting this operation
+            if (IEEE802154_security_outgoingFrameSecurityAtAsn(&plan->frame,asn) != E_SUCCESS) {
+                DISABLE_INTERRUPTS();
+                plan->state = SLOTPLAN_FREE;
+                ENABLE_INTERRUPTS();
+                continue;
+            }
+        }
+
+        // add 2 CRC bytes
+        packetfunctions_reserveFooterSize(&plan->frame, 2);
+
+        DISABLE_INTERRUPTS();
+        plan->state = SLOTPLAN_READY;
+        ENABLE_INTERRUPTS();
+    }
+}
+#endif
+
 //======= misc
 
 /**
@@ -506,6 +810,7 @@ status information about several modules in the OpenWSN stack.
 */
 bool debugPrint_asn(void) {
     asn_t output;
+    memset(&output,0,sizeof(asn_t));
     output.byte4         =  ieee154e_vars.asn.byte4;
     output.bytes2and3    =  ieee154e_vars.asn.bytes2and3;
     output.bytes0and1    =  ieee154e_vars.asn.bytes0and1;
@@ -542,6 +847,39 @@ bool debugPrint_macStats(void) {
     return TRUE;
 }
 
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+Prints the execution time of the next activity which ran at least once,
+preceded by its ieee154e_activity_t.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_macProfile(void) {
+#ifdef IEEE802154E_PROFILE_ENABLED
+    uint8_t output[1+sizeof(ieee154e_profile_t)];
+    uint8_t i;
+    INTERRUPT_DECLARATION();
+
+    for (i=0;i<ACTIVITY_MAX;i++) {
+        ieee154e_dbg.profilePrintIdx = (ieee154e_dbg.profilePrintIdx+1)%ACTIVITY_MAX;
+        if (ieee154e_dbg.profile[ieee154e_dbg.profilePrintIdx].count==0) {
+            continue;
+        }
+        output[0] = ieee154e_dbg.profilePrintIdx;
+        DISABLE_INTERRUPTS();
+        memcpy(&output[1],&ieee154e_dbg.profile[ieee154e_dbg.profilePrintIdx],sizeof(ieee154e_profile_t));
+        ENABLE_INTERRUPTS();
+        openserial_printStatus(STATUS_MACPROFILE,output,sizeof(output));
+        return TRUE;
+    }
+#endif
+    return FALSE;
+}
+
 //=========================== private =========================================
 
 //======= SYNCHRONIZING
@@ -871,10 +1209,28 @@ port_INLINE void activity_ti1ORri1(void) {
     uint8_t     asn[5];
     uint8_t     join_priority;
     bool        couldSendEB=FALSE;
+#ifdef SLOT_FSM_IMPLEMENTATION_MULTIPLE_TIMER_INTERRUPT
+    OpenQueueEntry_t* frame;
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+    OpenQueueEntry_t* lastInFrame;
+    bool        burstOnTxCell=FALSE;
+#endif
 
     // increment ASN (do this first so debug pins are in sync)
     incrementAsnOffset();
 
+#ifdef IEEE802154E_BURST_ENABLED
+    // a burst armed in the previous slot continues in this one
+    ieee154e_vars.burst.role         = ieee154e_vars.burst.nextRole;
+    ieee154e_vars.burst.nextRole     = BURST_NONE;
+    ieee154e_vars.burst.framePending = FALSE;
+    ieee154e_vars.burst.inSchedule   = FALSE;
+    if (ieee154e_vars.burst.role!=BURST_TX) {
+        ieee154e_vars.burst.length   = 0;
+    }
+#endif
+
     // wiggle debug pins
     debugpins_slot_toggle();
     if (ieee154e_vars.slotOffset==0) {
@@ -927,6 +1283,9 @@ port_INLINE void activity_ti1ORri1(void) {
 
         // advance the schedule
         schedule_advanceSlot();
+#ifdef IEEE802154E_BURST_ENABLED
+        ieee154e_vars.burst.inSchedule = TRUE;
+#endif
 
         // calculate the frequency to transmit on
         ieee154e_vars.freq = calculateFrequency(schedule_getChannelOffset());
@@ -957,14 +1316,41 @@ port_INLINE void activity_ti1ORri1(void) {
         }
     } else {
         // this is NOT the next active slot, abort
+#ifdef IEEE802154E_BURST_ENABLED
+        // unless it continues a burst
+        if (ieee154e_vars.burst.role==BURST_NONE) {
+            endSlot();
+            return;
+        }
+#else
 
         // abort the slot
         endSlot();
         return;
+#endif
     }
 
     // check the schedule to see what type of slot this is
     cellType = schedule_getType();
+#ifdef IEEE802154E_BURST_ENABLED
+    if (ieee154e_vars.burst.role!=BURST_NONE) {
+        // a managed Tx cell the burst takes still elapses for MSF
+        if (
+            ieee154e_vars.burst.inSchedule                       &&
+            (cellType==CELLTYPE_TX || cellType==CELLTYPE_TXRX)   &&
+            schedule_getShared()==FALSE
+        ) {
+            schedule_getNeighbor(&neighbor);
+            burstOnTxCell = packetfunctions_isBroadcastMulticast(&neighbor)==FALSE;
+        }
+        if (burstOnTxCell && ieee154e_vars.burst.role==BURST_RX) {
+            msf_updateCellsElapsed(&neighbor, CELLTYPE_TX);
+        }
+        // a burst takes the slot, on the channel offset it started on
+        cellType = (ieee154e_vars.burst.role==BURST_TX)?CELLTYPE_TX:CELLTYPE_RX;
+        ieee154e_vars.freq = calculateFrequency(ieee154e_vars.burst.channelOffset);
+    }
+#endif
     switch (cellType) {
         case CELLTYPE_TXRX:
         case CELLTYPE_TX:
@@ -973,6 +1359,25 @@ port_INLINE void activity_ti1ORri1(void) {
             // get the neighbor
             schedule_getNeighbor(&neighbor);
 
+#ifdef IEEE802154E_BURST_ENABLED
+            if (ieee154e_vars.burst.role==BURST_TX) {
+                // the neighbor is listening for the next frame of the burst
+                ieee154e_vars.dataToSend = openqueue_macGetUnicastPakcet(&ieee154e_vars.burst.neighbor);
+                if (ieee154e_vars.dataToSend!=NULL) {
+                    ieee154e_vars.dataToSend->l2_sendOnTxCell = TRUE;
+                }
+                if (burstOnTxCell) {
+                    // the cell is used if the burst is with its neighbor
+                    if (
+                        ieee154e_vars.dataToSend!=NULL &&
+                        packetfunctions_sameAddress(&neighbor,&ieee154e_vars.burst.neighbor)
+                    ) {
+                        msf_updateCellsUsed(&neighbor, CELLTYPE_TX);
+                    }
+                    msf_updateCellsElapsed(&neighbor, CELLTYPE_TX);
+                }
+            } else
+#endif
             // check whether we can send
             if (schedule_getOkToSend()) {
                 if (packetfunctions_isBroadcastMulticast(&neighbor)==FALSE){
@@ -1014,6 +1419,26 @@ port_INLINE void activity_ti1ORri1(void) {
                 changeState(S_TXDATAOFFSET);
                 // change owner
                 ieee154e_vars.dataToSend->owner = COMPONENT_IEEE802154E;
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+                // send the packets queued behind it in the same frame, if they fit
+                ieee154e_vars.numAggregated = selectAggregatedPackets(
+                    ieee154e_vars.dataToSend,
+                    ieee154e_vars.aggregated
+                );
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+                // from a dedicated cell, announce the packets queued behind
+                // this frame for the same neighbor
+                lastInFrame = ieee154e_vars.dataToSend;
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+                if (ieee154e_vars.numAggregated>0) {
+                    lastInFrame = ieee154e_vars.aggregated[ieee154e_vars.numAggregated-1];
+                }
+#endif
+                ieee154e_vars.burst.framePending =
+                    (ieee154e_vars.burst.role==BURST_TX || schedule_getShared()==FALSE) &&
+                    isBurstPending(lastInFrame,ieee154e_vars.slotOffset,ieee154e_vars.burst.length);
+#endif
                 if (couldSendEB==TRUE) {        // I will be sending an EB
                     //copy synch IE  -- should be Little endian???
                     // fill in the ASN field of the EB
@@ -1022,33 +1447,38 @@ port_INLINE void activity_ti1ORri1(void) {
                     memcpy(ieee154e_vars.dataToSend->l2_ASNpayload,&asn[0],sizeof(asn_t));
                     memcpy(ieee154e_vars.dataToSend->l2_ASNpayload+sizeof(asn_t),&join_priority,sizeof(uint8_t));
                 }
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+                else {
+                    // use the frame prepared ahead of this slot, if any
+                    ieee154e_vars.slotPlan = findSlotPlan(ieee154e_vars.dataToSend);
+                }
+#endif
                 // record that I attempt to transmit this packet
                 ieee154e_vars.dataToSend->l2_numTxAttempts++;
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+                for (i=0;i<ieee154e_vars.numAggregated;i++) {
+                    ieee154e_vars.aggregated[i]->owner = COMPONENT_IEEE802154E;
+                    ieee154e_vars.aggregated[i]->l2_numTxAttempts++;
+                }
+                ieee154e_dbg.num_aggregated += ieee154e_vars.numAggregated;
+#endif
 #ifdef SLOT_FSM_IMPLEMENTATION_MULTIPLE_TIMER_INTERRUPT
                 // 1. schedule timer for loading packet
                 sctimer_scheduleActionIn(ACTION_LOAD_PACKET, ieee154e_vars.startOfSlotReference+DURATION_tt1);
                 // prepare the packet for load packet action at DURATION_tt1
-                // make a local copy of the frame
-                packetfunctions_duplicatePacket(&ieee154e_vars.localCopyForTransmission, ieee154e_vars.dataToSend);
-
-                // check if packet needs to be encrypted/authenticated before transmission
-                if (ieee154e_vars.localCopyForTransmission.l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) { // security enabled
-                    // encrypt in a local copy
-                    if (IEEE802154_security_outgoingFrameSecurity(&ieee154e_vars.localCopyForTransmission) != E_SUCCESS) {
-                        // keep the frame in the OpenQueue in order to retry later
-                        endSlot(); // abort
-                        return;
-                    }
+                frame = prepareTxFrame();
+                if (frame==NULL) {
+                    // keep the frame in the OpenQueue in order to retry later
+                    endSlot(); // abort
+                    return;
                 }
-                // add 2 CRC bytes only to the local copy as we end up here for each retransmission
-                packetfunctions_reserveFooterSize(&ieee154e_vars.localCopyForTransmission, 2);
-                
+
                 // configure the radio to listen to the default synchronizing channel
                 radio_setFrequency(ieee154e_vars.freq, FREQ_TX);
 
                 // set the tx buffer address and length register.(packet is NOT loaded at this moment)
-                radio_loadPacket_prepare(ieee154e_vars.localCopyForTransmission.payload,
-                                     ieee154e_vars.localCopyForTransmission.length);
+                radio_loadPacket_prepare(frame->payload,
+                                     frame->length);
                 // 2. schedule timer for sending packet
                 sctimer_scheduleActionIn(ACTION_SEND_PACKET,  ieee154e_vars.startOfSlotReference+DURATION_tt2);
                 // 3. schedule timer radio tx watchdog
@@ -1110,6 +1540,9 @@ port_INLINE void activity_ti1ORri1(void) {
 }
 
 port_INLINE void activity_ti2(void) {
+#ifndef SLOT_FSM_IMPLEMENTATION_MULTIPLE_TIMER_INTERRUPT
+    OpenQueueEntry_t* frame;
+#endif
 
     // change state
     changeState(S_TXDATAPREPARE);
@@ -1126,28 +1559,19 @@ port_INLINE void activity_ti2(void) {
     );
     // radiotimer_schedule(DURATION_tt2);
 
-    // make a local copy of the frame
-    packetfunctions_duplicatePacket(&ieee154e_vars.localCopyForTransmission, ieee154e_vars.dataToSend);
-
-    // check if packet needs to be encrypted/authenticated before transmission
-    if (ieee154e_vars.localCopyForTransmission.l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) { // security enabled
-        // encrypt in a local copy
-        if (IEEE802154_security_outgoingFrameSecurity(&ieee154e_vars.localCopyForTransmission) != E_SUCCESS) {
-            // keep the frame in the OpenQueue in order to retry later
-            endSlot(); // abort
-            return;
-        }
+    frame = prepareTxFrame();
+    if (frame==NULL) {
+        // keep the frame in the OpenQueue in order to retry later
+        endSlot(); // abort
+        return;
     }
 
-    // add 2 CRC bytes only to the local copy as we end up here for each retransmission
-    packetfunctions_reserveFooterSize(&ieee154e_vars.localCopyForTransmission, 2);
-
     // configure the radio to listen to the default synchronizing channel
     radio_setFrequency(ieee154e_vars.freq, FREQ_TX);
 
     // load the packet in the radio's Tx buffer
-    radio_loadPacket(ieee154e_vars.localCopyForTransmission.payload,
-                    ieee154e_vars.localCopyForTransmission.length);
+    radio_loadPacket(frame->payload,
+                    frame->length);
 #endif
     // enable the radio in Tx mode. This does not send the packet.
     radio_txEnable();
@@ -1305,7 +1729,12 @@ port_INLINE void activity_ti5(PORT_TIMER_WIDTH capturedTime) {
 #endif
     } else {
         // indicate succesful Tx to schedule to keep statistics
-        schedule_indicateTx(&ieee154e_vars.asn,TRUE);
+        if (isScheduledSlot()) {
+            schedule_indicateTx(&ieee154e_vars.asn,TRUE);
+        }
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+        notif_sendDoneAggregated(E_SUCCESS);
+#endif
         // indicate to upper later the packet was sent successfully
         notif_sendDone(ieee154e_vars.dataToSend,E_SUCCESS);
         // reset local variable
@@ -1380,7 +1809,13 @@ port_INLINE void activity_ti7(void) {
 
 port_INLINE void activity_tie5(void) {
     // indicate transmit failed to schedule to keep stats
-    schedule_indicateTx(&ieee154e_vars.asn,FALSE);
+    if (isScheduledSlot()) {
+        schedule_indicateTx(&ieee154e_vars.asn,FALSE);
+    }
+
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+    notif_sendDoneAggregated(E_FAIL);
+#endif
 
     // decrement transmits left counter
     ieee154e_vars.dataToSend->l2_retriesLeft--;
@@ -1571,9 +2006,24 @@ port_INLINE void activity_ti9(PORT_TIMER_WIDTH capturedTime) {
         }
 
         // inform schedule of successful transmission
-        schedule_indicateTx(&ieee154e_vars.asn,TRUE);
+        if (isScheduledSlot()) {
+            schedule_indicateTx(&ieee154e_vars.asn,TRUE);
+        }
+
+#ifdef IEEE802154E_BURST_ENABLED
+        if (ieee154e_vars.burst.role==BURST_TX) {
+            ieee154e_dbg.num_burstTx++;
+        }
+        if (ieee154e_vars.burst.framePending && ieee802514_header.framePending==TRUE) {
+            // the neighbor listens in the next slot, send the next frame there
+            armBurst(BURST_TX,&(ieee154e_vars.dataToSend->l2_nextORpreviousHop));
+        }
+#endif
 
         // inform upper layer
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+        notif_sendDoneAggregated(E_SUCCESS);
+#endif
         notif_sendDone(ieee154e_vars.dataToSend,E_SUCCESS);
         ieee154e_vars.dataToSend = NULL;
 
@@ -1859,6 +2309,18 @@ port_INLINE void activity_ri5(PORT_TIMER_WIDTH capturedTime) {
         // record the timeCorrection and print out at end of slot
         ieee154e_vars.dataReceived->l2_timeCorrection = (PORT_SIGNED_INT_WIDTH)((PORT_SIGNED_INT_WIDTH)TsTxOffset-(PORT_SIGNED_INT_WIDTH)ieee154e_vars.syncCapturedTime);
 
+#ifdef IEEE802154E_BURST_ENABLED
+        if (ieee154e_vars.burst.role==BURST_RX) {
+            ieee154e_dbg.num_burstRx++;
+        }
+        // the ACK tells the sender whether I listen for the burst it announces
+        ieee154e_vars.burst.framePending =
+            ieee802514_header.framePending==TRUE &&
+            ieee802514_header.ackRequested==1    &&
+            ieee154e_vars.isAckEnabled==TRUE     &&
+            isBurstAccepted(&ieee802514_header.src);
+#endif
+
         // check if ack requested
         if (ieee802514_header.ackRequested==1 && ieee154e_vars.isAckEnabled == TRUE) {
 #ifdef SLOT_FSM_IMPLEMENTATION_MULTIPLE_TIMER_INTERRUPT
@@ -1904,6 +2366,11 @@ port_INLINE void activity_ri5(PORT_TIMER_WIDTH capturedTime) {
                 ieee154e_vars.dataReceived->l2_dsn,
                 &(ieee154e_vars.dataReceived->l2_nextORpreviousHop)
             );
+#ifdef IEEE802154E_BURST_ENABLED
+            if (ieee154e_vars.burst.framePending) {
+                setFramePending(ieee154e_vars.ackToSend);
+            }
+#endif
 
             // if security is enabled, encrypt directly in OpenQueue as there are no retransmissions for ACKs
             if (ieee154e_vars.ackToSend->l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) {
@@ -2039,6 +2506,11 @@ port_INLINE void activity_ri6(void) {
                             ieee154e_vars.dataReceived->l2_dsn,
                             &(ieee154e_vars.dataReceived->l2_nextORpreviousHop)
                             );
+#ifdef IEEE802154E_BURST_ENABLED
+    if (ieee154e_vars.burst.framePending) {
+        setFramePending(ieee154e_vars.ackToSend);
+    }
+#endif
 
     // if security is enabled, encrypt directly in OpenQueue as there are no retransmissions for ACKs
     if (ieee154e_vars.ackToSend->l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) {
@@ -2185,6 +2657,13 @@ port_INLINE void activity_ri9(PORT_TIMER_WIDTH capturedTime) {
         synchronizePacket(ieee154e_vars.syncCapturedTime);
     }
 
+#ifdef IEEE802154E_BURST_ENABLED
+    if (ieee154e_vars.burst.framePending) {
+        // the ACK told the sender to send its next frame in the next slot
+        armBurst(BURST_RX,&(ieee154e_vars.dataReceived->l2_nextORpreviousHop));
+    }
+#endif
+
     // inform upper layer of reception (after ACK sent)
     notif_receive(ieee154e_vars.dataReceived);
 
@@ -2195,6 +2674,498 @@ port_INLINE void activity_ri9(PORT_TIMER_WIDTH capturedTime) {
     endSlot();
 }
 
+//======= look-ahead
+
+/**
+\brief Get the frame to load into the radio for ieee154e_vars.dataToSend.
+
+This is the frame prepared ahead of the slot by task_ieee154eSlotPlan() if
+there is one, otherwise a local copy of the packet, secured now.
+
+\returns The frame, or NULL if it could not be secured.
+*/
+port_INLINE OpenQueueEntry_t* prepareTxFrame(void) {
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+    if (ieee154e_vars.slotPlan!=NULL) {
+        ieee154e_dbg.num_slotPlanUsed++;
+        return &ieee154e_vars.slotPlan->frame;
+    }
+    if (ieee154e_vars.dataToSend->l2_frameType!=IEEE154_TYPE_BEACON) {
+        ieee154e_dbg.num_slotPlanMissed++;
+    }
+#endif
+
+    // make a local copy of the frame
+    packetfunctions_duplicatePacket(&ieee154e_vars.localCopyForTransmission, ieee154e_vars.dataToSend);
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+    aggregateTxFrame(
+        &ieee154e_vars.localCopyForTransmission,
+        ieee154e_vars.dataToSend,
+        ieee154e_vars.aggregated,
+        ieee154e_vars.numAggregated
+    );
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+    if (ieee154e_vars.burst.framePending) {
+        setFramePending(&ieee154e_vars.localCopyForTransmission);
+    }
+#endif
+
+    // check if packet needs to be encrypted/authenticated before transmission
+    if (ieee154e_vars.localCopyForTransmission.l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) { // security enabled
+        // encrypt in a local copy
+        if (IEEE802154_security_outgoingFrameSecurity(&ieee154e_vars.localCopyForTransmission) != E_SUCCESS) {
+            return NULL;
+        }
+    }
+
+    // add 2 CRC bytes only to the local copy as we end up here for each retransmission
+    packetfunctions_reserveFooterSize(&ieee154e_vars.localCopyForTransmission, 2);
+
+    return &ieee154e_vars.localCopyForTransmission;
+}
+
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+/**
+\brief Find the plan prepared for transmitting a packet in the current slot.
+
+Must be called before the packet's l2_numTxAttempts is incremented, and after
+the packets sent in the same frame are selected. The plan found is marked in
+use until endSlot().
+
+\param[in] dataToSend The packet the MAC picked for this slot.
+
+\returns The plan, or NULL if there is none for this packet in this slot.
+*/
+slotPlan_t* findSlotPlan(OpenQueueEntry_t* dataToSend) {
+    slotPlanKey_t key;
+    uint8_t       i;
+
+    memcpy(&key.asn,&ieee154e_vars.asn,sizeof(asn_t));
+    key.freq          = ieee154e_vars.freq;
+    key.dataToSend    = dataToSend;
+    key.dsn           = dataToSend->l2_dsn;
+    key.numTxAttempts = dataToSend->l2_numTxAttempts;
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+    key.numAggregated = ieee154e_vars.numAggregated;
+    for (i=0;i<key.numAggregated;i++) {
+        key.aggregated[i]    = ieee154e_vars.aggregated[i];
+        key.aggregatedDsn[i] = ieee154e_vars.aggregated[i]->l2_dsn;
+    }
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+    key.framePending  = ieee154e_vars.burst.framePending;
+#endif
+
+    for (i=0;i<SLOTPLAN_LENGTH;i++) {
+        if (
+            ieee154e_vars.slotPlans[i].state==SLOTPLAN_READY &&
+            isSameSlotPlanKey(&ieee154e_vars.slotPlans[i].key,&key)
+        ) {
+            ieee154e_vars.slotPlans[i].state = SLOTPLAN_IN_USE;
+            return &ieee154e_vars.slotPlans[i];
+        }
+    }
+    return NULL;
+}
+
+bool isSameSlotPlanKey(slotPlanKey_t* key1, slotPlanKey_t* key2) {
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+    uint8_t i;
+
+    if (key1->numAggregated!=key2->numAggregated) {
+        return FALSE;
+    }
+    for (i=0;i<key1->numAggregated;i++) {
+        if (
+            key1->aggregated[i]    != key2->aggregated[i] ||
+            key1->aggregatedDsn[i] != key2->aggregatedDsn[i]
+        ) {
+            return FALSE;
+        }
+    }
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+    if (key1->framePending!=key2->framePending) {
+        return FALSE;
+    }
+#endif
+    return key1->asn.bytes0and1 == key2->asn.bytes0and1 &&
+           key1->asn.bytes2and3 == key2->asn.bytes2and3 &&
+           key1->asn.byte4      == key2->asn.byte4      &&
+           key1->freq           == key2->freq           &&
+           key1->dataToSend     == key2->dataToSend     &&
+           key1->dsn            == key2->dsn            &&
+           key1->numTxAttempts  == key2->numTxAttempts;
+}
+#endif
+
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+//======= aggregation
+
+/**
+\brief Pick the packets to send in the same frame as a unicast packet.
+
+These are the next packets queued for the same neighbor which can share its
+frame, oldest first, as long as the frame still fits in IEEE802154_FRAME_SIZE
+bytes.
+
+\param[in]  dataToSend The packet the MAC picked.
+\param[out] aggregated The packets to send with it, at most
+   AGGREGATION_MAX_PACKETS-1.
+
+\returns The number of packets written to aggregated.
+*/
+uint8_t selectAggregatedPackets(OpenQueueEntry_t* dataToSend, OpenQueueEntry_t** aggregated) {
+    OpenQueueEntry_t* packet;
+    uint8_t           numAggregated;
+    uint16_t          length;
+    uint16_t          maxLength;
+    uint8_t           payloadLength;
+
+    if (isAggregatable(dataToSend,dataToSend)==FALSE) {
+        return 0;
+    }
+
+    // MAC header, dispatch, then each payload after its length
+    length    = dataToSend->length+2;
+    // the MIC and CRC are added to that
+    maxLength = IEEE802154_FRAME_SIZE-IEEE802154_security_authLengthChecking(dataToSend->l2_securityLevel)-2;
+
+    numAggregated = 0;
+    packet        = openqueue_macGetNextUnicastPacket(dataToSend);
+    while (packet!=NULL && numAggregated<AGGREGATION_MAX_PACKETS-1) {
+        if (isAggregatable(dataToSend,packet)) {
+            payloadLength = packet->length-(packet->l2_payload-packet->payload);
+            if (length+1+payloadLength>maxLength) {
+                // don't reorder the packets to that neighbor
+                break;
+            }
+            aggregated[numAggregated++] = packet;
+            length += 1+payloadLength;
+        }
+        packet = openqueue_macGetNextUnicastPacket(packet);
+    }
+    return numAggregated;
+}
+
+/**
+\brief Tell whether a packet can be sent in the frame of another one.
+
+The MAC payload of unicast data frames without payload IEs is a 6LoWPAN packet,
+which can move to another frame. That frame is secured as a whole, so both
+need the same security settings.
+*/
+bool isAggregatable(OpenQueueEntry_t* dataToSend, OpenQueueEntry_t* packet) {
+    return packet->l2_frameType        == IEEE154_TYPE_DATA               &&
+           packet->l2_payloadIEpresent == FALSE                           &&
+           packet->is_big_packet       == FALSE                           &&
+           packet->creator             != COMPONENT_SIXTOP                && // KA
+           packet->l2_securityLevel    == dataToSend->l2_securityLevel    &&
+           packet->l2_keyIdMode        == dataToSend->l2_keyIdMode        &&
+           packet->l2_keyIndex         == dataToSend->l2_keyIndex         &&
+           packetfunctions_isBroadcastMulticast(&packet->l2_nextORpreviousHop)==FALSE;
+}
+
+/**
+\brief Put the packets sent with dataToSend in its frame.
+
+The MAC payload of the frame becomes AGGREGATION_DISPATCH, then the payload of
+dataToSend and of each aggregated packet, each preceded by its length on one
+byte. sixtop_receiveAggregated() splits it on the receiving side.
+
+\param[out] frame         A copy of dataToSend, not secured yet.
+\param[in]  dataToSend    The packet the MAC picked.
+\param[in]  aggregated    The packets sent with it.
+\param[in]  numAggregated The number of those packets.
+*/
+void aggregateTxFrame(
+        OpenQueueEntry_t*  frame,
+        OpenQueueEntry_t*  dataToSend,
+        OpenQueueEntry_t** aggregated,
+        uint8_t            numAggregated
+    ) {
+    uint8_t* start;
+    uint8_t* ptr;
+    uint8_t  headerLength;
+    uint8_t  payloadLength;
+    uint8_t  length;
+    uint8_t  i;
+
+    if (numAggregated==0) {
+        return;
+    }
+
+    headerLength = dataToSend->l2_payload-dataToSend->payload;
+    length       = dataToSend->length+2;
+    for (i=0;i<numAggregated;i++) {
+        length  += 1+aggregated[i]->length-(aggregated[i]->l2_payload-aggregated[i]->payload);
+    }
+
+    // end the frame where its MIC and CRC still fit in the buffer
+    start = &frame->packet[IEEE802154_FRAME_SIZE-IEEE802154_security_authLengthChecking(frame->l2_securityLevel)]-length;
+
+    // built from the queued packets, the bytes of the copy get overwritten
+    ptr = start;
+    memcpy(ptr,dataToSend->payload,headerLength);
+    ptr += headerLength;
+    *ptr++ = AGGREGATION_DISPATCH;
+    payloadLength = dataToSend->length-headerLength;
+    *ptr++ = payloadLength;
+    memcpy(ptr,dataToSend->l2_payload,payloadLength);
+    ptr += payloadLength;
+    for (i=0;i<numAggregated;i++) {
+        payloadLength = aggregated[i]->length-(aggregated[i]->l2_payload-aggregated[i]->payload);
+        *ptr++ = payloadLength;
+        memcpy(ptr,aggregated[i]->l2_payload,payloadLength);
+        ptr += payloadLength;
+    }
+
+    // update the pointers into the frame
+    frame->l2_FrameCounter = start+(dataToSend->l2_FrameCounter-dataToSend->payload);
+    frame->l2_payload      = start+headerLength;
+    frame->payload         = start;
+    frame->length          = length;
+}
+
+/**
+\brief Report the outcome of a transmission to the packets aggregated in the
+   frame of dataToSend.
+
+Called before dataToSend itself is reported. Packets sent in the same frame
+are handed to sixtop together, by the task posted for dataToSend, or by one
+posted here if dataToSend stays in the queue for another attempt.
+
+\param[in] error E_SUCCESS if the frame was acknowledged, E_FAIL otherwise.
+*/
+void notif_sendDoneAggregated(owerror_t error) {
+    OpenQueueEntry_t* packet;
+    bool              isTaskPosted;
+    bool              isDone;
+    uint8_t           i;
+
+    // dataToSend is done unless it has retries left
+    isTaskPosted = (error==E_SUCCESS || ieee154e_vars.dataToSend->l2_retriesLeft==1);
+
+    isDone = FALSE;
+    for (i=0;i<ieee154e_vars.numAggregated;i++) {
+        packet = ieee154e_vars.aggregated[i];
+        if (error!=E_SUCCESS) {
+            packet->l2_retriesLeft--;
+        }
+        if (error==E_SUCCESS || packet->l2_retriesLeft==0) {
+            // same as notif_sendDone(), the task is posted once
+            packet->l2_sendDoneError = error;
+            memcpy(&packet->l2_asn,&ieee154e_vars.asn,sizeof(asn_t));
+            packet->owner            = COMPONENT_IEEE802154E_TO_SIXTOP;
+            isDone                   = TRUE;
+        } else {
+            // return packet to the virtual COMPONENT_SIXTOP_TO_IEEE802154E component
+            packet->owner            = COMPONENT_SIXTOP_TO_IEEE802154E;
+        }
+    }
+    ieee154e_vars.numAggregated = 0;
+
+    if (isDone && isTaskPosted==FALSE) {
+        scheduler_push_task(task_sixtopNotifSendDone,TASKPRIO_SIXTOP_NOTIF_TXDONE);
+        SCHEDULER_WAKEUP();
+    }
+}
+#endif
+
+#ifdef IEEE802154E_BURST_ENABLED
+//======= burst
+
+/**
+\brief Tell whether a unicast frame announces a burst.
+
+It does, with its frame pending bit, when more packets for the same neighbor
+are queued behind the ones it carries, the burst is shorter than
+BURST_MAX_LENGTH frames, and the slot after the frame's can carry the next one.
+A mote skipping slots is already asleep in that slot, so it never bursts.
+
+\param[in] lastInFrame The last packet the frame carries.
+\param[in] slotOffset  The slot offset the frame is sent at.
+\param[in] burstLength The number of frames of the burst sent before this one.
+
+\returns TRUE to set the frame pending bit, FALSE otherwise.
+*/
+bool isBurstPending(OpenQueueEntry_t* lastInFrame, slotOffset_t slotOffset, uint8_t burstLength) {
+    if (
+        burstLength+1>=BURST_MAX_LENGTH                                          ||
+        packetfunctions_isBroadcastMulticast(&lastInFrame->l2_nextORpreviousHop) ||
+        (idmanager_getIsSlotSkip() && idmanager_getIsDAGroot()==FALSE)           ||
+        openqueue_macGetNextUnicastPacket(lastInFrame)==NULL
+    ) {
+        return FALSE;
+    }
+    return schedule_getOkToBurst(
+        (slotOffset+1)%schedule_getFrameLength(),
+        CELLTYPE_TX,
+        &lastInFrame->l2_nextORpreviousHop
+    );
+}
+
+/**
+\brief Tell whether to listen for the burst a neighbor announces.
+
+The answer goes back in the frame pending bit of the ACK, and the neighbor only
+sends in the next slot if it is set.
+
+\param[in] neighbor The neighbor announcing the burst.
+
+\returns TRUE to listen to it in the next slot, FALSE otherwise.
+*/
+bool isBurstAccepted(open_addr_t* neighbor) {
+    if (idmanager_getIsSlotSkip() && idmanager_getIsDAGroot()==FALSE) {
+        return FALSE;
+    }
+    return schedule_getOkToBurst(
+        (ieee154e_vars.slotOffset+1)%schedule_getFrameLength(),
+        CELLTYPE_RX,
+        neighbor
+    );
+}
+
+/**
+\brief Set the frame pending bit of a frame, before it is secured.
+*/
+void setFramePending(OpenQueueEntry_t* frame) {
+    frame->payload[0] |= IEEE154_PENDING_YES_FRAMEPENDING << IEEE154_FCF_FRAME_PENDING;
+}
+
+/**
+\brief Make the next slot part of the burst of this one, or start a burst.
+
+\param[in] role     BURST_TX to send the next frame, BURST_RX to listen for it.
+\param[in] neighbor The neighbor of the burst.
+*/
+void armBurst(burstRole_t role, open_addr_t* neighbor) {
+    if (ieee154e_vars.burst.role==BURST_NONE) {
+        // the burst stays on the channel offset of the cell it starts in
+        ieee154e_vars.burst.channelOffset = schedule_getChannelOffset();
+    }
+    if (role==BURST_TX) {
+        ieee154e_vars.burst.length++;
+    }
+    ieee154e_vars.burst.nextRole = role;
+    memcpy(&ieee154e_vars.burst.neighbor,neighbor,sizeof(open_addr_t));
+}
+#endif
+
+#ifdef IEEE802154E_PROFILE_ENABLED
+//======= profiling
+
+/**
+\brief Tell which activity an event is about to run.
+
+Mirrors the dispatching done by isr_ieee154e_newSlot(), isr_ieee154e_timer(),
+ieee154e_startOfFrame() and ieee154e_endOfFrame(), so it must be called before
+the activity changes the state.
+
+\returns The activity, ACTIVITY_MAX if the event is unexpected in this state.
+*/
+ieee154e_activity_t profileActivity(ieee154e_profileEvent_t event) {
+    if (event==PROFILE_EVENT_NEWSLOT) {
+        return (ieee154e_vars.isSync)?ACTIVITY_TI1ORRI1:ACTIVITY_SYNC_NEWSLOT;
+    }
+    if (ieee154e_vars.isSync==FALSE) {
+        switch (event) {
+            case PROFILE_EVENT_STARTOFFRAME: return ACTIVITY_SYNC_STARTOFFRAME;
+            case PROFILE_EVENT_ENDOFFRAME:   return ACTIVITY_SYNC_ENDOFFRAME;
+            default:                         return ACTIVITY_MAX;
+        }
+    }
+    switch (event) {
+        case PROFILE_EVENT_TIMER:
+            switch (ieee154e_vars.state) {
+                case S_TXDATAOFFSET:  return ACTIVITY_TI2;
+                case S_TXDATAPREPARE: return ACTIVITY_TIE1;
+                case S_TXDATAREADY:   return ACTIVITY_TI3;
+                case S_TXDATADELAY:   return ACTIVITY_TIE2;
+                case S_TXDATA:        return ACTIVITY_TIE3;
+                case S_RXACKOFFSET:   return ACTIVITY_TI6;
+                case S_RXACKPREPARE:  return ACTIVITY_TIE4;
+                case S_RXACKREADY:    return ACTIVITY_TI7;
+                case S_RXACKLISTEN:   return ACTIVITY_TIE5;
+                case S_RXACK:         return ACTIVITY_TIE6;
+                case S_RXDATAOFFSET:  return ACTIVITY_RI2;
+                case S_RXDATAPREPARE: return ACTIVITY_RIE1;
+                case S_RXDATAREADY:   return ACTIVITY_RI3;
+                case S_RXDATALISTEN:  return ACTIVITY_RIE2;
+                case S_RXDATA:        return ACTIVITY_RIE3;
+                case S_TXACKOFFSET:   return ACTIVITY_RI6;
+                case S_TXACKPREPARE:  return ACTIVITY_RIE4;
+                case S_TXACKREADY:    return ACTIVITY_RI7;
+                case S_TXACKDELAY:    return ACTIVITY_RIE5;
+                case S_TXACK:         return ACTIVITY_RIE6;
+                default:              return ACTIVITY_MAX;
+            }
+        case PROFILE_EVENT_STARTOFFRAME:
+            switch (ieee154e_vars.state) {
+                case S_TXDATADELAY:   return ACTIVITY_TI4;
+                case S_RXACKREADY:
+                case S_RXACKLISTEN:   return ACTIVITY_TI8;
+                case S_RXDATAREADY:
+                case S_RXDATALISTEN:  return ACTIVITY_RI4;
+                case S_TXACKDELAY:    return ACTIVITY_RI8;
+                default:              return ACTIVITY_MAX;
+            }
+        case PROFILE_EVENT_ENDOFFRAME:
+            switch (ieee154e_vars.state) {
+                case S_TXDATA:        return ACTIVITY_TI5;
+                case S_RXACK:         return ACTIVITY_TI9;
+                case S_RXDATA:        return ACTIVITY_RI5;
+                case S_TXACK:         return ACTIVITY_RI9;
+                default:              return ACTIVITY_MAX;
+            }
+        default:
+            return ACTIVITY_MAX;
+    }
+}
+
+/**
+\brief Record the execution time of an activity which just returned.
+
+\param[in] activity  The activity, as returned by profileActivity().
+\param[in] startTime IEEE802154E_PROFILE_COUNTER() when it was entered.
+*/
+void profileRecord(ieee154e_activity_t activity, PORT_TIMER_WIDTH startTime) {
+    PORT_TIMER_WIDTH    duration;
+    ieee154e_profile_t* profile;
+    uint8_t             bin;
+
+    if (activity>=ACTIVITY_MAX) {
+        return;
+    }
+    duration = (PORT_TIMER_WIDTH)(IEEE802154E_PROFILE_COUNTER()-startTime);
+    if (duration>0xffff) {
+        duration = 0xffff;
+    }
+    profile = &ieee154e_dbg.profile[activity];
+
+    if (profile->count==0 || duration<profile->minDuration) {
+        profile->minDuration = (uint16_t)duration;
+    }
+    if (duration>profile->maxDuration) {
+        profile->maxDuration = (uint16_t)duration;
+    }
+    if (profile->count<0xffff) {
+        profile->count++;
+    }
+
+    // bin i>0 holds the durations of i significant bits
+    bin = 0;
+    while (duration>0 && bin<PROFILE_NUMBINS-1) {
+        duration >>= 1;
+        bin++;
+    }
+    if (profile->histogram[bin]<0xffff) {
+        profile->histogram[bin]++;
+    }
+}
+#endif
+
 //======= frame validity check
 
 /**
@@ -2727,6 +3698,10 @@ void changeIsSync(bool newIsSync) {
     } else {
         leds_sync_off();
         schedule_resetBackoff();
+#ifdef IEEE802154E_BURST_ENABLED
+        ieee154e_vars.burst.role     = BURST_NONE;
+        ieee154e_vars.burst.nextRole = BURST_NONE;
+#endif
     }
 }
 
@@ -2750,7 +3725,9 @@ void notif_receive(OpenQueueEntry_t* packetReceived) {
     // record the current ASN
     memcpy(&packetReceived->l2_asn, &ieee154e_vars.asn, sizeof(asn_t));
     // indicate reception to the schedule, to keep statistics
-    schedule_indicateRx(&packetReceived->l2_asn);
+    if (isScheduledSlot()) {
+        schedule_indicateRx(&packetReceived->l2_asn);
+    }
     // associate this packet with the virtual component
     // COMPONENT_IEEE802154E_TO_SIXTOP so sixtop can knows it's for it
     packetReceived->owner          = COMPONENT_IEEE802154E_TO_SIXTOP;
@@ -2785,6 +3762,21 @@ void updateStats(PORT_SIGNED_INT_WIDTH timeCorrection) {
 
 //======= misc
 
+/**
+\brief Tell whether the current slot is an active slot of the schedule.
+
+Only those go past activity_ti1ORri1(), except for the slots a burst continues
+in: the schedule still points at the previous active cell there, whose
+statistics must not be updated.
+*/
+bool isScheduledSlot(void) {
+#ifdef IEEE802154E_BURST_ENABLED
+    return ieee154e_vars.burst.role==BURST_NONE || ieee154e_vars.burst.inSchedule;
+#else
+    return TRUE;
+#endif
+}
+
 /**
 \brief Calculates the frequency channel to transmit on, based on the
 absolute slot number and the channel offset of the requested slot.
@@ -2804,13 +3796,26 @@ different channel offsets in the same slot.
 \returns The calculated frequency channel, an integer between 11 and 26.
 */
 port_INLINE uint8_t calculateFrequency(uint8_t channelOffset) {
+    return calculateFrequencyAt(ieee154e_vars.asnOffset, channelOffset);
+    //return 11+(ieee154e_vars.asnOffset+channelOffset)%16; //channel hopping
+}
+
+/**
+\brief Same as calculateFrequency(), for the slot at another offset in the
+hopping sequence.
+
+\param[in] asnOffset     ASN of the slot, modulo NUM_CHANNELS
+\param[in] channelOffset channel offset of that slot
+
+\returns The calculated frequency channel, an integer between 11 and 26.
+*/
+port_INLINE uint8_t calculateFrequencyAt(uint8_t asnOffset, uint8_t channelOffset) {
     if (ieee154e_vars.singleChannel >= 11 && ieee154e_vars.singleChannel <= 26 ) {
         return ieee154e_vars.singleChannel; // single channel
     } else {
         // channel hopping enabled, use the channel depending on hopping template
-        return 11 + ieee154e_vars.chTemplate[(ieee154e_vars.asnOffset+channelOffset)%NUM_CHANNELS];
+        return 11 + ieee154e_vars.chTemplate[(asnOffset+channelOffset)%NUM_CHANNELS];
     }
-    //return 11+(ieee154e_vars.asnOffset+channelOffset)%16; //channel hopping
 }
 
 /**
@@ -2922,7 +3927,13 @@ void endSlot(void) {
         // getting here means transmit failed
 
         // indicate Tx fail to schedule to update stats
-        schedule_indicateTx(&ieee154e_vars.asn,FALSE);
+        if (isScheduledSlot()) {
+            schedule_indicateTx(&ieee154e_vars.asn,FALSE);
+        }
+
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+        notif_sendDoneAggregated(E_FAIL);
+#endif
 
         //decrement transmits left counter
         ieee154e_vars.dataToSend->l2_retriesLeft--;
@@ -2939,6 +3950,18 @@ void endSlot(void) {
         ieee154e_vars.dataToSend = NULL;
     }
 
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+    // release the plan used in this slot, and prepare the next slots after
+    // an active one
+    if (ieee154e_vars.slotPlan!=NULL) {
+        ieee154e_vars.slotPlan->state = SLOTPLAN_FREE;
+        ieee154e_vars.slotPlan        = NULL;
+    }
+    if (schedule_getSlottOffset()==ieee154e_vars.slotOffset) {
+        ieee154e_planSlots();
+    }
+#endif
+
     schedule_getSlotInfo(ieee154e_vars.slotOffset, &info);
     if (info.link_type==CELLTYPE_RX){
         // update numcellelapsed and numcellused on Rx cell
@@ -48,6 +48,23 @@ static const uint8_t ebIEsBytestream[] = {
 #define LENGTH_IEEE154_MAX         128 // max length of a valid radio packet
 #define DUTY_CYCLE_WINDOW_LIMIT    (0xFFFFFFFF>>1) // limit of the dutycycle window
 #define SERIALINHIBITGUARD         (1000/PORT_US_PER_TICK) // 32@32kHz ~ 1ms
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+#define SLOTPLAN_LENGTH              2 // number of upcoming active slots whose transmission is prepared ahead
+#endif
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+#define AGGREGATION_MAX_PACKETS      4 // max number of packets sent in one frame
+#define AGGREGATION_DISPATCH      0x4f // 6LoWPAN dispatch starting an aggregated frame, from the range RFC4944 reserves
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+#define BURST_MAX_LENGTH             8 // max number of frames sent to a neighbor in consecutive slots
+#endif
+#ifdef IEEE802154E_PROFILE_ENABLED
+#define PROFILE_NUMBINS              8 // number of duration bins per activity
+#ifndef IEEE802154E_PROFILE_COUNTER
+// boards may define a finer counter, e.g. a CPU cycle counter, in board_info.h
+#define IEEE802154E_PROFILE_COUNTER() sctimer_readCounter()
+#endif
+#endif
 
 //15.4e information elements related
 #define IEEE802154E_PAYLOAD_DESC_LEN_SHIFT                 0x04
@@ -149,6 +166,70 @@ typedef enum {
    S_RXPROC                  = 0x19,   // processing received data
 } ieee154e_state_t;
 
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+typedef enum {
+   SLOTPLAN_FREE             = 0x00,   // entry unused
+   SLOTPLAN_BUILDING         = 0x01,   // frame being prepared by the planning task
+   SLOTPLAN_READY            = 0x02,   // frame prepared, waiting for its slot
+   SLOTPLAN_IN_USE           = 0x03,   // frame being transmitted in the current slot
+} slotPlanState_t;
+#endif
+
+#ifdef IEEE802154E_BURST_ENABLED
+typedef enum {
+   BURST_NONE                = 0x00,   // slot not part of a burst
+   BURST_TX                  = 0x01,   // sending the next frame of a burst
+   BURST_RX                  = 0x02,   // listening for the next frame of a burst
+} burstRole_t;
+#endif
+
+#ifdef IEEE802154E_PROFILE_ENABLED
+// the activities of the state machine, as timed by the profiler
+typedef enum {
+   ACTIVITY_SYNC_NEWSLOT     = 0x00,   // activity_synchronize_newSlot
+   ACTIVITY_SYNC_STARTOFFRAME= 0x01,   // activity_synchronize_startOfFrame
+   ACTIVITY_SYNC_ENDOFFRAME  = 0x02,   // activity_synchronize_endOfFrame
+   ACTIVITY_TI1ORRI1         = 0x03,
+   ACTIVITY_TI2              = 0x04,
+   ACTIVITY_TIE1             = 0x05,
+   ACTIVITY_TI3              = 0x06,
+   ACTIVITY_TIE2             = 0x07,
+   ACTIVITY_TI4              = 0x08,
+   ACTIVITY_TIE3             = 0x09,
+   ACTIVITY_TI5              = 0x0a,
+   ACTIVITY_TI6              = 0x0b,
+   ACTIVITY_TIE4             = 0x0c,
+   ACTIVITY_TI7              = 0x0d,
+   ACTIVITY_TIE5             = 0x0e,
+   ACTIVITY_TI8              = 0x0f,
+   ACTIVITY_TIE6             = 0x10,
+   ACTIVITY_TI9              = 0x11,
+   ACTIVITY_RI2              = 0x12,
+   ACTIVITY_RIE1             = 0x13,
+   ACTIVITY_RI3              = 0x14,
+   ACTIVITY_RIE2             = 0x15,
+   ACTIVITY_RI4              = 0x16,
+   ACTIVITY_RIE3             = 0x17,
+   ACTIVITY_RI5              = 0x18,
+   ACTIVITY_RI6              = 0x19,
+   ACTIVITY_RIE4             = 0x1a,
+   ACTIVITY_RI7              = 0x1b,
+   ACTIVITY_RIE5             = 0x1c,
+   ACTIVITY_RI8              = 0x1d,
+   ACTIVITY_RIE6             = 0x1e,
+   ACTIVITY_RI9              = 0x1f,
+   ACTIVITY_MAX              = 0x20,   // also: no activity, e.g. in a wrong state
+} ieee154e_activity_t;
+
+// the entry points of the state machine
+typedef enum {
+   PROFILE_EVENT_NEWSLOT     = 0x00,   // isr_ieee154e_newSlot
+   PROFILE_EVENT_TIMER       = 0x01,   // isr_ieee154e_timer
+   PROFILE_EVENT_STARTOFFRAME= 0x02,   // ieee154e_startOfFrame
+   PROFILE_EVENT_ENDOFFRAME  = 0x03,   // ieee154e_endOfFrame
+} ieee154e_profileEvent_t;
+#endif
+
 #define  TIMESLOT_TEMPLATE_ID         0x00
 #define  CHANNELHOPPING_TEMPLATE_ID   0x00
 
@@ -238,6 +319,57 @@ typedef struct {
    PORT_SIGNED_INT_WIDTH timeCorrection;
 } IEEE802154E_ACK_ht;
 
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+// transmission a plan is prepared for
+typedef struct {
+   asn_t                     asn;                     // ASN of the slot
+   uint8_t                   freq;                    // frequency of the slot
+   OpenQueueEntry_t*         dataToSend;              // packet the MAC picks in that slot
+   uint8_t                   dsn;                     // its sequence number
+   uint8_t                   numTxAttempts;           // its number of attempts before that slot
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+   uint8_t                   numAggregated;           // number of packets aggregated in its frame
+   OpenQueueEntry_t*         aggregated[AGGREGATION_MAX_PACKETS-1];// those packets
+   uint8_t                   aggregatedDsn[AGGREGATION_MAX_PACKETS-1];// their sequence numbers
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+   bool                      framePending;            // whether its frame announces a burst
+#endif
+} slotPlanKey_t;
+
+// transmission prepared ahead of its slot
+typedef struct {
+   slotPlanState_t           state;                   // state of the entry
+   slotPlanKey_t             key;                     // transmission the frame is prepared for
+   OpenQueueEntry_t          frame;                   // secured frame, with room for the CRC
+} slotPlan_t;
+#endif
+
+#ifdef IEEE802154E_BURST_ENABLED
+// frames exchanged with one neighbor in consecutive slots
+typedef struct {
+   burstRole_t               role;                    // role in the current slot
+   burstRole_t               nextRole;                // role in the next slot
+   bool                      inSchedule;              // the current slot is an active slot of the schedule
+   open_addr_t               neighbor;                // neighbor of the burst
+   channelOffset_t           channelOffset;           // channel offset the burst stays on
+   uint8_t                   length;                  // frames of the burst sent before the current slot
+   bool                      framePending;            // frame pending bit of the frame or ACK sent in the current slot
+} burst_t;
+#endif
+
+#ifdef IEEE802154E_PROFILE_ENABLED
+// execution time of one activity, in IEEE802154E_PROFILE_COUNTER() ticks
+BEGIN_PACK
+typedef struct {
+   uint16_t                  count;                   // number of runs, saturates
+   uint16_t                  minDuration;             // shortest run
+   uint16_t                  maxDuration;             // longest run, saturates
+   uint16_t                  histogram[PROFILE_NUMBINS];// runs per bin: 0, 1, 2-3, 4-7, ... ticks, the last bin holding all longer ones
+} ieee154e_profile_t;
+END_PACK
+#endif
+
 //=========================== module variables ================================
 
 typedef struct {
@@ -286,6 +418,21 @@ typedef struct {
     uint32_t                  receivedFrameFromParent; // True when received a frame from parent
 
    uint16_t                  compensatingCounter;
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+   // look-ahead
+   slotPlan_t                slotPlans[SLOTPLAN_LENGTH];// transmissions prepared ahead of their slot
+   slotPlan_t*               slotPlan;                // plan used in the current slot, NULL if none
+   bool                      slotPlanTaskPending;     // TRUE iff task_ieee154eSlotPlan() is posted
+#endif
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+   // aggregation
+   OpenQueueEntry_t*         aggregated[AGGREGATION_MAX_PACKETS-1];// packets sent in the frame of dataToSend
+   uint8_t                   numAggregated;           // number of them
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+   // burst
+   burst_t                   burst;                   // burst the current or next slot is part of
+#endif
 } ieee154e_vars_t;
 
 BEGIN_PACK
@@ -305,6 +452,21 @@ typedef struct {
    PORT_TIMER_WIDTH          num_timer;
    PORT_TIMER_WIDTH          num_startOfFrame;
    PORT_TIMER_WIDTH          num_endOfFrame;
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+   PORT_TIMER_WIDTH          num_slotPlanUsed;        // transmissions loaded from a plan
+   PORT_TIMER_WIDTH          num_slotPlanMissed;      // transmissions other than EBs prepared in the slot
+#endif
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+   PORT_TIMER_WIDTH          num_aggregated;          // packets sent in the frame of another one
+#endif
+#ifdef IEEE802154E_BURST_ENABLED
+   PORT_TIMER_WIDTH          num_burstTx;             // frames acknowledged in a slot continuing a burst
+   PORT_TIMER_WIDTH          num_burstRx;             // frames received in a slot continuing a burst
+#endif
+#ifdef IEEE802154E_PROFILE_ENABLED
+   ieee154e_profile_t        profile[ACTIVITY_MAX];   // execution time of each activity
+   uint8_t                   profilePrintIdx;         // activity printed last over serial
+#endif
 } ieee154e_dbg_t;
 
 //=========================== prototypes ======================================
@@ -331,10 +493,16 @@ void               ieee154e_getTicsInfo(uint32_t* numTicsOn, uint32_t* numTicsTo
 // events
 void               ieee154e_startOfFrame(PORT_TIMER_WIDTH capturedTime);
 void               ieee154e_endOfFrame(PORT_TIMER_WIDTH capturedTime);
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+// look-ahead
+void               ieee154e_planSlots(void);
+void               task_ieee154eSlotPlan(void);
+#endif
 // misc
 bool               debugPrint_asn(void);
 bool               debugPrint_isSync(void);
 bool               debugPrint_macStats(void);
+bool               debugPrint_macProfile(void);
 
 /**
 \}
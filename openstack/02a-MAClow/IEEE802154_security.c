@@ -46,6 +46,8 @@ void IEEE802154_security_init(void) {
    // invalidate data key (key 2)
    ieee802154_security_vars.k2.index = IEEE802154_SECURITY_KEYINDEX_INVALID;
    memset(&ieee802154_security_vars.k2.value[0], 0x00, 16);
+
+   ieee802154_security_vars.busy = FALSE;
       }
 
 uint8_t IEEE802154_security_getBeaconKeyIndex(void) {
@@ -155,8 +157,31 @@ void IEEE802154_security_prependAuxiliarySecurityHeader(OpenQueueEntry_t* msg){
 
 /**
 \brief Key searching and encryption/authentication operations.
+
+Called from the slot ISR. Fails if the ISR interrupted task code using the
+crypto engine, which is not reentrant.
 */
 owerror_t IEEE802154_security_outgoingFrameSecurity(OpenQueueEntry_t*   msg){
+   uint8_t asn[5];
+
+   if (ieee802154_security_vars.busy) {
+      return E_FAIL;
+   }
+
+   ieee154e_getAsn(asn);
+   return IEEE802154_security_outgoingFrameSecurityAtAsn(msg,asn);
+}
+
+/**
+\brief Same as IEEE802154_security_outgoingFrameSecurity(), for a frame sent
+in the slot with the given ASN rather than in the current one.
+
+May be called from a task with interrupts enabled. Meanwhile, the slot ISR
+does not use the crypto engine and fails its own security operations.
+
+\param[in] asn ASN of the slot, in the byte order of ieee154e_getAsn().
+*/
+owerror_t IEEE802154_security_outgoingFrameSecurityAtAsn(OpenQueueEntry_t* msg, uint8_t* asn){
    uint8_t nonce[13];
    uint8_t *key;
    owerror_t outStatus;
@@ -171,7 +196,7 @@ owerror_t IEEE802154_security_outgoingFrameSecurity(OpenQueueEntry_t*   msg){
    memcpy(&nonce[0],idmanager_getMyID(ADDR_64B)->addr_64b,8);
 
    // Fill last 5 bytes with the ASN part of the nonce
-   ieee154e_getAsn(&nonce[8]);
+   memcpy(&nonce[8],asn,5);
    packetfunctions_reverseArrayByteOrder(&nonce[8], 5);  // reverse ASN bytes to big endian 
 
    //identify data to be authenticated and data to be encrypted
@@ -215,6 +240,8 @@ owerror_t IEEE802154_security_outgoingFrameSecurity(OpenQueueEntry_t*   msg){
 
    //Encryption and/or authentication
    // cryptoengine overwrites m[] with ciphertext and appends the MIC
+   // the slot ISR leaves the engine alone until this returns, when run from a task
+   ieee802154_security_vars.busy = TRUE;
    outStatus = cryptoengine_aes_ccms_enc(a,
                                           len_a,
                                           m,
@@ -223,6 +250,7 @@ owerror_t IEEE802154_security_outgoingFrameSecurity(OpenQueueEntry_t*   msg){
                                           2, // L=2 in 15.4 std
                                           key,
                                           msg->l2_authenticationLength);
+   ieee802154_security_vars.busy = FALSE;
 
    //verify that no errors occurred
    if (outStatus != E_SUCCESS) {
@@ -335,6 +363,9 @@ void IEEE802154_security_retrieveAuxiliarySecurityHeader(OpenQueueEntry_t*
 
 /**
 \brief Identification of the key used to protect the frame and unsecuring operations.
+
+Called from the slot ISR. Fails if the ISR interrupted task code using the
+crypto engine, which is not reentrant.
 */
 owerror_t IEEE802154_security_incomingFrame(OpenQueueEntry_t* msg){
    uint8_t nonce[13];
@@ -345,6 +376,10 @@ owerror_t IEEE802154_security_incomingFrame(OpenQueueEntry_t* msg){
    uint8_t len_c;
    uint8_t *key;
 
+   if (ieee802154_security_vars.busy) {
+      return E_FAIL;
+   }
+
    key = msg->l2_frameType == IEEE154_TYPE_BEACON ? ieee802154_security_vars.k1.value : ieee802154_security_vars.k2.value;
 
    // First 8 bytes of the nonce are always the source address of the frame
@@ -550,6 +585,10 @@ owerror_t IEEE802154_security_outgoingFrameSecurity(OpenQueueEntry_t* msg) {
     return E_SUCCESS;
 }
 
+owerror_t IEEE802154_security_outgoingFrameSecurityAtAsn(OpenQueueEntry_t* msg, uint8_t* asn) {
+    return E_SUCCESS;
+}
+
 owerror_t IEEE802154_security_incomingFrame(OpenQueueEntry_t* msg) {
     return E_SUCCESS;
 }
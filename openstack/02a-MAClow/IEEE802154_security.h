@@ -56,6 +56,7 @@ typedef struct {
    bool                    joinPermitted;
    symmetric_key_802154_t  k1;
    symmetric_key_802154_t  k2;
+   bool                    busy;               // crypto engine in use, possibly by an interrupted task
 } ieee802154_security_vars_t;
 
 //=========================== prototypes ======================================
@@ -64,6 +65,7 @@ void        IEEE802154_security_init(void);
 void        IEEE802154_security_prependAuxiliarySecurityHeader(OpenQueueEntry_t* msg);
 void        IEEE802154_security_retrieveAuxiliarySecurityHeader(OpenQueueEntry_t* msg, ieee802154_header_iht* tempheader);
 owerror_t   IEEE802154_security_outgoingFrameSecurity(OpenQueueEntry_t* msg);
+owerror_t   IEEE802154_security_outgoingFrameSecurityAtAsn(OpenQueueEntry_t* msg, uint8_t* asn);
 owerror_t   IEEE802154_security_incomingFrame(OpenQueueEntry_t* msg);
 uint8_t     IEEE802154_security_authLengthChecking(uint8_t securityLevel);
 uint8_t     IEEE802154_security_auxLengthChecking(uint8_t keyIdMode, uint8_t frameCounterSuppression, uint8_t frameCounterSize);
@@ -397,7 +397,11 @@ bool msf_candidateAddCellList(
     numCandCells=0;
     for(i=0;i<CELLLIST_MAX_LEN;i++){
         slotoffset = openrandom_get16b()%schedule_getFrameLength();
-        if(schedule_isSlotOffsetAvailable(slotoffset)==TRUE){
+        // not offered to another neighbor in a 6P transaction in progress either
+        if(
+            schedule_isSlotOffsetAvailable(slotoffset)==TRUE &&
+            sixtop_isSlotOffsetRequested(slotoffset)==FALSE
+        ){
             cellList[numCandCells].slotoffset       = slotoffset;
             cellList[numCandCells].channeloffset    = openrandom_get16b()&0x0F;
             cellList[numCandCells].isUsed           = TRUE;
@@ -24,10 +24,10 @@ void registerNewNeighbor(
      );
 bool isNeighbor(open_addr_t* neighbor);
 void removeNeighbor(uint8_t neighborIndex);
-bool isThisRowMatching(
-        open_addr_t* address,
-        uint8_t      rowNumber
-     );
+uint16_t neighbors_hashBucket(open_addr_t* address);
+uint8_t  neighbors_hashLookup(open_addr_t* address);
+void     neighbors_hashInsert(uint8_t row);
+void     neighbors_hashRemove(uint8_t row);
 
 //=========================== public ==========================================
 
@@ -38,7 +38,8 @@ void neighbors_init(void) {
 
    // clear module variables
    memset(&neighbors_vars,0,sizeof(neighbors_vars_t));
-   // The .used fields get reset to FALSE by this memset.
+   // The .used fields get reset to FALSE, and the hash buckets emptied, by
+   // this memset.
 
 }
 
@@ -139,10 +140,10 @@ bool neighbors_getNeighborNoResource(uint8_t index){
 
 uint8_t neighbors_getSequenceNumber(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            break;
-        }
+
+    i = neighbors_hashLookup(address);
+    if (i==MAXNUMNEIGHBORS) {
+        return 0;
     }
     return neighbors_vars.neighbors[i].sequenceNumber;
 
@@ -178,12 +179,10 @@ bool neighbors_isStableNeighbor(open_addr_t* address) {
          return returnVal;
    }
 
-   // iterate through neighbor table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(&temp_addr_64b,i) && neighbors_vars.neighbors[i].stableNeighbor==TRUE) {
-         returnVal  = TRUE;
-         break;
-      }
+   // look up neighbor table
+   i = neighbors_hashLookup(&temp_addr_64b);
+   if (i<MAXNUMNEIGHBORS && neighbors_vars.neighbors[i].stableNeighbor==TRUE) {
+      returnVal  = TRUE;
    }
 
    return returnVal;
@@ -225,12 +224,10 @@ bool neighbors_isInsecureNeighbor(open_addr_t* address) {
          return returnVal;
    }
 
-   // iterate through neighbor table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(address,i)) {
-         returnVal  = neighbors_vars.neighbors[i].insecure;
-         break;
-      }
+   // look up neighbor table
+   i = neighbors_hashLookup(address);
+   if (i<MAXNUMNEIGHBORS) {
+      returnVal  = neighbors_vars.neighbors[i].insecure;
    }
 
    return returnVal;
@@ -304,50 +301,42 @@ void neighbors_indicateRx(open_addr_t* l2_src,
    bool    newNeighbor;
 
    // update existing neighbor
-   newNeighbor = TRUE;
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(l2_src,i)) {
-
-         // this is not a new neighbor
-         newNeighbor = FALSE;
-
-         // whether the neighbor is considered as secure or not
-         neighbors_vars.neighbors[i].insecure = insecure;
-
-         // update numRx, rssi, asn
-         neighbors_vars.neighbors[i].numRx++;
-         neighbors_vars.neighbors[i].rssi=rssi;
-         memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
-         //update jp
-         if (joinPrioPresent==TRUE){
-            neighbors_vars.neighbors[i].joinPrio=joinPrio;
-         }
+   i = neighbors_hashLookup(l2_src);
+   newNeighbor = (i==MAXNUMNEIGHBORS);
+   if (newNeighbor==FALSE) {
+      // whether the neighbor is considered as secure or not
+      neighbors_vars.neighbors[i].insecure = insecure;
+
+      // update numRx, rssi, asn
+      neighbors_vars.neighbors[i].numRx++;
+      neighbors_vars.neighbors[i].rssi=rssi;
+      memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
+      //update jp
+      if (joinPrioPresent==TRUE){
+         neighbors_vars.neighbors[i].joinPrio=joinPrio;
+      }
 
-         // update stableNeighbor, switchStabilityCounter
-         if (neighbors_vars.neighbors[i].stableNeighbor==FALSE) {
-            if (neighbors_vars.neighbors[i].rssi>BADNEIGHBORMAXRSSI) {
-               neighbors_vars.neighbors[i].switchStabilityCounter++;
-               if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
-                  neighbors_vars.neighbors[i].switchStabilityCounter=0;
-                  neighbors_vars.neighbors[i].stableNeighbor=TRUE;
-               }
-            } else {
+      // update stableNeighbor, switchStabilityCounter
+      if (neighbors_vars.neighbors[i].stableNeighbor==FALSE) {
+         if (neighbors_vars.neighbors[i].rssi>BADNEIGHBORMAXRSSI) {
+            neighbors_vars.neighbors[i].switchStabilityCounter++;
+            if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
                neighbors_vars.neighbors[i].switchStabilityCounter=0;
+               neighbors_vars.neighbors[i].stableNeighbor=TRUE;
             }
-         } else if (neighbors_vars.neighbors[i].stableNeighbor==TRUE) {
-            if (neighbors_vars.neighbors[i].rssi<GOODNEIGHBORMINRSSI) {
-               neighbors_vars.neighbors[i].switchStabilityCounter++;
-               if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
-                  neighbors_vars.neighbors[i].switchStabilityCounter=0;
-                   neighbors_vars.neighbors[i].stableNeighbor=FALSE;
-               }
-            } else {
+         } else {
+            neighbors_vars.neighbors[i].switchStabilityCounter=0;
+         }
+      } else if (neighbors_vars.neighbors[i].stableNeighbor==TRUE) {
+         if (neighbors_vars.neighbors[i].rssi<GOODNEIGHBORMINRSSI) {
+            neighbors_vars.neighbors[i].switchStabilityCounter++;
+            if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
                neighbors_vars.neighbors[i].switchStabilityCounter=0;
+                neighbors_vars.neighbors[i].stableNeighbor=FALSE;
             }
+         } else {
+            neighbors_vars.neighbors[i].switchStabilityCounter=0;
          }
-
-         // stop looping
-         break;
       }
    }
 
@@ -388,63 +377,57 @@ void neighbors_indicateTx(
         return;
     }
 
-    // loop through neighbor table
-    for (i=0;i<MAXNUMNEIGHBORS;i++) {
-        if (isThisRowMatching(l2_dest,i)) {
-            // found the target neighbor
-
-            // reset backoff variable
-            neighbors_vars.neighbors[i].backoffExponenton     = MINBE-1;
-            neighbors_vars.neighbors[i].backoff               = 0;
+    // look up the target neighbor
+    i = neighbors_hashLookup(l2_dest);
+    if (i==MAXNUMNEIGHBORS) {
+        return;
+    }
 
-            // update asn if ack'ed
-            if (was_finally_acked==TRUE) {
-                memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
-            }
+    // reset backoff variable
+    neighbors_vars.neighbors[i].backoffExponenton     = MINBE-1;
+    neighbors_vars.neighbors[i].backoff               = 0;
 
-            // only update numTx/numTxAck on Tx cell
-            if (sentOnTxCell) {
-                if (neighbors_vars.neighbors[i].numTx>(0xff-numTxAttempts)) {
-                    neighbors_vars.neighbors[i].numWraps++; //counting the number of times that tx wraps.
-                    neighbors_vars.neighbors[i].numTx/=2;
-                    neighbors_vars.neighbors[i].numTxACK/=2;
-                }
-                // update statistics
-                neighbors_vars.neighbors[i].numTx += numTxAttempts;
+    // update asn if ack'ed
+    if (was_finally_acked==TRUE) {
+        memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
+    }
 
-                if (was_finally_acked==TRUE) {
-                    neighbors_vars.neighbors[i].numTxACK++;
-                }
+    // only update numTx/numTxAck on Tx cell
+    if (sentOnTxCell) {
+        if (neighbors_vars.neighbors[i].numTx>(0xff-numTxAttempts)) {
+            neighbors_vars.neighbors[i].numWraps++; //counting the number of times that tx wraps.
+            neighbors_vars.neighbors[i].numTx/=2;
+            neighbors_vars.neighbors[i].numTxACK/=2;
+        }
+        // update statistics
+        neighbors_vars.neighbors[i].numTx += numTxAttempts;
 
-                // numTx and numTxAck changed,, update my rank
-                icmpv6rpl_updateMyDAGrankAndParentSelection();
-            }
-            break;
+        if (was_finally_acked==TRUE) {
+            neighbors_vars.neighbors[i].numTxACK++;
         }
+
+        // numTx and numTxAck changed,, update my rank
+        icmpv6rpl_updateMyDAGrankAndParentSelection();
     }
 }
 
 void neighbors_updateSequenceNumber(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            neighbors_vars.neighbors[i].sequenceNumber = (neighbors_vars.neighbors[i].sequenceNumber+1) & 0xFF;
-            // rollover from 0xff to 0x01
-            if (neighbors_vars.neighbors[i].sequenceNumber == 0){
-                neighbors_vars.neighbors[i].sequenceNumber = 1;
-            }
-            break;
+    i = neighbors_hashLookup(address);
+    if (i<MAXNUMNEIGHBORS) {
+        neighbors_vars.neighbors[i].sequenceNumber = (neighbors_vars.neighbors[i].sequenceNumber+1) & 0xFF;
+        // rollover from 0xff to 0x01
+        if (neighbors_vars.neighbors[i].sequenceNumber == 0){
+            neighbors_vars.neighbors[i].sequenceNumber = 1;
         }
     }
 }
 
 void neighbors_resetSequenceNumber(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            neighbors_vars.neighbors[i].sequenceNumber = 0;
-            break;
-        }
+    i = neighbors_hashLookup(address);
+    if (i<MAXNUMNEIGHBORS) {
+        neighbors_vars.neighbors[i].sequenceNumber = 0;
     }
 }
 
@@ -473,26 +456,22 @@ bool  neighbors_getNeighborEui64(open_addr_t* address, uint8_t addr_type, uint8_
 // ==== update backoff
 void neighbors_updateBackoff(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            // increase the backoffExponent
-            if (neighbors_vars.neighbors[i].backoffExponenton<MAXBE) {
-                neighbors_vars.neighbors[i].backoffExponenton++;
-            }
-            // set the backoff to a random value in [0..2^BE]
-            neighbors_vars.neighbors[i].backoff = openrandom_get16b()%(1<<neighbors_vars.neighbors[i].backoffExponenton);
-            break;
+    i = neighbors_hashLookup(address);
+    if (i<MAXNUMNEIGHBORS) {
+        // increase the backoffExponent
+        if (neighbors_vars.neighbors[i].backoffExponenton<MAXBE) {
+            neighbors_vars.neighbors[i].backoffExponenton++;
         }
+        // set the backoff to a random value in [0..2^BE]
+        neighbors_vars.neighbors[i].backoff = openrandom_get16b()%(1<<neighbors_vars.neighbors[i].backoffExponenton);
     }
 }
 void neighbors_decreaseBackoff(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            if (neighbors_vars.neighbors[i].backoff>0) {
-                neighbors_vars.neighbors[i].backoff--;
-            }
-            break;
+    i = neighbors_hashLookup(address);
+    if (i<MAXNUMNEIGHBORS) {
+        if (neighbors_vars.neighbors[i].backoff>0) {
+            neighbors_vars.neighbors[i].backoff--;
         }
     }
 }
@@ -500,14 +479,10 @@ bool neighbors_backoffHitZero(open_addr_t* address){
     uint8_t i;
     bool returnVal;
 
-    returnVal = FALSE;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            returnVal = (neighbors_vars.neighbors[i].backoff==0);
-            break;
-        }
-    }
-    if (i==MAXNUMNEIGHBORS) {
+    i = neighbors_hashLookup(address);
+    if (i<MAXNUMNEIGHBORS) {
+        returnVal = (neighbors_vars.neighbors[i].backoff==0);
+    } else {
         // The neighbor looking for is not in the table.
         // This is usually the case a packet is from downward traffic, which
         // doesn't need to be in the neighbor table.
@@ -522,12 +497,10 @@ bool neighbors_backoffHitZero(open_addr_t* address){
 void neighbors_resetBackoff(open_addr_t* address){
     uint8_t i;
 
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            neighbors_vars.neighbors[i].backoffExponenton     = MINBE-1;
-            neighbors_vars.neighbors[i].backoff               = 0;
-            break;
-        }
+    i = neighbors_hashLookup(address);
+    if (i<MAXNUMNEIGHBORS) {
+        neighbors_vars.neighbors[i].backoffExponenton     = MINBE-1;
+        neighbors_vars.neighbors[i].backoff               = 0;
     }
 }
 
@@ -541,13 +514,10 @@ void neighbors_setNeighborRank(uint8_t index, dagrank_t rank) {
 void neighbors_setNeighborNoResource(open_addr_t* address){
    uint8_t i;
 
-   // loop through neighbor table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(address,i)) {
-          neighbors_vars.neighbors[i].f6PNORES = TRUE;
-          icmpv6rpl_updateMyDAGrankAndParentSelection();
-          break;
-      }
+   i = neighbors_hashLookup(address);
+   if (i<MAXNUMNEIGHBORS) {
+       neighbors_vars.neighbors[i].f6PNORES = TRUE;
+       icmpv6rpl_updateMyDAGrankAndParentSelection();
    }
 }
 
@@ -659,6 +629,7 @@ status information about several modules in the OpenWSN stack.
 bool debugPrint_neighbors(void) {
     debugNeighborEntry_t temp;
     neighbors_vars.debugRow=(neighbors_vars.debugRow+1)%MAXNUMNEIGHBORS;
+    memset(&temp,0,sizeof(debugNeighborEntry_t));
     temp.row=neighbors_vars.debugRow;
     temp.neighborEntry=neighbors_vars.neighbors[neighbors_vars.debugRow];
     openserial_printStatus(STATUS_NEIGHBORS,(uint8_t*)&temp,sizeof(debugNeighborEntry_t));
@@ -698,6 +669,7 @@ void registerNewNeighbor(open_addr_t* address,
                 neighbors_vars.neighbors[i].stableNeighbor         = TRUE;
                 neighbors_vars.neighbors[i].switchStabilityCounter = 0;
                 memcpy(&neighbors_vars.neighbors[i].addr_64b,address,sizeof(open_addr_t));
+                neighbors_hashInsert(i);
                 neighbors_vars.neighbors[i].DAGrank                = DEFAULTDAGRANK;
                 // since we don't have a DAG rank at this point, no need to call for routing table update
                 neighbors_vars.neighbors[i].rssi                   = rssi;
@@ -727,17 +699,14 @@ void registerNewNeighbor(open_addr_t* address,
 }
 
 bool isNeighbor(open_addr_t* neighbor) {
-   uint8_t i=0;
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(neighbor,i)) {
-         return TRUE;
-      }
-   }
-   return FALSE;
+   return neighbors_hashLookup(neighbor)<MAXNUMNEIGHBORS;
 }
 
 void removeNeighbor(uint8_t neighborIndex) {
 
+    // unindex it while its address is still known
+    neighbors_hashRemove(neighborIndex);
+
     neighbors_vars.neighbors[neighborIndex].used                      = FALSE;
     neighbors_vars.neighbors[neighborIndex].parentPreference          = 0;
     neighbors_vars.neighbors[neighborIndex].stableNeighbor            = FALSE;
@@ -759,15 +728,111 @@ void removeNeighbor(uint8_t neighborIndex) {
 
 //=========================== helpers =========================================
 
-bool isThisRowMatching(open_addr_t* address, uint8_t rowNumber) {
-   switch (address->type) {
-      case ADDR_64B:
-         return neighbors_vars.neighbors[rowNumber].used &&
-                packetfunctions_sameAddress(address,&neighbors_vars.neighbors[rowNumber].addr_64b);
-      default:
-         openserial_printCritical(COMPONENT_NEIGHBORS,ERR_WRONG_ADDR_TYPE,
-                               (errorparameter_t)address->type,
-                               (errorparameter_t)4);
-         return FALSE;
+/**
+\brief Compute the hash bucket of a 64-bit neighbor address.
+
+\param[in] address The 64-bit address of the neighbor.
+
+\returns The index of the first bucket to probe for that address.
+*/
+uint16_t neighbors_hashBucket(open_addr_t* address) {
+   uint16_t hash;
+   uint8_t  i;
+
+   hash = 0;
+   for (i=0;i<LENGTH_ADDR64b;i++) {
+      hash = (hash<<5) + hash + address->addr_64b[i];
+   }
+   return (hash ^ (hash>>8)) & (NEIGHBORS_HASHSIZE-1);
+}
+
+/**
+\brief Find the row of the neighbor table holding some neighbor.
+
+The rows in use are indexed by an open-addressing hash with linear probing,
+which is kept at most half full so probe sequences remain short.
+
+\param[in] address The 64-bit address of the neighbor.
+
+\returns The row of that neighbor, or MAXNUMNEIGHBORS if it is not in the
+   table.
+*/
+uint8_t neighbors_hashLookup(open_addr_t* address) {
+   uint16_t bucket;
+   uint8_t  row;
+
+   if (address->type!=ADDR_64B) {
+      return MAXNUMNEIGHBORS;
+   }
+
+   bucket = neighbors_hashBucket(address);
+   while (neighbors_vars.hashTable[bucket]!=0) {
+      row = neighbors_vars.hashTable[bucket]-1;
+      if (packetfunctions_sameAddress(address,&neighbors_vars.neighbors[row].addr_64b)) {
+         return row;
+      }
+      bucket = (bucket+1) & (NEIGHBORS_HASHSIZE-1);
+   }
+   return MAXNUMNEIGHBORS;
+}
+
+/**
+\brief Index a row of the neighbor table by its address.
+
+\param[in] row The row, of which addr_64b is already filled in.
+*/
+void neighbors_hashInsert(uint8_t row) {
+   uint16_t bucket;
+
+   bucket = neighbors_hashBucket(&neighbors_vars.neighbors[row].addr_64b);
+   while (neighbors_vars.hashTable[bucket]!=0) {
+      bucket = (bucket+1) & (NEIGHBORS_HASHSIZE-1);
+   }
+   neighbors_vars.hashTable[bucket] = row+1;
+}
+
+/**
+\brief Stop indexing a row of the neighbor table.
+
+The entries following the emptied bucket are shifted back into it whenever
+that does not move them before their home bucket, so no deleted markers are
+needed.
+
+\param[in] row The row, of which addr_64b is still filled in.
+*/
+void neighbors_hashRemove(uint8_t row) {
+   uint16_t hole;
+   uint16_t bucket;
+   uint16_t home;
+
+   // find the bucket of that row
+   hole = neighbors_hashBucket(&neighbors_vars.neighbors[row].addr_64b);
+   while (neighbors_vars.hashTable[hole]!=row+1) {
+      if (neighbors_vars.hashTable[hole]==0) {
+         // row not indexed
+         return;
+      }
+      hole = (hole+1) & (NEIGHBORS_HASHSIZE-1);
+   }
+   neighbors_vars.hashTable[hole] = 0;
+
+   // close the hole
+   bucket = hole;
+   while (1) {
+      bucket = (bucket+1) & (NEIGHBORS_HASHSIZE-1);
+      if (neighbors_vars.hashTable[bucket]==0) {
+         break;
+      }
+      home = neighbors_hashBucket(
+         &neighbors_vars.neighbors[neighbors_vars.hashTable[bucket]-1].addr_64b
+      );
+      if (
+         ((bucket-home) & (NEIGHBORS_HASHSIZE-1)) >=
+         ((bucket-hole) & (NEIGHBORS_HASHSIZE-1))
+      ) {
+         neighbors_vars.hashTable[hole]   = neighbors_vars.hashTable[bucket];
+         neighbors_vars.hashTable[bucket] = 0;
+         hole                             = bucket;
+      }
    }
 }
@@ -26,6 +26,18 @@
 
 #define DEFAULTJOINPRIORITY       0xff
 
+// number of buckets of the EUI-64 to row index hash, a power of 2
+#ifndef NEIGHBORS_HASHSIZE
+#define NEIGHBORS_HASHSIZE        64
+#endif
+
+#if MAXNUMNEIGHBORS>255
+#error "neighbor rows are indexed on 8 bits"
+#endif
+#if (NEIGHBORS_HASHSIZE & (NEIGHBORS_HASHSIZE-1))!=0 || NEIGHBORS_HASHSIZE<2*MAXNUMNEIGHBORS
+#error "NEIGHBORS_HASHSIZE must be a power of 2, at least twice MAXNUMNEIGHBORS"
+#endif
+
 //=========================== typedef =========================================
 
 BEGIN_PACK
@@ -49,6 +61,7 @@ END_PACK
 
 typedef struct {
    neighborRow_t        neighbors[MAXNUMNEIGHBORS];
+   uint8_t              hashTable[NEIGHBORS_HASHSIZE]; // 1+row of the neighbor hashed there, 0 if empty
    dagrank_t            myDAGrank;
    uint8_t              debugRow;
 } neighbors_vars_t;
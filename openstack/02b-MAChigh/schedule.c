@@ -22,6 +22,11 @@ schedule_vars_t schedule_vars;
 
 void schedule_resetEntry(scheduleEntry_t* pScheduleEntry);
 void schedule_resetBackupEntry(backupEntry_t* pBackupEntry);
+int8_t  schedule_compareAddress(open_addr_t* address_1, open_addr_t* address_2);
+uint8_t schedule_slotLowerBound(slotOffset_t slotOffset);
+uint8_t schedule_nbrLowerBound(open_addr_t* neighbor);
+void    schedule_nbrIndexInsert(uint8_t row);
+void    schedule_nbrIndexRemove(uint8_t row);
 
 //=========================== public ==========================================
 
@@ -43,6 +48,8 @@ void schedule_init(void) {
         for (i=0;i<MAXBACKUPSLOTS;i++){
             schedule_resetBackupEntry(&schedule_vars.scheduleBuf[running_slotOffset].backupEntries[i]);
         }
+        // all rows are free
+        schedule_vars.slotIndex[running_slotOffset] = running_slotOffset;
     }
     schedule_vars.backoffExponenton   = MINBE-1;
     schedule_vars.maxActiveSlots = MAXACTIVESLOTS;
@@ -100,7 +107,8 @@ bool debugPrint_schedule(void) {
    // increment the row just printed
    schedule_vars.debugPrintRow         = (schedule_vars.debugPrintRow+1)%schedule_vars.maxActiveSlots;
 
-   // gather status data
+   // gather status data, zeroed first since openserial hashes the padding too
+   memset(&temp,0,sizeof(debugScheduleEntry_t));
    temp.row                            = schedule_vars.debugPrintRow;
    temp.slotOffset                     = \
       schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].slotOffset;
@@ -223,11 +231,12 @@ void  schedule_getSlotInfo(
 ){
 
     scheduleEntry_t* slotContainer;
+    uint8_t          pos;
 
-    // find an empty schedule entry container
-    slotContainer = &schedule_vars.scheduleBuf[0];
-    while (slotContainer<=&schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]) {
-       //check that this entry for that neighbour and timeslot is not already scheduled.
+    // look up the active slot at that slot offset
+    pos = schedule_slotLowerBound(slotOffset);
+    if (pos<schedule_vars.numActiveSlots) {
+       slotContainer = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos]];
        if (slotContainer->slotOffset==slotOffset){
                //it exists so this is an update.
                info->link_type                 = slotContainer->type;
@@ -238,7 +247,6 @@ void  schedule_getSlotInfo(
                memcpy(&(info->address), &(slotContainer->neighbor), sizeof(open_addr_t));
                return; //as this is an update. No need to re-insert as it is in the same position on the list.
         }
-        slotContainer++;
     }
     // return cell type off
     info->link_type                 = CELLTYPE_OFF;
@@ -268,63 +276,46 @@ owerror_t schedule_addActiveSlot(
 ) {
     uint8_t asn[5];
     scheduleEntry_t* slotContainer;
-    scheduleEntry_t* previousSlotWalker;
-    scheduleEntry_t* nextSlotWalker;
+    scheduleEntry_t* previousSlotContainer;
 
     backupEntry_t*   backupEntry;
 
     uint8_t          i;
-    bool             entry_found;
-    bool             inBackupEntries;
+    uint8_t          pos;
+    uint8_t          row;
 
     bool             needSwapEntries;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    // find an empty schedule entry container
-    entry_found     = FALSE;
-    inBackupEntries = FALSE;
-    slotContainer = &schedule_vars.scheduleBuf[0];
-    do {
-        if (slotContainer->type != CELLTYPE_OFF) {
-            if (slotContainer->slotOffset == slotOffset) {
-                // found one entry with same slotoffset in schedule
-                // check if there is space in second entries
-
-                for (i=0;i<MAXBACKUPSLOTS;i++) {
-                    if (slotContainer->backupEntries[i].type == CELLTYPE_OFF) {
-                        inBackupEntries = TRUE;
-                        backupEntry     = &(slotContainer->backupEntries[i]);
-                        break;
-                    }
-                }
-                if (inBackupEntries) {
-                    entry_found = TRUE;
-                    break;
-                }
+    // look up the active slot at that slot offset
+    pos = schedule_slotLowerBound(slotOffset);
+    if (
+        pos<schedule_vars.numActiveSlots &&
+        schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos]].slotOffset == slotOffset
+    ) {
+        // found one entry with same slotoffset in schedule
+        // check if there is space in second entries
+        row           = schedule_vars.slotIndex[pos];
+        slotContainer = &schedule_vars.scheduleBuf[row];
+        backupEntry   = NULL;
+        for (i=0;i<MAXBACKUPSLOTS;i++) {
+            if (slotContainer->backupEntries[i].type == CELLTYPE_OFF) {
+                backupEntry     = &(slotContainer->backupEntries[i]);
+                break;
             }
-            slotContainer++;
-        } else {
-            entry_found = TRUE;
-            break;
         }
-    } while (slotContainer <= &schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]);
-
-    // abort it schedule overflow
-    if (entry_found == FALSE) {
-        ENABLE_INTERRUPTS();
-        openserial_printError(
-            COMPONENT_SCHEDULE,ERR_SCHEDULE_OVERFLOWN,
-            (errorparameter_t)0,
-            (errorparameter_t)0
-        );
-        return E_FAIL;
-    }
-
-
-    // assign the next slot pointer if it's allocated in backup entries
-    if (inBackupEntries) {
+        if (backupEntry == NULL) {
+            // slot is already in schedule
+            ENABLE_INTERRUPTS();
+            openserial_printError(
+               COMPONENT_SCHEDULE,ERR_SCHEDULE_ADDDUPLICATESLOT,
+               (errorparameter_t)slotOffset,
+               (errorparameter_t)0
+            );
+            return E_FAIL;
+        }
 
         // the highest priority cell should be in schedule
         // priority  high ----------------- low
@@ -350,6 +341,9 @@ owerror_t schedule_addActiveSlot(
 
         if (needSwapEntries) {
 
+            // the neighbor of this row changes
+            schedule_nbrIndexRemove(row);
+
             // backup current entries
             backupEntry->type           = slotContainer->type;
             backupEntry->shared         = slotContainer->shared;
@@ -378,6 +372,8 @@ owerror_t schedule_addActiveSlot(
             slotContainer->lastUsedAsn.bytes0and1 = 256*asn[1]+asn[0];
             slotContainer->lastUsedAsn.bytes2and3 = 256*asn[3]+asn[2];
             slotContainer->lastUsedAsn.byte4      = asn[4];
+
+            schedule_nbrIndexInsert(row);
         } else {
             // add cell to backup schedule
 
@@ -396,10 +392,26 @@ owerror_t schedule_addActiveSlot(
             // use the same next point in schedule
             backupEntry->next = slotContainer->next;
         }
+        schedule_vars.numBackupEntries++;
         ENABLE_INTERRUPTS();
         return E_SUCCESS;
     }
 
+    // abort it schedule overflow
+    if (schedule_vars.numActiveSlots >= schedule_vars.maxActiveSlots) {
+        ENABLE_INTERRUPTS();
+        openserial_printError(
+            COMPONENT_SCHEDULE,ERR_SCHEDULE_OVERFLOWN,
+            (errorparameter_t)0,
+            (errorparameter_t)0
+        );
+        return E_FAIL;
+    }
+
+    // take the first free row
+    row           = schedule_vars.slotIndex[schedule_vars.numActiveSlots];
+    slotContainer = &schedule_vars.scheduleBuf[row];
+
     // fill that schedule entry with parameters passed
     slotContainer->slotOffset                = slotOffset;
     slotContainer->type                      = type;
@@ -426,51 +438,27 @@ owerror_t schedule_addActiveSlot(
     } else  {
         // this is NOT the first active slot added
 
-        // find position in schedule
-        previousSlotWalker                    = schedule_vars.currentScheduleEntry;
-        while (1) {
-            nextSlotWalker                    = previousSlotWalker->next;
-            if (
-                (
-                    (previousSlotWalker->slotOffset <  slotContainer->slotOffset) &&
-                    (slotContainer->slotOffset <  nextSlotWalker->slotOffset)
-                )
-                ||
-                (
-                    (previousSlotWalker->slotOffset <  slotContainer->slotOffset) &&
-                    (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
-                )
-                ||
-                (
-                    (slotContainer->slotOffset <  nextSlotWalker->slotOffset) &&
-                    (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
-                )
-            ) {
-                break;
-            }
-            if (previousSlotWalker->slotOffset == slotContainer->slotOffset) {
-                // slot is already in schedule
-                openserial_printError(
-                   COMPONENT_SCHEDULE,ERR_SCHEDULE_ADDDUPLICATESLOT,
-                   (errorparameter_t)slotContainer->slotOffset,
-                   (errorparameter_t)0
-                );
-                // reset the entry
-                slotContainer->slotOffset                = 0;
-                slotContainer->type                      = CELLTYPE_OFF;
-                slotContainer->shared                    = FALSE;
-                slotContainer->channelOffset             = 0;
-                memset(&slotContainer->neighbor,0,sizeof(open_addr_t));
-                ENABLE_INTERRUPTS();
-                return E_FAIL;
-            }
-            previousSlotWalker                 = nextSlotWalker;
+        // insert right after the active slot with the preceding slot offset
+        // (the last one when inserting before the first one)
+        if (pos==0) {
+            previousSlotContainer = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[schedule_vars.numActiveSlots-1]];
+        } else {
+            previousSlotContainer = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos-1]];
         }
-        // insert between previousSlotWalker and nextSlotWalker
-        previousSlotWalker->next              = slotContainer;
-        slotContainer->next                   = nextSlotWalker;
+        slotContainer->next                   = previousSlotContainer->next;
+        previousSlotContainer->next           = slotContainer;
     }
 
+    // insert in the indexes
+    memmove(
+        &schedule_vars.slotIndex[pos+1],
+        &schedule_vars.slotIndex[pos],
+        schedule_vars.numActiveSlots-pos
+    );
+    schedule_vars.slotIndex[pos] = row;
+    schedule_vars.numActiveSlots++;
+    schedule_nbrIndexInsert(row);
+
     ENABLE_INTERRUPTS();
     return E_SUCCESS;
 }
@@ -495,6 +483,8 @@ owerror_t schedule_removeActiveSlot(
     bool             isbackupEntry;
     backupEntry_t*   backupEntry;
     uint8_t          candidate_index;
+    uint8_t          pos;
+    uint8_t          row;
 
     scheduleEntry_t* slotContainer;
     scheduleEntry_t* previousSlotWalker;
@@ -505,31 +495,32 @@ owerror_t schedule_removeActiveSlot(
     // find the schedule entry
     entry_found        = FALSE;
     isbackupEntry      = FALSE;
-    slotContainer = &schedule_vars.scheduleBuf[0];
-    while (slotContainer<=&schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]) {
-        if (slotContainer->slotOffset==slotOffset) {
-            if (packetfunctions_sameAddress(neighbor,&(slotContainer->neighbor))) {
-                entry_found = TRUE;
-                break;
-            } else {
-                for (i=0;i<MAXBACKUPSLOTS;i++){
-                    if (
-                        packetfunctions_sameAddress(neighbor,&(slotContainer->backupEntries[i].neighbor))  &&
-                        type     == slotContainer->backupEntries[i].type                                   &&
-                        isShared == slotContainer->backupEntries[i].shared
-                    ) {
-                        isbackupEntry = TRUE;
-                        backupEntry = &(slotContainer->backupEntries[i]);
-                        break;
-                    }
-                }
-                if (isbackupEntry) {
-                    entry_found = TRUE;
+    pos                = schedule_slotLowerBound(slotOffset);
+    row                = 0;
+    slotContainer      = NULL;
+    if (pos<schedule_vars.numActiveSlots) {
+        row           = schedule_vars.slotIndex[pos];
+        slotContainer = &schedule_vars.scheduleBuf[row];
+    }
+    if (slotContainer!=NULL && slotContainer->slotOffset==slotOffset) {
+        if (packetfunctions_sameAddress(neighbor,&(slotContainer->neighbor))) {
+            entry_found = TRUE;
+        } else {
+            for (i=0;i<MAXBACKUPSLOTS;i++){
+                if (
+                    packetfunctions_sameAddress(neighbor,&(slotContainer->backupEntries[i].neighbor))  &&
+                    type     == slotContainer->backupEntries[i].type                                   &&
+                    isShared == slotContainer->backupEntries[i].shared
+                ) {
+                    isbackupEntry = TRUE;
+                    backupEntry = &(slotContainer->backupEntries[i]);
                     break;
                 }
             }
+            if (isbackupEntry) {
+                entry_found = TRUE;
+            }
         }
-        slotContainer++;
     }
 
     // abort it could not find
@@ -558,6 +549,8 @@ owerror_t schedule_removeActiveSlot(
         backupEntry->lastUsedAsn.byte4      = 0;
         backupEntry->next                   = NULL;
 
+        schedule_vars.numBackupEntries--;
+
         ENABLE_INTERRUPTS();
         return E_SUCCESS;
     } else {
@@ -576,6 +569,9 @@ owerror_t schedule_removeActiveSlot(
         }
 
         if (candidate_index < MAXBACKUPSLOTS){
+            // the neighbor of this row changes
+            schedule_nbrIndexRemove(row);
+
             // move the backup entry to the schedule
             slotContainer->type                      = slotContainer->backupEntries[candidate_index].type;
             slotContainer->shared                    = slotContainer->backupEntries[candidate_index].shared;
@@ -592,6 +588,9 @@ owerror_t schedule_removeActiveSlot(
 
             // reset the backup entry
             schedule_resetBackupEntry(&(slotContainer->backupEntries[candidate_index]));
+            schedule_vars.numBackupEntries--;
+
+            schedule_nbrIndexInsert(row);
 
             ENABLE_INTERRUPTS();
             return E_SUCCESS;
@@ -612,14 +611,12 @@ owerror_t schedule_removeActiveSlot(
     } else {
         // this is NOT the last active slot
 
-        // find the previous in the schedule
-        previousSlotWalker                    = schedule_vars.currentScheduleEntry;
-
-        while (1) {
-            if (previousSlotWalker->next==slotContainer){
-                break;
-            }
-            previousSlotWalker                 = previousSlotWalker->next;
+        // the previous in the schedule is the active slot with the preceding
+        // slot offset (the last one when removing the first one)
+        if (pos==0) {
+            previousSlotWalker = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[schedule_vars.numActiveSlots-1]];
+        } else {
+            previousSlotWalker = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos-1]];
         }
 
         // remove this element from the linked list, i.e. have the previous slot
@@ -643,6 +640,16 @@ owerror_t schedule_removeActiveSlot(
         }
    }
 
+    // remove from the indexes, the row becomes the first free one
+    schedule_nbrIndexRemove(row);
+    schedule_vars.numActiveSlots--;
+    memmove(
+        &schedule_vars.slotIndex[pos],
+        &schedule_vars.slotIndex[pos+1],
+        schedule_vars.numActiveSlots-pos
+    );
+    schedule_vars.slotIndex[schedule_vars.numActiveSlots] = row;
+
     // reset removed schedule entry
     schedule_resetEntry(slotContainer);
 
@@ -653,7 +660,7 @@ owerror_t schedule_removeActiveSlot(
 
 bool schedule_isSlotOffsetAvailable(uint16_t slotOffset){
 
-   scheduleEntry_t* scheduleWalker;
+   uint8_t pos;
 
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
@@ -663,14 +670,14 @@ bool schedule_isSlotOffsetAvailable(uint16_t slotOffset){
       return FALSE;
    }
 
-   scheduleWalker = schedule_vars.currentScheduleEntry;
-   do {
-      if(slotOffset == scheduleWalker->slotOffset){
-          ENABLE_INTERRUPTS();
-          return FALSE;
-      }
-      scheduleWalker = scheduleWalker->next;
-   }while(scheduleWalker!=schedule_vars.currentScheduleEntry);
+   pos = schedule_slotLowerBound(slotOffset);
+   if (
+      pos<schedule_vars.numActiveSlots &&
+      schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos]].slotOffset == slotOffset
+   ){
+      ENABLE_INTERRUPTS();
+      return FALSE;
+   }
 
    ENABLE_INTERRUPTS();
 
@@ -681,68 +688,115 @@ void schedule_removeAllNegotiatedCellsToNeighbor(
     uint8_t        slotframeID,
     open_addr_t*   neighbor
 ){
-    uint8_t i;
+    uint8_t         pos;
+    uint8_t         row;
+    uint8_t         firstRow;
+    bool            found;
+    slotOffset_t    slotOffset;
+    cellType_t      type;
+    bool            shared;
 
-    // remove all entries in schedule with previousHop address
-    for(i=0;i<MAXACTIVESLOTS;i++){
-        if (
-            packetfunctions_sameAddress(&(schedule_vars.scheduleBuf[i].neighbor),neighbor) &&
-            (
-                schedule_vars.scheduleBuf[i].type == CELLTYPE_TX ||
-                schedule_vars.scheduleBuf[i].type == CELLTYPE_RX
-            )
+    INTERRUPT_DECLARATION();
+
+    // remove all entries in schedule with previousHop address, by increasing
+    // row; removing a cell may promote a backup entry in the same row
+    firstRow = 0;
+    do {
+        found = FALSE;
+
+        DISABLE_INTERRUPTS();
+        for (
+            pos=schedule_nbrLowerBound(neighbor);
+            pos<schedule_vars.numNbrIndex &&
+            schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,neighbor)==0;
+            pos++
         ){
+            row = schedule_vars.nbrIndex[pos];
+            if (
+                row >= firstRow &&
+                (
+                    schedule_vars.scheduleBuf[row].type == CELLTYPE_TX ||
+                    schedule_vars.scheduleBuf[row].type == CELLTYPE_RX
+                )
+            ){
+                found      = TRUE;
+                firstRow   = row+1;
+                slotOffset = schedule_vars.scheduleBuf[row].slotOffset;
+                type       = schedule_vars.scheduleBuf[row].type;
+                shared     = schedule_vars.scheduleBuf[row].shared;
+                break;
+            }
+        }
+        ENABLE_INTERRUPTS();
+
+        if (found) {
             schedule_removeActiveSlot(
-                schedule_vars.scheduleBuf[i].slotOffset,
-                schedule_vars.scheduleBuf[i].type,
-                schedule_vars.scheduleBuf[i].shared,
+                slotOffset,
+                type,
+                shared,
                 neighbor
             );
         }
-    }
+    } while (found);
 }
 
 uint8_t schedule_getNumberOfFreeEntries(){
-    uint8_t i;
     uint8_t counter;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    counter = 0;
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(schedule_vars.scheduleBuf[i].type == CELLTYPE_OFF){
-            counter++;
-        }
-     }
+    counter = MAXACTIVESLOTS-schedule_vars.numActiveSlots;
 
-     ENABLE_INTERRUPTS();
+    ENABLE_INTERRUPTS();
     return counter;
 }
 
 uint8_t schedule_getNumberOfNegotiatedCells(open_addr_t* neighbor, cellType_t cell_type){
     uint8_t i;
     uint8_t j;
+    uint8_t pos;
     uint8_t counter;
+    scheduleEntry_t* entry;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
     counter = 0;
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(
-            schedule_vars.scheduleBuf[i].shared == FALSE       &&
-            schedule_vars.scheduleBuf[i].type   == cell_type &&
-            packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE
+
+    // cells to that neighbor
+    for (
+        pos=schedule_nbrLowerBound(neighbor);
+        pos<schedule_vars.numNbrIndex &&
+        schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,neighbor)==0;
+        pos++
+    ){
+        entry = &schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]];
+        if (
+            entry->shared == FALSE       &&
+            entry->type   == cell_type
         ){
             counter++;
-        } else {
-            if (schedule_vars.scheduleBuf[i].isAutoCell){
+        }
+    }
+
+    // negotiated Tx cells hidden behind an autonomous cell
+    if (schedule_vars.numBackupEntries>0) {
+        for(i=0;i<schedule_vars.numActiveSlots;i++) {
+            entry = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[i]];
+            if (
+                entry->isAutoCell &&
+                (
+                    entry->shared != FALSE       ||
+                    entry->type   != cell_type   ||
+                    packetfunctions_sameAddress(&entry->neighbor, neighbor) == FALSE
+                )
+            ){
                 for(j=0;j<MAXBACKUPSLOTS;j++) {
                     if(
-                        schedule_vars.scheduleBuf[i].backupEntries[j].type   == CELLTYPE_TX &&
-                        packetfunctions_sameAddress(&(schedule_vars.scheduleBuf[i].backupEntries[j].neighbor), neighbor) == TRUE &&
-                        schedule_vars.scheduleBuf[i].backupEntries[j].shared == FALSE
+                        entry->backupEntries[j].type   == CELLTYPE_TX &&
+                        packetfunctions_sameAddress(&(entry->backupEntries[j].neighbor), neighbor) == TRUE &&
+                        entry->backupEntries[j].shared == FALSE
                     ){
                         counter++;
                         // at most one negotiated Tx cell to a neighbor in backup entries
@@ -759,22 +813,22 @@ uint8_t schedule_getNumberOfNegotiatedCells(open_addr_t* neighbor, cellType_t ce
 }
 
 bool schedule_isNumTxWrapped(open_addr_t* neighbor){
-    uint8_t i;
+    uint8_t pos;
     bool    returnVal;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
     returnVal = FALSE;
-    for(i=0;i<MAXACTIVESLOTS;i++){
-        if(
-            packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE
-        ){
-            if (schedule_vars.scheduleBuf[i].numTx>0xFF/2){
-                returnVal = TRUE;
-            }
-            ENABLE_INTERRUPTS();
-            return returnVal;
+
+    // the first row of that neighbor
+    pos = schedule_nbrLowerBound(neighbor);
+    if (
+        pos<schedule_vars.numNbrIndex &&
+        packetfunctions_sameAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor, neighbor) == TRUE
+    ){
+        if (schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].numTx>0xFF/2){
+            returnVal = TRUE;
         }
     }
     ENABLE_INTERRUPTS();
@@ -783,7 +837,8 @@ bool schedule_isNumTxWrapped(open_addr_t* neighbor){
 }
 
 bool schedule_getCellsToBeRelocated(open_addr_t* neighbor, cellInfo_ht* celllist){
-    uint8_t     i;
+    uint8_t          pos;
+    scheduleEntry_t* entry;
 
     uint16_t    cellPDR;
 
@@ -791,19 +846,21 @@ bool schedule_getCellsToBeRelocated(open_addr_t* neighbor, cellInfo_ht* celllist
     DISABLE_INTERRUPTS();
 
     // found the cell with higest PDR
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(
-            packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE
-        ){
-            if (schedule_vars.scheduleBuf[i].numTx>MINIMAL_NUM_TX){
-                cellPDR = 100*schedule_vars.scheduleBuf[i].numTxACK/schedule_vars.scheduleBuf[i].numTx;
-                if (cellPDR < RELOCATE_PDRTHRES){
-                    celllist->isUsed            = TRUE;
-                    celllist->slotoffset        = schedule_vars.scheduleBuf[i].slotOffset;
-                    celllist->channeloffset     = schedule_vars.scheduleBuf[i].channelOffset;
-                    ENABLE_INTERRUPTS();
-                    return TRUE;
-                }
+    for (
+        pos=schedule_nbrLowerBound(neighbor);
+        pos<schedule_vars.numNbrIndex &&
+        schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,neighbor)==0;
+        pos++
+    ){
+        entry = &schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]];
+        if (entry->numTx>MINIMAL_NUM_TX){
+            cellPDR = 100*entry->numTxACK/entry->numTx;
+            if (cellPDR < RELOCATE_PDRTHRES){
+                celllist->isUsed            = TRUE;
+                celllist->slotoffset        = entry->slotOffset;
+                celllist->channeloffset     = entry->channelOffset;
+                ENABLE_INTERRUPTS();
+                return TRUE;
             }
         }
     }
@@ -814,20 +871,25 @@ bool schedule_getCellsToBeRelocated(open_addr_t* neighbor, cellInfo_ht* celllist
 }
 
 bool schedule_hasAutonomousTxRxCellUnicast(open_addr_t* neighbor){
-    uint8_t i;
+    uint8_t pos;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(
-            schedule_vars.scheduleBuf[i].type          == CELLTYPE_TXRX &&
-            schedule_vars.scheduleBuf[i].shared                         &&
-            schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B      &&
-            packetfunctions_sameAddress(neighbor,&schedule_vars.scheduleBuf[i].neighbor)
+    if (neighbor->type == ADDR_64B) {
+        for (
+            pos=schedule_nbrLowerBound(neighbor);
+            pos<schedule_vars.numNbrIndex &&
+            schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,neighbor)==0;
+            pos++
         ){
-            ENABLE_INTERRUPTS();
-            return TRUE;
+            if(
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].type == CELLTYPE_TXRX &&
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].shared
+            ){
+                ENABLE_INTERRUPTS();
+                return TRUE;
+            }
         }
     }
 
@@ -836,21 +898,26 @@ bool schedule_hasAutonomousTxRxCellUnicast(open_addr_t* neighbor){
 }
 
 bool schedule_getAutonomousTxRxCellUnicastNeighbor(open_addr_t* neighbor){
-    uint8_t i;
+    uint8_t pos;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(
-            schedule_vars.scheduleBuf[i].type          == CELLTYPE_TXRX &&
-            schedule_vars.scheduleBuf[i].shared                         &&
-            schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B      &&
-            packetfunctions_sameAddress(neighbor,&schedule_vars.scheduleBuf[i].neighbor)
+    if (neighbor->type == ADDR_64B) {
+        for (
+            pos=schedule_nbrLowerBound(neighbor);
+            pos<schedule_vars.numNbrIndex &&
+            schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,neighbor)==0;
+            pos++
         ){
-            memcpy(neighbor, &schedule_vars.scheduleBuf[i].neighbor, sizeof(open_addr_t));
-            ENABLE_INTERRUPTS();
-            return TRUE;
+            if(
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].type == CELLTYPE_TXRX &&
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].shared
+            ){
+                memcpy(neighbor, &schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor, sizeof(open_addr_t));
+                ENABLE_INTERRUPTS();
+                return TRUE;
+            }
         }
     }
 
@@ -859,20 +926,25 @@ bool schedule_getAutonomousTxRxCellUnicastNeighbor(open_addr_t* neighbor){
 }
 
 bool schedule_hasAutoTxCellToNeighbor(open_addr_t* neighbor){
-    uint8_t i;
+    uint8_t pos;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(
-            schedule_vars.scheduleBuf[i].shared == TRUE &&
-            schedule_vars.scheduleBuf[i].type   == CELLTYPE_TX &&
-            schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B &&
-            packetfunctions_sameAddress(neighbor,&schedule_vars.scheduleBuf[i].neighbor)
+    if (neighbor->type == ADDR_64B) {
+        for (
+            pos=schedule_nbrLowerBound(neighbor);
+            pos<schedule_vars.numNbrIndex &&
+            schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,neighbor)==0;
+            pos++
         ){
-            ENABLE_INTERRUPTS();
-            return TRUE;
+            if(
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].shared == TRUE &&
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].type   == CELLTYPE_TX
+            ){
+                ENABLE_INTERRUPTS();
+                return TRUE;
+            }
         }
     }
 
@@ -881,20 +953,25 @@ bool schedule_hasAutoTxCellToNeighbor(open_addr_t* neighbor){
 }
 
 bool schedule_hasNegotiatedCellToNeighbor(open_addr_t* neighbor, cellType_t cell_type){
-    uint8_t i;
+    uint8_t pos;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(
-            schedule_vars.scheduleBuf[i].shared == FALSE &&
-            schedule_vars.scheduleBuf[i].type   == cell_type &&
-            schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B &&
-            packetfunctions_sameAddress(neighbor,&schedule_vars.scheduleBuf[i].neighbor)
+    if (neighbor->type == ADDR_64B && schedule_vars.numCellsOfType[cell_type]>0) {
+        for (
+            pos=schedule_nbrLowerBound(neighbor);
+            pos<schedule_vars.numNbrIndex &&
+            schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,neighbor)==0;
+            pos++
         ){
-            ENABLE_INTERRUPTS();
-            return TRUE;
+            if(
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].shared == FALSE &&
+                schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].type   == cell_type
+            ){
+                ENABLE_INTERRUPTS();
+                return TRUE;
+            }
         }
     }
 
@@ -913,21 +990,26 @@ bool schedule_hasNegotiatedTxCellToNonParent(
     open_addr_t* parentNeighbor,
     open_addr_t* nonParentNeighbor
 ){
-    uint8_t i;
+    uint8_t          pos;
+    scheduleEntry_t* entry;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for(i=0;i<MAXACTIVESLOTS;i++) {
-        if(
-            schedule_vars.scheduleBuf[i].type          == CELLTYPE_TX   &&
-            schedule_vars.scheduleBuf[i].shared        == FALSE         &&
-            schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B      &&
-            packetfunctions_sameAddress(parentNeighbor,&schedule_vars.scheduleBuf[i].neighbor) == FALSE
-        ){
-            memcpy(nonParentNeighbor,&schedule_vars.scheduleBuf[i].neighbor,sizeof(open_addr_t));
-            ENABLE_INTERRUPTS();
-            return TRUE;
+    if (schedule_vars.numCellsOfType[CELLTYPE_TX]>0) {
+        // walk the cells by neighbor, the ones to the parent are grouped
+        for (pos=0;pos<schedule_vars.numNbrIndex;pos++) {
+            entry = &schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]];
+            if(
+                entry->type          == CELLTYPE_TX   &&
+                entry->shared        == FALSE         &&
+                entry->neighbor.type == ADDR_64B      &&
+                packetfunctions_sameAddress(parentNeighbor,&entry->neighbor) == FALSE
+            ){
+                memcpy(nonParentNeighbor,&entry->neighbor,sizeof(open_addr_t));
+                ENABLE_INTERRUPTS();
+                return TRUE;
+            }
         }
     }
 
@@ -936,18 +1018,27 @@ bool schedule_hasNegotiatedTxCellToNonParent(
 }
 
 bool schedule_getAutonomousTxRxCellAnycast(uint16_t* slotoffset){
-    uint8_t i;
+    uint8_t          pos;
+    open_addr_t      anycast;
+    scheduleEntry_t* entry;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for(i=0;i<MAXACTIVESLOTS;i++) {
+    // anycast cells are grouped in the neighbor index, starting from the
+    // lowest anycast address
+    memset(&anycast,0,sizeof(open_addr_t));
+    anycast.type = ADDR_ANYCAST;
+    for (pos=schedule_nbrLowerBound(&anycast);pos<schedule_vars.numNbrIndex;pos++) {
+        entry = &schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]];
+        if (entry->neighbor.type != ADDR_ANYCAST) {
+            break;
+        }
         if(
-            schedule_vars.scheduleBuf[i].type          == CELLTYPE_TXRX &&
-            schedule_vars.scheduleBuf[i].shared        == FALSE         &&
-            schedule_vars.scheduleBuf[i].neighbor.type == ADDR_ANYCAST
+            entry->type          == CELLTYPE_TXRX &&
+            entry->shared        == FALSE
         ){
-            *slotoffset = schedule_vars.scheduleBuf[i].slotOffset;
+            *slotoffset = entry->slotOffset;
             ENABLE_INTERRUPTS();
             return TRUE;
         }
@@ -959,13 +1050,30 @@ bool schedule_getAutonomousTxRxCellAnycast(uint16_t* slotoffset){
 
 //=== from IEEE802154E: reading the schedule and updating statistics
 
+/**
+\brief Make the active slot at a given slot offset the current one.
+
+When that slot offset is not active, the current slot becomes the active one
+preceding it, so that the next active slot is the first one after it.
+*/
 void schedule_syncSlotOffset(slotOffset_t targetSlotOffset) {
+   uint8_t pos;
 
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
 
-   while (schedule_vars.currentScheduleEntry->slotOffset!=targetSlotOffset) {
-      schedule_advanceSlot();
+   if (schedule_vars.numActiveSlots>0) {
+      pos = schedule_slotLowerBound(targetSlotOffset);
+      if (
+         pos==schedule_vars.numActiveSlots ||
+         schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos]].slotOffset != targetSlotOffset
+      ) {
+         if (pos==0) {
+            pos = schedule_vars.numActiveSlots;
+         }
+         pos--;
+      }
+      schedule_vars.currentScheduleEntry = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos]];
    }
 
    ENABLE_INTERRUPTS();
@@ -999,6 +1107,41 @@ slotOffset_t schedule_getNextActiveSlotOffset(void) {
     return res;
 }
 
+/**
+\brief Get the cell of an upcoming active slot.
+
+\param[in]  numAhead How many active slots after the current one, 1 being the
+   next active slot.
+\param[out] info     The cell of that active slot, of type CELLTYPE_OFF if the
+   schedule is empty.
+*/
+void schedule_getNextActiveSlotInfo(uint8_t numAhead, slotinfo_element_t* info) {
+    scheduleEntry_t* slotContainer;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    slotContainer = schedule_vars.currentScheduleEntry;
+    if (slotContainer==NULL) {
+        info->link_type                 = CELLTYPE_OFF;
+        ENABLE_INTERRUPTS();
+        return;
+    }
+    while (numAhead>0) {
+        slotContainer = slotContainer->next;
+        numAhead--;
+    }
+
+    info->link_type                 = slotContainer->type;
+    info->shared                    = slotContainer->shared;
+    info->slotOffset                = slotContainer->slotOffset;
+    info->channelOffset             = slotContainer->channelOffset;
+    info->isAutoCell                = slotContainer->isAutoCell;
+    memcpy(&(info->address), &(slotContainer->neighbor), sizeof(open_addr_t));
+
+    ENABLE_INTERRUPTS();
+}
+
 /**
 \brief Get the frame length.
 
@@ -1175,6 +1318,43 @@ bool schedule_getOkToSend(void) {
     return returnVal;
 }
 
+/**
+\brief Tell whether a slot can carry the next frame of a burst with a neighbor.
+
+The slot can if it is not active, or if it is a dedicated cell of the same type
+with that neighbor, so a burst never takes a slot from other traffic. Unlike in
+schedule_getOkToSend(), backoff does not apply.
+
+\param[in] slotOffset The slot offset of the slot.
+\param[in] type       CELLTYPE_TX to send the frame, CELLTYPE_RX to receive it.
+\param[in] neighbor   The neighbor of the burst.
+
+\returns TRUE if the slot can be used for the burst, FALSE otherwise.
+*/
+bool schedule_getOkToBurst(slotOffset_t slotOffset, cellType_t type, open_addr_t* neighbor) {
+    scheduleEntry_t* slotContainer;
+    uint8_t          pos;
+    bool             returnVal;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    returnVal = TRUE;
+    pos = schedule_slotLowerBound(slotOffset);
+    if (pos<schedule_vars.numActiveSlots) {
+        slotContainer = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos]];
+        if (slotContainer->slotOffset==slotOffset) {
+            returnVal = slotContainer->type==type &&
+                        slotContainer->shared==FALSE &&
+                        packetfunctions_sameAddress(&slotContainer->neighbor,neighbor);
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+
+    return returnVal;
+}
+
 /**
 \brief Reset the backoff and backoffExponent.
 */
@@ -1261,6 +1441,7 @@ bool schedule_getOneCellAfterOffset(uint8_t metadata,uint8_t offset,open_addr_t*
     bool returnVal;
     scheduleEntry_t* scheduleWalker;
     cellType_t type;
+    uint8_t pos;
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
@@ -1276,16 +1457,16 @@ bool schedule_getOneCellAfterOffset(uint8_t metadata,uint8_t offset,open_addr_t*
     }
 
     returnVal      = FALSE;
-    scheduleWalker = &schedule_vars.scheduleBuf[0]; // fisrt entry record slotoffset 0
-    do {
-        if(type == scheduleWalker->type && scheduleWalker->slotOffset >= offset){
+    // active slots from that offset on, by increasing slot offset
+    for (pos=schedule_slotLowerBound(offset);pos<schedule_vars.numActiveSlots;pos++) {
+        scheduleWalker = &schedule_vars.scheduleBuf[schedule_vars.slotIndex[pos]];
+        if(type == scheduleWalker->type){
             *slotoffset    = scheduleWalker->slotOffset;
             *channeloffset = scheduleWalker->channelOffset;
             returnVal      = TRUE;
             break;
         }
-        scheduleWalker = scheduleWalker->next;
-   }while(scheduleWalker!=&schedule_vars.scheduleBuf[0]);
+    }
 
     ENABLE_INTERRUPTS();
 
@@ -1335,3 +1516,149 @@ void schedule_resetBackupEntry(backupEntry_t* e) {
     e->next                   = NULL;
 }
 
+/**
+\brief Compare two neighbor addresses, for ordering the neighbor index.
+
+Addresses are ordered by type, then by the bytes significant for that type, so
+that two addresses compare equal exactly when packetfunctions_sameAddress()
+holds.
+
+\returns A negative, zero or positive value when address_1 is respectively
+   lower than, equal to or greater than address_2.
+*/
+int8_t schedule_compareAddress(open_addr_t* address_1, open_addr_t* address_2) {
+    uint8_t address_length;
+    int     diff;
+
+    if (address_1->type != address_2->type) {
+        return (address_1->type < address_2->type) ? -1 : 1;
+    }
+    switch (address_1->type) {
+        case ADDR_16B:
+        case ADDR_PANID:
+            address_length = 2;
+            break;
+        case ADDR_64B:
+        case ADDR_PREFIX:
+            address_length = 8;
+            break;
+        case ADDR_128B:
+        case ADDR_ANYCAST:
+            address_length = 16;
+            break;
+        default:
+            address_length = 0;
+            break;
+    }
+    diff = memcmp(address_1->addr_128b, address_2->addr_128b, address_length);
+    if (diff < 0) {
+        return -1;
+    }
+    return (diff > 0) ? 1 : 0;
+}
+
+/**
+\brief Find the position of a slot offset in the slot offset index.
+
+\returns The position of the first active slot with a slot offset greater than
+   or equal to the one given, numActiveSlots if there is none.
+*/
+uint8_t schedule_slotLowerBound(slotOffset_t slotOffset) {
+    uint8_t low;
+    uint8_t high;
+    uint8_t middle;
+
+    low  = 0;
+    high = schedule_vars.numActiveSlots;
+    while (low < high) {
+        middle = low + (high-low)/2;
+        if (schedule_vars.scheduleBuf[schedule_vars.slotIndex[middle]].slotOffset < slotOffset) {
+            low  = middle+1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+\brief Find the position of a neighbor in the neighbor index.
+
+\returns The position of the first row with a neighbor greater than or equal to
+   the one given, numNbrIndex if there is none. The rows of that neighbor, if
+   any, follow by increasing row.
+*/
+uint8_t schedule_nbrLowerBound(open_addr_t* neighbor) {
+    uint8_t low;
+    uint8_t high;
+    uint8_t middle;
+
+    low  = 0;
+    high = schedule_vars.numNbrIndex;
+    while (low < high) {
+        middle = low + (high-low)/2;
+        if (schedule_compareAddress(&schedule_vars.scheduleBuf[schedule_vars.nbrIndex[middle]].neighbor, neighbor) < 0) {
+            low  = middle+1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+\brief Add an active row to the neighbor index and to the type counters.
+
+\pre Interrupts are disabled.
+*/
+void schedule_nbrIndexInsert(uint8_t row) {
+    uint8_t pos;
+
+    pos = schedule_nbrLowerBound(&schedule_vars.scheduleBuf[row].neighbor);
+    while (
+        pos<schedule_vars.numNbrIndex &&
+        schedule_vars.nbrIndex[pos] < row &&
+        schedule_compareAddress(
+            &schedule_vars.scheduleBuf[schedule_vars.nbrIndex[pos]].neighbor,
+            &schedule_vars.scheduleBuf[row].neighbor
+        )==0
+    ) {
+        pos++;
+    }
+    memmove(
+        &schedule_vars.nbrIndex[pos+1],
+        &schedule_vars.nbrIndex[pos],
+        schedule_vars.numNbrIndex-pos
+    );
+    schedule_vars.nbrIndex[pos] = row;
+    schedule_vars.numNbrIndex++;
+
+    schedule_vars.numCellsOfType[schedule_vars.scheduleBuf[row].type]++;
+}
+
+/**
+\brief Remove an active row from the neighbor index and from the type counters.
+
+\pre Interrupts are disabled, and the neighbor and type of that row did not
+   change since it was inserted.
+*/
+void schedule_nbrIndexRemove(uint8_t row) {
+    uint8_t pos;
+
+    pos = schedule_nbrLowerBound(&schedule_vars.scheduleBuf[row].neighbor);
+    while (pos<schedule_vars.numNbrIndex && schedule_vars.nbrIndex[pos]!=row) {
+        pos++;
+    }
+    if (pos==schedule_vars.numNbrIndex) {
+        // not indexed, should never happen
+        return;
+    }
+    schedule_vars.numNbrIndex--;
+    memmove(
+        &schedule_vars.nbrIndex[pos],
+        &schedule_vars.nbrIndex[pos+1],
+        schedule_vars.numNbrIndex-pos
+    );
+
+    schedule_vars.numCellsOfType[schedule_vars.scheduleBuf[row].type]--;
+}
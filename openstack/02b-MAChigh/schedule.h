@@ -37,7 +37,9 @@ The superframe reappears over time and can be arbitrarily long.
   for serial port to transmit data to dagroot.
 */
 
+#ifndef NUMSLOTSOFF
 #define NUMSLOTSOFF          20
+#endif
 
 /**
 \brief Maximum number of active slots in a superframe.
@@ -49,7 +51,11 @@ in that table; a slot is "active" when it is not of type CELLTYPE_OFF.
 Set this number to the exact number of active slots you are planning on having
 in your schedule, so not to waste RAM.
 */
-#define MAXACTIVESLOTS       SCHEDULE_MINIMAL_6TISCH_ACTIVE_CELLS+NUMSLOTSOFF
+#define MAXACTIVESLOTS       (SCHEDULE_MINIMAL_6TISCH_ACTIVE_CELLS+NUMSLOTSOFF)
+
+#if MAXACTIVESLOTS>255
+#error "schedule rows are indexed on 8 bits"
+#endif
 
 /**
 \brief Maximum number of alternative slots (more than one cells with same slotOffset)
@@ -161,6 +167,12 @@ typedef struct {
 typedef struct {
    scheduleEntry_t  scheduleBuf[MAXACTIVESLOTS];
    scheduleEntry_t* currentScheduleEntry;
+   uint8_t          slotIndex[MAXACTIVESLOTS];      // active rows sorted by slot offset, then free rows
+   uint8_t          numActiveSlots;                 // number of active rows at the start of slotIndex
+   uint8_t          nbrIndex[MAXACTIVESLOTS];       // active rows sorted by neighbor, then by row
+   uint8_t          numNbrIndex;                    // number of rows in nbrIndex
+   uint8_t          numCellsOfType[CELLTYPE_TXRX+1];// number of active rows of each cell type
+   uint8_t          numBackupEntries;               // number of backup entries in use
    frameLength_t    frameLength;
    frameLength_t    maxActiveSlots;
    uint8_t          frameHandle;
@@ -228,6 +240,7 @@ bool              schedule_hasNegotiatedTxCellToNonParent(
 void               schedule_syncSlotOffset(slotOffset_t targetSlotOffset);
 void               schedule_advanceSlot(void);
 slotOffset_t       schedule_getNextActiveSlotOffset(void);
+void               schedule_getNextActiveSlotInfo(uint8_t numAhead, slotinfo_element_t* info);
 frameLength_t      schedule_getFrameLength(void);
 cellType_t         schedule_getType(void);
 bool               schedule_getShared(void);
@@ -236,6 +249,11 @@ void               schedule_getNeighbor(open_addr_t* addrToWrite);
 slotOffset_t       schedule_getSlottOffset(void);
 channelOffset_t    schedule_getChannelOffset(void);
 bool               schedule_getOkToSend(void);
+bool               schedule_getOkToBurst(
+                        slotOffset_t slotOffset,
+                        cellType_t   type,
+                        open_addr_t* neighbor
+                   );
 void               schedule_resetBackoff(void);
 void               schedule_indicateRx(asn_t*   asnTimestamp);
 void               schedule_indicateTx(
@@ -40,6 +40,12 @@ owerror_t     sixtop_send_internal(
    bool                 payloadIEPresent
 );
 
+// notifications from the MAC
+void          sixtop_sendDone(OpenQueueEntry_t* msg);
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+void          sixtop_receiveAggregated(OpenQueueEntry_t* msg);
+#endif
+
 // timer interrupt callbacks
 void          sixtop_maintenance_timer_cb(opentimers_id_t id);
 void          sixtop_timeout_timer_cb(opentimers_id_t id);
@@ -55,6 +61,10 @@ void          sixtop_sendKA(void);
 //=== six2six task
 
 void          timer_sixtop_six2six_timeout_fired(void);
+sixtop_transaction_t* sixtop_getTransaction(open_addr_t* neighbor);
+void          sixtop_startTimeout(sixtop_transaction_t* transaction);
+void          sixtop_timeoutTransaction(sixtop_transaction_t* transaction);
+void          sixtop_endTransaction(sixtop_transaction_t* transaction);
 void          sixtop_six2six_sendDone(
    OpenQueueEntry_t*    msg,
    owerror_t            error
@@ -112,7 +122,8 @@ void sixtop_init(void) {
     sixtop_vars.mgtTaskCounter     = 0;
     sixtop_vars.kaPeriod           = MAXKAPERIOD;
     sixtop_vars.isResponseEnabled  = TRUE;
-    sixtop_vars.six2six_state      = SIX_STATE_IDLE;
+    sixtop_vars.clock              = 0;
+    memset(sixtop_vars.transactions,0,sizeof(sixtop_vars.transactions));
 
     sixtop_vars.ebSendingTimerId   = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_SIXTOP);
     opentimers_scheduleIn(
@@ -181,13 +192,27 @@ owerror_t sixtop_request(
     uint16_t          length_groupid_type;
     uint8_t           sequenceNumber;
     owerror_t         outcome;
+    sixtop_transaction_t* transaction;
 
     // filter parameters: handler, status and neighbor
     if(
-        sixtop_vars.six2six_state != SIX_STATE_IDLE   ||
-        neighbor                  == NULL
+        neighbor                        == NULL ||
+        sixtop_getTransaction(neighbor) != NULL
     ){
-        // neighbor can't be none or previous transcation doesn't finish yet
+        // neighbor can't be none or previous transcation with it doesn't finish yet
+        return E_FAIL;
+    }
+
+    // find a free transaction entry
+    transaction = NULL;
+    for (i=0;i<SIX2SIX_MAX_TRANSACTIONS;i++) {
+        if (sixtop_vars.transactions[i].state == SIX_STATE_IDLE) {
+            transaction = &sixtop_vars.transactions[i];
+            break;
+        }
+    }
+    if (transaction == NULL) {
+        // as many transactions in progress as I can track
         return E_FAIL;
     }
 
@@ -213,10 +238,17 @@ owerror_t sixtop_request(
     pkt->owner   = COMPONENT_SIXTOP_RES;
 
     memcpy(&(pkt->l2_nextORpreviousHop),neighbor,sizeof(open_addr_t));
+    memset(transaction->celllist_toAdd,0,sizeof(transaction->celllist_toAdd));
+    if (
+        (code == IANA_6TOP_CMD_ADD || code == IANA_6TOP_CMD_RELOCATE) &&
+        celllist_toBeAdded != NULL
+    ){
+        memcpy(transaction->celllist_toAdd,celllist_toBeAdded,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
+    }
     if (celllist_toBeDeleted != NULL){
-        memcpy(sixtop_vars.celllist_toDelete,celllist_toBeDeleted,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
+        memcpy(transaction->celllist_toDelete,celllist_toBeDeleted,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
     }
-    sixtop_vars.cellOptions = cellOptions;
+    transaction->cellOptions = cellOptions;
 
     len  = 0;
     if (
@@ -277,9 +309,6 @@ owerror_t sixtop_request(
         packetfunctions_reserveHeaderSize(pkt,sizeof(uint8_t));
         *((uint8_t*)(pkt->payload)) = cellOptions;
         len+=1;
-    } else {
-        // record the neighbor in case no response  for clear
-        memcpy(&sixtop_vars.neighborToClearCells,neighbor,sizeof(open_addr_t));
     }
 
     // append 6p metadata
@@ -292,6 +321,8 @@ owerror_t sixtop_request(
     packetfunctions_reserveHeaderSize(pkt,sizeof(uint8_t));
     sequenceNumber              = neighbors_getSequenceNumber(neighbor);
     *((uint8_t*)(pkt->payload)) = sequenceNumber;
+    transaction->seqNum         = sequenceNumber;
+    pkt->l2_sixtop_seqNum       = sequenceNumber;
     len += 1;
 
     // append 6p sfid
@@ -335,24 +366,27 @@ owerror_t sixtop_request(
         //update states
         switch(code){
         case IANA_6TOP_CMD_ADD:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_ADDREQUEST_SENDDONE;
+            transaction->state = SIX_STATE_WAIT_ADDREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_DELETE:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_DELETEREQUEST_SENDDONE;
+            transaction->state = SIX_STATE_WAIT_DELETEREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_RELOCATE:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_RELOCATEREQUEST_SENDDONE;
+            transaction->state = SIX_STATE_WAIT_RELOCATEREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_COUNT:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_COUNTREQUEST_SENDDONE;
+            transaction->state = SIX_STATE_WAIT_COUNTREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_LIST:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_LISTREQUEST_SENDDONE;
+            transaction->state = SIX_STATE_WAIT_LISTREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_CLEAR:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_CLEARREQUEST_SENDDONE;
+            transaction->state = SIX_STATE_WAIT_CLEARREQUEST_SENDDONE;
             break;
         }
+        memcpy(&transaction->neighbor,neighbor,sizeof(open_addr_t));
+        // time the transaction out even if the request never leaves the queue
+        sixtop_startTimeout(transaction);
     } else {
         openqueue_freePacketBuffer(pkt);
     }
@@ -389,6 +423,9 @@ owerror_t sixtop_send(OpenQueueEntry_t *msg) {
 
 void task_sixtopNotifSendDone(void) {
     OpenQueueEntry_t* msg;
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+    asn_t             asn;
+#endif
 
     // get recently-sent packet from openqueue
     msg = openqueue_sixtopGetSentPacket();
@@ -402,53 +439,16 @@ void task_sixtopNotifSendDone(void) {
         return;
     }
 
-    // take ownership
-    msg->owner = COMPONENT_SIXTOP;
-
-    // update neighbor statistics
-    if (msg->l2_sendDoneError==E_SUCCESS) {
-        neighbors_indicateTx(
-            &(msg->l2_nextORpreviousHop),
-            msg->l2_numTxAttempts,
-            msg->l2_sendOnTxCell,
-            TRUE,
-            &msg->l2_asn
-        );
-    } else {
-        neighbors_indicateTx(
-             &(msg->l2_nextORpreviousHop),
-             msg->l2_numTxAttempts,
-             msg->l2_sendOnTxCell,
-             FALSE,
-             &msg->l2_asn
-        );
-    }
-
-    // send the packet to where it belongs
-    switch (msg->creator) {
-        case COMPONENT_SIXTOP:
-            if (msg->l2_frameType==IEEE154_TYPE_BEACON) {
-                // this is a EB
-
-                // not busy sending EB anymore
-                sixtop_vars.busySendingEB = FALSE;
-            } else {
-                // this is a KA
-
-                // not busy sending KA anymore
-                sixtop_vars.busySendingKA = FALSE;
-            }
-            // discard packets
-            openqueue_freePacketBuffer(msg);
-            break;
-        case COMPONENT_SIXTOP_RES:
-            sixtop_six2six_sendDone(msg,msg->l2_sendDoneError);
-            break;
-        default:
-            // send the rest up the stack
-            frag_sendDone(msg,msg->l2_sendDoneError);
-            break;
-    }
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+    // a single task is posted for the packets sent in the same frame
+    memcpy(&asn,&msg->l2_asn,sizeof(asn_t));
+    do {
+        sixtop_sendDone(msg);
+        msg = openqueue_sixtopGetSentPacketAtAsn(&asn);
+    } while (msg!=NULL);
+#else
+    sixtop_sendDone(msg);
+#endif
 }
 
 void task_sixtopNotifReceive(void) {
@@ -510,6 +510,13 @@ void task_sixtopNotifReceive(void) {
                 openqueue_freePacketBuffer(msg);
                 break;
             }
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+            if (msg->payload[0]==AGGREGATION_DISPATCH) {
+                // several packets in this frame
+                sixtop_receiveAggregated(msg);
+                break;
+            }
+#endif
             // send to upper layer
             frag_receive(msg);
         } else {
@@ -618,7 +625,7 @@ owerror_t sixtop_send_internal(
         &(msg->l2_nextORpreviousHop)
     );
     // change owner to IEEE802154E fetches it from queue
-    msg->owner  = COMPONENT_SIXTOP_TO_IEEE802154E;
+    openqueue_sixtopPushToMac(msg);
 
     if (
         packetfunctions_isBroadcastMulticast(&(msg->l2_nextORpreviousHop))   == FALSE &&
@@ -638,9 +645,126 @@ owerror_t sixtop_send_internal(
             &(msg->l2_nextORpreviousHop)                                     // neighbor
         );
     }
+#ifdef IEEE802154E_SLOTPLAN_ENABLED
+    // prepare the frame ahead of its slot
+    ieee154e_planSlots();
+#endif
     return E_SUCCESS;
 }
 
+/**
+\brief Handle the outcome of the transmission of a packet.
+
+\param[in] msg The packet, handed back by the MAC.
+*/
+void sixtop_sendDone(OpenQueueEntry_t* msg) {
+    // take ownership
+    msg->owner = COMPONENT_SIXTOP;
+
+    // update neighbor statistics
+    if (msg->l2_sendDoneError==E_SUCCESS) {
+        neighbors_indicateTx(
+            &(msg->l2_nextORpreviousHop),
+            msg->l2_numTxAttempts,
+            msg->l2_sendOnTxCell,
+            TRUE,
+            &msg->l2_asn
+        );
+    } else {
+        neighbors_indicateTx(
+             &(msg->l2_nextORpreviousHop),
+             msg->l2_numTxAttempts,
+             msg->l2_sendOnTxCell,
+             FALSE,
+             &msg->l2_asn
+        );
+    }
+
+    // send the packet to where it belongs
+    switch (msg->creator) {
+        case COMPONENT_SIXTOP:
+            if (msg->l2_frameType==IEEE154_TYPE_BEACON) {
+                // this is a EB
+
+                // not busy sending EB anymore
+                sixtop_vars.busySendingEB = FALSE;
+            } else {
+                // this is a KA
+
+                // not busy sending KA anymore
+                sixtop_vars.busySendingKA = FALSE;
+            }
+            // discard packets
+            openqueue_freePacketBuffer(msg);
+            break;
+        case COMPONENT_SIXTOP_RES:
+            sixtop_six2six_sendDone(msg,msg->l2_sendDoneError);
+            break;
+        default:
+            // send the rest up the stack
+            frag_sendDone(msg,msg->l2_sendDoneError);
+            break;
+    }
+}
+
+#ifdef IEEE802154E_AGGREGATION_ENABLED
+/**
+\brief Send up the stack each packet of an aggregated frame.
+
+The frame payload is AGGREGATION_DISPATCH, then the packets, each preceded by
+its length on one byte. All but the last packet are copied to a buffer of
+their own, the last one is sent up in the received buffer.
+
+\param[in] msg The received frame, MAC header tossed.
+*/
+void sixtop_receiveAggregated(OpenQueueEntry_t* msg) {
+    OpenQueueEntry_t* pkt;
+    uint8_t           len;
+
+    // toss the dispatch
+    packetfunctions_tossHeader(msg,1);
+
+    while (msg->length>0) {
+        len = msg->payload[0];
+        if (len==0 || len>=msg->length) {
+            openserial_printError(
+                COMPONENT_SIXTOP,
+                ERR_UNSUPPORTED_FORMAT,
+                (errorparameter_t)1,
+                (errorparameter_t)0
+            );
+            break;
+        }
+        packetfunctions_tossHeader(msg,1);
+
+        if (len==msg->length) {
+            // last packet
+            frag_receive(msg);
+            return;
+        }
+
+        pkt = openqueue_getFreePacketBuffer(COMPONENT_IEEE802154E);
+        if (pkt==NULL) {
+            openserial_printError(
+                COMPONENT_SIXTOP,
+                ERR_NO_FREE_PACKET_BUFFER,
+                (errorparameter_t)1,
+                (errorparameter_t)0
+            );
+        } else {
+            // same L2 information, payload cut to this packet
+            packetfunctions_duplicatePacket(pkt,msg);
+            pkt->length = len;
+            frag_receive(pkt);
+        }
+        packetfunctions_tossHeader(msg,len);
+    }
+
+    // free the packet's RAM memory
+    openqueue_freePacketBuffer(msg);
+}
+#endif
+
 /**
 \brief sixtop sendingEb timer callback function.
 
@@ -909,73 +1033,140 @@ port_INLINE void sixtop_sendKA(void) {
 //======= six2six task
 
 void timer_sixtop_six2six_timeout_fired(void) {
+    sixtop_transaction_t* transaction;
+    bool                  pending;
+    uint8_t               i;
 
-    if (sixtop_vars.six2six_state == SIX_STATE_WAIT_CLEARRESPONSE){
+    sixtop_vars.clock++;
+
+    pending = FALSE;
+    for (i=0;i<SIX2SIX_MAX_TRANSACTIONS;i++) {
+        transaction = &sixtop_vars.transactions[i];
+        if (transaction->state == SIX_STATE_IDLE) {
+            continue;
+        }
+        if ((int16_t)(sixtop_vars.clock-transaction->expiry)>=0) {
+            sixtop_timeoutTransaction(transaction);
+        } else {
+            pending = TRUE;
+        }
+    }
+
+    // no transaction left to time out
+    if (pending == FALSE) {
+        opentimers_cancel(sixtop_vars.timeoutTimerId);
+    }
+}
+
+/**
+\brief Find the transaction in progress with a neighbor.
+
+\returns The transaction, NULL if there is none.
+*/
+sixtop_transaction_t* sixtop_getTransaction(open_addr_t* neighbor) {
+    uint8_t i;
+
+    for (i=0;i<SIX2SIX_MAX_TRANSACTIONS;i++) {
+        if (
+            sixtop_vars.transactions[i].state != SIX_STATE_IDLE &&
+            packetfunctions_sameAddress(&sixtop_vars.transactions[i].neighbor,neighbor)
+        ){
+            return &sixtop_vars.transactions[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+\brief (Re)arm the timeout of a transaction, ticking the timer if it was idle.
+*/
+void sixtop_startTimeout(sixtop_transaction_t* transaction) {
+    transaction->expiry = sixtop_vars.clock+SIX2SIX_TIMEOUT_PERIODS;
+    if (opentimers_isRunning(sixtop_vars.timeoutTimerId) == FALSE) {
+        opentimers_scheduleIn(
+            sixtop_vars.timeoutTimerId,
+            SIX2SIX_TIMER_PERIOD,
+            TIME_MS,
+            TIMER_PERIODIC,
+            sixtop_timeout_timer_cb
+        );
+    }
+}
+
+void sixtop_timeoutTransaction(sixtop_transaction_t* transaction) {
+    if (
+        transaction->state == SIX_STATE_WAIT_CLEARREQUEST_SENDDONE ||
+        transaction->state == SIX_STATE_WAIT_CLEARRESPONSE
+    ){
         // no response for the 6p clear, just clear locally
         schedule_removeAllNegotiatedCellsToNeighbor(
             sixtop_vars.cb_sf_getMetadata(),
-            &sixtop_vars.neighborToClearCells
+            &transaction->neighbor
         );
-        neighbors_resetSequenceNumber(&sixtop_vars.neighborToClearCells);
-        memset(&sixtop_vars.neighborToClearCells,0,sizeof(open_addr_t));
+        neighbors_resetSequenceNumber(&transaction->neighbor);
     }
-    // timeout timer fired, reset the state of sixtop to idle
-    sixtop_vars.six2six_state = SIX_STATE_IDLE;
-    opentimers_cancel(sixtop_vars.timeoutTimerId);
+    // a request still waiting in the queue would start another transaction
+    openqueue_remove6PrequestToNeighbor(&transaction->neighbor);
+    sixtop_endTransaction(transaction);
+}
+
+void sixtop_endTransaction(sixtop_transaction_t* transaction) {
+    memset(transaction,0,sizeof(sixtop_transaction_t));
+    transaction->state = SIX_STATE_IDLE;
 }
 
 void sixtop_six2six_sendDone(OpenQueueEntry_t* msg, owerror_t error){
+    sixtop_transaction_t* transaction;
 
     msg->owner = COMPONENT_SIXTOP_RES;
 
-    // if this is a request send done
-    if (msg->l2_sixtop_messageType == SIXTOP_CELL_REQUEST){
+    // if this is a request send done (its transaction may have timed out meanwhile,
+    // and another one started with the same neighbor)
+    transaction = sixtop_getTransaction(&(msg->l2_nextORpreviousHop));
+    if (
+        msg->l2_sixtop_messageType == SIXTOP_CELL_REQUEST &&
+        transaction != NULL                               &&
+        transaction->seqNum == msg->l2_sixtop_seqNum
+    ){
         if(error == E_FAIL) {
             // max retries, without ack
-            switch (sixtop_vars.six2six_state) {
+            switch (transaction->state) {
 
             case SIX_STATE_WAIT_CLEARREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_CLEARRESPONSE;
-                timer_sixtop_six2six_timeout_fired();
+                sixtop_timeoutTransaction(transaction);
                 break;
             default:
                 // reset handler and state if the request is failed to send out
-                sixtop_vars.six2six_state = SIX_STATE_IDLE;
+                sixtop_endTransaction(transaction);
                 break;
             }
         } else {
             // the packet has been sent out successfully
-            switch (sixtop_vars.six2six_state) {
+            switch (transaction->state) {
             case SIX_STATE_WAIT_ADDREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_ADDRESPONSE;
+                transaction->state = SIX_STATE_WAIT_ADDRESPONSE;
                 break;
             case SIX_STATE_WAIT_DELETEREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_DELETERESPONSE;
+                transaction->state = SIX_STATE_WAIT_DELETERESPONSE;
                 break;
             case SIX_STATE_WAIT_RELOCATEREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_RELOCATERESPONSE;
+                transaction->state = SIX_STATE_WAIT_RELOCATERESPONSE;
                 break;
             case SIX_STATE_WAIT_LISTREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_LISTRESPONSE;
+                transaction->state = SIX_STATE_WAIT_LISTRESPONSE;
                 break;
             case SIX_STATE_WAIT_COUNTREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_COUNTRESPONSE;
+                transaction->state = SIX_STATE_WAIT_COUNTRESPONSE;
                 break;
             case SIX_STATE_WAIT_CLEARREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_CLEARRESPONSE;
+                transaction->state = SIX_STATE_WAIT_CLEARRESPONSE;
                 break;
             default:
                 // should never happen
                 break;
             }
-            // start timeout timer if I am waiting for a response
-            opentimers_scheduleIn(
-                sixtop_vars.timeoutTimerId,
-                SIX2SIX_TIMEOUT_MS,
-                TIME_MS,
-                TIMER_ONESHOT,
-                sixtop_timeout_timer_cb
-            );
+            // wait for the response a full timeout from now
+            sixtop_startTimeout(transaction);
         }
     }
 
@@ -1139,6 +1330,8 @@ void sixtop_six2six_notifyReceive(
     uint8_t           pktLen            = length;
     uint8_t           response_pktLen   = 0;
     cellInfo_ht       celllist_list[CELLLIST_MAX_LEN];
+    sixtop_transaction_t* transaction;
+    six2six_state_t   state;
 
     if (type == SIXTOP_CELL_REQUEST){
         // if this is a 6p request message
@@ -1186,8 +1379,8 @@ void sixtop_six2six_notifyReceive(
                 returnCode = IANA_6TOP_RC_SEQNUM_ERR;
                 break;
             }
-            // previous 6p transcation check
-            if (sixtop_vars.six2six_state != SIX_STATE_IDLE){
+            // previous 6p transcation with that neighbor check
+            if (sixtop_getTransaction(&(pkt->l2_nextORpreviousHop)) != NULL){
                 returnCode = IANA_6TOP_RC_RESET;
                 break;
             }
@@ -1502,9 +1695,16 @@ void sixtop_six2six_notifyReceive(
     if (type == SIXTOP_CELL_RESPONSE) {
         // this is a 6p response message
 
+        transaction = sixtop_getTransaction(&(pkt->l2_nextORpreviousHop));
+        if (transaction != NULL && transaction->seqNum != seqNum){
+            // answers an earlier request to that neighbor, keep waiting
+            return;
+        }
+        state = (transaction != NULL)?transaction->state:SIX_STATE_IDLE;
+
         // if the code is SUCCESS
         if (code == IANA_6TOP_RC_SUCCESS || code == IANA_6TOP_RC_EOL){
-            switch(sixtop_vars.six2six_state){
+            switch(state){
             case SIX_STATE_WAIT_ADDRESPONSE:
                 i = 0;
                 memset(pkt->l2_sixtop_celllist_add,0,sizeof(pkt->l2_sixtop_celllist_add));
@@ -1522,7 +1722,7 @@ void sixtop_six2six_notifyReceive(
                     sixtop_vars.cb_sf_getMetadata(),     // frame id
                     pkt->l2_sixtop_celllist_add,  // celllist to be added
                     &(pkt->l2_nextORpreviousHop), // neighbor that cells to be added to
-                    sixtop_vars.cellOptions       // cell options
+                    transaction->cellOptions       // cell options
                 );
                 neighbors_updateSequenceNumber(&(pkt->l2_nextORpreviousHop));
                 break;
@@ -1543,7 +1743,7 @@ void sixtop_six2six_notifyReceive(
                     sixtop_vars.cb_sf_getMetadata(),
                     pkt->l2_sixtop_celllist_delete,
                     &(pkt->l2_nextORpreviousHop),
-                    sixtop_vars.cellOptions
+                    transaction->cellOptions
                 );
                 neighbors_updateSequenceNumber(&(pkt->l2_nextORpreviousHop));
                 break;
@@ -1562,15 +1762,15 @@ void sixtop_six2six_notifyReceive(
                 }
                 sixtop_removeCells(
                     sixtop_vars.cb_sf_getMetadata(),
-                    sixtop_vars.celllist_toDelete,
+                    transaction->celllist_toDelete,
                     &(pkt->l2_nextORpreviousHop),
-                    sixtop_vars.cellOptions
+                    transaction->cellOptions
                 );
                 sixtop_addCells(
                     sixtop_vars.cb_sf_getMetadata(),     // frame id
                     pkt->l2_sixtop_celllist_add,  // celllist to be added
                     &(pkt->l2_nextORpreviousHop), // neighbor that cells to be added to
-                    sixtop_vars.cellOptions       // cell options
+                    transaction->cellOptions       // cell options
                 );
                 neighbors_updateSequenceNumber(&(pkt->l2_nextORpreviousHop));
                 break;
@@ -1582,7 +1782,7 @@ void sixtop_six2six_notifyReceive(
                     COMPONENT_SIXTOP,
                     ERR_SIXTOP_COUNT,
                     (errorparameter_t)numCells,
-                    (errorparameter_t)sixtop_vars.six2six_state
+                    (errorparameter_t)state
                 );
                 neighbors_updateSequenceNumber(&(pkt->l2_nextORpreviousHop));
                 break;
@@ -1630,11 +1830,11 @@ void sixtop_six2six_notifyReceive(
             COMPONENT_SIXTOP,
             ERR_SIXTOP_RETURNCODE,
             (errorparameter_t)code,
-            (errorparameter_t)sixtop_vars.six2six_state
+            (errorparameter_t)state
         );
-        memset(&sixtop_vars.neighborToClearCells,0,sizeof(open_addr_t));
-        sixtop_vars.six2six_state   = SIX_STATE_IDLE;
-        opentimers_cancel(sixtop_vars.timeoutTimerId);
+        if (transaction != NULL){
+            sixtop_endTransaction(transaction);
+        }
     }
 }
 
@@ -1751,7 +1951,10 @@ bool sixtop_areAvailableCellsToBeScheduled(
         available = FALSE;
     } else {
         do {
-            if(schedule_isSlotOffsetAvailable(cellList[i].slotoffset) == TRUE){
+            if(
+                schedule_isSlotOffsetAvailable(cellList[i].slotoffset) == TRUE &&
+                sixtop_isSlotOffsetRequested(cellList[i].slotoffset)   == FALSE
+            ){
                 numbOfavailableCells++;
             } else {
                 // mark the cell
@@ -1776,6 +1979,31 @@ bool sixtop_areAvailableCellsToBeScheduled(
     return available;
 }
 
+/**
+\brief Tell whether a slot offset is proposed in one of my requests in progress.
+
+The neighbor may still grant it, so it is not given to another neighbor.
+*/
+bool sixtop_isSlotOffsetRequested(uint16_t slotOffset) {
+    uint8_t i;
+    uint8_t j;
+
+    for (i=0;i<SIX2SIX_MAX_TRANSACTIONS;i++) {
+        if (sixtop_vars.transactions[i].state == SIX_STATE_IDLE) {
+            continue;
+        }
+        for (j=0;j<CELLLIST_MAX_LEN;j++) {
+            if (
+                sixtop_vars.transactions[i].celllist_toAdd[j].isUsed &&
+                sixtop_vars.transactions[i].celllist_toAdd[j].slotoffset == slotOffset
+            ){
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
 bool sixtop_areAvailableCellsToBeRemoved(
     uint8_t      frameID,
     uint8_t      numOfCells,
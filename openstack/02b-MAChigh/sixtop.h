@@ -82,6 +82,11 @@ typedef enum {
 // on the receiver side of sixtop, it may has mutiple sixtop request in the queue to response (most of them will return with RC BUSY)
 // increase the timeout longer than calculated value
 #define SIX2SIX_TIMEOUT_MS      65535
+// a single timer ticks at this period (ms) while any transaction is in progress
+#define SIX2SIX_TIMER_PERIOD    1000
+#define SIX2SIX_TIMEOUT_PERIODS (SIX2SIX_TIMEOUT_MS/SIX2SIX_TIMER_PERIOD)
+// max number of neighbors with a transaction in progress at the same time
+#define SIX2SIX_MAX_TRANSACTIONS 4
 typedef uint8_t                 (*sixtop_sf_getsfid_cbt)(void);
 typedef uint16_t                (*sixtop_sf_getmetadata_cbt)(void);
 typedef metadata_t              (*sixtop_sf_translatemetadata_cbt)(void);
@@ -89,6 +94,17 @@ typedef void (*sixtop_sf_handle_callback_cbt)(uint8_t arg, open_addr_t* address)
 
 #define SIXTOP_MINIMAL_EBPERIOD     5 // minist period of sending EB
 
+// a 6P transaction this mote started with a neighbor
+typedef struct {
+   open_addr_t          neighbor;                // the neighbor the request is sent to
+   six2six_state_t      state;                   // SIX_STATE_IDLE when the entry is free
+   uint8_t              seqNum;                  // sequence number of the request
+   uint8_t              cellOptions;
+   cellInfo_ht          celllist_toAdd[CELLLIST_MAX_LEN];    // cells proposed to the neighbor
+   cellInfo_ht          celllist_toDelete[CELLLIST_MAX_LEN];
+   uint16_t             expiry;                  // clock tick at which the transaction times out
+} sixtop_transaction_t;
+
 //=========================== module variables ================================
 
 typedef struct {
@@ -100,19 +116,17 @@ typedef struct {
    uint8_t              ebCounter;               // counter to determine when to send EB
    opentimers_id_t      ebSendingTimerId;        // EB sending timer id
    opentimers_id_t      maintenanceTimerId;
-   opentimers_id_t      timeoutTimerId;          // TimeOut timer id
+   opentimers_id_t      timeoutTimerId;          // times the transactions out
+   uint16_t             clock;                   // ticks of the timeout timer
    uint16_t             kaPeriod;                // period of sending KA
    uint16_t             ebPeriod;                // period of sending EB
-   six2six_state_t      six2six_state;
+   sixtop_transaction_t transactions[SIX2SIX_MAX_TRANSACTIONS];
    uint8_t              commandID;
    bool                 isResponseEnabled;
-   uint8_t                      cellOptions;
-   cellInfo_ht                  celllist_toDelete[CELLLIST_MAX_LEN];
    sixtop_sf_getsfid_cbt            cb_sf_getsfid;
    sixtop_sf_getmetadata_cbt        cb_sf_getMetadata;
    sixtop_sf_translatemetadata_cbt  cb_sf_translateMetadata;
    sixtop_sf_handle_callback_cbt    cb_sf_handleRCError;
-   open_addr_t          neighborToClearCells;
 } sixtop_vars_t;
 
 //=========================== prototypes ======================================
@@ -149,6 +163,8 @@ bool      debugPrint_myDAGrank(void);
 bool      debugPrint_kaPeriod(void);
 // control
 void      sixtop_setIsResponseEnabled(bool isEnabled);
+// from the scheduling function
+bool      sixtop_isSlotOffsetRequested(uint16_t slotOffset);
 
 /**
 \}
@@ -43,6 +43,15 @@ This module implements 6LoWPAN fragmentation according to RFC 4944,
         } \
     } while (0)
 
+#define SET_EXPIRY(entry) \
+    do { \
+        (entry).expiry = frag_vars.clock + FRAG_TIMEOUT_PERIODS; \
+        frag_timer_start(); \
+    } while (0)
+
+#define EXPIRED(entry)      ((int16_t)(frag_vars.clock - (entry).expiry) >= 0)
+
+#define RFRAG_BIT(seq)      (0x80000000UL >> (seq))
 
 #define CHECK_OVERSIZED(size) \
     do { \
@@ -68,27 +77,77 @@ static void cleanup_fragments(uint16_t datagram_tag);
 
 static void store_fragment(OpenQueueEntry_t *msg, uint16_t size, uint16_t tag, uint8_t offset);
 
-static void reassemble_fragments(uint16_t tag, uint16_t size, OpenQueueEntry_t *reassembled_msg);
+static owerror_t reassemble_fragment(OpenQueueEntry_t *msg, uint16_t size, uint16_t tag, uint8_t offset);
+
+static reassembly_t* find_reassembly_buffer(uint16_t tag, uint16_t size);
+
+static reassembly_t* allocate_reassembly_buffer(uint16_t tag, uint16_t size);
+
+static owerror_t write_fragment(reassembly_t *buffer, OpenQueueEntry_t *fragment, uint8_t offset);
+
+static void complete_reassembly(reassembly_t *buffer);
+
+static uint8_t hash_vrb(open_addr_t *prevhop, uint16_t tag);
+
+static vrb_t* find_vrb(open_addr_t *prevhop, uint16_t tag, uint16_t size);
+
+static vrb_t* allocate_vrb(OpenQueueEntry_t *frag1, uint16_t size, uint16_t tag);
+
+static void release_vrb(vrb_t *vrb);
 
-static owerror_t allocate_vrb(OpenQueueEntry_t *frag1, uint16_t size, uint16_t tag);
+static void touch_vrb(vrb_t *vrb);
+
+static void update_vrb(vrb_t *vrb, uint16_t forwarded);
+
+static void append_lru_vrb(uint8_t pos);
+
+static void unlink_lru_vrb(uint8_t pos);
 
 static void prepend_frag1_header(OpenQueueEntry_t *frag1, uint16_t size, uint16_t tag);
 
 static void prepend_fragn_header(OpenQueueEntry_t *fragn, uint16_t size, uint16_t tag, uint8_t offset);
 
-static void fast_forward_frags(uint16_t tag, uint16_t size, uint8_t vrb_pos);
+static void fast_forward_frags(vrb_t *vrb);
+
+#ifdef FRAG_RECOVERY_ENABLED
+static owerror_t send_rfrags(OpenQueueEntry_t *msg);
+
+static owerror_t send_rfrag(rfrag_tx_t *tx, uint8_t seq, bool ack_request);
+
+static rfrag_tx_t* find_rfrag_tx(OpenQueueEntry_t *msg);
+
+static void wait_rfrag_ack(rfrag_tx_t *tx);
+
+static void recover_rfrags(rfrag_tx_t *tx);
+
+static void finish_rfrag_tx(rfrag_tx_t *tx, owerror_t error);
+
+static void receive_rfrag(OpenQueueEntry_t *msg);
+
+static void receive_rfrag_ack(OpenQueueEntry_t *msg);
 
-void frag_timeout_cb(opentimers_id_t id);
+static rfrag_rx_t* find_rfrag_rx(open_addr_t *prevhop, uint8_t tag);
 
-owerror_t frag_timerq_enqueue(opentimers_id_t id);
+static rfrag_rx_t* allocate_rfrag_rx(open_addr_t *prevhop, uint8_t tag, uint16_t size);
 
-owerror_t frag_timerq_remove(opentimers_id_t id);
+static void send_rfrag_ack(rfrag_rx_t *rx);
 
-opentimers_id_t frag_timerq_dequeue(void);
+static void prepend_rfrag_header(OpenQueueEntry_t *rfrag, uint8_t tag, uint8_t seq, bool ack_request, uint16_t offset);
+
+static void prepend_rfrag_ack_header(OpenQueueEntry_t *ack, uint8_t tag, uint32_t bitmap);
+#endif
+
+void frag_timer_start(void);
+
+void frag_timer_cb(opentimers_id_t id);
 //============================= public ========================================
 
 void frag_init() {
     memset(&frag_vars, 0, sizeof(frag_vars_t));
+    memset(frag_vars.vrb_buckets, VRB_NONE, sizeof(frag_vars.vrb_buckets));
+    frag_vars.vrb_lru_head = VRB_NONE;
+    frag_vars.vrb_lru_tail = VRB_NONE;
+    frag_vars.timerId = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_FRAG);
 
     // unspecified start value, wraps around at 65535     
     frag_vars.global_tag = openrandom_get16b() & 0x7FF;
@@ -105,6 +164,13 @@ owerror_t frag_fragment6LoPacket(OpenQueueEntry_t *msg) {
     // check if fragmentation is necessary
     if (!msg->l3_isFragment && msg->length > (MAX_FRAGMENT_SIZE + FRAGN_HEADER_SIZE)) {
 
+#ifdef FRAG_RECOVERY_ENABLED
+        // only a unicast next hop acknowledges fragments, broadcast ones go the usual way
+        if (packetfunctions_isBroadcastMulticast(&msg->l2_nextORpreviousHop) == FALSE) {
+            return send_rfrags(msg);
+        }
+#endif
+
         openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_FRAGMENTING,
                              (errorparameter_t) msg->length,
                              (errorparameter_t)(msg->length / MAX_FRAGMENT_SIZE) + 1);
@@ -200,6 +266,9 @@ owerror_t frag_fragment6LoPacket(OpenQueueEntry_t *msg) {
         }
 
         // if we arrive here, all fragments were successfully created and passed to the MAC layer
+        // the datagram is created by FRAG until its last fragment is sent, so that its creator flushing its
+        // packets does not free it under the fragments, which carry the original creator
+        msg->creator = COMPONENT_FRAG;
         return E_SUCCESS;
 
     } else if (msg->l3_isFragment) {
@@ -207,10 +276,19 @@ owerror_t frag_fragment6LoPacket(OpenQueueEntry_t *msg) {
         // set nexthop in vrb and restore original frag1 header
 
         for (i = 0; i < NUM_OF_VRBS; i++) {
-            if (frag_vars.vrbs[i].frag1 == msg) {
+            if (frag_vars.vrbs[i].size != 0 && frag_vars.vrbs[i].frag1 == msg) {
+                frag_vars.vrbs[i].frag1 = NULL;
                 memcpy(&frag_vars.vrbs[i].nexthop, &msg->l2_nextORpreviousHop, sizeof(open_addr_t));
+#ifdef FRAG_RECOVERY_ENABLED
+                if (frag_vars.vrbs[i].recoverable) {
+                    // the next fragments follow as they come, there are none stored
+                    prepend_rfrag_header(msg, (uint8_t) frag_vars.vrbs[i].tag, 0, frag_vars.vrbs[i].ack_request,
+                                         frag_vars.vrbs[i].size);
+                    break;
+                }
+#endif
                 prepend_frag1_header(msg, frag_vars.vrbs[i].size, frag_vars.vrbs[i].tag);
-                fast_forward_frags(frag_vars.vrbs[i].tag, frag_vars.vrbs[i].size, i);
+                fast_forward_frags(&frag_vars.vrbs[i]);
                 break;
             }
         }
@@ -230,6 +308,9 @@ void frag_sendDone(OpenQueueEntry_t *msg, owerror_t sendError) {
     bool upward_relay;
     uint16_t datagram_tag;
     OpenQueueEntry_t *original_msg;
+#ifdef FRAG_RECOVERY_ENABLED
+    rfrag_tx_t *tx;
+#endif
 
     if (msg->l3_isFragment && !msg->l3_useSourceRouting) {
 
@@ -251,6 +332,20 @@ void frag_sendDone(OpenQueueEntry_t *msg, owerror_t sendError) {
             upward_relay = TRUE;
         }
 
+#ifdef FRAG_RECOVERY_ENABLED
+        tx = (upward_relay == FALSE) ? find_rfrag_tx(original_msg) : NULL;
+        if (tx != NULL) {
+            // fragments lost on the way are sent again, once the last one in flight is done with
+            for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
+                if (frag_vars.fragmentBuf[i].pFragment != NULL && frag_vars.fragmentBuf[i].pOriginalMsg == original_msg) {
+                    return;
+                }
+            }
+            wait_rfrag_ack(tx);
+            return;
+        }
+#endif
+
         if (sendError == E_SUCCESS && upward_relay == FALSE) {
             // check if we have send all other fragments of the original packet
             for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
@@ -261,12 +356,14 @@ void frag_sendDone(OpenQueueEntry_t *msg, owerror_t sendError) {
             }
 
             if (frags_queued == FALSE) {
+                original_msg->creator = msg->creator;
                 iphc_sendDone(original_msg, sendError);
             }
 
         } else if (sendError == E_FAIL && upward_relay == FALSE) {
             // transmission failed, remove the other fragments that are not locked in for transmission
             cleanup_fragments(datagram_tag);
+            original_msg->creator = msg->creator;
             iphc_sendDone(original_msg, sendError);
         } else {
             openqueue_freePacketBuffer(msg);
@@ -284,6 +381,14 @@ void frag_sendDone(OpenQueueEntry_t *msg, owerror_t sendError) {
         }
 
         if (k >= FRAGMENT_BUFFER_SIZE) {
+#ifdef FRAG_RECOVERY_ENABLED
+            // an acknowledgment sent, fragments received from now on may queue another one
+            for (k = 0; k < NUM_OF_RFRAG_DATAGRAMS; k++) {
+                if (frag_vars.rfragRx[k].ack == msg) {
+                    frag_vars.rfragRx[k].ack = NULL;
+                }
+            }
+#endif
             // fragment not found in fragment buffer (it was never stored locally, immediately fast-forwarded)
             openqueue_freePacketBuffer(msg);
         }
@@ -296,7 +401,7 @@ void frag_sendDone(OpenQueueEntry_t *msg, owerror_t sendError) {
 
 
 void frag_receive(OpenQueueEntry_t *msg) {
-    uint32_t i;
+    vrb_t *vrb;
     uint8_t dispatch;
     uint8_t offset;
     uint8_t page_length;
@@ -331,10 +436,10 @@ void frag_receive(OpenQueueEntry_t *msg) {
             iphc_retrieveIPv6Header(msg, &ipv6_outer_header, &ipv6_inner_header, &page_length);
 
             if (idmanager_isMyAddress(&ipv6_inner_header.dest)) {
-                // if LoWPAN packet is for me, store it for reassembly
-                store_fragment(msg, size, tag, offset);
+                // if LoWPAN packet is for me, write it in its reassembly buffer
+                reassemble_fragment(msg, size, tag, offset);
             } else {
-                // fast forwarding / source routing
+                // fast forwarding / source routing, the VRB gets its next hop when the first fragment is sent
                 msg->creator = COMPONENT_FRAG;
                 allocate_vrb(msg, size, tag);
                 return iphc_receive(msg);
@@ -355,41 +460,27 @@ void frag_receive(OpenQueueEntry_t *msg) {
         } else {
             packetfunctions_tossHeader(msg, FRAGN_HEADER_SIZE);
 
-            for (i = 0; i < NUM_OF_VRBS; i++) {
-                if (frag_vars.vrbs[i].tag == tag &&
-                    frag_vars.vrbs[i].size == size &&
-                    frag_vars.vrbs[i].nexthop.type != ADDR_NONE)
-                    break;
-            }
+            vrb = find_vrb(&msg->l2_nextORpreviousHop, tag, size);
 
-            if (i < NUM_OF_VRBS) {
+            if (vrb != NULL && vrb->nexthop.type != ADDR_NONE) {
                 // we have found a corresponding VRB for this subsequent fragment, update the fragment's next hop
                 msg->l3_useSourceRouting = TRUE;
                 msg->creator = COMPONENT_FRAG;
 
-                memcpy(&msg->l2_nextORpreviousHop, &frag_vars.vrbs[i].nexthop, sizeof(open_addr_t));
+                memcpy(&msg->l2_nextORpreviousHop, &vrb->nexthop, sizeof(open_addr_t));
 
                 // update the VRB (how many bytes do we still need to forward)
-                frag_vars.vrbs[i].left -= msg->length;
-
-                if (frag_vars.vrbs[i].left == 0) {
-                    // all bytes forwarded, remove VRB entry
-                    openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_FAST_FORWARD, (errorparameter_t) tag,
-                                         (errorparameter_t) size);
-                    opentimers_cancel(frag_vars.vrbs[i].forward_timer);
-                    opentimers_destroy(frag_vars.vrbs[i].forward_timer);
-                    if (frag_timerq_remove(frag_vars.vrbs[i].forward_timer) == E_FAIL) {
-                        openserial_printCritical(COMPONENT_FRAG, ERR_EMPTY_QUEUE_OR_UNKNOWN_TIMER,
-                                                 (errorparameter_t) 1,
-                                                 (errorparameter_t) 0);
-                    }
-                    memset(&frag_vars.vrbs[i], 0, sizeof(vrb_t));
-
-                }
+                update_vrb(vrb, msg->length);
 
                 // restore fragn header
                 prepend_fragn_header(msg, size, tag, offset);
                 sixtop_send(msg);
+            } else if (vrb != NULL) {
+                // the first fragment could not be forwarded, neither can this one
+                openqueue_freePacketBuffer(msg);
+            } else if (find_reassembly_buffer(tag, size) != NULL) {
+                // the first fragment told me I am the destination
+                reassemble_fragment(msg, size, tag, offset);
             } else {
                 /*
                  * If VRB buffer does not exist, there are two scenarios:
@@ -401,6 +492,14 @@ void frag_receive(OpenQueueEntry_t *msg) {
                 store_fragment(msg, size, tag, offset);
             }
         }
+#ifdef FRAG_RECOVERY_ENABLED
+    } else if (dispatch == DISPATCH_RFRAG) {
+        if (msg->payload[0] & RFRAG_ACK_FLAG) {
+            receive_rfrag_ack(msg);
+        } else {
+            receive_rfrag(msg);
+        }
+#endif
     } else {
         // not a fragment
         iphc_receive(msg);
@@ -419,29 +518,15 @@ static void cleanup_fragments(uint16_t datagram_tag) {
 }
 
 static void store_fragment(OpenQueueEntry_t *msg, uint16_t size, uint16_t tag, uint8_t offset) {
-    uint32_t i, j;
-    uint8_t dropped_srh_len;
+    uint32_t i;
     uint8_t count;
-    uint16_t total_wanted_bytes;
-    uint16_t received_bytes;
-
-    bool do_reassemble;
-    bool has_timer;
-
-    do_reassemble = FALSE;
-    has_timer = FALSE;
 
     // we detect a duplicate fragment (if datagram_tag and offset are the same)
-    // check if we have running reassembly timer
     for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
         if (frag_vars.fragmentBuf[i].datagram_tag == tag && frag_vars.fragmentBuf[i].datagram_offset == offset) {
             openqueue_freePacketBuffer(msg);
             return;
         }
-
-        if (frag_vars.fragmentBuf[i].datagram_tag == tag && frag_vars.fragmentBuf[i].reassembly_timer != 0) {
-            has_timer = TRUE;
-        }
     }
 
     // we find buffer space for a new fragment (new datagram_tag)
@@ -451,28 +536,7 @@ static void store_fragment(OpenQueueEntry_t *msg, uint16_t size, uint16_t tag, u
             frag_vars.fragmentBuf[i].datagram_offset = offset;
             frag_vars.fragmentBuf[i].pFragment = msg;
             frag_vars.fragmentBuf[i].pOriginalMsg = NULL;
-
-            if (!has_timer) {
-                frag_vars.fragmentBuf[i].reassembly_timer = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_FRAG);
-
-                // get a timer for the fragment reassembly and add it to the timer queue
-                if ((frag_vars.fragmentBuf[i].reassembly_timer == ERROR_NO_AVAILABLE_ENTRIES) ||
-                    (frag_timerq_enqueue(frag_vars.fragmentBuf[i].reassembly_timer) == E_FAIL)) {
-
-                    openserial_printError(COMPONENT_FRAG, ERR_NO_FREE_TIMER_OR_QUEUE_ENTRY,
-                                          (errorparameter_t) 0, (errorparameter_t) 0);
-                    RESET_FRAG_BUFFER_ENTRY(i);
-                    return;
-                }
-
-                opentimers_scheduleAbsolute(
-                        frag_vars.fragmentBuf[i].reassembly_timer,
-                        FRAG_REASSEMBLY_TIMEOUT,
-                        opentimers_getValue(),
-                        TIME_MS,
-                        frag_timeout_cb
-                );
-            }
+            SET_EXPIRY(frag_vars.fragmentBuf[i]);
             break;
         }
     }
@@ -480,142 +544,346 @@ static void store_fragment(OpenQueueEntry_t *msg, uint16_t size, uint16_t tag, u
     // if we don't find any buffer space, delete all the related fragments
     if (i == FRAGMENT_BUFFER_SIZE) {
         openserial_printError(COMPONENT_FRAG, ERR_FRAG_BUFFER_OV, (errorparameter_t) 0, (errorparameter_t) 0);
+        openqueue_freePacketBuffer(msg);
         cleanup_fragments(tag);
         return;
     }
 
-    // check if we have all the fragments
-    total_wanted_bytes = size;
-    received_bytes = dropped_srh_len = count = 0;
-
-    for (j = 0; j < FRAGMENT_BUFFER_SIZE; j++) {
-        if (tag == frag_vars.fragmentBuf[j].datagram_tag) {
-            if (frag_vars.fragmentBuf[j].datagram_offset == 0) {
-                dropped_srh_len = MAX_FRAGMENT_SIZE - frag_vars.fragmentBuf[j].pFragment->length;
-                received_bytes += (frag_vars.fragmentBuf[j].pFragment->length + dropped_srh_len);
-            } else {
-                received_bytes += (frag_vars.fragmentBuf[j].pFragment->length);
-            }
-        }
-        if (frag_vars.fragmentBuf[j].pFragment != NULL) {
+    // the fragment waits for the first one, telling where it goes
+    count = 0;
+    for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
+        if (frag_vars.fragmentBuf[i].pFragment != NULL) {
             count++;
         }
     }
+    openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_STORED, (errorparameter_t) offset, (errorparameter_t) count);
+}
 
-    if (total_wanted_bytes == received_bytes) {
-        do_reassemble = TRUE;
-        openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_STORED, (errorparameter_t) offset, (errorparameter_t) count);
-    } else if (total_wanted_bytes < received_bytes) {
-        board_reset();
-    } else {
-        do_reassemble = FALSE;
-        openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_STORED, (errorparameter_t) offset, (errorparameter_t) count);
+static owerror_t reassemble_fragment(OpenQueueEntry_t *msg, uint16_t size, uint16_t tag, uint8_t offset) {
+    uint32_t i;
+    owerror_t error;
+    reassembly_t *buffer;
+
+    buffer = find_reassembly_buffer(tag, size);
+
+    if (buffer == NULL) {
+        buffer = allocate_reassembly_buffer(tag, size);
+        if (buffer == NULL) {
+            openqueue_freePacketBuffer(msg);
+            cleanup_fragments(tag);
+            return E_FAIL;
+        }
+
+        // move in the fragments which arrived before the first one
+        for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
+            if (frag_vars.fragmentBuf[i].pFragment != NULL &&
+                frag_vars.fragmentBuf[i].pOriginalMsg == NULL &&
+                frag_vars.fragmentBuf[i].datagram_tag == tag) {
+                write_fragment(buffer, frag_vars.fragmentBuf[i].pFragment, frag_vars.fragmentBuf[i].datagram_offset);
+                RESET_FRAG_BUFFER_ENTRY(i);
+            }
+        }
     }
 
-    if (do_reassemble) {
-        OpenQueueEntry_t *reassembled_msg;
-        reassembled_msg = openqueue_getFreeBigPacketBuffer(COMPONENT_FRAG);
+    // the fragment is copied to its final place, its queue entry is not needed anymore
+    error = write_fragment(buffer, msg, offset);
+    if (error == E_SUCCESS) {
+        openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_STORED, (errorparameter_t) offset,
+                             (errorparameter_t) buffer->received);
+    }
+    openqueue_freePacketBuffer(msg);
 
-        reassemble_fragments(tag, size - dropped_srh_len, reassembled_msg);
+    if (buffer->received == buffer->size) {
+        complete_reassembly(buffer);
+    }
+    return error;
+}
 
-        if (reassembled_msg == NULL) {
-            return;
-        } else {
-            iphc_receive(reassembled_msg);
+static reassembly_t* find_reassembly_buffer(uint16_t tag, uint16_t size) {
+    uint32_t i;
+    for (i = 0; i < NUM_OF_REASSEMBLY_BUFFERS; i++) {
+        if (frag_vars.reassemblyBuf[i].msg != NULL &&
+            frag_vars.reassemblyBuf[i].tag == tag &&
+            frag_vars.reassemblyBuf[i].size == size) {
+            return &frag_vars.reassemblyBuf[i];
         }
     }
+    return NULL;
 }
 
-static void reassemble_fragments(uint16_t tag, uint16_t size, OpenQueueEntry_t *reassembled_msg) {
+static reassembly_t* allocate_reassembly_buffer(uint16_t tag, uint16_t size) {
     uint32_t i;
-    uint8_t *ptr;
-    uint8_t offset = 0;
+    reassembly_t *buffer;
 
-    if (reassembled_msg == NULL) {
-        openserial_printError(COMPONENT_FRAG, ERR_NO_FREE_PACKET_BUFFER, (errorparameter_t) 1, (errorparameter_t) 0);
-        cleanup_fragments(tag);
-        return;
+    buffer = NULL;
+    for (i = 0; i < NUM_OF_REASSEMBLY_BUFFERS; i++) {
+        if (frag_vars.reassemblyBuf[i].msg == NULL) {
+            buffer = &frag_vars.reassemblyBuf[i];
+            break;
+        }
+    }
+    if (buffer == NULL) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_BUFFER_OV, (errorparameter_t) 1, (errorparameter_t) 0);
+        return NULL;
     }
 
-    reassembled_msg->is_big_packet = TRUE;
-    reassembled_msg->length = size;
-
+    buffer->msg = openqueue_getFreeBigPacketBuffer(COMPONENT_FRAG);
+    if (buffer->msg == NULL) {
+        openserial_printError(COMPONENT_FRAG, ERR_NO_FREE_PACKET_BUFFER, (errorparameter_t) 1, (errorparameter_t) 0);
+        return NULL;
+    }
+    buffer->msg->owner = COMPONENT_FRAG;
+    buffer->tag = tag;
+    buffer->size = size;
+    buffer->received = 0;
+    buffer->start = 0;
+    memset(buffer->bitmap, 0, REASSEMBLY_BITMAP_SIZE);
+
+    // expire with the fragments which arrived before the first one, if any
+    SET_EXPIRY(*buffer);
     for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
-        if (frag_vars.fragmentBuf[i].pFragment != NULL && frag_vars.fragmentBuf[i].datagram_tag == tag) {
-            if (frag_vars.fragmentBuf[i].datagram_offset == 0 &&
-                frag_vars.fragmentBuf[i].pFragment->length < MAX_FRAGMENT_SIZE) {
-                offset = (MAX_FRAGMENT_SIZE - frag_vars.fragmentBuf[i].pFragment->length);
-                ptr = reassembled_msg->packet + offset;
-            } else {
-                ptr = reassembled_msg->packet + (frag_vars.fragmentBuf[i].datagram_offset * OFFSET_MULTIPLE);
-            }
+        if (frag_vars.fragmentBuf[i].pFragment != NULL &&
+            frag_vars.fragmentBuf[i].pOriginalMsg == NULL &&
+            frag_vars.fragmentBuf[i].datagram_tag == tag &&
+            (int16_t)(frag_vars.fragmentBuf[i].expiry - buffer->expiry) < 0) {
+            buffer->expiry = frag_vars.fragmentBuf[i].expiry;
+        }
+    }
 
-            memcpy(ptr, frag_vars.fragmentBuf[i].pFragment->payload, frag_vars.fragmentBuf[i].pFragment->length);
+    return buffer;
+}
 
-            if (frag_vars.fragmentBuf[i].reassembly_timer != 0) {
-                opentimers_cancel(frag_vars.fragmentBuf[i].reassembly_timer);
-                opentimers_destroy(frag_vars.fragmentBuf[i].reassembly_timer);
-                if (frag_timerq_remove(frag_vars.fragmentBuf[i].reassembly_timer) == E_FAIL) {
-                    openserial_printCritical(COMPONENT_FRAG, ERR_EMPTY_QUEUE_OR_UNKNOWN_TIMER,
-                                             (errorparameter_t) 2,
-                                             (errorparameter_t) 0);
-                }
-            }
+static owerror_t write_fragment(reassembly_t *buffer, OpenQueueEntry_t *fragment, uint8_t offset) {
+    uint16_t position;
+    uint16_t block;
+    uint16_t last_block;
+    uint16_t counted;
 
-            RESET_FRAG_BUFFER_ENTRY(i);
+    if (offset == 0) {
+        // the first fragment may have lost its source routing header on the way, align it on the second one
+        if (fragment->length > MAX_FRAGMENT_SIZE) {
+            return E_FAIL;
         }
+        position = MAX_FRAGMENT_SIZE - fragment->length;
+        block = 0;
+        last_block = MAX_FRAGMENT_SIZE / OFFSET_MULTIPLE;
+        counted = MAX_FRAGMENT_SIZE;
+    } else {
+        position = offset * OFFSET_MULTIPLE;
+        block = offset;
+        last_block = offset + ((fragment->length + OFFSET_MULTIPLE - 1) / OFFSET_MULTIPLE);
+        counted = fragment->length;
+    }
+
+    if (position + fragment->length > buffer->size) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_INVALID_SIZE,
+                              (errorparameter_t) (position + fragment->length),
+                              (errorparameter_t) buffer->size);
+        return E_FAIL;
     }
 
-    openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_REASSEMBLED, (errorparameter_t) size, (errorparameter_t) tag);
-    reassembled_msg->payload = reassembled_msg->packet + offset;
+    // drop duplicates, and fragments overlapping the ones already written
+    if (buffer->bitmap[block / 8] & (1 << (block % 8))) {
+        return E_FAIL;
+    }
+    if (buffer->received + counted > buffer->size) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_INVALID_SIZE,
+                              (errorparameter_t) (buffer->received + counted),
+                              (errorparameter_t) buffer->size);
+        return E_FAIL;
+    }
+    for (; block < last_block; block++) {
+        buffer->bitmap[block / 8] |= (1 << (block % 8));
+    }
+
+    memcpy(buffer->msg->packet + position, fragment->payload, fragment->length);
+    // the layers above look for the neighbor the datagram came from
+    memcpy(&buffer->msg->l2_nextORpreviousHop, &fragment->l2_nextORpreviousHop, sizeof(open_addr_t));
+    if (offset == 0) {
+        buffer->start = position;
+    }
+    buffer->received += counted;
+
+    return E_SUCCESS;
 }
 
-static owerror_t allocate_vrb(OpenQueueEntry_t *frag1, uint16_t size, uint16_t tag) {
-    // find an a vrb spot
-    uint32_t i;
-    for (i = 0; i < NUM_OF_VRBS; i++) {
-        if (frag_vars.vrbs[i].tag == 0 && frag_vars.vrbs[i].size == 0) {
-            frag_vars.vrbs[i].tag = tag;
-            frag_vars.vrbs[i].size = size;
-            frag_vars.vrbs[i].left = (size - MAX_FRAGMENT_SIZE);
-            frag_vars.vrbs[i].frag1 = frag1;
+static void complete_reassembly(reassembly_t *buffer) {
+    OpenQueueEntry_t *reassembled_msg;
 
-            frag_vars.vrbs[i].forward_timer = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_FRAG);
+    reassembled_msg = buffer->msg;
+    reassembled_msg->payload = reassembled_msg->packet + buffer->start;
+    reassembled_msg->length = buffer->size - buffer->start;
 
-            // get a timer for the fragment forwarding and add it to the timer queue
-            if ((frag_vars.vrbs[i].forward_timer == ERROR_NO_AVAILABLE_ENTRIES) ||
-                (frag_timerq_enqueue(frag_vars.vrbs[i].forward_timer) == E_FAIL)) {
+    openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_REASSEMBLED, (errorparameter_t) reassembled_msg->length,
+                         (errorparameter_t) buffer->tag);
+    memset(buffer, 0, sizeof(reassembly_t));
 
-                openserial_printError(COMPONENT_FRAG, ERR_NO_FREE_TIMER_OR_QUEUE_ENTRY,
-                                      (errorparameter_t) 0, (errorparameter_t) 0);
-                memset(&frag_vars.vrbs[i], 0, sizeof(vrb_t));
-                return E_FAIL;
-            }
+    iphc_receive(reassembled_msg);
+}
 
-            opentimers_scheduleAbsolute(
-                    frag_vars.vrbs[i].forward_timer,
-                    FRAG_REASSEMBLY_TIMEOUT,
-                    opentimers_getValue(),
-                    TIME_MS,
-                    frag_timeout_cb
-            );
+static uint8_t hash_vrb(open_addr_t *prevhop, uint16_t tag) {
+    uint16_t hash;
+    uint8_t len;
+    uint8_t i;
 
+    switch (prevhop->type) {
+        case ADDR_16B:
+            len = 2;
+            break;
+        case ADDR_64B:
+            len = 8;
+            break;
+        default:
+            len = 0;
             break;
+    }
+
+    hash = tag;
+    for (i = 0; i < len; i++) {
+        hash = (hash * 31) + prevhop->addr_64b[i];
+    }
+    return (uint8_t)(hash % NUM_OF_VRB_BUCKETS);
+}
+
+static vrb_t* find_vrb(open_addr_t *prevhop, uint16_t tag, uint16_t size) {
+    uint8_t pos;
+
+    pos = frag_vars.vrb_buckets[hash_vrb(prevhop, tag)];
+    while (pos != VRB_NONE) {
+        // recoverable fragments carry the datagram size in the first one only, 0 matches any size
+        if (frag_vars.vrbs[pos].tag == tag &&
+            (size == 0 || frag_vars.vrbs[pos].size == size) &&
+            packetfunctions_sameAddress(&frag_vars.vrbs[pos].prevhop, prevhop)) {
+            return &frag_vars.vrbs[pos];
         }
+        pos = frag_vars.vrbs[pos].next;
     }
+    return NULL;
+}
 
-    if (i >= NUM_OF_VRBS)
-        return E_FAIL;
-    else
-        return E_SUCCESS;
+static vrb_t* allocate_vrb(OpenQueueEntry_t *frag1, uint16_t size, uint16_t tag) {
+    uint8_t pos;
+    uint8_t bucket;
+    vrb_t *vrb;
+
+    // the first fragment was received again, it will be forwarded again
+    vrb = find_vrb(&frag1->l2_nextORpreviousHop, tag, size);
+    if (vrb != NULL) {
+        vrb->frag1 = frag1;
+        touch_vrb(vrb);
+        return vrb;
+    }
+
+    // find a free VRB, or make room by evicting the least recently used one
+    for (pos = 0; pos < NUM_OF_VRBS; pos++) {
+        if (frag_vars.vrbs[pos].size == 0) {
+            break;
+        }
+    }
+    if (pos == NUM_OF_VRBS) {
+        pos = frag_vars.vrb_lru_head;
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_BUFFER_OV, (errorparameter_t) 2,
+                              (errorparameter_t) frag_vars.vrbs[pos].tag);
+        release_vrb(&frag_vars.vrbs[pos]);
+    }
+
+    vrb = &frag_vars.vrbs[pos];
+    vrb->tag = tag;
+    vrb->size = size;
+    vrb->left = (size - MAX_FRAGMENT_SIZE);
+    vrb->frag1 = frag1;
+    memcpy(&vrb->prevhop, &frag1->l2_nextORpreviousHop, sizeof(open_addr_t));
+
+    bucket = hash_vrb(&vrb->prevhop, tag);
+    vrb->next = frag_vars.vrb_buckets[bucket];
+    frag_vars.vrb_buckets[bucket] = pos;
+
+    append_lru_vrb(pos);
+    SET_EXPIRY(*vrb);
+
+    return vrb;
+}
+
+static void release_vrb(vrb_t *vrb) {
+    uint8_t pos;
+    uint8_t *link;
+
+    pos = (uint8_t)(vrb - frag_vars.vrbs);
+
+    // unlink it from its hash bucket
+    link = &frag_vars.vrb_buckets[hash_vrb(&vrb->prevhop, vrb->tag)];
+    while (*link != pos) {
+        link = &frag_vars.vrbs[*link].next;
+    }
+    *link = vrb->next;
+
+    unlink_lru_vrb(pos);
+    memset(vrb, 0, sizeof(vrb_t));
 }
 
-static void fast_forward_frags(uint16_t tag, uint16_t size, uint8_t vrb_pos) {
+static void touch_vrb(vrb_t *vrb) {
+    uint8_t pos;
+
+    pos = (uint8_t)(vrb - frag_vars.vrbs);
+    unlink_lru_vrb(pos);
+    append_lru_vrb(pos);
+    SET_EXPIRY(*vrb);
+}
+
+static void update_vrb(vrb_t *vrb, uint16_t forwarded) {
+#ifdef FRAG_RECOVERY_ENABLED
+    if (vrb->recoverable) {
+        // fragments may be sent again, the VRB is kept until the acknowledgment goes back
+        touch_vrb(vrb);
+        return;
+    }
+#endif
+    if (forwarded < vrb->left) {
+        vrb->left -= forwarded;
+        touch_vrb(vrb);
+    } else {
+        // all bytes forwarded, remove VRB entry
+        openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_FAST_FORWARD, (errorparameter_t) vrb->tag,
+                             (errorparameter_t) vrb->size);
+        release_vrb(vrb);
+    }
+}
+
+static void append_lru_vrb(uint8_t pos) {
+    frag_vars.vrbs[pos].lru_prev = frag_vars.vrb_lru_tail;
+    frag_vars.vrbs[pos].lru_next = VRB_NONE;
+    if (frag_vars.vrb_lru_tail == VRB_NONE) {
+        frag_vars.vrb_lru_head = pos;
+    } else {
+        frag_vars.vrbs[frag_vars.vrb_lru_tail].lru_next = pos;
+    }
+    frag_vars.vrb_lru_tail = pos;
+}
+
+static void unlink_lru_vrb(uint8_t pos) {
+    if (frag_vars.vrbs[pos].lru_prev == VRB_NONE) {
+        frag_vars.vrb_lru_head = frag_vars.vrbs[pos].lru_next;
+    } else {
+        frag_vars.vrbs[frag_vars.vrbs[pos].lru_prev].lru_next = frag_vars.vrbs[pos].lru_next;
+    }
+    if (frag_vars.vrbs[pos].lru_next == VRB_NONE) {
+        frag_vars.vrb_lru_tail = frag_vars.vrbs[pos].lru_prev;
+    } else {
+        frag_vars.vrbs[frag_vars.vrbs[pos].lru_next].lru_prev = frag_vars.vrbs[pos].lru_prev;
+    }
+}
+
+static void fast_forward_frags(vrb_t *vrb) {
     uint32_t i;
+    uint16_t forwarded;
+
+    forwarded = 0;
     for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
         // check if we have subsequent fragments stored.
         if (frag_vars.fragmentBuf[i].pFragment != NULL &&
-            frag_vars.fragmentBuf[i].datagram_tag == tag &&
+            frag_vars.fragmentBuf[i].pOriginalMsg == NULL &&
+            ISLOCKED(frag_vars.fragmentBuf[i]) == FALSE &&
+            frag_vars.fragmentBuf[i].datagram_tag == vrb->tag &&
             frag_vars.fragmentBuf[i].datagram_offset != 0) {
 
             frag_vars.fragmentBuf[i].pFragment->creator = COMPONENT_FRAG;
@@ -623,40 +891,15 @@ static void fast_forward_frags(uint16_t tag, uint16_t size, uint8_t vrb_pos) {
 
             // provide the stored fragment with the right next hop address
             memcpy(&frag_vars.fragmentBuf[i].pFragment->l2_nextORpreviousHop,
-                   &frag_vars.vrbs[vrb_pos].nexthop,
+                   &vrb->nexthop,
                    sizeof(open_addr_t)
             );
 
-            // update the VRB
-            frag_vars.vrbs[vrb_pos].left -= frag_vars.fragmentBuf[i].pFragment->length;
-
-            if (frag_vars.vrbs[vrb_pos].left == 0) {
-                // clear VRB entry if all data is forwarded
-                openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_FAST_FORWARD, (errorparameter_t) tag,
-                                     (errorparameter_t) size);
-                opentimers_cancel(frag_vars.vrbs[vrb_pos].forward_timer);
-                opentimers_destroy(frag_vars.vrbs[vrb_pos].forward_timer);
-                if (frag_timerq_remove(frag_vars.vrbs[vrb_pos].forward_timer) == E_FAIL) {
-                    openserial_printCritical(COMPONENT_FRAG, ERR_EMPTY_QUEUE_OR_UNKNOWN_TIMER,
-                                             (errorparameter_t) 3,
-                                             (errorparameter_t) 0);
-                }
-                memset(&frag_vars.vrbs[vrb_pos], 0, sizeof(vrb_t));
-            }
-
-            if (frag_vars.fragmentBuf[i].reassembly_timer != 0) {
-                opentimers_cancel(frag_vars.fragmentBuf[i].reassembly_timer);
-                opentimers_destroy(frag_vars.fragmentBuf[i].reassembly_timer);
-                if (frag_timerq_remove(frag_vars.fragmentBuf[i].reassembly_timer) == E_FAIL) {
-                    openserial_printCritical(COMPONENT_FRAG, ERR_EMPTY_QUEUE_OR_UNKNOWN_TIMER,
-                                             (errorparameter_t) 4,
-                                             (errorparameter_t) 0);
-                }
-            }
+            forwarded += frag_vars.fragmentBuf[i].pFragment->length;
 
             prepend_fragn_header(
                     frag_vars.fragmentBuf[i].pFragment,
-                    size,
+                    vrb->size,
                     frag_vars.fragmentBuf[i].datagram_tag,
                     frag_vars.fragmentBuf[i].datagram_offset);
 
@@ -668,6 +911,11 @@ static void fast_forward_frags(uint16_t tag, uint16_t size, uint8_t vrb_pos) {
             };
         }
     }
+
+    // update the VRB, this clears it if all data is forwarded
+    if (forwarded > 0) {
+        update_vrb(vrb, forwarded);
+    }
 }
 
 static void prepend_frag1_header(OpenQueueEntry_t *frag1, uint16_t size, uint16_t tag) {
@@ -689,76 +937,563 @@ static void prepend_fragn_header(OpenQueueEntry_t *fragn, uint16_t size, uint16_
     ((fragn_t *) fragn->payload)->datagram_offset = offset;
 }
 
-owerror_t frag_timerq_enqueue(opentimers_id_t id) {
+#ifdef FRAG_RECOVERY_ENABLED
+
+static owerror_t send_rfrags(OpenQueueEntry_t *msg) {
     uint32_t i;
-    for (i = 0; i < NUM_OF_CONCURRENT_TIMERS; i++) {
-        if (frag_vars.frag_timerq[i] == 0) {
-            frag_vars.frag_timerq[i] = id;
-            return E_SUCCESS;
+    uint8_t seq;
+    rfrag_tx_t *tx;
+
+    tx = NULL;
+    for (i = 0; i < NUM_OF_RFRAG_DATAGRAMS; i++) {
+        if (frag_vars.rfragTx[i].msg == NULL) {
+            tx = &frag_vars.rfragTx[i];
+            break;
         }
     }
+    if (tx == NULL) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_BUFFER_OV, (errorparameter_t) 3, (errorparameter_t) 0);
+        return E_FAIL;
+    }
 
-    return E_FAIL;
+    // RFRAG tags are one byte long, skip the ones of the datagrams still in flight
+    do {
+        frag_vars.global_tag++;
+        for (i = 0; i < NUM_OF_RFRAG_DATAGRAMS; i++) {
+            if (frag_vars.rfragTx[i].msg != NULL && frag_vars.rfragTx[i].tag == (uint8_t) frag_vars.global_tag) {
+                break;
+            }
+        }
+    } while (i < NUM_OF_RFRAG_DATAGRAMS);
+
+    memset(tx, 0, sizeof(rfrag_tx_t));
+    tx->tag = (uint8_t) frag_vars.global_tag;
+    tx->num_fragments = (msg->length + MAX_FRAGMENT_SIZE - 1) / MAX_FRAGMENT_SIZE;
+    tx->msg = msg;
+    tx->creator = msg->creator;
+    msg->creator = COMPONENT_FRAG;
+
+    openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_FRAGMENTING,
+                         (errorparameter_t) msg->length,
+                         (errorparameter_t) tx->num_fragments);
+
+    // the last fragment requests an acknowledgment
+    for (seq = 0; seq < tx->num_fragments; seq++) {
+        if (send_rfrag(tx, seq, seq == tx->num_fragments - 1) == E_FAIL) {
+            if (seq == 0) {
+                msg->creator = tx->creator;
+                memset(tx, 0, sizeof(rfrag_tx_t));
+                return E_FAIL;
+            }
+            // the fragments not sent are recovered like lost ones
+            break;
+        }
+    }
+
+    return E_SUCCESS;
 }
 
-opentimers_id_t frag_timerq_dequeue(void) {
-    opentimers_id_t expired;
-    expired = frag_vars.frag_timerq[0];
+static owerror_t send_rfrag(rfrag_tx_t *tx, uint8_t seq, bool ack_request) {
+    uint32_t i;
+    uint16_t offset;
+    uint8_t length;
+    OpenQueueEntry_t *lowpan_fragment;
 
-    memcpy((uint8_t *) frag_vars.frag_timerq, (uint8_t * ) & (frag_vars.frag_timerq[1]), NUM_OF_CONCURRENT_TIMERS - 1);
-    frag_vars.frag_timerq[NUM_OF_CONCURRENT_TIMERS - 1] = 0;
+    offset = seq * MAX_FRAGMENT_SIZE;
+    if (tx->msg->length - offset > MAX_FRAGMENT_SIZE) {
+        length = MAX_FRAGMENT_SIZE;
+    } else {
+        length = tx->msg->length - offset;
+    }
 
-    return expired;
+    // find a new spot in the fragmentation buffer
+    for (i = 0; i < FRAGMENT_BUFFER_SIZE; i++) {
+        if (frag_vars.fragmentBuf[i].pFragment == NULL) {
+            break;
+        }
+    }
+    if (i == FRAGMENT_BUFFER_SIZE) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_BUFFER_OV, (errorparameter_t) 0, (errorparameter_t) 0);
+        return E_FAIL;
+    }
+
+    lowpan_fragment = openqueue_getFreePacketBuffer(COMPONENT_FRAG);
+    if (lowpan_fragment == NULL) {
+        openserial_printError(COMPONENT_FRAG, ERR_NO_FREE_PACKET_BUFFER,
+                              (errorparameter_t) 2,
+                              (errorparameter_t) 0);
+        return E_FAIL;
+    }
+
+    lowpan_fragment->l3_isFragment = TRUE;
+    lowpan_fragment->owner = COMPONENT_FRAG;
+    lowpan_fragment->creator = COMPONENT_FRAG;
+
+    // copy the fragment from the original packet, which is kept until acknowledged
+    packetfunctions_reserveHeaderSize(lowpan_fragment, length);
+    memcpy(lowpan_fragment->payload, tx->msg->payload + offset, length);
+
+    // copy address information
+    lowpan_fragment->l3_destinationAdd = tx->msg->l3_destinationAdd;
+    lowpan_fragment->l3_sourceAdd = tx->msg->l3_sourceAdd;
+    lowpan_fragment->l2_nextORpreviousHop = tx->msg->l2_nextORpreviousHop;
+
+    // the first fragment carries the datagram size in place of its offset
+    prepend_rfrag_header(lowpan_fragment, tx->tag, seq, ack_request, (seq == 0) ? tx->msg->length : offset);
+
+    frag_vars.fragmentBuf[i].datagram_tag = tx->tag;
+    frag_vars.fragmentBuf[i].datagram_offset = offset / OFFSET_MULTIPLE;
+    frag_vars.fragmentBuf[i].pFragment = lowpan_fragment;
+    frag_vars.fragmentBuf[i].pOriginalMsg = tx->msg;
+
+    LOCK(frag_vars.fragmentBuf[i]);
+    if (sixtop_send(lowpan_fragment) == E_FAIL) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_TX_FAIL,
+                              (errorparameter_t) tx->tag,
+                              (errorparameter_t) frag_vars.fragmentBuf[i].datagram_offset);
+        UNLOCK(frag_vars.fragmentBuf[i]);
+        RESET_FRAG_BUFFER_ENTRY(i);
+        return E_FAIL;
+    }
+
+    return E_SUCCESS;
 }
 
-owerror_t frag_timerq_remove(opentimers_id_t id) {
+static rfrag_tx_t* find_rfrag_tx(OpenQueueEntry_t *msg) {
     uint32_t i;
-    for (i = 0; i < NUM_OF_CONCURRENT_TIMERS - 1; i++) {
-        if (frag_vars.frag_timerq[i] == id) {
-            memcpy(&frag_vars.frag_timerq[i], &frag_vars.frag_timerq[i + 1], NUM_OF_CONCURRENT_TIMERS - 1 - i);
-            frag_vars.frag_timerq[NUM_OF_CONCURRENT_TIMERS - 1] = 0;
-            return E_SUCCESS;
+    for (i = 0; i < NUM_OF_RFRAG_DATAGRAMS; i++) {
+        if (frag_vars.rfragTx[i].msg == msg) {
+            return &frag_vars.rfragTx[i];
         }
     }
+    return NULL;
+}
 
-    if (frag_vars.frag_timerq[NUM_OF_CONCURRENT_TIMERS - 1] == id) {
-        frag_vars.frag_timerq[NUM_OF_CONCURRENT_TIMERS - 1] = 0;
-        return E_SUCCESS;
+static void wait_rfrag_ack(rfrag_tx_t *tx) {
+    uint32_t all;
+
+    all = ~(RFRAG_FULL_BITMAP >> tx->num_fragments);
+
+    // an acknowledgment may have come back before the last fragment was sent
+    if (tx->acked != RFRAG_NULL_BITMAP && (tx->acked & all) == all) {
+        finish_rfrag_tx(tx, E_SUCCESS);
+        return;
+    }
+
+    tx->waiting_ack = TRUE;
+    tx->expiry = frag_vars.clock + RFRAG_ACK_TIMEOUT_PERIODS;
+    frag_timer_start();
+}
+
+static void recover_rfrags(rfrag_tx_t *tx) {
+    uint32_t all;
+    uint8_t seq;
+    uint8_t last;
+    uint8_t count;
+
+    all = ~(RFRAG_FULL_BITMAP >> tx->num_fragments);
+
+    if (tx->acked == RFRAG_NULL_BITMAP) {
+        // the receiver aborted the datagram
+        finish_rfrag_tx(tx, E_FAIL);
+        return;
+    }
+    if ((tx->acked & all) == all) {
+        finish_rfrag_tx(tx, E_SUCCESS);
+        return;
+    }
+    if (tx->retries == RFRAG_MAX_RETRIES) {
+        finish_rfrag_tx(tx, E_FAIL);
+        return;
+    }
+    tx->retries++;
+    tx->waiting_ack = FALSE;
+
+    // send the missing fragments again, the last one requests an acknowledgment
+    count = 0;
+    last = 0;
+    for (seq = 0; seq < tx->num_fragments; seq++) {
+        if ((tx->acked & RFRAG_BIT(seq)) == 0) {
+            count++;
+            last = seq;
+        }
+    }
+    openserial_printInfo(COMPONENT_FRAG, ERR_FRAG_RECOVERED, (errorparameter_t) tx->tag, (errorparameter_t) count);
+
+    count = 0;
+    for (seq = 0; seq <= last; seq++) {
+        if ((tx->acked & RFRAG_BIT(seq)) == 0) {
+            if (send_rfrag(tx, seq, seq == last) == E_FAIL) {
+                break;
+            }
+            count++;
+        }
     }
 
-    return E_FAIL;
+    // nothing in flight, request the acknowledgment again later
+    if (count == 0) {
+        wait_rfrag_ack(tx);
+    }
 }
 
-void frag_timeout_cb(opentimers_id_t id) {
+static void finish_rfrag_tx(rfrag_tx_t *tx, owerror_t error) {
+    OpenQueueEntry_t *msg;
+
+    if (error == E_FAIL) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_TX_FAIL, (errorparameter_t) tx->tag,
+                              (errorparameter_t) tx->acked);
+    }
+
+    msg = tx->msg;
+    msg->creator = tx->creator;
+    memset(tx, 0, sizeof(rfrag_tx_t));
+    iphc_sendDone(msg, error);
+}
+
+static void receive_rfrag(OpenQueueEntry_t *msg) {
+    ipv6_header_iht ipv6_outer_header;
+    ipv6_header_iht ipv6_inner_header;
+    uint8_t page_length;
+    uint16_t field;
+    uint16_t offset;
+    uint16_t length;
+    uint8_t tag;
+    uint8_t seq;
+    bool ack_request;
+    vrb_t *vrb;
+    rfrag_rx_t *rx;
+
+    memset(&ipv6_outer_header, 0, sizeof(ipv6_header_iht));
+    memset(&ipv6_inner_header, 0, sizeof(ipv6_header_iht));
+
+    tag = msg->payload[1];
+    field = packetfunctions_ntohs(msg->payload + 2);
+    offset = packetfunctions_ntohs(msg->payload + 4);
+    seq = (uint8_t)((field >> RFRAG_SEQUENCE_SHIFT) & RFRAG_SEQUENCE_MASK);
+    ack_request = (field & RFRAG_ACK_REQUEST) != 0;
+
+    msg->l3_isFragment = TRUE;
+
+    // the first fragment carries the datagram size in place of its offset
+    if (seq == 0) {
+        CHECK_OVERSIZED(offset);
+    }
+
+    // a fragment of a datagram this mote forwards, possibly sent again, follows the first one as is
+    vrb = find_vrb(&msg->l2_nextORpreviousHop, tag, 0);
+    if (vrb != NULL && vrb->recoverable) {
+        if (vrb->nexthop.type == ADDR_NONE) {
+            // the first fragment could not be forwarded, neither can this one
+            openqueue_freePacketBuffer(msg);
+            return;
+        }
+        msg->creator = COMPONENT_FRAG;
+        msg->l3_useSourceRouting = TRUE;
+        memcpy(&msg->l2_nextORpreviousHop, &vrb->nexthop, sizeof(open_addr_t));
+        update_vrb(vrb, msg->length - RFRAG_HEADER_SIZE);
+        if (sixtop_send(msg) == E_FAIL) {
+            openqueue_freePacketBuffer(msg);
+        }
+        return;
+    }
+
+    rx = find_rfrag_rx(&msg->l2_nextORpreviousHop, tag);
+    packetfunctions_tossHeader(msg, RFRAG_HEADER_SIZE);
+
+    if (rx == NULL) {
+        if (seq != 0) {
+            // only the first fragment tells where the datagram goes, this one gets recovered
+            openqueue_freePacketBuffer(msg);
+            return;
+        }
+
+        if (idmanager_getIsDAGroot() == FALSE) {
+            iphc_retrieveIPv6Header(msg, &ipv6_outer_header, &ipv6_inner_header, &page_length);
+            if (idmanager_isMyAddress(&ipv6_inner_header.dest) == FALSE) {
+                // fast forwarding, the VRB gets its next hop when the first fragment is sent
+                msg->creator = COMPONENT_FRAG;
+                vrb = allocate_vrb(msg, offset, tag);
+                vrb->recoverable = TRUE;
+                vrb->ack_request = ack_request;
+                iphc_receive(msg);
+                return;
+            }
+        }
+
+        rx = allocate_rfrag_rx(&msg->l2_nextORpreviousHop, tag, offset);
+    }
+
+    if (rx->complete || (rx->acked & RFRAG_BIT(seq)) != 0) {
+        // received already
+        openqueue_freePacketBuffer(msg);
+    } else {
+        // reassemble_fragment() frees the fragment when it fails, remember its length
+        length = (seq == 0) ? MAX_FRAGMENT_SIZE : msg->length;
+        rx->acked |= RFRAG_BIT(seq);
+        rx->received += length;
+
+        if (idmanager_getIsDAGroot() == TRUE) {
+            // OpenVisualizer reassembles the datagram, hand it regular 6LoWPAN fragments
+            if (seq == 0) {
+                prepend_frag1_header(msg, rx->size, tag);
+            } else {
+                prepend_fragn_header(msg, rx->size, tag, (uint8_t)(offset / OFFSET_MULTIPLE));
+            }
+            openbridge_receive(msg);
+        } else if (reassemble_fragment(msg, rx->size, tag, (seq == 0) ? 0 : (uint8_t)(offset / OFFSET_MULTIPLE)) ==
+                   E_FAIL) {
+            rx->acked &= ~RFRAG_BIT(seq);
+            rx->received -= length;
+        }
+        rx->complete = (rx->received >= rx->size);
+    }
+    SET_EXPIRY(*rx);
+
+    if (ack_request || rx->complete) {
+        send_rfrag_ack(rx);
+    }
+}
+
+static void receive_rfrag_ack(OpenQueueEntry_t *msg) {
+    uint32_t i;
+    uint32_t bitmap;
+    uint8_t tag;
+    vrb_t *vrb;
+
+    tag = msg->payload[1];
+    bitmap = packetfunctions_ntohl(msg->payload + 2);
+
+    // an acknowledgment on its way back to the sender goes to the previous hop of the datagram
+    for (i = 0; i < NUM_OF_VRBS; i++) {
+        vrb = &frag_vars.vrbs[i];
+        if (vrb->size != 0 && vrb->recoverable && vrb->tag == tag &&
+            packetfunctions_sameAddress(&vrb->nexthop, &msg->l2_nextORpreviousHop)) {
+
+            msg->creator = COMPONENT_FRAG;
+            msg->l3_isFragment = TRUE;
+            msg->l3_useSourceRouting = TRUE;
+            memcpy(&msg->l2_nextORpreviousHop, &vrb->prevhop, sizeof(open_addr_t));
+
+            if (bitmap == RFRAG_FULL_BITMAP || bitmap == RFRAG_NULL_BITMAP) {
+                // the datagram is done with
+                release_vrb(vrb);
+            } else {
+                touch_vrb(vrb);
+            }
+
+            if (sixtop_send(msg) == E_FAIL) {
+                openqueue_freePacketBuffer(msg);
+            }
+            return;
+        }
+    }
+    openqueue_freePacketBuffer(msg);
+
+    // an acknowledgment for a datagram this mote sent
+    for (i = 0; i < NUM_OF_RFRAG_DATAGRAMS; i++) {
+        if (frag_vars.rfragTx[i].msg != NULL && frag_vars.rfragTx[i].tag == tag) {
+            frag_vars.rfragTx[i].acked = bitmap;
+            // if fragments are still in flight, the last one requested another acknowledgment
+            if (frag_vars.rfragTx[i].waiting_ack) {
+                recover_rfrags(&frag_vars.rfragTx[i]);
+            }
+            break;
+        }
+    }
+}
+
+static rfrag_rx_t* find_rfrag_rx(open_addr_t *prevhop, uint8_t tag) {
+    uint32_t i;
+    for (i = 0; i < NUM_OF_RFRAG_DATAGRAMS; i++) {
+        if (frag_vars.rfragRx[i].size != 0 &&
+            frag_vars.rfragRx[i].tag == tag &&
+            packetfunctions_sameAddress(&frag_vars.rfragRx[i].prevhop, prevhop)) {
+            return &frag_vars.rfragRx[i];
+        }
+    }
+    return NULL;
+}
+
+static rfrag_rx_t* allocate_rfrag_rx(open_addr_t *prevhop, uint8_t tag, uint16_t size) {
+    uint32_t i;
+    rfrag_rx_t *rx;
+
+    // find a free entry, or make room by evicting the one expiring first
+    rx = NULL;
+    for (i = 0; i < NUM_OF_RFRAG_DATAGRAMS; i++) {
+        if (frag_vars.rfragRx[i].size == 0) {
+            rx = &frag_vars.rfragRx[i];
+            break;
+        }
+        if (rx == NULL || (int16_t)(frag_vars.rfragRx[i].expiry - rx->expiry) < 0) {
+            rx = &frag_vars.rfragRx[i];
+        }
+    }
+    // a complete datagram is only kept to acknowledge its fragments sent again
+    if (rx->size != 0 && rx->complete == FALSE) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_BUFFER_OV, (errorparameter_t) 4, (errorparameter_t) rx->tag);
+    }
+
+    memset(rx, 0, sizeof(rfrag_rx_t));
+    memcpy(&rx->prevhop, prevhop, sizeof(open_addr_t));
+    rx->tag = tag;
+    rx->size = size;
+
+    return rx;
+}
+
+static void send_rfrag_ack(rfrag_rx_t *rx) {
+    OpenQueueEntry_t *ack;
+
+    if (rx->ack != NULL) {
+        // the previous hop gets the one already queued
+        return;
+    }
+
+    ack = openqueue_getFreePacketBuffer(COMPONENT_FRAG);
+    if (ack == NULL) {
+        openserial_printError(COMPONENT_FRAG, ERR_NO_FREE_PACKET_BUFFER,
+                              (errorparameter_t) 3,
+                              (errorparameter_t) 0);
+        return;
+    }
+
+    // sent back hop by hop, and freed in frag_sendDone
+    ack->creator = COMPONENT_FRAG;
+    ack->owner = COMPONENT_FRAG;
+    ack->l3_isFragment = TRUE;
+    ack->l3_useSourceRouting = TRUE;
+    memcpy(&ack->l2_nextORpreviousHop, &rx->prevhop, sizeof(open_addr_t));
+
+    prepend_rfrag_ack_header(ack, rx->tag, rx->complete ? RFRAG_FULL_BITMAP : rx->acked);
+
+    if (sixtop_send(ack) == E_FAIL) {
+        openqueue_freePacketBuffer(ack);
+    } else {
+        rx->ack = ack;
+    }
+}
+
+static void prepend_rfrag_header(OpenQueueEntry_t *rfrag, uint8_t tag, uint8_t seq, bool ack_request,
+                                 uint16_t offset) {
+    uint16_t field; // temporary X flag | sequence | fragment size field
+    field = ((seq & RFRAG_SEQUENCE_MASK) << RFRAG_SEQUENCE_SHIFT);
+    field |= (rfrag->length & RFRAG_SIZE_MASK);
+    if (ack_request) {
+        field |= RFRAG_ACK_REQUEST;
+    }
+    packetfunctions_reserveHeaderSize(rfrag, RFRAG_HEADER_SIZE);
+    rfrag->payload[0] = (DISPATCH_RFRAG & DISPATCH_MASK) << (DISPATCH_SHIFT - 8);
+    rfrag->payload[1] = tag;
+    packetfunctions_htons(field, rfrag->payload + 2);
+    packetfunctions_htons(offset, rfrag->payload + 4);
+}
+
+static void prepend_rfrag_ack_header(OpenQueueEntry_t *ack, uint8_t tag, uint32_t bitmap) {
+    packetfunctions_reserveHeaderSize(ack, RFRAG_ACK_HEADER_SIZE);
+    ack->payload[0] = ((DISPATCH_RFRAG & DISPATCH_MASK) << (DISPATCH_SHIFT - 8)) | RFRAG_ACK_FLAG;
+    ack->payload[1] = tag;
+    packetfunctions_htonl(bitmap, ack->payload + 2);
+}
+
+#endif
+
+void frag_timer_start(void) {
+    if (opentimers_isRunning(frag_vars.timerId) == FALSE) {
+        opentimers_scheduleIn(
+                frag_vars.timerId,
+                FRAG_TIMER_PERIOD,
+                TIME_MS,
+                TIMER_PERIODIC,
+                frag_timer_cb
+        );
+    }
+}
+
+void frag_timer_cb(opentimers_id_t id) {
     uint32_t j;
-    opentimers_id_t expired_timer;
+    bool pending;
+#ifdef FRAG_RECOVERY_ENABLED
+    uint8_t seq;
+    rfrag_tx_t *tx;
+#endif
+
+    frag_vars.clock++;
+
+    // the least recently used VRBs are the first to expire
+    while (frag_vars.vrb_lru_head != VRB_NONE && EXPIRED(frag_vars.vrbs[frag_vars.vrb_lru_head])) {
+        openserial_printError(COMPONENT_FRAG, ERR_FRAG_REASSEMBLY_OR_VRB_TIMEOUT,
+                              (errorparameter_t) frag_vars.vrbs[frag_vars.vrb_lru_head].tag,
+                              (errorparameter_t) 0);
+        release_vrb(&frag_vars.vrbs[frag_vars.vrb_lru_head]);
+    }
+    pending = (frag_vars.vrb_lru_head != VRB_NONE);
 
-    if ((expired_timer = frag_timerq_dequeue()) == 0) {
-        // timer id can never be 0, if we get zero we have "dequeued" and empty queue!
-        openserial_printCritical(COMPONENT_FRAG, ERR_EMPTY_QUEUE_OR_UNKNOWN_TIMER,
-                                 (errorparameter_t) 0,
-                                 (errorparameter_t) 0);
+    for (j = 0; j < NUM_OF_REASSEMBLY_BUFFERS; j++) {
+        if (frag_vars.reassemblyBuf[j].msg == NULL) {
+            continue;
+        }
+        if (EXPIRED(frag_vars.reassemblyBuf[j])) {
+            openserial_printError(COMPONENT_FRAG, ERR_FRAG_REASSEMBLY_OR_VRB_TIMEOUT,
+                                  (errorparameter_t) frag_vars.reassemblyBuf[j].tag,
+                                  (errorparameter_t) 1);
+            openqueue_freePacketBuffer(frag_vars.reassemblyBuf[j].msg);
+            memset(&frag_vars.reassemblyBuf[j], 0, sizeof(reassembly_t));
+        } else {
+            pending = TRUE;
+        }
     }
 
-    // find the tag of the expired fragments
+    // fragments waiting for their first one
     for (j = 0; j < FRAGMENT_BUFFER_SIZE; j++) {
-        if (frag_vars.fragmentBuf[j].pFragment != NULL && frag_vars.fragmentBuf[j].reassembly_timer == expired_timer) {
+        if (frag_vars.fragmentBuf[j].pFragment == NULL ||
+            frag_vars.fragmentBuf[j].pOriginalMsg != NULL ||
+            ISLOCKED(frag_vars.fragmentBuf[j])) {
+            continue;
+        }
+        if (EXPIRED(frag_vars.fragmentBuf[j])) {
             openserial_printError(COMPONENT_FRAG, ERR_FRAG_REASSEMBLY_OR_VRB_TIMEOUT,
                                   (errorparameter_t) frag_vars.fragmentBuf[j].datagram_tag,
                                   (errorparameter_t) 0);
-            opentimers_destroy(frag_vars.fragmentBuf[j].reassembly_timer);
             cleanup_fragments(frag_vars.fragmentBuf[j].datagram_tag);
-            break;
+        } else {
+            pending = TRUE;
         }
     }
 
-    for (j = 0; j < NUM_OF_VRBS; j++) {
-        if (frag_vars.vrbs[j].tag != 0 && frag_vars.vrbs[j].forward_timer == expired_timer) {
-            openserial_printError(COMPONENT_FRAG, ERR_FRAG_REASSEMBLY_OR_VRB_TIMEOUT,
-                                  (errorparameter_t) frag_vars.vrbs[j].tag,
-                                  (errorparameter_t) 0);
-            opentimers_destroy(frag_vars.vrbs[j].forward_timer);
-            memset(&frag_vars.vrbs[j], 0, sizeof(vrb_t));
+#ifdef FRAG_RECOVERY_ENABLED
+    for (j = 0; j < NUM_OF_RFRAG_DATAGRAMS; j++) {
+        tx = &frag_vars.rfragTx[j];
+        if (tx->msg != NULL && tx->waiting_ack && EXPIRED(*tx)) {
+            if (tx->retries == RFRAG_MAX_RETRIES) {
+                finish_rfrag_tx(tx, E_FAIL);
+            } else {
+                // request the acknowledgment again, with the first fragment not acknowledged yet
+                tx->retries++;
+                tx->waiting_ack = FALSE;
+                for (seq = 0; seq < tx->num_fragments - 1 && (tx->acked & RFRAG_BIT(seq)) != 0; seq++);
+                if (send_rfrag(tx, seq, TRUE) == E_FAIL) {
+                    wait_rfrag_ack(tx);
+                }
+            }
+        }
+        if (tx->waiting_ack) {
+            pending = TRUE;
         }
+
+        if (frag_vars.rfragRx[j].size == 0) {
+            continue;
+        }
+        if (EXPIRED(frag_vars.rfragRx[j])) {
+            memset(&frag_vars.rfragRx[j], 0, sizeof(rfrag_rx_t));
+        } else {
+            pending = TRUE;
+        }
+    }
+#endif
+
+    // nothing left to expire, stop ticking
+    if (pending == FALSE) {
+        opentimers_cancel(frag_vars.timerId);
     }
 }
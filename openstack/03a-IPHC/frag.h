@@ -30,19 +30,64 @@
 #define MAX_FRAGMENT_SIZE           80
 
 #define FRAGMENT_BUFFER_SIZE        (((IPV6_PACKET_SIZE / MAX_FRAGMENT_SIZE) + 1) * BIGQUEUELENGTH)
-#define NUM_OF_VRBS                 2
-#define NUM_OF_CONCURRENT_TIMERS    (NUM_OF_VRBS + BIGQUEUELENGTH)
+#define NUM_OF_REASSEMBLY_BUFFERS   BIGQUEUELENGTH
+
+/// Maximum number of datagrams forwarded concurrently (can be overridden at build time)
+#ifndef NUM_OF_VRBS
+#define NUM_OF_VRBS                 8
+#endif
+/// Number of hash buckets of the VRB table, preferably a power of two (can be overridden at build time)
+#ifndef NUM_OF_VRB_BUCKETS
+#define NUM_OF_VRB_BUCKETS          8
+#endif
+#define VRB_NONE                    0xff
+
+#if NUM_OF_VRBS >= VRB_NONE
+#error "NUM_OF_VRBS must fit in a VRB index"
+#endif
 
 #define FRAG1_HEADER_SIZE           4
 #define FRAGN_HEADER_SIZE           5
 
 #define DISPATCH_FRAG_FIRST         24
 #define DISPATCH_FRAG_SUBSEQ        28
+#define DISPATCH_RFRAG              29
 
 #define OFFSET_MULTIPLE             8
 
+// one bit per OFFSET_MULTIPLE bytes of a datagram
+#define REASSEMBLY_BITMAP_SIZE      (((IPV6_PACKET_SIZE / OFFSET_MULTIPLE) + 7) / 8)
+
 // specifies how long we store fragments or keep vrb allocated
 #define FRAG_REASSEMBLY_TIMEOUT     60000
+// a single timer expires them, at this period (in ms)
+#define FRAG_TIMER_PERIOD           1000
+#define FRAG_TIMEOUT_PERIODS        (FRAG_REASSEMBLY_TIMEOUT / FRAG_TIMER_PERIOD)
+
+// RFC 8931 recoverable fragments (RFRAG), and their acknowledgments (RFRAG-ACK)
+#define RFRAG_HEADER_SIZE           6
+#define RFRAG_ACK_HEADER_SIZE       6
+#define RFRAG_ACK_FLAG              0x02        // in the dispatch byte, an RFRAG-ACK rather than an RFRAG
+#define RFRAG_ACK_REQUEST           0x8000      // X flag, the receiver acknowledges the fragments received so far
+#define RFRAG_SEQUENCE_SHIFT        10
+#define RFRAG_SEQUENCE_MASK         0x1F
+#define RFRAG_SIZE_MASK             0x3FF
+#define RFRAG_NULL_BITMAP           0x00000000  // the datagram was aborted
+#define RFRAG_FULL_BITMAP           0xFFFFFFFF  // the datagram was received entirely
+#define RFRAG_MAX_FRAGMENTS         32          // one bit each in the acknowledgment bitmap
+#define RFRAG_MAX_RETRIES           3
+// how long the sender waits for an acknowledgment before requesting it again (in ms)
+#define RFRAG_ACK_TIMEOUT           10000
+#define RFRAG_ACK_TIMEOUT_PERIODS   (RFRAG_ACK_TIMEOUT / FRAG_TIMER_PERIOD)
+
+/// Maximum number of recoverable datagrams sent, and received, concurrently (can be overridden at build time)
+#ifndef NUM_OF_RFRAG_DATAGRAMS
+#define NUM_OF_RFRAG_DATAGRAMS      4
+#endif
+
+#if ((IPV6_PACKET_SIZE + MAX_FRAGMENT_SIZE - 1) / MAX_FRAGMENT_SIZE) > RFRAG_MAX_FRAGMENTS
+#error "a datagram does not fit in RFRAG_MAX_FRAGMENTS fragments"
+#endif
 
 // 6LoWPAN fragment1 header
 typedef struct {
@@ -62,7 +107,7 @@ typedef struct {
  * - If lock is TRUE, fragment is scheduled for Tx (do not delete until cb sendDone!!).
  * - The fragment offset value (multiple of 8)
  * - The tag value used for this fragment.
- * - The reassembly timer (60s after the arrival of the first fragment, reassembly must be completed).
+ * - When the fragment expires, in ticks of the fragment timer (60s after its arrival, reassembly must be completed).
  * - A pointer to the fragment's location in the OpenQueue.
  * - A pointer to the original unfragmented 6LoWPAN packet in the OpenQueue.
 */
@@ -71,7 +116,7 @@ struct fragment_t {
     bool lock;
     uint8_t datagram_offset;
     uint16_t datagram_tag;
-    opentimers_id_t reassembly_timer;
+    uint16_t expiry;
     OpenQueueEntry_t *pFragment;
     OpenQueueEntry_t *pOriginalMsg;
 };
@@ -79,24 +124,111 @@ END_PACK
 
 typedef struct fragment_t fragment;
 
-// virtual reassembly buffer struct
+/*
+ * Virtual reassembly buffer of a datagram forwarded by this mote, contains:
+ * - The previous hop and datagram tag, which identify the datagram, and its size.
+ * - How many bytes are left to forward.
+ * - When the VRB expires, in ticks of the fragment timer (60s after the last fragment forwarded).
+ * - The first fragment, until it is forwarded, and the next hop it was forwarded to.
+ * - The next VRB in the same hash bucket, and the neighbors of the VRB in the LRU list.
+ * - Whether the datagram is recoverable, and the first fragment requested an acknowledgment.
+*/
 BEGIN_PACK
 typedef struct {
     uint16_t tag;
     uint16_t left;
     uint16_t size;
-    opentimers_id_t forward_timer;
+    uint16_t expiry;
     OpenQueueEntry_t *frag1;
+    open_addr_t prevhop;
     open_addr_t nexthop;
+    uint8_t next;
+    uint8_t lru_prev;
+    uint8_t lru_next;
+#ifdef FRAG_RECOVERY_ENABLED
+    bool recoverable;
+    bool ack_request;
+#endif
 } vrb_t;
 END_PACK
 
+/*
+ * Reassembly buffer of a datagram addressed to this mote. Its fragments are copied straight to their
+ * offset in a big queue entry as they arrive, and freed:
+ * - The datagram tag and size, which identify the datagram.
+ * - The number of bytes received so far, the datagram is complete when it reaches its size.
+ * - Where the datagram starts in the big entry, after the first fragment got shorter on the way.
+ * - When the reassembly expires, in ticks of the fragment timer.
+ * - The big queue entry the datagram is reassembled in, NULL if the buffer is free.
+ * - A bitmap of the OFFSET_MULTIPLE-byte blocks received, to drop duplicates.
+*/
+typedef struct {
+    uint16_t tag;
+    uint16_t size;
+    uint16_t received;
+    uint8_t start;
+    uint16_t expiry;
+    OpenQueueEntry_t *msg;
+    uint8_t bitmap[REASSEMBLY_BITMAP_SIZE];
+} reassembly_t;
+
+#ifdef FRAG_RECOVERY_ENABLED
+/*
+ * Recoverable datagram sent by this mote, held until its receiver acknowledges all of its fragments:
+ * - The datagram tag, and its number of fragments.
+ * - The fragments acknowledged so far, the first one in the MSB.
+ * - How many times the missing fragments were sent again.
+ * - Whether all fragments were sent, and the mote waits for an acknowledgment until it expires.
+ * - The datagram, NULL if the entry is free, and its creator: the datagram is created by FRAG until it is done
+ *   with, so that its creator flushing its packets does not free it under the fragments.
+*/
+typedef struct {
+    uint8_t tag;
+    uint8_t num_fragments;
+    uint32_t acked;
+    uint8_t retries;
+    bool waiting_ack;
+    uint16_t expiry;
+    OpenQueueEntry_t *msg;
+    uint8_t creator;
+} rfrag_tx_t;
+
+/*
+ * Recoverable datagram received by this mote, either reassembled or, on the DAG root, bridged fragment per fragment:
+ * - The previous hop, where acknowledgments go, and the datagram tag.
+ * - The datagram size, 0 if the entry is free, and how many bytes of it were received, counted as for reassembly.
+ * - The fragments received so far, the first one in the MSB.
+ * - Whether the datagram is complete, and when the entry expires.
+ * - The acknowledgment queued for the previous hop, if any: fragments received again while it waits for a cell do
+ *   not queue more of them.
+*/
+typedef struct {
+    open_addr_t prevhop;
+    uint8_t tag;
+    uint16_t size;
+    uint16_t received;
+    uint32_t acked;
+    bool complete;
+    uint16_t expiry;
+    OpenQueueEntry_t *ack;
+} rfrag_rx_t;
+#endif
+
 // state information for fragmentation
 typedef struct {
     uint16_t global_tag;
+    uint16_t clock;                                  // ticks of the fragment timer
+    opentimers_id_t timerId;                         // expires fragments, reassembly buffers and VRBs
     vrb_t vrbs[NUM_OF_VRBS];
+    uint8_t vrb_buckets[NUM_OF_VRB_BUCKETS];         // first VRB of each hash bucket
+    uint8_t vrb_lru_head;                            // least recently used VRB, the first to expire
+    uint8_t vrb_lru_tail;                            // most recently used VRB
     fragment fragmentBuf[FRAGMENT_BUFFER_SIZE];
-    opentimers_id_t frag_timerq[NUM_OF_CONCURRENT_TIMERS];
+    reassembly_t reassemblyBuf[NUM_OF_REASSEMBLY_BUFFERS];
+#ifdef FRAG_RECOVERY_ENABLED
+    rfrag_tx_t rfragTx[NUM_OF_RFRAG_DATAGRAMS];
+    rfrag_rx_t rfragRx[NUM_OF_RFRAG_DATAGRAMS];
+#endif
 } frag_vars_t;
 
 
@@ -15,6 +15,8 @@
 
 static const uint8_t dagroot_mac64b[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
 
+iphc_vars_t iphc_vars;
+
 #ifdef DEADLINE_OPTION_ENABLED
 static monitor_expiration_vars_t  monitor_expiration_vars;
 #endif
@@ -55,6 +57,7 @@ uint8_t iphc_getAsnLen(
 //=========================== public ==========================================
 
 void iphc_init(void) {
+    memset(&iphc_vars, 0, sizeof(iphc_vars_t));
 }
 
 // send from upper layer: I need to add 6LoWPAN header
@@ -315,6 +318,193 @@ void iphc_receive(OpenQueueEntry_t *msg) {
     }
 }
 
+//===== compression contexts
+
+/**
+\brief Install, update or remove a compression context.
+
+Context 0 is the DODAG prefix and cannot be set.
+
+\param[in] cid      Context identifier, 1 to 15.
+\param[in] prefix   The 64-bit prefix of the context, NULL to remove it.
+\param[in] compress FALSE if the context may only be used to decompress.
+
+\returns E_SUCCESS if the table was updated, E_FAIL if the identifier is
+   invalid or the table is full.
+*/
+owerror_t iphc_setContext(uint8_t cid, open_addr_t *prefix, bool compress) {
+    iphc_context_t *context;
+    uint8_t i;
+
+    if (cid == 0 || cid > IPHC_CONTEXT_ID_MASK) {
+        return E_FAIL;
+    }
+
+    // reuse the entry of that context, or else the first free one
+    context = NULL;
+    for (i = 0; i < IPHC_MAXNUM_CONTEXTS; i++) {
+        if (iphc_vars.contexts[i].prefix.type == ADDR_NONE) {
+            if (context == NULL) {
+                context = &iphc_vars.contexts[i];
+            }
+        } else if (iphc_vars.contexts[i].cid == cid) {
+            context = &iphc_vars.contexts[i];
+            break;
+        }
+    }
+
+    if (prefix == NULL) {
+        if (context != NULL && context->cid == cid) {
+            memset(context, 0, sizeof(iphc_context_t));
+            iphc_flushCachedIPv6Headers();
+        }
+        return E_SUCCESS;
+    }
+
+    if (context == NULL || prefix->type != ADDR_PREFIX) {
+        return E_FAIL;
+    }
+    if (context->cid == cid &&
+        context->compress == compress &&
+        packetfunctions_sameAddress(&context->prefix, prefix)) {
+        // nothing changes, typically when the context is heard again in a DIO
+        return E_SUCCESS;
+    }
+    iphc_flushCachedIPv6Headers();
+    context->cid = cid;
+    context->compress = compress;
+    memcpy(&context->prefix, prefix, sizeof(open_addr_t));
+    return E_SUCCESS;
+}
+
+/**
+\brief Find the context a prefix can be compressed against.
+
+\returns TRUE and writes its identifier into cid if there is one, FALSE
+   otherwise.
+*/
+bool iphc_getContextId(open_addr_t *prefix, uint8_t *cid) {
+    uint8_t i;
+
+    for (i = 0; i < IPHC_MAXNUM_CONTEXTS; i++) {
+        if (iphc_vars.contexts[i].prefix.type == ADDR_PREFIX &&
+            iphc_vars.contexts[i].compress &&
+            packetfunctions_sameAddress(&iphc_vars.contexts[i].prefix, prefix)) {
+            *cid = iphc_vars.contexts[i].cid;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+\brief The prefix of a context, as used to decompress an address.
+
+\returns A pointer to the prefix, NULL if that context is unknown.
+*/
+open_addr_t* iphc_getContextPrefix(uint8_t cid) {
+    uint8_t i;
+
+    if (cid == 0) {
+        return idmanager_getMyID(ADDR_PREFIX);
+    }
+    for (i = 0; i < IPHC_MAXNUM_CONTEXTS; i++) {
+        if (iphc_vars.contexts[i].prefix.type == ADDR_PREFIX && iphc_vars.contexts[i].cid == cid) {
+            return &iphc_vars.contexts[i].prefix;
+        }
+    }
+    return NULL;
+}
+
+/**
+\brief The context at some position of the table, to advertise it.
+
+\returns A pointer to the context, NULL if that entry is free.
+*/
+iphc_context_t* iphc_getContext(uint8_t index) {
+    if (index >= IPHC_MAXNUM_CONTEXTS || iphc_vars.contexts[index].prefix.type == ADDR_NONE) {
+        return NULL;
+    }
+    return &iphc_vars.contexts[index];
+}
+
+//===== cached headers
+
+/**
+\brief Prepend the cached IPv6 header of the flow a packet belongs to.
+
+The flow is identified by the source port (or ICMPv6 type), destination
+address and next header of the packet, and the hop limit mode.
+
+\param[in,out] msg    The packet, its source address is set on a hit.
+\param[in]     hlim   Hop limit mode of the header.
+\param[in]     nh     Whether the next header is compressed.
+\param[out]    ipinip Whether the packet leaves the DODAG.
+
+\returns TRUE if the header was prepended, FALSE if that flow is not cached.
+*/
+bool iphc_prependCachedIPv6Header(OpenQueueEntry_t *msg, uint8_t hlim, uint8_t nh, bool *ipinip) {
+    iphc_cached_header_t *entry;
+    uint8_t i;
+
+    for (i = 0; i < IPHC_NUM_CACHED_HEADERS; i++) {
+        entry = &iphc_vars.headers[i];
+        if (entry->dest.type != ADDR_NONE &&
+            entry->src_port == msg->l4_sourcePortORicmpv6Type &&
+            entry->next_header == msg->l4_protocol &&
+            entry->nh == nh &&
+            entry->hlim == hlim &&
+            packetfunctions_sameAddress(&entry->dest, &(msg->l3_destinationAdd))) {
+            memcpy(&(msg->l3_sourceAdd), &entry->src, sizeof(open_addr_t));
+            packetfunctions_reserveHeaderSize(msg, entry->length);
+            memcpy(msg->payload, entry->header, entry->length);
+            *ipinip = entry->ipinip;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+\brief Remember the IPv6 header just prepended to a packet, for its flow.
+
+\param[in] msg    The packet, msg->payload pointing to the IPv6 header.
+\param[in] hlim   Hop limit mode of the header.
+\param[in] nh     Whether the next header is compressed.
+\param[in] length Length of the IPv6 header.
+\param[in] ipinip Whether the packet leaves the DODAG.
+*/
+void iphc_cacheIPv6Header(OpenQueueEntry_t *msg, uint8_t hlim, uint8_t nh, uint8_t length, bool ipinip) {
+    iphc_cached_header_t *entry;
+
+    if (length > IPHC_CACHED_HEADER_LEN) {
+        return;
+    }
+
+    entry = &iphc_vars.headers[iphc_vars.nextHeaderIdx];
+    iphc_vars.nextHeaderIdx = (iphc_vars.nextHeaderIdx + 1) % IPHC_NUM_CACHED_HEADERS;
+
+    entry->src_port = msg->l4_sourcePortORicmpv6Type;
+    memcpy(&entry->dest, &(msg->l3_destinationAdd), sizeof(open_addr_t));
+    entry->next_header = msg->l4_protocol;
+    entry->nh = nh;
+    entry->hlim = hlim;
+    memcpy(&entry->src, &(msg->l3_sourceAdd), sizeof(open_addr_t));
+    entry->ipinip = ipinip;
+    entry->length = length;
+    memcpy(entry->header, msg->payload, length);
+}
+
+/**
+\brief Forget all cached headers.
+
+To be called when my prefix, my parent or a compression context changes.
+*/
+void iphc_flushCachedIPv6Headers(void) {
+    memset(iphc_vars.headers, 0, sizeof(iphc_vars.headers));
+    iphc_vars.nextHeaderIdx = 0;
+}
+
 //=========================== private =========================================
 
 //===== IPv6 header
@@ -331,6 +521,7 @@ owerror_t iphc_prependIPv6Header(
         uint8_t hlim,
         uint8_t value_hopLimit,
         bool cid,
+        uint8_t value_cid,
         bool sac,
         uint8_t sam,
         bool m,
@@ -542,6 +733,12 @@ owerror_t iphc_prependIPv6Header(
             return E_FAIL;
     }
 
+    // context identifier extension, right after the IPHC base header
+    if (cid == IPHC_CID_YES) {
+        packetfunctions_reserveHeaderSize(msg, sizeof(uint8_t));
+        *((uint8_t * )(msg->payload)) = value_cid;
+    }
+
     // header
     temp_8b = 0;
     temp_8b |= cid << IPHC_CID;
@@ -800,6 +997,13 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t *temp_addr_16b,
     uint8_t temp_8b;
     uint8_t ipinip_length;
     uint8_t lowpan_nhc;
+    uint8_t cid;
+    uint8_t sac;
+    uint8_t dac;
+    uint8_t sci;
+    uint8_t dci;
+    open_addr_t *src_prefix;
+    open_addr_t *dest_prefix;
 
     temp_8b = *((uint8_t * )(msg->payload) + ipv6_header->header_length + previousLen);
 
@@ -822,15 +1026,52 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t *temp_addr_16b,
         *hlim = (temp_8b >> IPHC_HLIM) & 0x03;   // 2b
         ipv6_header->header_length += sizeof(uint8_t);
         temp_8b = *((uint8_t * )(msg->payload) + ipv6_header->header_length + previousLen);
-        // cid unused
-        // sac unused
+        cid = (temp_8b >> IPHC_CID) & 0x01;   // 1b
+        sac = (temp_8b >> IPHC_SAC) & 0x01;   // 1b
         *sam = (temp_8b >> IPHC_SAM) & 0x03;   // 2b
-        // m unused
         *m = (temp_8b >> IPHC_M) & 0x01;   // 1b
-        // dac unused
+        dac = (temp_8b >> IPHC_DAC) & 0x01;   // 1b
         *dam = (temp_8b >> IPHC_DAM) & 0x03;   // 2b
         ipv6_header->header_length += sizeof(uint8_t);
 
+        // context identifier extension, both contexts default to 0 without it
+        sci = 0;
+        dci = 0;
+        if (cid == IPHC_CID_YES) {
+            temp_8b = *((uint8_t * )(msg->payload) + ipv6_header->header_length + previousLen);
+            sci = (temp_8b >> IPHC_CONTEXT_SCI) & IPHC_CONTEXT_ID_MASK;
+            dci = temp_8b & IPHC_CONTEXT_ID_MASK;
+            ipv6_header->header_length += sizeof(uint8_t);
+        }
+
+        // prefixes the addresses are rebuilt from
+        src_prefix = idmanager_getMyID(ADDR_PREFIX);
+        if (sac == IPHC_SAC_STATEFUL) {
+            src_prefix = iphc_getContextPrefix(sci);
+            if (src_prefix == NULL) {
+                openserial_printError(
+                        COMPONENT_IPHC,
+                        ERR_UNKNOWN_CONTEXT,
+                        (errorparameter_t) sci,
+                        (errorparameter_t) 0
+                );
+                src_prefix = idmanager_getMyID(ADDR_PREFIX);
+            }
+        }
+        dest_prefix = idmanager_getMyID(ADDR_PREFIX);
+        if (dac == IPHC_DAC_STATEFUL && *m == IPHC_M_NO) {
+            dest_prefix = iphc_getContextPrefix(dci);
+            if (dest_prefix == NULL) {
+                openserial_printError(
+                        COMPONENT_IPHC,
+                        ERR_UNKNOWN_CONTEXT,
+                        (errorparameter_t) dci,
+                        (errorparameter_t) 1
+                );
+                dest_prefix = idmanager_getMyID(ADDR_PREFIX);
+            }
+        }
+
         // dispatch
         switch (*dispatch) {
             case IPHC_DISPATCH_IPHC:
@@ -931,7 +1172,7 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t *temp_addr_16b,
         // source address
         switch (*sam) {
             case IPHC_SAM_ELIDED:
-                packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX), &(msg->l2_nextORpreviousHop),
+                packetfunctions_mac64bToIp128b(src_prefix, &(msg->l2_nextORpreviousHop),
                                                &ipv6_header->src);
                 break;
             case IPHC_SAM_16B:
@@ -939,13 +1180,13 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t *temp_addr_16b,
                                             ADDR_16B, temp_addr_16b, OW_BIG_ENDIAN);
                 ipv6_header->header_length += 2 * sizeof(uint8_t);
                 packetfunctions_mac16bToMac64b(temp_addr_16b, temp_addr_64b);
-                packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX), temp_addr_64b, &ipv6_header->src);
+                packetfunctions_mac64bToIp128b(src_prefix, temp_addr_64b, &ipv6_header->src);
                 break;
             case IPHC_SAM_64B:
                 packetfunctions_readAddress(((uint8_t * )(msg->payload + ipv6_header->header_length + previousLen)),
                                             ADDR_64B, temp_addr_64b, OW_BIG_ENDIAN);
                 ipv6_header->header_length += 8 * sizeof(uint8_t);
-                packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX), temp_addr_64b, &ipv6_header->src);
+                packetfunctions_mac64bToIp128b(src_prefix, temp_addr_64b, &ipv6_header->src);
                 break;
             case IPHC_SAM_128B:
                 packetfunctions_readAddress(((uint8_t * )(msg->payload + ipv6_header->header_length + previousLen)),
@@ -992,7 +1233,7 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t *temp_addr_16b,
         } else {
             switch (*dam) {
                 case IPHC_DAM_ELIDED:
-                    packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX), idmanager_getMyID(ADDR_64B),
+                    packetfunctions_mac64bToIp128b(dest_prefix, idmanager_getMyID(ADDR_64B),
                                                    &(ipv6_header->dest));
                     break;
                 case IPHC_DAM_16B:
@@ -1000,13 +1241,13 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t *temp_addr_16b,
                                                 ADDR_16B, temp_addr_16b, OW_BIG_ENDIAN);
                     ipv6_header->header_length += 2 * sizeof(uint8_t);
                     packetfunctions_mac16bToMac64b(temp_addr_16b, temp_addr_64b);
-                    packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX), temp_addr_64b, &ipv6_header->dest);
+                    packetfunctions_mac64bToIp128b(dest_prefix, temp_addr_64b, &ipv6_header->dest);
                     break;
                 case IPHC_DAM_64B:
                     packetfunctions_readAddress(((uint8_t * )(msg->payload + ipv6_header->header_length + previousLen)),
                                                 ADDR_64B, temp_addr_64b, OW_BIG_ENDIAN);
                     ipv6_header->header_length += 8 * sizeof(uint8_t);
-                    packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX), temp_addr_64b, &ipv6_header->dest);
+                    packetfunctions_mac64bToIp128b(dest_prefix, temp_addr_64b, &ipv6_header->dest);
                     break;
                 case IPHC_DAM_128B:
                     packetfunctions_readAddress(((uint8_t * )(msg->payload + ipv6_header->header_length + previousLen)),
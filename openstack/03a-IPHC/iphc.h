@@ -15,6 +15,11 @@
 #define IPHC_DEFAULT_HOP_LIMIT    65
 #define IPv6HOP_HDR_LEN           2  // tengfei: should be 2
 #define MAXNUM_RH3                3
+#define IPHC_MAXNUM_CONTEXTS      3  // contexts besides context 0, which is always the DODAG prefix
+#define IPHC_CONTEXT_ID_MASK      0x0f
+#define IPHC_CONTEXT_SCI          4
+#define IPHC_NUM_CACHED_HEADERS   4
+#define IPHC_CACHED_HEADER_LEN    40 // IPHC, CID, flow label, next header, hop limit and two 128b addresses
 
 enum IPHC_enums {
     IPHC_DISPATCH = 5,
@@ -243,8 +248,44 @@ typedef struct {
     uint16_t time_elapsed;
 } monitor_expiration_vars_t;
 
+/**
+\brief A 6LoWPAN compression context, see http://tools.ietf.org/html/rfc6282#section-3.1.2
+
+Only 64-bit prefixes are supported, the IID of a context-compressed address is
+carried inline or derived from the link-layer address.
+*/
+typedef struct {
+    uint8_t cid;                    ///< context identifier, 1 to 15
+    bool compress;                  ///< FALSE if the context is only valid for decompression
+    open_addr_t prefix;             ///< ADDR_NONE when this entry is free
+} iphc_context_t;
+
+/**
+\brief The compressed IPv6 header of a flow originating at this mote.
+
+None of the inline fields it holds changes from one packet of the flow to the
+next, so it is prepended as is.
+*/
+typedef struct {
+    uint16_t src_port;              ///< source port, or ICMPv6 type
+    open_addr_t dest;               ///< ADDR_NONE when this entry is free
+    uint8_t next_header;
+    uint8_t nh;
+    uint8_t hlim;
+    open_addr_t src;                ///< source address the header was compressed for
+    bool ipinip;                    ///< the packet leaves the DODAG, in an IPinIP 6LoRH
+    uint8_t length;
+    uint8_t header[IPHC_CACHED_HEADER_LEN];
+} iphc_cached_header_t;
+
 //=========================== variables =======================================
 
+typedef struct {
+    iphc_context_t contexts[IPHC_MAXNUM_CONTEXTS];
+    iphc_cached_header_t headers[IPHC_NUM_CACHED_HEADERS];
+    uint8_t nextHeaderIdx;          ///< next cached header to replace
+} iphc_vars_t;
+
 //=========================== prototypes ======================================
 
 void iphc_init(void);
@@ -279,6 +320,7 @@ owerror_t iphc_prependIPv6Header(
         uint8_t hlim,
         uint8_t value_hopLimit,
         bool cid,
+        uint8_t value_cid,
         bool sac,
         uint8_t sam,
         bool m,
@@ -289,6 +331,23 @@ owerror_t iphc_prependIPv6Header(
         uint8_t fw_SendOrfw_Rcv
 );
 
+bool iphc_prependCachedIPv6Header(
+        OpenQueueEntry_t *msg,
+        uint8_t hlim,
+        uint8_t nh,
+        bool *ipinip
+);
+
+void iphc_cacheIPv6Header(
+        OpenQueueEntry_t *msg,
+        uint8_t hlim,
+        uint8_t nh,
+        uint8_t length,
+        bool ipinip
+);
+
+void iphc_flushCachedIPv6Headers(void);
+
 uint8_t iphc_retrieveIPv6HopByHopHeader(
         OpenQueueEntry_t *msg,
         rpl_option_ht *rpl_option
@@ -301,6 +360,14 @@ void iphc_retrieveIPv6Header(
    uint8_t*         page_length
 );
 
+owerror_t iphc_setContext(uint8_t cid, open_addr_t *prefix, bool compress);
+
+bool iphc_getContextId(open_addr_t *prefix, uint8_t *cid);
+
+open_addr_t* iphc_getContextPrefix(uint8_t cid);
+
+iphc_context_t* iphc_getContext(uint8_t index);
+
 #ifdef DEADLINE_OPTION_ENABLED
 void iphc_retrieveIPv6DeadlineHeader(
    OpenQueueEntry_t*    msg,
@@ -40,6 +40,8 @@ owerror_t forwarding_send_internal_SourceRouting(
         rpl_option_ht *rpl_option
 );
 
+void forwarding_prependIPv6Header(OpenQueueEntry_t *msg, ipv6_header_iht *ipv6_outer_header, uint8_t next_header);
+
 void forwarding_createRplOption(rpl_option_ht *rpl_option, uint8_t flags);
 
 #ifdef DEADLINE_OPTION_ENABLED
@@ -69,63 +71,13 @@ owerror_t forwarding_send(OpenQueueEntry_t *msg) {
 #ifdef DEADLINE_OPTION_ENABLED
     deadline_option_ht   deadline_option;
 #endif
-    open_addr_t *myprefix;
-    open_addr_t *myadd64;
     uint32_t flow_label = 0;
-
-    open_addr_t temp_dest_prefix;
-    open_addr_t temp_dest_mac64b;
-    open_addr_t *p_dest;
-    open_addr_t *p_src;
-    open_addr_t temp_src_prefix;
-    open_addr_t temp_src_mac64b;
-    bool sac;
-    uint8_t sam;
-    uint8_t m;
-    bool dac;
-    uint8_t dam;
     uint8_t next_header;
+    bool ipinip;
 
     // take ownership over the packet
     msg->owner = COMPONENT_FORWARDING;
 
-    m = IPHC_M_NO;
-
-    // retrieve my prefix and EUI64
-    myadd64 = idmanager_getMyID(ADDR_64B);
-
-    // set source address (me)
-    msg->l3_sourceAdd.type = ADDR_128B;
-
-    packetfunctions_ip128bToMac64b(&(msg->l3_destinationAdd), &temp_dest_prefix, &temp_dest_mac64b);
-    // at this point, we still haven't written in the packet the source prefix
-    // that we will use - it depends whether the destination address is link-local or not
-
-    // if we are sending to a link-local address set the source prefix to link-local
-    if (packetfunctions_isLinkLocal(&msg->l3_destinationAdd) ||
-        packetfunctions_isAllRoutersMulticast(&msg->l3_destinationAdd) ||
-        packetfunctions_isAllHostsMulticast(&msg->l3_destinationAdd)) {
-        memset(&temp_src_prefix, 0x00, sizeof(open_addr_t));
-        temp_src_prefix.type = ADDR_PREFIX;
-        temp_src_prefix.prefix[0] = 0xfe;
-        temp_src_prefix.prefix[1] = 0x80;
-        myprefix = &temp_src_prefix;
-        sac = IPHC_SAC_STATELESS;
-        dac = IPHC_DAC_STATELESS;
-    } else if (packetfunctions_sameAddress(&temp_dest_prefix, idmanager_getMyID(ADDR_PREFIX)) == FALSE &&
-               packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd)) == FALSE) {
-        myprefix = idmanager_getMyID(ADDR_PREFIX);
-        sac = IPHC_SAC_STATELESS;
-        dac = IPHC_DAC_STATELESS;
-    } else {
-        myprefix = idmanager_getMyID(ADDR_PREFIX);
-        sac = IPHC_SAC_STATEFUL;
-        dac = IPHC_DAC_STATEFUL;
-    }
-    // myprefix now contains the pointer to the correct prefix to use (link-local or global)
-    memcpy(&(msg->l3_sourceAdd.addr_128b[0]), myprefix->prefix, 8);
-    memcpy(&(msg->l3_sourceAdd.addr_128b[8]), myadd64->addr_64b, 8);
-
     // initialize IPv6 header
     memset(&ipv6_outer_header, 0, sizeof(ipv6_header_iht));
     memset(&ipv6_inner_header, 0, sizeof(ipv6_header_iht));
@@ -149,57 +101,24 @@ owerror_t forwarding_send(OpenQueueEntry_t *msg) {
     );
 #endif
 
-    if (packetfunctions_sameAddress(&temp_dest_prefix, myprefix)) {
-        // same prefix use 64B address
-        sam = IPHC_SAM_64B;
-        dam = IPHC_DAM_64B;
-        p_dest = &temp_dest_mac64b;
-        p_src = &temp_src_mac64b;
+    if (msg->l4_protocol_compressed) {
+        next_header = IPHC_NH_COMPRESSED;
     } else {
-        //not the same prefix. so the packet travels to another network
-        //check if this is a source routing pkt. in case it is then the DAM is elided as it is in the SrcRouting header.
-        if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd)) == FALSE) {
-            sam = IPHC_SAM_128B;
-            dam = IPHC_DAM_128B;
-            p_dest = &(msg->l3_destinationAdd);
-            p_src = &(msg->l3_sourceAdd);
+        next_header = IPHC_NH_INLINE;
+    }
 
-            ipv6_outer_header.src.type = ADDR_128B;
-            memcpy(&ipv6_outer_header.src, p_src, sizeof(open_addr_t));
+    // a flow already sent to that destination reuses its compressed header
+    if (
+            packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd)) == FALSE &&
+            iphc_prependCachedIPv6Header(msg, IPHC_HLIM_64, next_header, &ipinip)
+            ) {
+        if (ipinip) {
+            memcpy(&ipv6_outer_header.src, &(msg->l3_sourceAdd), sizeof(open_addr_t));
             ipv6_outer_header.hop_limit = IPHC_DEFAULT_HOP_LIMIT;
-        } else {
-            // this is DIO, source address elided, multicast bit is set
-            sam = IPHC_SAM_ELIDED;
-            m = IPHC_M_YES;
-            dam = IPHC_DAM_ELIDED;
-            p_dest = &(msg->l3_destinationAdd);
-            p_src = &(msg->l3_sourceAdd);
         }
-    }
-    //IPHC inner header and NHC IPv6 header will be added at here
-
-    if (msg->l4_protocol_compressed) {
-        next_header = IPHC_NH_COMPRESSED;
     } else {
-        next_header = IPHC_NH_INLINE;
+        forwarding_prependIPv6Header(msg, &ipv6_outer_header, next_header);
     }
-    iphc_prependIPv6Header(msg,
-                           IPHC_TF_ELIDED,
-                           flow_label, // value_flowlabel
-                           next_header,
-                           msg->l4_protocol, // value nh. If compressed this is ignored as LOWPAN_NH is already there.
-                           IPHC_HLIM_64,
-                           ipv6_outer_header.hop_limit,
-                           IPHC_CID_NO,
-                           sac,
-                           sam,
-                           m,
-                           dac,
-                           dam,
-                           p_dest,
-                           p_src,
-                           PCKTSEND
-    );
     // both of them are compressed
     ipv6_outer_header.next_header_compressed = TRUE;
 
@@ -373,6 +292,21 @@ void forwarding_receive(
         if (ipv6_outer_header->next_header != IANA_IPv6ROUTE) {
             flags = rpl_option->flags;
             senderRank = rpl_option->senderRank;
+#ifdef RPL_STORING_MODE_ENABLED
+            if ((flags & O_FLAG) != 0) {
+                // going down, the sender is above me
+                if (senderRank > icmpv6rpl_getMyDAGrank()) {
+                    // loop detected
+                    rpl_option->flags |= R_FLAG;
+                    openserial_printError(
+                            COMPONENT_FORWARDING,
+                            ERR_LOOP_DETECTED,
+                            (errorparameter_t) senderRank,
+                            (errorparameter_t) icmpv6rpl_getMyDAGrank()
+                    );
+                }
+            } else
+#else
             if ((flags & O_FLAG) != 0) {
                 // wrong direction
                 // log error
@@ -383,6 +317,7 @@ void forwarding_receive(
                         (errorparameter_t) senderRank
                 );
             }
+#endif
             if (senderRank < icmpv6rpl_getMyDAGrank()) {
                 // loop detected
                 // set flag
@@ -445,6 +380,153 @@ void forwarding_receive(
 
 //=========================== private =========================================
 
+/**
+\brief Compress the IPv6 header of a packet originating at this mote.
+
+Sets the source address of the packet, and the IPinIP source in the outer
+header when the packet leaves the DODAG. The compressed header of a unicast
+packet is cached by IPHC for the next packets of that flow.
+
+\param[in,out] msg               Packet to send.
+\param[out]    ipv6_outer_header Outer header of the packet.
+\param[in]     next_header       Whether the next header is compressed.
+*/
+void forwarding_prependIPv6Header(OpenQueueEntry_t *msg, ipv6_header_iht *ipv6_outer_header, uint8_t next_header) {
+    open_addr_t *myprefix;
+    open_addr_t *myadd64;
+
+    open_addr_t temp_dest_prefix;
+    open_addr_t temp_dest_mac64b;
+    open_addr_t *p_dest;
+    open_addr_t *p_src;
+    open_addr_t temp_src_prefix;
+    open_addr_t temp_src_mac64b;
+    bool cid;
+    uint8_t value_cid;
+    uint8_t dci;
+    bool sac;
+    uint8_t sam;
+    uint8_t m;
+    bool dac;
+    uint8_t dam;
+    uint16_t length;
+
+    m = IPHC_M_NO;
+    cid = IPHC_CID_NO;
+    value_cid = 0;
+
+    // retrieve my prefix and EUI64
+    myadd64 = idmanager_getMyID(ADDR_64B);
+
+    // set source address (me)
+    msg->l3_sourceAdd.type = ADDR_128B;
+
+    packetfunctions_ip128bToMac64b(&(msg->l3_destinationAdd), &temp_dest_prefix, &temp_dest_mac64b);
+    // at this point, we still haven't written in the packet the source prefix
+    // that we will use - it depends whether the destination address is link-local or not
+
+    // if we are sending to a link-local address set the source prefix to link-local
+    if (packetfunctions_isLinkLocal(&msg->l3_destinationAdd) ||
+        packetfunctions_isAllRoutersMulticast(&msg->l3_destinationAdd) ||
+        packetfunctions_isAllHostsMulticast(&msg->l3_destinationAdd)) {
+        memset(&temp_src_prefix, 0x00, sizeof(open_addr_t));
+        temp_src_prefix.type = ADDR_PREFIX;
+        temp_src_prefix.prefix[0] = 0xfe;
+        temp_src_prefix.prefix[1] = 0x80;
+        myprefix = &temp_src_prefix;
+        sac = IPHC_SAC_STATELESS;
+        dac = IPHC_DAC_STATELESS;
+    } else if (packetfunctions_sameAddress(&temp_dest_prefix, idmanager_getMyID(ADDR_PREFIX)) == FALSE &&
+               packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd)) == FALSE) {
+        myprefix = idmanager_getMyID(ADDR_PREFIX);
+        if (iphc_getContextId(&temp_dest_prefix, &dci)) {
+            // destination prefix is a known context, my prefix is context 0
+            cid = IPHC_CID_YES;
+            value_cid = dci;
+            sac = IPHC_SAC_STATEFUL;
+            dac = IPHC_DAC_STATEFUL;
+        } else {
+            sac = IPHC_SAC_STATELESS;
+            dac = IPHC_DAC_STATELESS;
+        }
+    } else {
+        myprefix = idmanager_getMyID(ADDR_PREFIX);
+        sac = IPHC_SAC_STATEFUL;
+        dac = IPHC_DAC_STATEFUL;
+    }
+    // myprefix now contains the pointer to the correct prefix to use (link-local or global)
+    memcpy(&(msg->l3_sourceAdd.addr_128b[0]), myprefix->prefix, 8);
+    memcpy(&(msg->l3_sourceAdd.addr_128b[8]), myadd64->addr_64b, 8);
+
+    if (packetfunctions_sameAddress(&temp_dest_prefix, myprefix)) {
+        // same prefix use 64B address
+        sam = IPHC_SAM_64B;
+        dam = IPHC_DAM_64B;
+        p_dest = &temp_dest_mac64b;
+        p_src = &temp_src_mac64b;
+    } else {
+        //not the same prefix. so the packet travels to another network
+        //check if this is a source routing pkt. in case it is then the DAM is elided as it is in the SrcRouting header.
+        if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd)) == FALSE) {
+            if (cid == IPHC_CID_YES) {
+                // both prefixes are rebuilt from the contexts, only carry the IIDs
+                sam = IPHC_SAM_64B;
+                dam = IPHC_DAM_64B;
+                p_dest = &temp_dest_mac64b;
+                p_src = &temp_src_mac64b;
+            } else {
+                sam = IPHC_SAM_128B;
+                dam = IPHC_DAM_128B;
+                p_dest = &(msg->l3_destinationAdd);
+                p_src = &(msg->l3_sourceAdd);
+            }
+
+            ipv6_outer_header->src.type = ADDR_128B;
+            memcpy(&ipv6_outer_header->src, &(msg->l3_sourceAdd), sizeof(open_addr_t));
+            ipv6_outer_header->hop_limit = IPHC_DEFAULT_HOP_LIMIT;
+        } else {
+            // this is DIO, source address elided, multicast bit is set
+            sam = IPHC_SAM_ELIDED;
+            m = IPHC_M_YES;
+            dam = IPHC_DAM_ELIDED;
+            p_dest = &(msg->l3_destinationAdd);
+            p_src = &(msg->l3_sourceAdd);
+        }
+    }
+    //IPHC inner header and NHC IPv6 header will be added at here
+
+    length = msg->length;
+    if (
+            iphc_prependIPv6Header(msg,
+                                   IPHC_TF_ELIDED,
+                                   0, // value_flowlabel
+                                   next_header,
+                                   msg->l4_protocol, // value nh. If compressed this is ignored as LOWPAN_NH is already there.
+                                   IPHC_HLIM_64,
+                                   ipv6_outer_header->hop_limit,
+                                   cid,
+                                   value_cid,
+                                   sac,
+                                   sam,
+                                   m,
+                                   dac,
+                                   dam,
+                                   p_dest,
+                                   p_src,
+                                   PCKTSEND
+            ) == E_SUCCESS &&
+            m == IPHC_M_NO
+            ) {
+        iphc_cacheIPv6Header(
+                msg,
+                IPHC_HLIM_64,
+                next_header,
+                (uint8_t)(msg->length - length),
+                ipv6_outer_header->src.type != ADDR_NONE
+        );
+    }
+}
+
 /**
 \brief Retrieve the next hop's address from routing table.
 
@@ -461,6 +543,12 @@ void forwarding_getNextHop(open_addr_t *destination128b, open_addr_t *addressToW
             addressToWrite64b->addr_64b[i] = 0xff;
         }
     } else {
+#ifdef RPL_STORING_MODE_ENABLED
+        // destination is below me, send to the child on its route
+        if (icmpv6rpl_getRouteNextHop(destination128b, addressToWrite64b)) {
+            return;
+        }
+#endif
         // destination is remote, send to preferred parent
         icmpv6rpl_getPreferredParentEui64(addressToWrite64b);
     }
@@ -515,6 +603,19 @@ owerror_t forwarding_send_internal_RoutingTable(
         return E_FAIL;
     }
 
+#ifdef RPL_STORING_MODE_ENABLED
+    if (
+            packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd)) == FALSE &&
+            icmpv6rpl_isPreferredParent(&(msg->l2_nextORpreviousHop)) == FALSE
+            ) {
+        // going down a route learnt from DAOs, the packet must not follow a parent change
+        msg->l3_useSourceRouting = TRUE;
+        rpl_option->flags |= O_FLAG;
+    } else {
+        rpl_option->flags &= ~O_FLAG;
+    }
+#endif
+
     if (ipv6_outer_header->src.type != ADDR_NONE) {
         packetfunctions_tossHeader(msg, ipv6_outer_header->header_length);
     }
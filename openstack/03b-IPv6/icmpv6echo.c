@@ -4,6 +4,7 @@
 #include "openserial.h"
 #include "openqueue.h"
 #include "packetfunctions.h"
+#include "idmanager.h"
 #include "debugpins.h"
 
 //=========================== variables =======================================
@@ -94,6 +95,8 @@ void icmpv6echo_sendDone(OpenQueueEntry_t *msg, owerror_t error) {
 
 void icmpv6echo_receive(OpenQueueEntry_t *msg) {
     OpenQueueEntry_t *reply;
+    uint8_t oldType;
+    bool wasForMe;
     msg->owner = COMPONENT_ICMPv6ECHO;
     switch (msg->l4_sourcePortORicmpv6Type) {
         case IANA_ICMPv6_ECHO_REQUEST:
@@ -119,15 +122,27 @@ void icmpv6echo_receive(OpenQueueEntry_t *msg) {
                 memcpy(reply->payload, msg->payload, msg->length);
                 // copy source of msg in destination of reply
                 memcpy(&(reply->l3_destinationAdd), &(msg->l3_sourceAdd), sizeof(open_addr_t));
+                // the reply is sent from the address the request went to
+                wasForMe = idmanager_isMyAddress(&(msg->l3_destinationAdd));
                 // free up msg
                 openqueue_freePacketBuffer(msg);
                 msg = NULL;
                 // administrative information for reply
                 reply->l4_protocol = IANA_ICMPv6;
                 reply->l4_sourcePortORicmpv6Type = IANA_ICMPv6_ECHO_REPLY;
+                oldType = ((ICMPv6_ht *) (reply->payload))->type;
                 ((ICMPv6_ht *) (reply->payload))->type = reply->l4_sourcePortORicmpv6Type;
-                packetfunctions_calculateChecksum(reply,
-                                                  (uint8_t * ) & (((ICMPv6_ht *) (reply->payload))->checksum));//do last
+                if (wasForMe) {
+                    // the pseudo header only has its addresses swapped, update the checksum for the new type
+                    packetfunctions_updateChecksum((uint8_t * ) & (((ICMPv6_ht *) (reply->payload))->checksum),
+                                                   &oldType,
+                                                   &(((ICMPv6_ht *) (reply->payload))->type),
+                                                   1);
+                } else {
+                    // the request went to a multicast or link-local address, the reply has another source
+                    packetfunctions_calculateChecksum(reply,
+                                                      (uint8_t * ) & (((ICMPv6_ht *) (reply->payload))->checksum));//do last
+                }
                 icmpv6echo_vars.busySending = TRUE;
                 if (icmpv6_send(reply) != E_SUCCESS) {
                     icmpv6echo_vars.busySending = FALSE;
@@ -13,11 +13,11 @@
 #include "IEEE802154_security.h"
 #include "schedule.h"
 #include "msf.h"
+#include "iphc.h"
 
 //=========================== definition ======================================
 
-#define DIO_PORTION 10
-#define DAO_PORTION 60
+#define DAO_STATS_PERIOD       (60000/(SLOTFRAME_LENGTH*SLOTDURATION)) // DAO timer periods in a minute
 
 //=========================== variables =======================================
 
@@ -28,11 +28,27 @@ icmpv6rpl_vars_t             icmpv6rpl_vars;
 // DIO-related
 void icmpv6rpl_timer_DIO_cb(opentimers_id_t id);
 void icmpv6rpl_timer_DIO_task(void);
-void sendDIO(void);
+void icmpv6rpl_resetDIOInterval(void);
+void icmpv6rpl_startDIOInterval(void);
+bool sendDIO(void);
+bool sendDIS(void);
 // DAO-related
 void icmpv6rpl_timer_DAO_cb(opentimers_id_t id);
 void icmpv6rpl_timer_DAO_task(void);
 void sendDAO(void);
+void icmpv6rpl_updateDAOStats(void);
+#ifdef RPL_STORING_MODE_ENABLED
+// routing-related
+void icmpv6rpl_indicateRxDAO(OpenQueueEntry_t* msg);
+void icmpv6rpl_relayDAO(uint8_t* options, uint8_t length);
+void icmpv6rpl_installRoute(uint8_t* target, uint8_t prefixLen, open_addr_t* nextHop, uint16_t lifetime);
+void icmpv6rpl_removeRoute(uint8_t* target, uint8_t prefixLen);
+void icmpv6rpl_ageRoutes(void);
+bool icmpv6rpl_matchRoute(icmpv6rpl_route_t* route, uint8_t* address);
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+void icmpv6rpl_aggregateRoute(icmpv6rpl_route_t* route);
+#endif
+#endif
 
 //=========================== public ==========================================
 
@@ -91,7 +107,6 @@ void icmpv6rpl_init(void) {
     icmpv6rpl_vars.dioDestination.type = ADDR_128B;
     memcpy(&icmpv6rpl_vars.dioDestination.addr_128b[0],all_routers_multicast,sizeof(all_routers_multicast));
 
-    icmpv6rpl_vars.dioPeriod                 = DIO_PERIOD;
     icmpv6rpl_vars.timerIdDIO                = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_RPL);
 
     //initialize PIO -> move this to dagroot code
@@ -119,9 +134,9 @@ void icmpv6rpl_init(void) {
     icmpv6rpl_vars.conf.type = RPL_OPTION_CONFIG;
     icmpv6rpl_vars.conf.optLen = 14;
     icmpv6rpl_vars.conf.flagsAPCS = DEFAULT_PATH_CONTROL_SIZE; //DEFAULT_PATH_CONTROL_SIZE = 0
-    icmpv6rpl_vars.conf.DIOIntDoubl = 8; //8 -> trickle period - max times it will double ~20min
-    icmpv6rpl_vars.conf.DIOIntMin = 12 ; // 12 ->  min trickle period -> 16s
-    icmpv6rpl_vars.conf.DIORedun = 0 ; // 0
+    icmpv6rpl_vars.conf.DIOIntDoubl = DIO_INTERVAL_DOUBLINGS; //8 -> trickle period - max times it will double ~17min
+    icmpv6rpl_vars.conf.DIOIntMin = DIO_INTERVAL_MIN; // 12 ->  min trickle period -> 4s
+    icmpv6rpl_vars.conf.DIORedun = DIO_REDUNDANCY;
     icmpv6rpl_vars.conf.maxRankIncrease = 2048; //  2048
     icmpv6rpl_vars.conf.minHopRankIncrease = 256 ; //256
     icmpv6rpl_vars.conf.OCP = 0; // 0 OF0
@@ -129,13 +144,7 @@ void icmpv6rpl_init(void) {
     icmpv6rpl_vars.conf.defLifetime = 0xff; //infinite - limit for DAO period  -> 0xff
     icmpv6rpl_vars.conf.lifetimeUnit = 0xffff; // 0xffff
 
-    opentimers_scheduleIn(
-        icmpv6rpl_vars.timerIdDIO,
-        SLOTFRAME_LENGTH*SLOTDURATION,
-        TIME_MS,
-        TIMER_PERIODIC,
-        icmpv6rpl_timer_DIO_cb
-    );
+    icmpv6rpl_resetDIOInterval();
 
     //=== DAO
 
@@ -169,14 +178,15 @@ void icmpv6rpl_init(void) {
                                                PC4_A_DAO_Transit_Info | \
                                                PC4_B_DAO_Transit_Info;
     icmpv6rpl_vars.dao_transit.PathSequence  = 0x00; // to be incremented at each TX
-    icmpv6rpl_vars.dao_transit.PathLifetime  = 0xAA;
+    icmpv6rpl_vars.dao_transit.PathLifetime  = DAO_PATH_LIFETIME;
     //target information
     icmpv6rpl_vars.dao_target.type  = OPTION_TARGET_INFORMATION_TYPE;
     icmpv6rpl_vars.dao_target.optionLength   = 0;
     icmpv6rpl_vars.dao_target.flags  = 0;
     icmpv6rpl_vars.dao_target.prefixLength   = 0;
 
-    icmpv6rpl_vars.daoPeriod                 = DAO_PERIOD;
+    // my first DAO goes out as soon as I have a parent
+    icmpv6rpl_vars.daoRefreshCounter         = 0;
     icmpv6rpl_vars.timerIdDAO                = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_RPL);
     opentimers_scheduleIn(
         icmpv6rpl_vars.timerIdDAO,
@@ -240,6 +250,10 @@ void icmpv6rpl_sendDone(OpenQueueEntry_t* msg, owerror_t error) {
         icmpv6rpl_vars.busySendingDIO = FALSE;
    } else {
         icmpv6rpl_vars.busySendingDAO = FALSE;
+        if (error!=E_SUCCESS) {
+            // my parent may not know about me, advertise all again
+            icmpv6rpl_vars.daoRefreshCounter = 0;
+        }
    }
 
    // free packet
@@ -266,7 +280,10 @@ void icmpv6rpl_receive(OpenQueueEntry_t* msg) {
    // handle message
    switch (icmpv6code) {
       case IANA_ICMPv6_RPL_DIS:
-         icmpv6rpl_timer_DIO_task();
+         // a neighbor looks for a DODAG, tell it about mine soon
+         if (icmpv6rpl_getMyDAGrank()!=DEFAULTDAGRANK) {
+            icmpv6rpl_resetDIOInterval();
+         }
          break;
       case IANA_ICMPv6_RPL_DIO:
          if (idmanager_getIsDAGroot()==TRUE) {
@@ -284,10 +301,15 @@ void icmpv6rpl_receive(OpenQueueEntry_t* msg) {
          break;
 
       case IANA_ICMPv6_RPL_DAO:
+#ifdef RPL_STORING_MODE_ENABLED
+         // learn the routes to the targets below that child
+         icmpv6rpl_indicateRxDAO(msg);
+#else
          // this should never happen
          openserial_printError(COMPONENT_ICMPv6RPL,ERR_UNEXPECTED_DAO,
                                (errorparameter_t)0,
                                (errorparameter_t)0);
+#endif
          break;
       default:
          // this should never happen
@@ -395,6 +417,7 @@ void icmpv6rpl_updateMyDAGrankAndParentSelection(void) {
         // the dagrank is not set through setting command, set rank to MINHOPRANKINCREASE here
         if (icmpv6rpl_vars.myDAGrank!=MINHOPRANKINCREASE) { // test for change so as not to report unchanged value when root
             icmpv6rpl_vars.myDAGrank=MINHOPRANKINCREASE;
+            icmpv6rpl_resetDIOInterval();
             return;
         }
     }
@@ -488,11 +511,22 @@ void icmpv6rpl_updateMyDAGrankAndParentSelection(void) {
             neighbors_getNeighborEui64(&newParent,ADDR_64B,icmpv6rpl_vars.ParentIndex);
             icmpv6rpl_updateNexthopAddress(&newParent);
 
+            // my children need to hear about my new rank
+            icmpv6rpl_resetDIOInterval();
+            // my parent needs to hear about me
+            icmpv6rpl_vars.daoRefreshCounter = 0;
 
         } else {
             if (icmpv6rpl_vars.ParentIndex==prevParentIndex) {
                 // report on the rank change if any, not on the deletion/creation of parent
                 if (icmpv6rpl_vars.myDAGrank!=previousDAGrank) {
+                    // small changes of the link cost don't make the network inconsistent
+                    if (
+                        icmpv6rpl_vars.myDAGrank>=previousDAGrank+MINHOPRANKINCREASE ||
+                        previousDAGrank>=icmpv6rpl_vars.myDAGrank+MINHOPRANKINCREASE
+                    ) {
+                        icmpv6rpl_resetDIOInterval();
+                    }
                 } else {
                     // same parent, same rank, nothing to report about
                 }
@@ -505,6 +539,10 @@ void icmpv6rpl_updateMyDAGrankAndParentSelection(void) {
                 // update the upstream traffic nexthop address to new parent
                 neighbors_getNeighborEui64(&newParent,ADDR_64B,icmpv6rpl_vars.ParentIndex);
                 icmpv6rpl_updateNexthopAddress(&newParent);
+
+                icmpv6rpl_resetDIOInterval();
+                // my new parent needs to learn the routes through me
+                icmpv6rpl_vars.daoRefreshCounter = 0;
             }
         }
     } else {
@@ -530,6 +568,7 @@ void icmpv6rpl_updateMyDAGrankAndParentSelection(void) {
 void icmpv6rpl_updateNexthopAddress(open_addr_t* newParent){
 
     openqueue_updateNextHopPayload(newParent);
+    iphc_flushCachedIPv6Headers();
 }
 
 /**
@@ -550,6 +589,8 @@ void icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg) {
    dagrank_t        neighborRank;
    open_addr_t      NeighborAddress;
    open_addr_t      myPrefix;
+   open_addr_t      contextPrefix;
+   icmpv6rpl_6co_ht* sixco;
    uint8_t*         current;
    uint8_t          optionsLen;
    // take ownership over the packet
@@ -600,10 +641,30 @@ void icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg) {
           icmpv6rpl_vars.incomingPio->prefix,
           sizeof(myPrefix.prefix)
         );
+        if (idmanager_isMyAddress(&myPrefix)==FALSE) {
+           // headers compressed for the former prefix are stale
+           iphc_flushCachedIPv6Headers();
+        }
         idmanager_setMyID(&myPrefix);
         optionsLen = optionsLen - current[1] - 2;
         current = current + current[1] + 2;
        break;
+     case RPL_OPTION_6CO:
+       // compression context, they are all distributed by the DAG root
+       sixco = (icmpv6rpl_6co_ht*)(current);
+       if (idmanager_getIsDAGroot()==FALSE && sixco->contextLen==RPL_6CO_CONTEXT_LEN) {
+          memset(&contextPrefix,0,sizeof(open_addr_t));
+          contextPrefix.type = ADDR_PREFIX;
+          memcpy(contextPrefix.prefix,sixco->prefix,sizeof(sixco->prefix));
+          iphc_setContext(
+             sixco->flagsCID & IPHC_CONTEXT_ID_MASK,
+             &contextPrefix,
+             (sixco->flagsCID & RPL_6CO_C_FLAG)!=0
+          );
+       }
+       optionsLen = optionsLen - current[1] - 2;
+       current = current + current[1] + 2;
+       break;
      default:
        //option not supported, just jump the len;
        optionsLen = optionsLen - current[1] - 2;
@@ -619,6 +680,16 @@ void icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg) {
    //update rank in DIO as well (which will be overwritten with my rank when send).
    icmpv6rpl_vars.dio.rank = icmpv6rpl_vars.incomingDio->rank;
 
+   // Trickle consistency: a DIO with a rank tells my neighbors what mine would,
+   // my parent losing its rank makes the DODAG inconsistent around me
+   if (icmpv6rpl_vars.incomingDio->rank!=DEFAULTDAGRANK) {
+      if (icmpv6rpl_vars.dioCounter<0xff) {
+         icmpv6rpl_vars.dioCounter++;
+      }
+   } else if (icmpv6rpl_isPreferredParent(&(msg->l2_nextORpreviousHop))) {
+      icmpv6rpl_resetDIOInterval();
+   }
+
    // update rank of that neighbor in table
    for (i=0;i<MAXNUMNEIGHBORS;i++) {
       if (neighbors_getNeighborEui64(&NeighborAddress, ADDR_64B, i)) { // this neighbor entry is in use
@@ -651,8 +722,40 @@ void icmpv6rpl_killPreferredParent(void) {
     } else {
        icmpv6rpl_vars.myDAGrank=DEFAULTDAGRANK;
     }
+    // look for a new parent with DIS right away
+    icmpv6rpl_resetDIOInterval();
 }
 
+#ifdef RPL_STORING_MODE_ENABLED
+/**
+\brief Find the child a destination is reached through.
+
+The routes are kept longest prefix first, so the first one matching is the
+longest prefix match.
+
+\param[in]  destination    The 128-bit IPv6 destination.
+\param[out] addressToWrite The EUI64 of the child, if a route was found.
+
+\returns TRUE if a route was found, FALSE otherwise.
+*/
+bool icmpv6rpl_getRouteNextHop(open_addr_t* destination, open_addr_t* addressToWrite) {
+    uint8_t i;
+
+    if (destination->type!=ADDR_128B) {
+        return FALSE;
+    }
+
+    for (i=0;i<icmpv6rpl_vars.numRoutes;i++) {
+        if (icmpv6rpl_matchRoute(&icmpv6rpl_vars.routes[i],destination->addr_128b)) {
+            addressToWrite->type = ADDR_64B;
+            memcpy(addressToWrite->addr_64b,icmpv6rpl_vars.routes[i].nextHop,8);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+#endif
+
 //=========================== private =========================================
 
 //===== DIO-related
@@ -668,24 +771,109 @@ void icmpv6rpl_timer_DIO_cb(opentimers_id_t id) {
 }
 
 /**
-\brief Handler for DIO timer event.
+\brief Handler for the Trickle timer of the DIOs (RFC6206).
+
+It fires twice per interval: at the transmission time t, when a DIO is sent
+unless k consistent ones were heard since the interval started, then at the
+end of the interval, which doubles it up to Imax. The interval only doubles
+once a DIO could be sent, a mote still waiting for a cell to its parent
+doesn't back off.
+
+Without a DAGrank there is no DIO to send, a DIS asks the neighbors for
+theirs instead.
 
 \note This function is executed in task context, called by the scheduler.
 */
 void icmpv6rpl_timer_DIO_task(void) {
+    uint32_t dioIntervalMax;
 
-    if(openrandom_get16b()<(0xffff/DIO_PORTION)){
-        sendDIO();
+    if (icmpv6rpl_vars.dioTxTimePassed==FALSE) {
+        if (
+            icmpv6rpl_vars.conf.DIORedun==0 ||
+            icmpv6rpl_vars.dioCounter<icmpv6rpl_vars.conf.DIORedun
+        ) {
+            if (icmpv6rpl_getMyDAGrank()==DEFAULTDAGRANK) {
+                icmpv6rpl_vars.dioTransmitted = sendDIS();
+            } else {
+                icmpv6rpl_vars.dioTransmitted = sendDIO();
+            }
+        } else {
+            // suppressed, my neighbors heard enough DIOs
+            icmpv6rpl_vars.dioTransmitted = TRUE;
+        }
+        icmpv6rpl_vars.dioTxTimePassed = TRUE;
+        opentimers_scheduleIn(
+            icmpv6rpl_vars.timerIdDIO,
+            icmpv6rpl_vars.dioIntervalRest,
+            TIME_MS,
+            TIMER_ONESHOT,
+            icmpv6rpl_timer_DIO_cb
+        );
+    } else {
+        dioIntervalMax = ((uint32_t)1<<icmpv6rpl_vars.conf.DIOIntMin)<<icmpv6rpl_vars.conf.DIOIntDoubl;
+        if (icmpv6rpl_vars.dioTransmitted) {
+            if (icmpv6rpl_vars.dioInterval<dioIntervalMax/2) {
+                icmpv6rpl_vars.dioInterval *= 2;
+            } else {
+                icmpv6rpl_vars.dioInterval  = dioIntervalMax;
+            }
+        }
+        icmpv6rpl_startDIOInterval();
+    }
+}
+
+/**
+\brief Go back to the smallest Trickle interval, after an inconsistency.
+
+Nothing changes if the interval is already Imin, as per RFC6206.
+*/
+void icmpv6rpl_resetDIOInterval(void) {
+    uint32_t dioIntervalMin;
+
+    dioIntervalMin = (uint32_t)1<<icmpv6rpl_vars.conf.DIOIntMin;
+    if (
+        icmpv6rpl_vars.dioInterval==dioIntervalMin &&
+        opentimers_isRunning(icmpv6rpl_vars.timerIdDIO)
+    ) {
+        return;
     }
+    icmpv6rpl_vars.dioInterval = dioIntervalMin;
+    icmpv6rpl_startDIOInterval();
+}
+
+/**
+\brief Start a Trickle interval, with t picked at random in [I/2,I).
+*/
+void icmpv6rpl_startDIOInterval(void) {
+    uint32_t txTime;
+
+    txTime  = icmpv6rpl_vars.dioInterval/2;
+    txTime += ((icmpv6rpl_vars.dioInterval/2)>>8)*(openrandom_get16b()>>8);
+
+    icmpv6rpl_vars.dioCounter      = 0;
+    icmpv6rpl_vars.dioTxTimePassed = FALSE;
+    icmpv6rpl_vars.dioIntervalRest = icmpv6rpl_vars.dioInterval-txTime;
+    opentimers_scheduleIn(
+        icmpv6rpl_vars.timerIdDIO,
+        txTime,
+        TIME_MS,
+        TIMER_ONESHOT,
+        icmpv6rpl_timer_DIO_cb
+    );
 }
 
 /**
 \brief Prepare and a send a RPL DIO.
+
+\returns TRUE if the DIO is on its way, FALSE if I'm not ready to send one.
 */
-void sendDIO(void) {
+bool sendDIO(void) {
 
     OpenQueueEntry_t*    msg;
     open_addr_t addressToWrite;
+    iphc_context_t*      context;
+    icmpv6rpl_6co_ht*    sixco;
+    uint8_t              i;
 
     memset(&addressToWrite,0,sizeof(open_addr_t));
 
@@ -700,12 +888,12 @@ void sendDIO(void) {
         icmpv6rpl_vars.busySendingDAO  = FALSE;
 
         // stop here
-        return;
+        return FALSE;
     }
 
     // do not send DIO if I have the default DAG rank
     if (icmpv6rpl_getMyDAGrank()==DEFAULTDAGRANK) {
-      return;
+      return FALSE;
     }
 
     if (
@@ -725,7 +913,7 @@ void sendDIO(void) {
         icmpv6rpl_vars.busySendingDIO  = FALSE;
         icmpv6rpl_vars.busySendingDAO  = FALSE;
 
-        return;
+        return FALSE;
     }
 
     // if you get here, all good to send a DIO
@@ -737,7 +925,7 @@ void sendDIO(void) {
                             (errorparameter_t)0,
                             (errorparameter_t)0);
 
-        return;
+        return FALSE;
     }
 
     // take ownership
@@ -752,20 +940,45 @@ void sendDIO(void) {
     // set DIO destination
     memcpy(&(msg->l3_destinationAdd),&icmpv6rpl_vars.dioDestination,sizeof(open_addr_t));
 
-    //===== Configuration option
-    packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_config_ht));
+    //===== 6LoWPAN context option
+    // a DIO with both a context and the configuration option takes two
+    // broadcast fragments, and either one lost drops it: every other DIO
+    // carries one context, in turn, instead of the configuration option
+    context = NULL;
+    icmpv6rpl_vars.dioWithContext = (icmpv6rpl_vars.dioWithContext==FALSE);
+    for (i=0;i<IPHC_MAXNUM_CONTEXTS && context==NULL && icmpv6rpl_vars.dioWithContext;i++) {
+        icmpv6rpl_vars.contextIdx = (icmpv6rpl_vars.contextIdx+1)%IPHC_MAXNUM_CONTEXTS;
+        context = iphc_getContext(icmpv6rpl_vars.contextIdx);
+    }
 
-   //copy the PIO in the packet
-    memcpy(
-       ((icmpv6rpl_config_ht*)(msg->payload)),
-       &(icmpv6rpl_vars.conf),
-       sizeof(icmpv6rpl_config_ht)
-    );
+    if (context!=NULL) {
+        packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_6co_ht));
+        sixco = (icmpv6rpl_6co_ht*)(msg->payload);
+        sixco->type       = RPL_OPTION_6CO;
+        sixco->optLen     = sizeof(icmpv6rpl_6co_ht)-2;
+        sixco->contextLen = RPL_6CO_CONTEXT_LEN;
+        sixco->flagsCID   = context->cid;
+        if (context->compress) {
+            sixco->flagsCID |= RPL_6CO_C_FLAG;
+        }
+        sixco->reserved   = 0;
+        sixco->lifetime   = 0xffff;
+        memcpy(sixco->prefix,context->prefix.prefix,sizeof(sixco->prefix));
+    } else {
+        //===== Configuration option
+        packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_config_ht));
+
+        memcpy(
+           ((icmpv6rpl_config_ht*)(msg->payload)),
+           &(icmpv6rpl_vars.conf),
+           sizeof(icmpv6rpl_config_ht)
+        );
 
-    ((icmpv6rpl_config_ht*)(msg->payload))->maxRankIncrease    = (icmpv6rpl_vars.conf.maxRankIncrease << 8)     | (icmpv6rpl_vars.conf.maxRankIncrease >>8); //  2048
-    ((icmpv6rpl_config_ht*)(msg->payload))->minHopRankIncrease = (icmpv6rpl_vars.conf.minHopRankIncrease << 8)  | (icmpv6rpl_vars.conf.minHopRankIncrease >>8); //256
-    ((icmpv6rpl_config_ht*)(msg->payload))->OCP                = (icmpv6rpl_vars.conf.OCP << 8)                 | (icmpv6rpl_vars.conf.OCP >>8); // 0 OF0
-    ((icmpv6rpl_config_ht*)(msg->payload))->lifetimeUnit       = (icmpv6rpl_vars.conf.lifetimeUnit << 8)        | (icmpv6rpl_vars.conf.lifetimeUnit >>8); // 0xffff
+        ((icmpv6rpl_config_ht*)(msg->payload))->maxRankIncrease    = (icmpv6rpl_vars.conf.maxRankIncrease << 8)     | (icmpv6rpl_vars.conf.maxRankIncrease >>8); //  2048
+        ((icmpv6rpl_config_ht*)(msg->payload))->minHopRankIncrease = (icmpv6rpl_vars.conf.minHopRankIncrease << 8)  | (icmpv6rpl_vars.conf.minHopRankIncrease >>8); //256
+        ((icmpv6rpl_config_ht*)(msg->payload))->OCP                = (icmpv6rpl_vars.conf.OCP << 8)                 | (icmpv6rpl_vars.conf.OCP >>8); // 0 OF0
+        ((icmpv6rpl_config_ht*)(msg->payload))->lifetimeUnit       = (icmpv6rpl_vars.conf.lifetimeUnit << 8)        | (icmpv6rpl_vars.conf.lifetimeUnit >>8); // 0xffff
+    }
 
     //===== PIO payload
 
@@ -816,9 +1029,65 @@ void sendDIO(void) {
     //send
     if (icmpv6_send(msg)==E_SUCCESS) {
         icmpv6rpl_vars.busySendingDIO = TRUE;
-    } else {
-        openqueue_freePacketBuffer(msg);
+        return TRUE;
     }
+    openqueue_freePacketBuffer(msg);
+    return FALSE;
+}
+
+/**
+\brief Prepare and send a multicast RPL DIS, to hear about a DODAG sooner.
+
+\returns TRUE if the DIS is on its way, FALSE if I'm not ready to send one.
+*/
+bool sendDIS(void) {
+    OpenQueueEntry_t*    msg;
+
+    if (
+        ieee154e_isSynch()==FALSE                    ||
+        idmanager_getIsDAGroot()==TRUE               ||
+        IEEE802154_security_isConfigured()==FALSE
+    ) {
+        return FALSE;
+    }
+
+    msg = openqueue_getFreePacketBuffer(COMPONENT_ICMPv6RPL);
+    if (msg==NULL) {
+        openserial_printError(COMPONENT_ICMPv6RPL,ERR_NO_FREE_PACKET_BUFFER,
+                            (errorparameter_t)2,
+                            (errorparameter_t)0);
+        return FALSE;
+    }
+
+    // take ownership
+    msg->creator                             = COMPONENT_ICMPv6RPL;
+    msg->owner                               = COMPONENT_ICMPv6RPL;
+
+    // set transport information
+    msg->l4_protocol                         = IANA_ICMPv6;
+    msg->l4_protocol_compressed              = FALSE;
+    msg->l4_sourcePortORicmpv6Type           = IANA_ICMPv6_RPL;
+
+    // the DIS goes where the DIOs go
+    memcpy(&(msg->l3_destinationAdd),&icmpv6rpl_vars.dioDestination,sizeof(open_addr_t));
+
+    //===== DIS payload
+    packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_dis_ht));
+    ((icmpv6rpl_dis_ht*)(msg->payload))->flags    = 0;
+    ((icmpv6rpl_dis_ht*)(msg->payload))->reserved = 0;
+
+    //===== ICMPv6 header
+    packetfunctions_reserveHeaderSize(msg,sizeof(ICMPv6_ht));
+    ((ICMPv6_ht*)(msg->payload))->type       = msg->l4_sourcePortORicmpv6Type;
+    ((ICMPv6_ht*)(msg->payload))->code       = IANA_ICMPv6_RPL_DIS;
+    packetfunctions_calculateChecksum(msg,(uint8_t*)&(((ICMPv6_ht*)(msg->payload))->checksum));
+
+    if (icmpv6_send(msg)==E_SUCCESS) {
+        icmpv6rpl_vars.busySendingDIO = TRUE;
+        return TRUE;
+    }
+    openqueue_freePacketBuffer(msg);
+    return FALSE;
 }
 
 //===== DAO-related
@@ -840,18 +1109,82 @@ void icmpv6rpl_timer_DAO_cb(opentimers_id_t id) {
 \note This function is executed in task context, called by the scheduler.
 */
 void icmpv6rpl_timer_DAO_task(void) {
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+    uint8_t i;
+#endif
+
+#ifdef RPL_STORING_MODE_ENABLED
+    icmpv6rpl_ageRoutes();
+#endif
+    icmpv6rpl_updateDAOStats();
+
+    // refresh my DAO halfway through its lifetime, or after a parent change
+    if (icmpv6rpl_vars.daoRefreshCounter>0) {
+        icmpv6rpl_vars.daoRefreshCounter--;
+    }
+    if (icmpv6rpl_vars.daoRefreshCounter==0) {
+        icmpv6rpl_vars.daoRefreshCounter = ((uint16_t)icmpv6rpl_vars.dao_transit.PathLifetime*RPL_LIFETIME_UNIT)/2;
+        icmpv6rpl_vars.daoPending        = TRUE;
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+        for (i=0;i<icmpv6rpl_vars.numRoutes;i++) {
+            icmpv6rpl_vars.routes[i].daoPending = TRUE;
+        }
+#endif
+    }
 
-    if(openrandom_get16b()<(0xffff/DAO_PORTION)){
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+    // give my other children a chance to be in the same DAO
+    if (icmpv6rpl_vars.daoHoldCounter>0) {
+        icmpv6rpl_vars.daoHoldCounter--;
+        return;
+    }
+#endif
+
+    // a DAO that could not be sent is tried again next period
+    if (icmpv6rpl_vars.daoPending==TRUE) {
         sendDAO();
     }
 }
 
+/**
+\brief Count a DAO timer period, and report the DAO bytes of the minute gone.
+*/
+void icmpv6rpl_updateDAOStats(void) {
+
+    icmpv6rpl_vars.daoStats.numTicks++;
+    if (icmpv6rpl_vars.daoStats.numTicks<DAO_STATS_PERIOD) {
+        return;
+    }
+
+    if (icmpv6rpl_vars.daoStats.bytesSent>0 || icmpv6rpl_vars.daoStats.bytesRelayed>0) {
+        openserial_printInfo(COMPONENT_ICMPv6RPL,ERR_DAO_BYTES,
+                            (errorparameter_t)icmpv6rpl_vars.daoStats.bytesSent,
+                            (errorparameter_t)icmpv6rpl_vars.daoStats.bytesRelayed);
+    }
+    icmpv6rpl_vars.daoStats.totalBytes      += icmpv6rpl_vars.daoStats.bytesSent+icmpv6rpl_vars.daoStats.bytesRelayed;
+    icmpv6rpl_vars.daoStats.numMinutes++;
+    icmpv6rpl_vars.daoStats.bytesSent        = 0;
+    icmpv6rpl_vars.daoStats.bytesRelayed     = 0;
+    icmpv6rpl_vars.daoStats.numTicks         = 0;
+}
+
 /**
 \brief Prepare and a send a RPL DAO.
+
+With DAO aggregation, the DAO also carries the targets of my children which
+are pending, up to RPL_DAO_MAXNUMTARGETS, the others go in the next DAO.
 */
 void sendDAO(void) {
     OpenQueueEntry_t*    msg;                // pointer to DAO messages
+#ifndef RPL_STORING_MODE_ENABLED
     uint8_t              nbrIdx;             // running neighbor index
+#endif
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+    uint8_t              routeIdx[RPL_DAO_MAXNUMTARGETS];
+    uint8_t              numAggregated;
+    uint8_t              prefixBytes;
+    uint8_t              i;
+#endif
     uint8_t              numTransitParents,numTargetParents;  // the number of parents indicated in transit option
     open_addr_t          address;
     open_addr_t*         prefix;
@@ -926,8 +1259,14 @@ void sendDAO(void) {
     msg->l4_sourcePortORicmpv6Type           = IANA_ICMPv6_RPL;
 
     // set DAO destination
+#ifdef RPL_STORING_MODE_ENABLED
+    // in storing mode the DAO goes to my parent, which relays it up
+    icmpv6rpl_getPreferredParentEui64(&address);
+    packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX),&address,&(msg->l3_destinationAdd));
+#else
     msg->l3_destinationAdd.type=ADDR_128B;
     memcpy(msg->l3_destinationAdd.addr_128b,icmpv6rpl_vars.dio.DODAGID,sizeof(icmpv6rpl_vars.dio.DODAGID));
+#endif
 
     //===== fill in packet
 
@@ -936,6 +1275,10 @@ void sendDAO(void) {
     //=== transit option -- from RFC 6550, page 55 - 1 transit information header per parent is required.
     //getting only preferred parent as transit
     numTransitParents=0;
+#ifdef RPL_STORING_MODE_ENABLED
+    // in storing mode the transit option carries no parent address
+    icmpv6rpl_vars.dao_transit.optionLength  = sizeof(icmpv6rpl_dao_transit_ht)-2;
+#else
     icmpv6rpl_getPreferredParentEui64(&address);
     packetfunctions_writeAddress(msg,&address,OW_BIG_ENDIAN);
     prefix=idmanager_getMyID(ADDR_PREFIX);
@@ -945,6 +1288,7 @@ void sendDAO(void) {
     // poipoi xv: it is not very clear if this includes all fields in the header. or as target info 2 bytes are removed.
     // using the same pattern as in target information.
     icmpv6rpl_vars.dao_transit.optionLength  = LENGTH_ADDR128b + sizeof(icmpv6rpl_dao_transit_ht)-2;
+#endif
     icmpv6rpl_vars.dao_transit.PathControl=0; //todo. this is to set the preference of this parent.
     icmpv6rpl_vars.dao_transit.type=OPTION_TRANSIT_INFORMATION_TYPE;
 
@@ -963,6 +1307,47 @@ void sendDAO(void) {
     more RPL Target options.
     */
     numTargetParents                        = 0;
+#ifdef RPL_STORING_MODE_ENABLED
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+    // the targets I learnt from my children, which my parent must hear about
+    numAggregated = 0;
+    for (i=0;i<icmpv6rpl_vars.numRoutes && numAggregated<RPL_DAO_MAXNUMTARGETS-1;i++) {
+        if (icmpv6rpl_vars.routes[i].daoPending==FALSE) {
+            continue;
+        }
+        prefixBytes = (icmpv6rpl_vars.routes[i].prefixLen+7)/8;
+        packetfunctions_reserveHeaderSize(msg,prefixBytes);
+        memcpy(msg->payload,icmpv6rpl_vars.routes[i].target,prefixBytes);
+        icmpv6rpl_vars.dao_target.optionLength  = prefixBytes+sizeof(icmpv6rpl_dao_target_ht)-2;
+        icmpv6rpl_vars.dao_target.type  = OPTION_TARGET_INFORMATION_TYPE;
+        icmpv6rpl_vars.dao_target.flags  = 0;
+        icmpv6rpl_vars.dao_target.prefixLength = icmpv6rpl_vars.routes[i].prefixLen;
+        packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_dao_target_ht));
+        memcpy(
+            ((icmpv6rpl_dao_target_ht*)(msg->payload)),
+            &(icmpv6rpl_vars.dao_target),
+            sizeof(icmpv6rpl_dao_target_ht)
+        );
+        routeIdx[numAggregated++] = i;
+    }
+#endif
+    // in storing mode I am the target, the routes to my children reach my
+    // parent through the DAOs I relay for them
+    packetfunctions_writeAddress(msg,idmanager_getMyID(ADDR_64B),OW_BIG_ENDIAN);
+    prefix=idmanager_getMyID(ADDR_PREFIX);
+    packetfunctions_writeAddress(msg,prefix,OW_BIG_ENDIAN);
+    icmpv6rpl_vars.dao_target.optionLength  = LENGTH_ADDR128b +sizeof(icmpv6rpl_dao_target_ht) - 2;
+    icmpv6rpl_vars.dao_target.type  = OPTION_TARGET_INFORMATION_TYPE;
+    icmpv6rpl_vars.dao_target.flags  = 0;
+    icmpv6rpl_vars.dao_target.prefixLength = 128;
+    packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_dao_target_ht));
+    memcpy(
+        ((icmpv6rpl_dao_target_ht*)(msg->payload)),
+        &(icmpv6rpl_vars.dao_target),
+        sizeof(icmpv6rpl_dao_target_ht)
+    );
+    numTargetParents++;
+#else
     for (nbrIdx=0;nbrIdx<MAXNUMNEIGHBORS;nbrIdx++) {
         if ((neighbors_isNeighborWithHigherDAGrank(nbrIdx))==TRUE) {
             // this neighbor is of higher DAGrank as I am. so it is my child
@@ -997,6 +1382,7 @@ void sendDAO(void) {
         // poipoi TODO base selection on ETX rather than first X.
         if (numTargetParents>=MAX_TARGET_PARENTS) break;
     }
+#endif
 
 
     // stop here if no parents found
@@ -1028,19 +1414,352 @@ void sendDAO(void) {
     if (icmpv6_send(msg)==E_SUCCESS) {
         icmpv6rpl_vars.busySendingDAO = TRUE;
         icmpv6rpl_vars.daoSent = TRUE;
+        icmpv6rpl_vars.daoPending = FALSE;
+        icmpv6rpl_vars.daoStats.bytesSent += msg->length;
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+        for (i=0;i<numAggregated;i++) {
+            icmpv6rpl_vars.routes[routeIdx[i]].daoPending = FALSE;
+        }
+        // the targets which did not fit go in the next DAO
+        for (i=0;i<icmpv6rpl_vars.numRoutes;i++) {
+            if (icmpv6rpl_vars.routes[i].daoPending==TRUE) {
+                icmpv6rpl_vars.daoPending = TRUE;
+            }
+        }
+#endif
+    } else {
+        openqueue_freePacketBuffer(msg);
+    }
+}
+
+#ifdef RPL_STORING_MODE_ENABLED
+//===== routing-related
+
+/**
+\brief Learn the routes carried by a DAO a child sent me, and relay it up.
+
+The targets take the lifetime of the transit option, in units of
+RPL_LIFETIME_UNIT DAO timer periods. A lifetime of 0 is a No-Path DAO and
+removes the routes.
+
+\param[in] msg The received message with msg->payload pointing to the DAO
+   header.
+*/
+void icmpv6rpl_indicateRxDAO(OpenQueueEntry_t* msg) {
+    icmpv6rpl_dao_ht*         dao;
+    icmpv6rpl_dao_target_ht*  target;
+    uint8_t*                  options;
+    uint8_t                   length;
+    uint8_t                   optionLen;
+    uint8_t                   lifetime;
+    uint8_t                   i;
+
+    if (msg->length<(int16_t)sizeof(icmpv6rpl_dao_ht)) {
+        return;
+    }
+    dao = (icmpv6rpl_dao_ht*)(msg->payload);
+    if (dao->rplinstanceId!=icmpv6rpl_vars.dao.rplinstanceId) {
+        return;
+    }
+
+    // a DAO from my parent would make a loop
+    if (icmpv6rpl_isPreferredParent(&(msg->l2_nextORpreviousHop))) {
+        return;
+    }
+
+    // options I could not relay in a single DAO are dropped, rather than truncated
+    if (msg->length-(int16_t)sizeof(icmpv6rpl_dao_ht)>0xff) {
+        return;
+    }
+    options = msg->payload+sizeof(icmpv6rpl_dao_ht);
+    length  = (uint8_t)(msg->length-sizeof(icmpv6rpl_dao_ht));
+
+    // find the path lifetime
+    lifetime = 0;
+    for (i=0;i+2<=length;i+=optionLen) {
+        optionLen = (options[i]==0)?1:options[i+1]+2; // Pad1 has no length
+        if (i+optionLen>length) {
+            return;
+        }
+        if (
+            options[i]==OPTION_TRANSIT_INFORMATION_TYPE &&
+            optionLen>=sizeof(icmpv6rpl_dao_transit_ht)
+        ) {
+            lifetime = ((icmpv6rpl_dao_transit_ht*)(&options[i]))->PathLifetime;
+        }
+    }
+
+    // install or remove the route to each target
+    for (i=0;i+2<=length;i+=optionLen) {
+        optionLen = (options[i]==0)?1:options[i+1]+2;
+        if (options[i]!=OPTION_TARGET_INFORMATION_TYPE) {
+            continue;
+        }
+        target = (icmpv6rpl_dao_target_ht*)(&options[i]);
+        if (
+            target->prefixLength>128 ||
+            optionLen<sizeof(icmpv6rpl_dao_target_ht)+(target->prefixLength+7)/8
+        ) {
+            continue;
+        }
+        if (lifetime==0) {
+            icmpv6rpl_removeRoute(&options[i+sizeof(icmpv6rpl_dao_target_ht)],target->prefixLength);
+        } else {
+            icmpv6rpl_installRoute(
+                &options[i+sizeof(icmpv6rpl_dao_target_ht)],
+                target->prefixLength,
+                &(msg->l2_nextORpreviousHop),
+                (uint16_t)lifetime*RPL_LIFETIME_UNIT
+            );
+        }
+    }
+
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+    // a No-Path goes up right away, new routes go in my next DAO and a
+    // refresh stops here, my own DAOs refresh the routes through me
+    if (lifetime==0) {
+        icmpv6rpl_relayDAO(options,length);
+    }
+#else
+    icmpv6rpl_relayDAO(options,length);
+#endif
+}
+
+/**
+\brief Send the options of a DAO received from a child to my parent.
+
+\param[in] options The target and transit options of the DAO.
+\param[in] length  The length of the options.
+*/
+void icmpv6rpl_relayDAO(uint8_t* options, uint8_t length) {
+    OpenQueueEntry_t*    msg;
+    open_addr_t          parent;
+
+    if (icmpv6rpl_getPreferredParentEui64(&parent)==FALSE) {
+        return;
+    }
+
+    // the relayed DAO is freed by forwarding once sent, it is not my own DAO
+    msg = openqueue_getFreePacketBuffer(COMPONENT_FORWARDING);
+    if (msg==NULL) {
+        openserial_printError(COMPONENT_ICMPv6RPL,ERR_NO_FREE_PACKET_BUFFER,
+                            (errorparameter_t)1,
+                            (errorparameter_t)0);
+        return;
+    }
+    msg->creator                             = COMPONENT_FORWARDING;
+    msg->owner                               = COMPONENT_ICMPv6RPL;
+    msg->l4_protocol                         = IANA_ICMPv6;
+    msg->l4_sourcePortORicmpv6Type           = IANA_ICMPv6_RPL;
+    packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX),&parent,&(msg->l3_destinationAdd));
+
+    //=== target and transit options, as received
+    packetfunctions_reserveHeaderSize(msg,length);
+    memcpy(msg->payload,options,length);
+
+    //=== DAO header
+    packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_dao_ht));
+    icmpv6rpl_vars.dao.DAOSequence++;
+    memcpy(
+        ((icmpv6rpl_dao_ht*)(msg->payload)),
+        &(icmpv6rpl_vars.dao),
+        sizeof(icmpv6rpl_dao_ht)
+    );
+
+    //=== ICMPv6 header
+    packetfunctions_reserveHeaderSize(msg,sizeof(ICMPv6_ht));
+    ((ICMPv6_ht*)(msg->payload))->type       = msg->l4_sourcePortORicmpv6Type;
+    ((ICMPv6_ht*)(msg->payload))->code       = IANA_ICMPv6_RPL_DAO;
+    packetfunctions_calculateChecksum(msg,(uint8_t*)&(((ICMPv6_ht*)(msg->payload))->checksum));
+
+    if (icmpv6_send(msg)==E_SUCCESS) {
+        icmpv6rpl_vars.daoStats.bytesRelayed += msg->length;
     } else {
         openqueue_freePacketBuffer(msg);
     }
 }
 
+/**
+\brief Add or refresh the route to a target.
+
+The table is kept sorted longest prefix first.
+
+\param[in] target    The target prefix, (prefixLen+7)/8 bytes long.
+\param[in] prefixLen The length of the prefix, in bits.
+\param[in] nextHop   The child the target is reached through.
+\param[in] lifetime  The lifetime of the route, in DAO timer periods.
+
+With DAO aggregation, a route which is new or goes through another child is
+advertised in my next DAO, a little later to give the other changes from my
+children a chance to be in the same DAO.
+*/
+void icmpv6rpl_installRoute(uint8_t* target, uint8_t prefixLen, open_addr_t* nextHop, uint16_t lifetime) {
+    icmpv6rpl_route_t    route;
+    uint8_t              i;
+
+    if (nextHop->type!=ADDR_64B) {
+        return;
+    }
+
+    memset(&route,0,sizeof(icmpv6rpl_route_t));
+    memcpy(route.target,target,(prefixLen+7)/8);
+    if (prefixLen%8!=0) {
+        route.target[prefixLen/8] &= (uint8_t)(0xff<<(8-prefixLen%8));
+    }
+    route.prefixLen = prefixLen;
+    memcpy(route.nextHop,nextHop->addr_64b,8);
+    route.lifetime  = lifetime;
+
+    // refresh the route if I already have it, the child may have changed
+    for (i=0;i<icmpv6rpl_vars.numRoutes;i++) {
+        if (
+            icmpv6rpl_vars.routes[i].prefixLen==prefixLen &&
+            memcmp(icmpv6rpl_vars.routes[i].target,route.target,sizeof(route.target))==0
+        ) {
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+            route.daoPending = icmpv6rpl_vars.routes[i].daoPending;
+            if (memcmp(icmpv6rpl_vars.routes[i].nextHop,route.nextHop,sizeof(route.nextHop))!=0) {
+                icmpv6rpl_aggregateRoute(&route);
+            }
+#endif
+            memcpy(&icmpv6rpl_vars.routes[i],&route,sizeof(icmpv6rpl_route_t));
+            return;
+        }
+    }
+
+    if (icmpv6rpl_vars.numRoutes==RPL_MAXNUMROUTES) {
+        openserial_printError(COMPONENT_ICMPv6RPL,ERR_ROUTING_TABLE_FULL,
+                            (errorparameter_t)route.target[14],
+                            (errorparameter_t)route.target[15]);
+        return;
+    }
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+    icmpv6rpl_aggregateRoute(&route);
+#endif
+
+    // shift the shorter prefixes down to make room
+    for (i=icmpv6rpl_vars.numRoutes;i>0 && icmpv6rpl_vars.routes[i-1].prefixLen<prefixLen;i--) {
+        memcpy(&icmpv6rpl_vars.routes[i],&icmpv6rpl_vars.routes[i-1],sizeof(icmpv6rpl_route_t));
+    }
+    memcpy(&icmpv6rpl_vars.routes[i],&route,sizeof(icmpv6rpl_route_t));
+    icmpv6rpl_vars.numRoutes++;
+}
+
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+/**
+\brief Put a route in my next DAO, and hold that DAO for more changes.
+*/
+void icmpv6rpl_aggregateRoute(icmpv6rpl_route_t* route) {
+
+    route->daoPending = TRUE;
+    if (icmpv6rpl_vars.daoPending==FALSE) {
+        icmpv6rpl_vars.daoPending     = TRUE;
+        icmpv6rpl_vars.daoHoldCounter = RPL_DAO_AGGREGATION_DELAY;
+    }
+}
+#endif
+
+/**
+\brief Remove the route to a target, after a No-Path DAO.
+*/
+void icmpv6rpl_removeRoute(uint8_t* target, uint8_t prefixLen) {
+    uint8_t i;
+
+    for (i=0;i<icmpv6rpl_vars.numRoutes;i++) {
+        if (
+            icmpv6rpl_vars.routes[i].prefixLen==prefixLen &&
+            icmpv6rpl_matchRoute(&icmpv6rpl_vars.routes[i],target)
+        ) {
+            break;
+        }
+    }
+    if (i==icmpv6rpl_vars.numRoutes) {
+        return;
+    }
+
+    icmpv6rpl_vars.numRoutes--;
+    for (;i<icmpv6rpl_vars.numRoutes;i++) {
+        memcpy(&icmpv6rpl_vars.routes[i],&icmpv6rpl_vars.routes[i+1],sizeof(icmpv6rpl_route_t));
+    }
+}
+
+/**
+\brief Age the routes by one DAO timer period, removing the expired ones.
+*/
+void icmpv6rpl_ageRoutes(void) {
+    uint8_t i;
+    uint8_t j;
+
+    j = 0;
+    for (i=0;i<icmpv6rpl_vars.numRoutes;i++) {
+        icmpv6rpl_vars.routes[i].lifetime--;
+        if (icmpv6rpl_vars.routes[i].lifetime>0) {
+            if (i!=j) {
+                memcpy(&icmpv6rpl_vars.routes[j],&icmpv6rpl_vars.routes[i],sizeof(icmpv6rpl_route_t));
+            }
+            j++;
+        }
+    }
+    icmpv6rpl_vars.numRoutes = j;
+}
+
+/**
+\brief Tell whether an address is covered by the prefix of a route.
+*/
+bool icmpv6rpl_matchRoute(icmpv6rpl_route_t* route, uint8_t* address) {
+    uint8_t numBytes;
+    uint8_t numBits;
+
+    numBytes = route->prefixLen/8;
+    numBits  = route->prefixLen%8;
+    if (memcmp(route->target,address,numBytes)!=0) {
+        return FALSE;
+    }
+    if (numBits==0) {
+        return TRUE;
+    }
+    return (address[numBytes]&(uint8_t)(0xff<<(8-numBits)))==route->target[numBytes];
+}
+#endif
+
+/**
+\brief Set the smallest Trickle interval of the DIOs.
+
+\param[in] dioPeriod Imin, in ms, rounded down to a power of 2.
+*/
 void icmpv6rpl_setDIOPeriod(uint16_t dioPeriod){
-    // convert to seconds
-    icmpv6rpl_vars.dioPeriod = dioPeriod/1000;
+    uint8_t dioIntervalMin;
+
+    dioIntervalMin = 0;
+    while (dioPeriod>1) {
+        dioPeriod >>= 1;
+        dioIntervalMin++;
+    }
+    icmpv6rpl_vars.conf.DIOIntMin = dioIntervalMin;
+    icmpv6rpl_resetDIOInterval();
 }
 
+/**
+\brief Set how often my DAO is refreshed.
+
+The path lifetime advertised in my DAOs is twice that period.
+
+\param[in] daoPeriod The refresh period, in ms.
+*/
 void icmpv6rpl_setDAOPeriod(uint16_t daoPeriod){
-    // convert to seconds
-    icmpv6rpl_vars.daoPeriod = daoPeriod/1000;
+    uint32_t lifetime;
+
+    lifetime = (2*(uint32_t)daoPeriod)/(RPL_LIFETIME_UNIT*SLOTFRAME_LENGTH*SLOTDURATION);
+    if (lifetime==0) {
+        lifetime = 1;
+    }
+    if (lifetime>0xff) {
+        lifetime = 0xff;
+    }
+    icmpv6rpl_vars.dao_transit.PathLifetime = (uint8_t)lifetime;
+    if (icmpv6rpl_vars.daoRefreshCounter>(lifetime*RPL_LIFETIME_UNIT)/2) {
+        icmpv6rpl_vars.daoRefreshCounter = (uint16_t)((lifetime*RPL_LIFETIME_UNIT)/2);
+    }
 }
 
 bool icmpv6rpl_daoSent(void) {
@@ -12,13 +12,24 @@
 
 //=========================== define ==========================================
 
-#define DIO_PERIOD             10000   // in miliseconds
-#define DAO_PERIOD             60000   // in miliseconds
-
+// Trickle parameters of the DIOs, advertised by the DAG root (RFC6550 section 8.3)
+#define DIO_INTERVAL_MIN       12      // Imin is 2^12 ms, about 4s
+#define DIO_INTERVAL_DOUBLINGS 8       // Imax is Imin*2^8, about 17min
+#define DIO_REDUNDANCY         3       // k, 0 never suppresses a DIO
+#define DAO_PATH_LIFETIME      0xAA    // in lifetime units, my DAO is refreshed at half of it
+#define RPL_LIFETIME_UNIT      4       // DAO timer periods per unit of DAO path lifetime
+
+#ifdef RPL_STORING_MODE_ENABLED
+// Storing Mode of Operation with no multicast support (2)
+#define MOP_DIO_A                 0<<5
+#define MOP_DIO_B                 1<<4
+#define MOP_DIO_C                 0<<3
+#else
 // Non-Storing Mode of Operation (1)
 #define MOP_DIO_A                 0<<5
 #define MOP_DIO_B                 0<<4
 #define MOP_DIO_C                 1<<3
+#endif
 // least preferred (0)
 #define PRF_DIO_A                 0<<2
 #define PRF_DIO_B                 0<<1
@@ -56,11 +67,30 @@
 
 #define RPL_OPTION_PIO 0x8
 #define RPL_OPTION_CONFIG 0x4
+// 6LoWPAN context option, with the layout of the ND 6CO (RFC6775). IANA assigns
+// no RPL option type to it, this one is unassigned in the RPL Control Message
+// Options registry; RPL nodes ignore options they do not know (RFC6550 6.7.1)
+#define RPL_OPTION_6CO 0xF0
+
+#define RPL_6CO_C_FLAG            0x10
+#define RPL_6CO_CONTEXT_LEN       64
 
 // max number of parents and children to send in DAO
 //section 8.2.1 pag 67 RFC6550 -- using a subset
 #define MAX_TARGET_PARENTS        0x01
 
+// downward routes learnt from DAOs in storing mode
+#define RPL_MAXNUMROUTES          16
+
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+#ifndef RPL_STORING_MODE_ENABLED
+#error "RPL_DAO_AGGREGATION_ENABLED requires RPL_STORING_MODE_ENABLED"
+#endif
+// a relay merges the targets of its children into its own DAOs
+#define RPL_DAO_MAXNUMTARGETS     3    // targets in one DAO, mine included, to fit in a small packet buffer
+#define RPL_DAO_AGGREGATION_DELAY 2    // DAO timer periods to wait for other children's changes
+#endif
+
 enum{
   OPTION_ROUTE_INFORMATION_TYPE   = 0x03,
   OPTION_DODAG_CONFIGURATION_TYPE = 0x04,
@@ -129,6 +159,30 @@ typedef struct {
 }icmpv6rpl_config_ht;
 END_PACK
 
+BEGIN_PACK
+typedef struct {
+   uint8_t type; // RPL_OPTION_6CO
+   uint8_t optLen; // 14d
+   uint8_t contextLen; // 64
+   uint8_t flagsCID; // 000,C,CID
+   uint16_t reserved;
+   uint16_t lifetime; // 0xffff
+   uint8_t  prefix[8];
+}icmpv6rpl_6co_ht;
+END_PACK
+
+//===== DIS
+
+/**
+\brief Header format of a RPL DIS packet.
+*/
+BEGIN_PACK
+typedef struct {
+   uint8_t         flags;
+   uint8_t         reserved;
+} icmpv6rpl_dis_ht;
+END_PACK
+
 //===== DAO
 
 /**
@@ -170,6 +224,34 @@ typedef struct {
 } icmpv6rpl_dao_target_ht;
 END_PACK
 
+//===== routing table
+
+/**
+\brief A downward route learnt from a DAO, in storing mode.
+*/
+typedef struct {
+   uint8_t         target[16];         ///< target prefix, the bits past prefixLen are 0.
+   uint8_t         prefixLen;
+   uint8_t         nextHop[8];         ///< EUI64 of the child the target is reached through.
+   uint16_t        lifetime;           ///< DAO timer periods left before the route expires.
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+   bool            daoPending;         ///< to be advertised in my next DAO.
+#endif
+} icmpv6rpl_route_t;
+
+//===== statistics
+
+/**
+\brief DAO traffic of this mote, over a minute.
+*/
+typedef struct {
+   uint16_t        bytesSent;          ///< bytes of my own DAOs sent this minute.
+   uint16_t        bytesRelayed;       ///< bytes of DAOs relayed for my children this minute.
+   uint32_t        totalBytes;         ///< bytes of DAOs sent and relayed over all the full minutes.
+   uint16_t        numMinutes;         ///< full minutes counted in totalBytes.
+   uint16_t        numTicks;           ///< DAO timer periods elapsed this minute.
+} icmpv6rpl_dao_stats_t;
+
 //=========================== module variables ================================
 
 
@@ -184,22 +266,35 @@ typedef struct {
    icmpv6rpl_pio_t           pio;                     ///< pre-populated PIO com
    icmpv6rpl_config_ht       conf;
    open_addr_t               dioDestination;          ///< IPv6 destination address for DIOs.
-   uint16_t                  dioTimerCounter;         ///< counter to determine when to send DIO.
-   opentimers_id_t           timerIdDIO;              ///< ID of the timer used to send DIOs.
-   uint16_t                  dioPeriod;               ///< dio period in seconds.
+   opentimers_id_t           timerIdDIO;              ///< ID of the Trickle timer used to send DIOs.
+   uint32_t                  dioInterval;             ///< current Trickle interval I, in ms.
+   uint32_t                  dioIntervalRest;         ///< part of I left after the transmission time t, in ms.
+   uint8_t                   dioCounter;              ///< Trickle counter c, consistent DIOs heard during I.
+   bool                      dioTxTimePassed;         ///< t is over, the timer runs to the end of I.
+   bool                      dioTransmitted;          ///< a DIO was sent or suppressed at t.
+   uint8_t                   contextIdx;              ///< last compression context advertised in a DIO.
+   bool                      dioWithContext;          ///< the last DIO was the turn of a context, instead of the configuration option.
    // DAO-related
    icmpv6rpl_dao_ht          dao;                     ///< pre-populated DAO packet.
    icmpv6rpl_dao_transit_ht  dao_transit;             ///< pre-populated DAO "Transit Info" option header.
    icmpv6rpl_dao_target_ht   dao_target;              ///< pre-populated DAO "Transit Info" option header.
    opentimers_id_t           timerIdDAO;              ///< ID of the timer used to send DAOs.
-   uint16_t                  daoTimerCounter;         ///< counter to determine when to send DAO.
-   uint16_t                  daoPeriod;               ///< dao period in seconds.
+   uint16_t                  daoRefreshCounter;       ///< DAO timer periods before my DAO is refreshed.
+   bool                      daoPending;              ///< my own target is to be advertised.
+#ifdef RPL_DAO_AGGREGATION_ENABLED
+   uint8_t                   daoHoldCounter;          ///< DAO timer periods before an aggregated DAO is sent.
+#endif
+   icmpv6rpl_dao_stats_t     daoStats;                ///< DAO bytes per minute.
    // routing table
    dagrank_t                 myDAGrank;               ///< rank of this router within DAG.
    dagrank_t                 lowestRankInHistory;     ///< lowest Rank that the node has advertised
    uint16_t                  rankIncrease;            ///< the cost of the link to the parent, in units of rank
    bool                      haveParent;              ///< this router has a route to DAG root
    uint8_t                   ParentIndex;             ///< index of Parent in neighbor table (iff haveParent==TRUE)
+#ifdef RPL_STORING_MODE_ENABLED
+   icmpv6rpl_route_t         routes[RPL_MAXNUMROUTES]; ///< downward routes, longest prefixes first.
+   uint8_t                   numRoutes;               ///< number of routes in use at the head of routes.
+#endif
    // actually only here for debug
    icmpv6rpl_dio_ht*         incomingDio;             //keep it global to be able to debug correctly.
    icmpv6rpl_pio_t*          incomingPio;             //pio structure incoming
@@ -229,6 +324,9 @@ void     icmpv6rpl_killPreferredParent(void);
 void     icmpv6rpl_updateMyDAGrankAndParentSelection(void);
 void     icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg);
 bool     icmpv6rpl_daoSent(void);
+#ifdef RPL_STORING_MODE_ENABLED
+bool     icmpv6rpl_getRouteNextHop(open_addr_t* destination, open_addr_t* addressToWrite);
+#endif
 
 
 /**
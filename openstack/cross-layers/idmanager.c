@@ -6,6 +6,7 @@
 #include "neighbors.h"
 #include "schedule.h"
 #include "IEEE802154_security.h"
+#include "iphc.h"
 // telosb needs debugpins to indicate the ISR activity
 #include "debugpins.h"
 
@@ -247,6 +248,10 @@ void idmanager_triggerAboutRoot(void) {
       &input_buffer[1],
       sizeof(myPrefix.prefix)
    );
+   if (idmanager_isMyAddress(&myPrefix)==FALSE) {
+      // headers compressed for the former prefix are stale
+      iphc_flushCachedIPv6Headers();
+   }
    idmanager_setMyID(&myPrefix);
 
    // indicate DODAGid to RPL
@@ -288,6 +293,7 @@ status information about several modules in the OpenWSN stack.
 bool debugPrint_id(void) {
    debugIDManagerEntry_t output;
 
+   memset(&output,0,sizeof(debugIDManagerEntry_t));
    output.isDAGroot = idmanager_vars.isDAGroot;
    memcpy(output.myPANID,idmanager_vars.myPANID.panid,2);
    memcpy(output.my16bID,idmanager_vars.my16bID.addr_16b,2);
@@ -300,6 +306,7 @@ bool debugPrint_id(void) {
 
 bool debugPrint_joined(void) {
    asn_t output;
+   memset(&output,0,sizeof(asn_t));
    output.byte4         =  idmanager_vars.joinAsn.byte4;
    output.bytes2and3    =  idmanager_vars.joinAsn.bytes2and3;
    output.bytes0and1    =  idmanager_vars.joinAsn.bytes0and1;
@@ -22,6 +22,22 @@ void openqueue_reset_entry(OpenQueueEntry_t *entry);
 
 void openqueue_reset_big_entry(OpenQueueBigEntry_t *entry);
 
+uint8_t openqueue_entryIndex(OpenQueueEntry_t *entry);
+
+OpenQueueEntry_t* openqueue_entryAt(uint8_t entryIdx);
+
+void openqueue_releaseEntry(uint8_t entryIdx);
+
+uint8_t openqueue_txListBucket(open_addr_t *neighbor);
+
+uint8_t openqueue_txListFind(open_addr_t *neighbor);
+
+void openqueue_txListUnhash(uint8_t listIdx);
+
+void openqueue_txListAppend(uint8_t entryIdx);
+
+void openqueue_txListRemove(uint8_t entryIdx);
+
 //=========================== public ==========================================
 
 //======= admin
@@ -31,6 +47,9 @@ void openqueue_reset_big_entry(OpenQueueBigEntry_t *entry);
 */
 void openqueue_init(void) {
     uint8_t i;
+
+    memset(&openqueue_vars, 0, sizeof(openqueue_vars_t));
+
     for (i = 0; i < QUEUELENGTH; i++) {
         openqueue_reset_entry(&(openqueue_vars.queue[i]));
     }
@@ -38,6 +57,23 @@ void openqueue_init(void) {
     for (i = 0; i < BIGQUEUELENGTH; i++) {
         openqueue_reset_big_entry(&(openqueue_vars.big_queue[i]));
     }
+
+    // chain the free entries
+    for (i = 0; i < OPENQUEUE_NUM_ENTRIES; i++) {
+        openqueue_vars.next[i] = i + 1;
+        openqueue_vars.prev[i] = OPENQUEUE_NONE;
+        openqueue_vars.txListIdx[i] = OPENQUEUE_NONE;
+    }
+    openqueue_vars.next[QUEUELENGTH - 1] = OPENQUEUE_NONE;
+    openqueue_vars.next[OPENQUEUE_NUM_ENTRIES - 1] = OPENQUEUE_NONE;
+    openqueue_vars.freeHead = 0;
+    openqueue_vars.bigFreeHead = QUEUELENGTH;
+
+    // only the broadcast TX list exists
+    openqueue_vars.txList[OPENQUEUE_BCAST_LIST].head = OPENQUEUE_NONE;
+    openqueue_vars.txList[OPENQUEUE_BCAST_LIST].tail = OPENQUEUE_NONE;
+    openqueue_vars.numTxLists = 1;
+    memset(openqueue_vars.txListBucket, OPENQUEUE_NONE, sizeof(openqueue_vars.txListBucket));
 }
 
 /**
@@ -51,6 +87,7 @@ status information about several modules in the OpenWSN stack.
 bool debugPrint_queue(void) {
     debugOpenQueueEntry_t output[QUEUELENGTH];
     uint8_t i;
+    memset(output, 0, sizeof(output));
     for (i = 0; i < QUEUELENGTH; i++) {
         output[i].creator = openqueue_vars.queue[i].creator;
         output[i].owner = openqueue_vars.queue[i].owner;
@@ -92,17 +129,19 @@ OpenQueueEntry_t* openqueue_getFreePacketBuffer(uint8_t creator) {
         return NULL;
     }
 
-    // walk through queue and find free entry
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (openqueue_vars.queue[i].owner == COMPONENT_NULL) {
-            openqueue_vars.queue[i].creator = creator;
-            openqueue_vars.queue[i].owner = COMPONENT_OPENQUEUE;
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
-        }
+    // take the first free entry
+    i = openqueue_vars.freeHead;
+    if (i == OPENQUEUE_NONE) {
+        ENABLE_INTERRUPTS();
+        return NULL;
     }
+    openqueue_vars.freeHead = openqueue_vars.next[i];
+    openqueue_vars.next[i] = OPENQUEUE_NONE;
+
+    openqueue_vars.queue[i].creator = creator;
+    openqueue_vars.queue[i].owner = COMPONENT_OPENQUEUE;
     ENABLE_INTERRUPTS();
-    return NULL;
+    return &openqueue_vars.queue[i];
 }
 
 OpenQueueEntry_t* openqueue_getFreeBigPacketBuffer(uint8_t creator) {
@@ -117,21 +156,21 @@ OpenQueueEntry_t* openqueue_getFreeBigPacketBuffer(uint8_t creator) {
         return NULL;
     }
 
-    for (i = 0; i < BIGQUEUELENGTH; i++) {
-        if (openqueue_vars.big_queue[i].standard_entry.owner == COMPONENT_NULL) {
-
-            openqueue_vars.big_queue[i].standard_entry.creator = creator;
-            openqueue_vars.big_queue[i].standard_entry.owner = COMPONENT_OPENQUEUE;
-            openqueue_vars.big_queue[i].standard_entry.is_big_packet = TRUE;
-
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.big_queue[i].standard_entry;
-
-        }
+    i = openqueue_vars.bigFreeHead;
+    if (i == OPENQUEUE_NONE) {
+        ENABLE_INTERRUPTS();
+        return NULL;
     }
+    openqueue_vars.bigFreeHead = openqueue_vars.next[i];
+    openqueue_vars.next[i] = OPENQUEUE_NONE;
+
+    i -= QUEUELENGTH;
+    openqueue_vars.big_queue[i].standard_entry.creator = creator;
+    openqueue_vars.big_queue[i].standard_entry.owner = COMPONENT_OPENQUEUE;
+    openqueue_vars.big_queue[i].standard_entry.is_big_packet = TRUE;
 
     ENABLE_INTERRUPTS();
-    return NULL;
+    return &openqueue_vars.big_queue[i].standard_entry;
 }
 
 /**
@@ -148,45 +187,27 @@ owerror_t openqueue_freePacketBuffer(OpenQueueEntry_t *pkt) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    if (pkt->is_big_packet) {
-        for (i = 0; i < BIGQUEUELENGTH; i++) {
-            if ((OpenQueueBigEntry_t *) pkt == &openqueue_vars.big_queue[i]) {
-                if (openqueue_vars.big_queue[i].standard_entry.owner == COMPONENT_NULL) {
-                    // log the error
-                    openserial_printCritical(COMPONENT_OPENQUEUE, ERR_FREEING_UNUSED,
-                                             (errorparameter_t) 0,
-                                             (errorparameter_t) 0);
-                }
-
-                openqueue_reset_big_entry((OpenQueueBigEntry_t *) pkt);
-                ENABLE_INTERRUPTS();
-                return E_SUCCESS;
-            }
-        }
+    i = openqueue_entryIndex(pkt);
+    if (i == OPENQUEUE_NONE) {
+        // log the error
+        openserial_printCritical(COMPONENT_OPENQUEUE, ERR_FREEING_ERROR,
+                                 (errorparameter_t) 0,
+                                 (errorparameter_t) 0);
+        ENABLE_INTERRUPTS();
+        return E_FAIL;
+    }
 
+    if (pkt->owner == COMPONENT_NULL) {
+        // log the error
+        openserial_printCritical(COMPONENT_OPENQUEUE, ERR_FREEING_UNUSED,
+                                 (errorparameter_t) 0,
+                                 (errorparameter_t) 0);
     } else {
-        for (i = 0; i < QUEUELENGTH; i++) {
-            if (&openqueue_vars.queue[i] == pkt) {
-                if (openqueue_vars.queue[i].owner == COMPONENT_NULL) {
-                    // log the error
-                    openserial_printCritical(COMPONENT_OPENQUEUE, ERR_FREEING_UNUSED,
-                                             (errorparameter_t) 0,
-                                             (errorparameter_t) 0);
-                }
-                openqueue_reset_entry(&(openqueue_vars.queue[i]));
-                ENABLE_INTERRUPTS();
-                return E_SUCCESS;
-            }
-        }
-
+        openqueue_releaseEntry(i);
     }
 
-    // log the error
-    openserial_printCritical(COMPONENT_OPENQUEUE, ERR_FREEING_ERROR,
-                             (errorparameter_t) 0,
-                             (errorparameter_t) 0);
     ENABLE_INTERRUPTS();
-    return E_FAIL;
+    return E_SUCCESS;
 }
 
 /**
@@ -201,21 +222,52 @@ void openqueue_removeAllCreatedBy(uint8_t creator) {
     for (i = 0; i < QUEUELENGTH; i++) {
         if (
                 openqueue_vars.queue[i].creator == creator &&
-                openqueue_vars.queue[i].owner != COMPONENT_IEEE802154E
+                openqueue_vars.queue[i].owner != COMPONENT_IEEE802154E &&
+                openqueue_vars.queue[i].owner != COMPONENT_NULL &&
+                openqueue_vars.queue[i].l3_isFragment == FALSE  // frag releases the fragments
                 ) {
-            openqueue_reset_entry(&(openqueue_vars.queue[i]));
+            openqueue_releaseEntry(i);
         }
     }
 
     for (i = 0; i < BIGQUEUELENGTH; i++) {
-        if (openqueue_vars.big_queue[i].standard_entry.creator == creator) {
-            openqueue_reset_big_entry(&(openqueue_vars.big_queue[i]));
+        if (
+                openqueue_vars.big_queue[i].standard_entry.creator == creator &&
+                openqueue_vars.big_queue[i].standard_entry.owner != COMPONENT_NULL
+                ) {
+            openqueue_releaseEntry(QUEUELENGTH + i);
         }
     }
 
     ENABLE_INTERRUPTS();
 }
 
+//======= called by sixtop
+
+/**
+\brief Hand a packet over to the MAC layer.
+
+The packet is assigned to the virtual component COMPONENT_SIXTOP_TO_IEEE802154E
+and appended to the TX list of its next hop, where IEEE802154E looks it up.
+The packet stays in that list until it is freed, or handed over again.
+
+\param[in] pkt The packet to transmit, l2_nextORpreviousHop already set.
+*/
+void openqueue_sixtopPushToMac(OpenQueueEntry_t *pkt) {
+    uint8_t i;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    i = openqueue_entryIndex(pkt);
+    if (i != OPENQUEUE_NONE) {
+        openqueue_txListRemove(i);
+        openqueue_txListAppend(i);
+    }
+    pkt->owner = COMPONENT_SIXTOP_TO_IEEE802154E;
+
+    ENABLE_INTERRUPTS();
+}
+
 //======= called by RES
 
 OpenQueueEntry_t* openqueue_sixtopGetSentPacket(void) {
@@ -242,6 +294,33 @@ OpenQueueEntry_t* openqueue_sixtopGetSentPacket(void) {
     return NULL;
 }
 
+/**
+\brief Get a recently-sent packet whose transmission ended at a given ASN.
+
+Several packets sent in the same frame end their transmission at the same ASN.
+
+\returns The packet, NULL if there is none.
+*/
+OpenQueueEntry_t* openqueue_sixtopGetSentPacketAtAsn(asn_t *asn) {
+    uint8_t i;
+    OpenQueueEntry_t *entry;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+    for (i = 0; i < OPENQUEUE_NUM_ENTRIES; i++) {
+        entry = openqueue_entryAt(i);
+        if (entry->owner == COMPONENT_IEEE802154E_TO_SIXTOP &&
+            entry->creator != COMPONENT_IEEE802154E &&
+            entry->l2_asn.bytes0and1 == asn->bytes0and1 &&
+            entry->l2_asn.bytes2and3 == asn->bytes2and3 &&
+            entry->l2_asn.byte4 == asn->byte4) {
+            ENABLE_INTERRUPTS();
+            return entry;
+        }
+    }
+    ENABLE_INTERRUPTS();
+    return NULL;
+}
+
 OpenQueueEntry_t* openqueue_sixtopGetReceivedPacket(void) {
     uint8_t i;
     INTERRUPT_DECLARATION();
@@ -260,20 +339,25 @@ OpenQueueEntry_t* openqueue_sixtopGetReceivedPacket(void) {
 uint8_t openqueue_getNum6PReq(open_addr_t *neighbor) {
 
     uint8_t i;
+    uint8_t listIdx;
     uint8_t num6Prequest;
+    OpenQueueEntry_t *entry;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
     num6Prequest = 0;
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                openqueue_vars.queue[i].creator == COMPONENT_SIXTOP_RES &&
-                openqueue_vars.queue[i].l2_sixtop_messageType == SIXTOP_CELL_REQUEST &&
-                packetfunctions_sameAddress(neighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
-                ) {
-            num6Prequest += 1;
+    listIdx = openqueue_txListFind(neighbor);
+    if (listIdx != OPENQUEUE_NONE) {
+        for (i = openqueue_vars.txList[listIdx].head; i != OPENQUEUE_NONE; i = openqueue_vars.next[i]) {
+            entry = openqueue_entryAt(i);
+            if (
+                    entry->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                    entry->creator == COMPONENT_SIXTOP_RES &&
+                    entry->l2_sixtop_messageType == SIXTOP_CELL_REQUEST
+                    ) {
+                num6Prequest += 1;
+            }
         }
     }
     ENABLE_INTERRUPTS();
@@ -305,18 +389,27 @@ uint8_t openqueue_getNum6PResp(void) {
 void openqueue_remove6PrequestToNeighbor(open_addr_t *neighbor) {
 
     uint8_t i;
+    uint8_t nextIdx;
+    uint8_t listIdx;
+    OpenQueueEntry_t *entry;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                openqueue_vars.queue[i].creator == COMPONENT_SIXTOP_RES &&
-                openqueue_vars.queue[i].l2_sixtop_messageType == SIXTOP_CELL_REQUEST &&
-                packetfunctions_sameAddress(neighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
-                ) {
-            openqueue_reset_entry(&(openqueue_vars.queue[i]));
+    listIdx = openqueue_txListFind(neighbor);
+    if (listIdx != OPENQUEUE_NONE) {
+        for (i = openqueue_vars.txList[listIdx].head; i != OPENQUEUE_NONE; i = nextIdx) {
+            // releasing the entry unlinks it, remember where to go next
+            nextIdx = openqueue_vars.next[i];
+            entry = openqueue_entryAt(i);
+            if (
+                    i < QUEUELENGTH &&
+                    entry->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                    entry->creator == COMPONENT_SIXTOP_RES &&
+                    entry->l2_sixtop_messageType == SIXTOP_CELL_REQUEST
+                    ) {
+                openqueue_releaseEntry(i);
+            }
         }
     }
     ENABLE_INTERRUPTS();
@@ -330,6 +423,7 @@ bool openqueue_isHighPriorityEntryEnough(void) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
+    // count the current creators, packets change hands after allocation
     numberOfEntry = 0;
     for (i = 0; i < QUEUELENGTH; i++) {
         if (openqueue_vars.queue[i].creator > COMPONENT_SIXTOP_RES) {
@@ -348,14 +442,15 @@ bool openqueue_isHighPriorityEntryEnough(void) {
 
 OpenQueueEntry_t* openqueue_macGetEBPacket(void) {
    uint8_t i;
+   OpenQueueEntry_t* entry;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-          openqueue_vars.queue[i].creator==COMPONENT_SIXTOP              &&
-          packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))) {
+   for (i=openqueue_vars.txList[OPENQUEUE_BCAST_LIST].head;i!=OPENQUEUE_NONE;i=openqueue_vars.next[i]) {
+      entry = openqueue_entryAt(i);
+      if (entry->owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
+          entry->creator==COMPONENT_SIXTOP) {
          ENABLE_INTERRUPTS();
-         return &openqueue_vars.queue[i];
+         return entry;
       }
    }
    ENABLE_INTERRUPTS();
@@ -364,16 +459,25 @@ OpenQueueEntry_t* openqueue_macGetEBPacket(void) {
 
 OpenQueueEntry_t* openqueue_macGetKaPacket(open_addr_t* toNeighbor) {
     uint8_t i;
+    uint8_t listIdx;
+    OpenQueueEntry_t *entry;
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-            openqueue_vars.queue[i].creator == COMPONENT_SIXTOP &&
-            toNeighbor->type == ADDR_64B &&
-            packetfunctions_sameAddress(toNeighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
-                ) {
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+
+    if (toNeighbor->type != ADDR_64B) {
+        ENABLE_INTERRUPTS();
+        return NULL;
+    }
+
+    listIdx = openqueue_txListFind(toNeighbor);
+    if (listIdx != OPENQUEUE_NONE) {
+        for (i = openqueue_vars.txList[listIdx].head; i != OPENQUEUE_NONE; i = openqueue_vars.next[i]) {
+            entry = openqueue_entryAt(i);
+            if (entry->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                entry->creator == COMPONENT_SIXTOP) {
+                ENABLE_INTERRUPTS();
+                return entry;
+            }
         }
     }
     ENABLE_INTERRUPTS();
@@ -382,14 +486,15 @@ OpenQueueEntry_t* openqueue_macGetKaPacket(open_addr_t* toNeighbor) {
 
 OpenQueueEntry_t*  openqueue_macGetDIOPacket(){
     uint8_t i;
+    OpenQueueEntry_t *entry;
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-            openqueue_vars.queue[i].creator == COMPONENT_ICMPv6RPL &&
-            packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))) {
+    for (i = openqueue_vars.txList[OPENQUEUE_BCAST_LIST].head; i != OPENQUEUE_NONE; i = openqueue_vars.next[i]) {
+        entry = openqueue_entryAt(i);
+        if (entry->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+            entry->creator == COMPONENT_ICMPv6RPL) {
             ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+            return entry;
         }
     }
     ENABLE_INTERRUPTS();
@@ -418,7 +523,10 @@ void openqueue_updateNextHopPayload(open_addr_t *newNextHop) {
                     openqueue_vars.queue[i].creator >= COMPONENT_FORWARDING &&
                     openqueue_vars.queue[i].l3_useSourceRouting == FALSE
                     ) {
+                // move the packet to the TX list of its new next hop
+                openqueue_txListRemove(i);
                 memcpy(&openqueue_vars.queue[i].l2_nextORpreviousHop, newNextHop, sizeof(open_addr_t));
+                openqueue_txListAppend(i);
                 for (j = 0; j < 8; j++) {
                     *((uint8_t *) openqueue_vars.queue[i].l2_nextHop_payload + j) = newNextHop->addr_64b[j];
                 }
@@ -431,54 +539,75 @@ void openqueue_updateNextHopPayload(open_addr_t *newNextHop) {
 
 OpenQueueEntry_t*  openqueue_macGetUnicastPakcet(open_addr_t* toNeighbor){
     uint8_t i;
+    uint8_t listIdx;
+    OpenQueueEntry_t *entry;
+    OpenQueueEntry_t *oldest;
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    // first to look the sixtop RES packet
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                openqueue_vars.queue[i].creator == COMPONENT_SIXTOP_RES &&
-                (
-                        toNeighbor->type == ADDR_64B &&
-                        packetfunctions_sameAddress(toNeighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
-                ) &&
-                openqueue_vars.queue[i].l2_sixtop_messageType == SIXTOP_CELL_RESPONSE
-                ) {
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
-        }
+    if (toNeighbor->type != ADDR_64B) {
+        ENABLE_INTERRUPTS();
+        return NULL;
     }
 
-    // if reach here, then looking for other unicast packets
-    for (i = 0; i < QUEUELENGTH; i++) {
+    listIdx = openqueue_txListFind(toNeighbor);
+    if (listIdx == OPENQUEUE_NONE) {
+        ENABLE_INTERRUPTS();
+        return NULL;
+    }
+
+    // a sixtop RES response goes first, otherwise the oldest packet
+    oldest = NULL;
+    for (i = openqueue_vars.txList[listIdx].head; i != OPENQUEUE_NONE; i = openqueue_vars.next[i]) {
+        entry = openqueue_entryAt(i);
+        if (entry->owner != COMPONENT_SIXTOP_TO_IEEE802154E) {
+            continue;
+        }
         if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                (
-                        toNeighbor->type == ADDR_64B &&
-                        packetfunctions_sameAddress(toNeighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
-                )
+                entry->creator == COMPONENT_SIXTOP_RES &&
+                entry->l2_sixtop_messageType == SIXTOP_CELL_RESPONSE
                 ) {
             ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+            return entry;
+        }
+        if (oldest == NULL) {
+            oldest = entry;
         }
     }
+    ENABLE_INTERRUPTS();
+    return oldest;
 
-    for (i = 0; i < BIGQUEUELENGTH; i++) {
-        if (
-                ((OpenQueueEntry_t*)&openqueue_vars.big_queue[i])->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                (
-                        toNeighbor->type == ADDR_64B &&
-                        packetfunctions_sameAddress(toNeighbor, &((OpenQueueEntry_t*)&openqueue_vars.big_queue[i])->l2_nextORpreviousHop)
-                )
-                ) {
+}
+
+/**
+\brief Get the packet handed to the MAC after a given one, for the same next hop.
+
+\param[in] previous A packet in the TX list of a unicast next hop.
+
+\returns The next packet of that list owned by COMPONENT_SIXTOP_TO_IEEE802154E,
+         NULL if there is none.
+*/
+OpenQueueEntry_t* openqueue_macGetNextUnicastPacket(OpenQueueEntry_t *previous) {
+    uint8_t i;
+    OpenQueueEntry_t *entry;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    i = openqueue_entryIndex(previous);
+    if (i == OPENQUEUE_NONE || openqueue_vars.txListIdx[i] == OPENQUEUE_NONE) {
+        ENABLE_INTERRUPTS();
+        return NULL;
+    }
+
+    for (i = openqueue_vars.next[i]; i != OPENQUEUE_NONE; i = openqueue_vars.next[i]) {
+        entry = openqueue_entryAt(i);
+        if (entry->owner == COMPONENT_SIXTOP_TO_IEEE802154E) {
             ENABLE_INTERRUPTS();
-            return (OpenQueueEntry_t*)&openqueue_vars.big_queue[i];
+            return entry;
         }
     }
     ENABLE_INTERRUPTS();
     return NULL;
-
 }
 
 
@@ -522,3 +651,207 @@ void openqueue_reset_big_entry(OpenQueueBigEntry_t *entry) {
     // make pointer point to the end op the extended buffer
     entry->standard_entry.payload = &(entry->standard_entry.packet[IPV6_PACKET_SIZE]);
 }
+
+/**
+\brief Retrieve the index of a queue entry.
+
+\param[in] entry A pointer into queue or big_queue.
+
+\returns The index of that entry, OPENQUEUE_NONE if it is not part of the queue.
+*/
+uint8_t openqueue_entryIndex(OpenQueueEntry_t *entry) {
+    OpenQueueBigEntry_t *bigEntry;
+
+    if (entry >= &openqueue_vars.queue[0] && entry < &openqueue_vars.queue[QUEUELENGTH]) {
+        return entry - &openqueue_vars.queue[0];
+    }
+
+    bigEntry = (OpenQueueBigEntry_t *) entry;
+    if (bigEntry >= &openqueue_vars.big_queue[0] && bigEntry < &openqueue_vars.big_queue[BIGQUEUELENGTH]) {
+        return QUEUELENGTH + (bigEntry - &openqueue_vars.big_queue[0]);
+    }
+    return OPENQUEUE_NONE;
+}
+
+OpenQueueEntry_t* openqueue_entryAt(uint8_t entryIdx) {
+    if (entryIdx < QUEUELENGTH) {
+        return &openqueue_vars.queue[entryIdx];
+    }
+    return &openqueue_vars.big_queue[entryIdx - QUEUELENGTH].standard_entry;
+}
+
+/**
+\brief Reset an allocated entry and put it back in its free list.
+
+\pre Interrupts are disabled.
+*/
+void openqueue_releaseEntry(uint8_t entryIdx) {
+    openqueue_txListRemove(entryIdx);
+
+    if (entryIdx < QUEUELENGTH) {
+        openqueue_reset_entry(&openqueue_vars.queue[entryIdx]);
+        openqueue_vars.next[entryIdx] = openqueue_vars.freeHead;
+        openqueue_vars.freeHead = entryIdx;
+    } else {
+        openqueue_reset_big_entry(&openqueue_vars.big_queue[entryIdx - QUEUELENGTH]);
+        openqueue_vars.next[entryIdx] = openqueue_vars.bigFreeHead;
+        openqueue_vars.bigFreeHead = entryIdx;
+    }
+}
+
+/**
+\brief Compute the hash bucket of a unicast next hop.
+*/
+uint8_t openqueue_txListBucket(open_addr_t *neighbor) {
+    uint8_t len;
+    uint8_t i;
+    uint16_t hash;
+
+    switch (neighbor->type) {
+        case ADDR_16B:
+            len = 2;
+            break;
+        case ADDR_64B:
+            len = 8;
+            break;
+        default:
+            len = 16;
+            break;
+    }
+
+    hash = 0;
+    for (i = 0; i < len; i++) {
+        hash = (hash << 5) + hash + neighbor->addr_128b[i];
+    }
+    return (hash ^ (hash >> 8)) & (OPENQUEUE_TXLIST_HASHSIZE - 1);
+}
+
+/**
+\brief Find the TX list of a unicast next hop.
+
+\returns The index of that list in txList, OPENQUEUE_NONE if no packet is
+         queued for that neighbor.
+*/
+uint8_t openqueue_txListFind(open_addr_t *neighbor) {
+    uint8_t listIdx;
+
+    listIdx = openqueue_vars.txListBucket[openqueue_txListBucket(neighbor)];
+    while (listIdx != OPENQUEUE_NONE) {
+        if (packetfunctions_sameAddress(neighbor, &openqueue_vars.txList[listIdx].neighbor)) {
+            return listIdx;
+        }
+        listIdx = openqueue_vars.txList[listIdx].hashNext;
+    }
+    return OPENQUEUE_NONE;
+}
+
+/**
+\brief Take a unicast TX list out of its hash bucket.
+
+\pre Interrupts are disabled and the list is in use.
+*/
+void openqueue_txListUnhash(uint8_t listIdx) {
+    uint8_t *link;
+
+    link = &openqueue_vars.txListBucket[openqueue_txListBucket(&openqueue_vars.txList[listIdx].neighbor)];
+    while (*link != listIdx) {
+        link = &openqueue_vars.txList[*link].hashNext;
+    }
+    *link = openqueue_vars.txList[listIdx].hashNext;
+}
+
+/**
+\brief Append an entry to the TX list of its next hop, creating that list if needed.
+
+\pre Interrupts are disabled and the entry is not in any TX list.
+*/
+void openqueue_txListAppend(uint8_t entryIdx) {
+    uint8_t listIdx;
+    uint8_t bucket;
+    open_addr_t *nextHop;
+    openqueue_txList_t *txList;
+
+    nextHop = &openqueue_entryAt(entryIdx)->l2_nextORpreviousHop;
+    if (packetfunctions_isBroadcastMulticast(nextHop)) {
+        listIdx = OPENQUEUE_BCAST_LIST;
+    } else {
+        listIdx = openqueue_txListFind(nextHop);
+        if (listIdx == OPENQUEUE_NONE) {
+            // there are as many lists as entries, this never runs out
+            listIdx = openqueue_vars.numTxLists++;
+            memcpy(&openqueue_vars.txList[listIdx].neighbor, nextHop, sizeof(open_addr_t));
+            openqueue_vars.txList[listIdx].head = OPENQUEUE_NONE;
+            openqueue_vars.txList[listIdx].tail = OPENQUEUE_NONE;
+            bucket = openqueue_txListBucket(nextHop);
+            openqueue_vars.txList[listIdx].hashNext = openqueue_vars.txListBucket[bucket];
+            openqueue_vars.txListBucket[bucket] = listIdx;
+        }
+    }
+    txList = &openqueue_vars.txList[listIdx];
+
+    openqueue_vars.next[entryIdx] = OPENQUEUE_NONE;
+    openqueue_vars.prev[entryIdx] = txList->tail;
+    if (txList->tail == OPENQUEUE_NONE) {
+        txList->head = entryIdx;
+    } else {
+        openqueue_vars.next[txList->tail] = entryIdx;
+    }
+    txList->tail = entryIdx;
+    openqueue_vars.txListIdx[entryIdx] = listIdx;
+}
+
+/**
+\brief Remove an entry from its TX list, if any.
+
+An emptied unicast list is replaced by the last list in use, so the lists in
+use always are the first numTxLists ones.
+
+\pre Interrupts are disabled.
+*/
+void openqueue_txListRemove(uint8_t entryIdx) {
+    uint8_t i;
+    uint8_t listIdx;
+    uint8_t lastIdx;
+    uint8_t bucket;
+    openqueue_txList_t *txList;
+
+    listIdx = openqueue_vars.txListIdx[entryIdx];
+    if (listIdx == OPENQUEUE_NONE) {
+        return;
+    }
+    txList = &openqueue_vars.txList[listIdx];
+
+    // unlink
+    if (openqueue_vars.prev[entryIdx] == OPENQUEUE_NONE) {
+        txList->head = openqueue_vars.next[entryIdx];
+    } else {
+        openqueue_vars.next[openqueue_vars.prev[entryIdx]] = openqueue_vars.next[entryIdx];
+    }
+    if (openqueue_vars.next[entryIdx] == OPENQUEUE_NONE) {
+        txList->tail = openqueue_vars.prev[entryIdx];
+    } else {
+        openqueue_vars.prev[openqueue_vars.next[entryIdx]] = openqueue_vars.prev[entryIdx];
+    }
+    openqueue_vars.next[entryIdx] = OPENQUEUE_NONE;
+    openqueue_vars.prev[entryIdx] = OPENQUEUE_NONE;
+    openqueue_vars.txListIdx[entryIdx] = OPENQUEUE_NONE;
+
+    if (listIdx == OPENQUEUE_BCAST_LIST || txList->head != OPENQUEUE_NONE) {
+        return;
+    }
+
+    // the list of that neighbor is now empty, fill the gap with the last list
+    openqueue_txListUnhash(listIdx);
+    lastIdx = openqueue_vars.numTxLists - 1;
+    if (listIdx != lastIdx) {
+        openqueue_txListUnhash(lastIdx);
+        memcpy(txList, &openqueue_vars.txList[lastIdx], sizeof(openqueue_txList_t));
+        bucket = openqueue_txListBucket(&txList->neighbor);
+        txList->hashNext = openqueue_vars.txListBucket[bucket];
+        openqueue_vars.txListBucket[bucket] = listIdx;
+        for (i = txList->head; i != OPENQUEUE_NONE; i = openqueue_vars.next[i]) {
+            openqueue_vars.txListIdx[i] = listIdx;
+        }
+    }
+    openqueue_vars.numTxLists--;
+}
@@ -13,9 +13,26 @@
 
 //=========================== define ==========================================
 
+#ifndef QUEUELENGTH
 #define QUEUELENGTH  20
+#endif
 #define BIGQUEUELENGTH  2
 
+#define OPENQUEUE_NUM_ENTRIES   (QUEUELENGTH+BIGQUEUELENGTH)
+#define OPENQUEUE_NONE          0xff    // end of list, or entry not in any list
+#define OPENQUEUE_BCAST_LIST    0       // TX list holding the broadcast/multicast packets
+// number of buckets of the next hop to TX list hash, a power of 2
+#ifndef OPENQUEUE_TXLIST_HASHSIZE
+#define OPENQUEUE_TXLIST_HASHSIZE 16
+#endif
+
+#if OPENQUEUE_NUM_ENTRIES>=OPENQUEUE_NONE
+#error "openqueue entries are indexed on 8 bits"
+#endif
+#if (OPENQUEUE_TXLIST_HASHSIZE & (OPENQUEUE_TXLIST_HASHSIZE-1))!=0
+#error "OPENQUEUE_TXLIST_HASHSIZE must be a power of 2"
+#endif
+
 //=========================== typedef =========================================
 
 typedef struct {
@@ -23,11 +40,32 @@ typedef struct {
    uint8_t  owner;
 } debugOpenQueueEntry_t;
 
+/**
+\brief FIFO of the packets handed to the MAC layer for a given next hop.
+
+Entries are chained through openqueue_vars.next[] and openqueue_vars.prev[].
+*/
+typedef struct {
+   open_addr_t neighbor;                         // next hop of all packets in this list
+   uint8_t     head;                             // oldest packet, OPENQUEUE_NONE if empty
+   uint8_t     tail;                             // newest packet, OPENQUEUE_NONE if empty
+   uint8_t     hashNext;                         // next list in the same hash bucket, OPENQUEUE_NONE if last
+} openqueue_txList_t;
+
 //=========================== module variables ================================
 
 typedef struct {
    OpenQueueEntry_t queue[QUEUELENGTH];
    OpenQueueBigEntry_t big_queue[BIGQUEUELENGTH];
+   // entry i is queue[i] if i<QUEUELENGTH, big_queue[i-QUEUELENGTH] otherwise
+   uint8_t             freeHead;                               // first free entry of queue
+   uint8_t             bigFreeHead;                            // first free entry of big_queue
+   uint8_t             next[OPENQUEUE_NUM_ENTRIES];            // next entry in the free list or TX list
+   uint8_t             prev[OPENQUEUE_NUM_ENTRIES];            // previous entry in the TX list
+   uint8_t             txListIdx[OPENQUEUE_NUM_ENTRIES];       // TX list the entry is in, OPENQUEUE_NONE if none
+   openqueue_txList_t  txList[OPENQUEUE_NUM_ENTRIES+1];        // broadcast list, then one list per next hop
+   uint8_t             numTxLists;                             // number of TX lists in use, broadcast list included
+   uint8_t             txListBucket[OPENQUEUE_TXLIST_HASHSIZE]; // first unicast TX list hashed there, OPENQUEUE_NONE if none
 } openqueue_vars_t;
 
 //=========================== prototypes ======================================
@@ -43,8 +81,11 @@ void               openqueue_removeAllCreatedBy(uint8_t creator);
 bool               openqueue_isHighPriorityEntryEnough(void);
 // called by ICMPv6
 void               openqueue_updateNextHopPayload(open_addr_t* newNextHop);
+// called by sixtop
+void               openqueue_sixtopPushToMac(OpenQueueEntry_t* pkt);
 // called by res
 OpenQueueEntry_t*  openqueue_sixtopGetSentPacket(void);
+OpenQueueEntry_t*  openqueue_sixtopGetSentPacketAtAsn(asn_t* asn);
 OpenQueueEntry_t*  openqueue_sixtopGetReceivedPacket(void);
 uint8_t            openqueue_getNum6PResp(void);
 uint8_t            openqueue_getNum6PReq(open_addr_t* neighbor);
@@ -54,6 +95,7 @@ OpenQueueEntry_t*  openqueue_macGetEBPacket(void);
 OpenQueueEntry_t*  openqueue_macGetKaPacket(open_addr_t* toNeighbor);
 OpenQueueEntry_t*  openqueue_macGetDIOPacket(void);
 OpenQueueEntry_t*  openqueue_macGetUnicastPakcet(open_addr_t* toNeighbor);
+OpenQueueEntry_t*  openqueue_macGetNextUnicastPacket(OpenQueueEntry_t* previous);
 /**
 \}
 \}
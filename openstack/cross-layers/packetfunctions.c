@@ -4,9 +4,90 @@
 
 //=========================== variables =======================================
 
+/**
+\brief CRC-16 (polynomial 0x8408, reflected) of each byte value.
+*/
+static const uint16_t packetfunctions_crcTable0[256] = {
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+    0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+    0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+    0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+    0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+    0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+    0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+    0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+    0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+    0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+    0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+    0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+    0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+    0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+    0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+    0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+    0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+};
+
+/**
+\brief CRC-16 of each byte value followed by a zero byte.
+
+Used together with packetfunctions_crcTable0 to process two bytes per lookup
+step (slice-by-2).
+*/
+static const uint16_t packetfunctions_crcTable1[256] = {
+    0x0000, 0x19d8, 0x33b0, 0x2a68, 0x6760, 0x7eb8, 0x54d0, 0x4d08,
+    0xcec0, 0xd718, 0xfd70, 0xe4a8, 0xa9a0, 0xb078, 0x9a10, 0x83c8,
+    0x9591, 0x8c49, 0xa621, 0xbff9, 0xf2f1, 0xeb29, 0xc141, 0xd899,
+    0x5b51, 0x4289, 0x68e1, 0x7139, 0x3c31, 0x25e9, 0x0f81, 0x1659,
+    0x2333, 0x3aeb, 0x1083, 0x095b, 0x4453, 0x5d8b, 0x77e3, 0x6e3b,
+    0xedf3, 0xf42b, 0xde43, 0xc79b, 0x8a93, 0x934b, 0xb923, 0xa0fb,
+    0xb6a2, 0xaf7a, 0x8512, 0x9cca, 0xd1c2, 0xc81a, 0xe272, 0xfbaa,
+    0x7862, 0x61ba, 0x4bd2, 0x520a, 0x1f02, 0x06da, 0x2cb2, 0x356a,
+    0x4666, 0x5fbe, 0x75d6, 0x6c0e, 0x2106, 0x38de, 0x12b6, 0x0b6e,
+    0x88a6, 0x917e, 0xbb16, 0xa2ce, 0xefc6, 0xf61e, 0xdc76, 0xc5ae,
+    0xd3f7, 0xca2f, 0xe047, 0xf99f, 0xb497, 0xad4f, 0x8727, 0x9eff,
+    0x1d37, 0x04ef, 0x2e87, 0x375f, 0x7a57, 0x638f, 0x49e7, 0x503f,
+    0x6555, 0x7c8d, 0x56e5, 0x4f3d, 0x0235, 0x1bed, 0x3185, 0x285d,
+    0xab95, 0xb24d, 0x9825, 0x81fd, 0xccf5, 0xd52d, 0xff45, 0xe69d,
+    0xf0c4, 0xe91c, 0xc374, 0xdaac, 0x97a4, 0x8e7c, 0xa414, 0xbdcc,
+    0x3e04, 0x27dc, 0x0db4, 0x146c, 0x5964, 0x40bc, 0x6ad4, 0x730c,
+    0x8ccc, 0x9514, 0xbf7c, 0xa6a4, 0xebac, 0xf274, 0xd81c, 0xc1c4,
+    0x420c, 0x5bd4, 0x71bc, 0x6864, 0x256c, 0x3cb4, 0x16dc, 0x0f04,
+    0x195d, 0x0085, 0x2aed, 0x3335, 0x7e3d, 0x67e5, 0x4d8d, 0x5455,
+    0xd79d, 0xce45, 0xe42d, 0xfdf5, 0xb0fd, 0xa925, 0x834d, 0x9a95,
+    0xafff, 0xb627, 0x9c4f, 0x8597, 0xc89f, 0xd147, 0xfb2f, 0xe2f7,
+    0x613f, 0x78e7, 0x528f, 0x4b57, 0x065f, 0x1f87, 0x35ef, 0x2c37,
+    0x3a6e, 0x23b6, 0x09de, 0x1006, 0x5d0e, 0x44d6, 0x6ebe, 0x7766,
+    0xf4ae, 0xed76, 0xc71e, 0xdec6, 0x93ce, 0x8a16, 0xa07e, 0xb9a6,
+    0xcaaa, 0xd372, 0xf91a, 0xe0c2, 0xadca, 0xb412, 0x9e7a, 0x87a2,
+    0x046a, 0x1db2, 0x37da, 0x2e02, 0x630a, 0x7ad2, 0x50ba, 0x4962,
+    0x5f3b, 0x46e3, 0x6c8b, 0x7553, 0x385b, 0x2183, 0x0beb, 0x1233,
+    0x91fb, 0x8823, 0xa24b, 0xbb93, 0xf69b, 0xef43, 0xc52b, 0xdcf3,
+    0xe999, 0xf041, 0xda29, 0xc3f1, 0x8ef9, 0x9721, 0xbd49, 0xa491,
+    0x2759, 0x3e81, 0x14e9, 0x0d31, 0x4039, 0x59e1, 0x7389, 0x6a51,
+    0x7c08, 0x65d0, 0x4fb8, 0x5660, 0x1b68, 0x02b0, 0x28d8, 0x3100,
+    0xb2c8, 0xab10, 0x8178, 0x98a0, 0xd5a8, 0xcc70, 0xe618, 0xffc0
+};
+
 //=========================== prototypes ======================================
 
-void onesComplementSum(uint8_t *global_sum, uint8_t *ptr, int length);
+uint16_t crc16Update(uint16_t crc, uint8_t *ptr, uint16_t length);
+uint32_t onesComplementAccumulate(uint32_t sum, uint8_t *ptr, uint16_t length);
+uint16_t onesComplementFold(uint32_t sum);
 
 //=========================== public ==========================================
 
@@ -381,19 +462,10 @@ void packetfunctions_duplicatePacket(OpenQueueEntry_t *dst, OpenQueueEntry_t *sr
 
 void packetfunctions_calculateCRC(OpenQueueEntry_t *msg) {
     uint16_t crc;
-    uint8_t i;
-    uint8_t count;
+
     crc = 0;
-    for (count = 1; count < msg->length - 2; count++) {
-        crc = crc ^ (uint8_t) * (msg->payload + count);
-        //crc = crc ^ (uint16_t)*ptr++ << 8;
-        for (i = 0; i < 8; i++) {
-            if (crc & 0x1) {
-                crc = crc >> 1 ^ 0x8408;
-            } else {
-                crc = crc >> 1;
-            }
-        }
+    if (msg->length > 3) {
+        crc = crc16Update(crc, msg->payload + 1, msg->length - 3);
     }
     *(msg->payload + (msg->length - 2)) = crc % 256;
     *(msg->payload + (msg->length - 1)) = crc / 256;
@@ -401,19 +473,10 @@ void packetfunctions_calculateCRC(OpenQueueEntry_t *msg) {
 
 bool packetfunctions_checkCRC(OpenQueueEntry_t *msg) {
     uint16_t crc;
-    uint8_t i;
-    uint8_t count;
+
     crc = 0;
-    for (count = 0; count < msg->length - 2; count++) {
-        crc = crc ^ (uint8_t) * (msg->payload + count);
-        //crc = crc ^ (uint16_t)*ptr++ << 8;
-        for (i = 0; i < 8; i++) {
-            if (crc & 0x1) {
-                crc = crc >> 1 ^ 0x8408;
-            } else {
-                crc = crc >> 1;
-            }
-        }
+    if (msg->length > 2) {
+        crc = crc16Update(crc, msg->payload, msg->length - 2);
     }
     if (*(msg->payload + (msg->length - 2)) == crc % 256 &&
         *(msg->payload + (msg->length - 1)) == crc / 256) {
@@ -428,13 +491,13 @@ bool packetfunctions_checkCRC(OpenQueueEntry_t *msg) {
 //see http://www-net.cs.umass.edu/kurose/transport/UDP.html, or http://tools.ietf.org/html/rfc1071
 //see http://en.wikipedia.org/wiki/User_Datagram_Protocol#IPv6_PSEUDO-HEADER
 void packetfunctions_calculateChecksum(OpenQueueEntry_t *msg, uint8_t *checksum_ptr) {
-    uint8_t temp_checksum[2];
-    uint8_t little_helper[2];
+    uint32_t sum;
+    uint16_t checksum;
+    uint8_t little_helper[4];
     open_addr_t localscopeAddress;
 
-    // initialize running checksum
-    temp_checksum[0] = 0;
-    temp_checksum[1] = 0;
+    // initialize running sum, only folded once everything is accumulated
+    sum = 0;
 
     //===== IPv6 pseudo header
 
@@ -443,33 +506,30 @@ void packetfunctions_calculateChecksum(OpenQueueEntry_t *msg, uint8_t *checksum_
         // use link local address for source address (prefix and EUI64)
 
         // source address
-        onesComplementSum(temp_checksum, (uint8_t *) linklocalprefix, 8);
+        sum = onesComplementAccumulate(sum, (uint8_t *) linklocalprefix, 8);
         memcpy(&localscopeAddress, idmanager_getMyID(ADDR_64B), sizeof(open_addr_t));
         // invert 'u' bit (section 2.5.1 at https://www.ietf.org/rfc/rfc2373.txt)
         localscopeAddress.addr_64b[0] ^= 0x02;
-        onesComplementSum(temp_checksum, localscopeAddress.addr_64b, 8);
+        sum = onesComplementAccumulate(sum, localscopeAddress.addr_64b, 8);
 
         // boardcast destination address
-        onesComplementSum(temp_checksum, msg->l3_destinationAdd.addr_128b, 16);
+        sum = onesComplementAccumulate(sum, msg->l3_destinationAdd.addr_128b, 16);
     } else {
         // use 128-bit ipv6 address for source address and destination address
 
         // source address
-        onesComplementSum(temp_checksum, (idmanager_getMyID(ADDR_PREFIX))->prefix, 8);
-        onesComplementSum(temp_checksum, (idmanager_getMyID(ADDR_64B))->addr_64b, 8);
+        sum = onesComplementAccumulate(sum, (idmanager_getMyID(ADDR_PREFIX))->prefix, 8);
+        sum = onesComplementAccumulate(sum, (idmanager_getMyID(ADDR_64B))->addr_64b, 8);
         // destination address
-        onesComplementSum(temp_checksum, msg->l3_destinationAdd.addr_128b, 16);
+        sum = onesComplementAccumulate(sum, msg->l3_destinationAdd.addr_128b, 16);
     }
 
-    // length
+    // length and next header
     little_helper[0] = (msg->length & 0xFF00) >> 8;
     little_helper[1] = (msg->length & 0x00FF);
-    onesComplementSum(temp_checksum, little_helper, 2);
-
-    // next header
-    little_helper[0] = 0;
-    little_helper[1] = msg->l4_protocol;
-    onesComplementSum(temp_checksum, little_helper, 2);
+    little_helper[2] = 0;
+    little_helper[3] = msg->l4_protocol;
+    sum = onesComplementAccumulate(sum, little_helper, 4);
 
     //===== payload
 
@@ -477,31 +537,122 @@ void packetfunctions_calculateChecksum(OpenQueueEntry_t *msg, uint8_t *checksum_
     *checksum_ptr = 0;
     *(checksum_ptr + 1) = 0;
 
-    onesComplementSum(temp_checksum, msg->payload, msg->length);
-    temp_checksum[0] ^= 0xFF;
-    temp_checksum[1] ^= 0xFF;
+    sum = onesComplementAccumulate(sum, msg->payload, msg->length);
+    checksum = ~onesComplementFold(sum);
 
     //write in packet
-    *checksum_ptr = temp_checksum[0];
-    *(checksum_ptr + 1) = temp_checksum[1];
+    packetfunctions_htons(checksum, checksum_ptr);
+}
+
+/**
+\brief Update a checksum after some field it covers was rewritten.
+
+Implements the incremental update of RFC1624 (eqn. 3), which yields the same
+value as recomputing the checksum over the whole packet. The field is expected
+to start at an even offset from the beginning of the checksummed data. When
+its length is odd, its last byte is the most significant byte of a 16-bit
+word.
+
+\param[in,out] checksum_ptr Where the checksum is written in the packet.
+\param[in] oldValue The previous value of the field.
+\param[in] newValue The new value of the field.
+\param[in] length The length of the field, in bytes.
+*/
+void packetfunctions_updateChecksum(
+        uint8_t *checksum_ptr,
+        uint8_t *oldValue,
+        uint8_t *newValue,
+        uint8_t length) {
+    uint32_t sum;
+    uint16_t checksum;
+    uint8_t i;
+
+    // HC' = ~(~HC + ~m + m')
+    sum = (uint16_t) ~packetfunctions_ntohs(checksum_ptr);
+    for (i = 0; i + 1 < length; i += 2) {
+        sum += (uint16_t) ~(((uint16_t) oldValue[i] << 8) | oldValue[i + 1]);
+        sum += ((uint16_t) newValue[i] << 8) | newValue[i + 1];
+    }
+    if (i < length) {
+        sum += (uint16_t) ~((uint16_t) oldValue[i] << 8);
+        sum += (uint16_t) newValue[i] << 8;
+    }
+    checksum = ~onesComplementFold(sum);
+
+    packetfunctions_htons(checksum, checksum_ptr);
 }
 
+/**
+\brief Add a buffer to a running CRC-16 (polynomial 0x8408, reflected).
 
-void onesComplementSum(uint8_t *global_sum, uint8_t *ptr, int length) {
-    uint32_t sum = 0xFFFF & (global_sum[0] << 8 | global_sum[1]);
+\param[in] crc The CRC of the bytes processed so far.
+\param[in] ptr The bytes to add.
+\param[in] length The number of bytes to add.
+
+\returns The CRC including those bytes.
+*/
+uint16_t crc16Update(uint16_t crc, uint8_t *ptr, uint16_t length) {
+    // two bytes per step
+    while (length > 1) {
+        crc ^= ((uint16_t) ptr[1] << 8) | ptr[0];
+        crc = packetfunctions_crcTable1[crc & 0xFF] ^ packetfunctions_crcTable0[crc >> 8];
+        ptr += 2;
+        length -= 2;
+    }
+    if (length) {
+        crc = (crc >> 8) ^ packetfunctions_crcTable0[(crc ^ *ptr) & 0xFF];
+    }
+    return crc;
+}
+
+/**
+\brief Add a buffer, as big-endian 16-bit words, to a running ones-complement
+   sum.
+
+Carries are kept in the upper bits of the 32-bit sum rather than folded after
+every addition; fold the sum with onesComplementFold() once done. This holds
+as long as less than 65536 words are accumulated. An odd trailing byte is
+padded with a zero byte.
+
+\param[in] sum The unfolded sum so far.
+\param[in] ptr The bytes to add.
+\param[in] length The number of bytes to add.
+
+\returns The unfolded sum including those bytes.
+*/
+uint32_t onesComplementAccumulate(uint32_t sum, uint8_t *ptr, uint16_t length) {
+    // four words per step
+    while (length >= 8) {
+        sum += ((uint16_t) ptr[0] << 8) | ptr[1];
+        sum += ((uint16_t) ptr[2] << 8) | ptr[3];
+        sum += ((uint16_t) ptr[4] << 8) | ptr[5];
+        sum += ((uint16_t) ptr[6] << 8) | ptr[7];
+        ptr += 8;
+        length -= 8;
+    }
     while (length > 1) {
-        sum += 0xFFFF & (*ptr << 8 | *(ptr + 1));
+        sum += ((uint16_t) ptr[0] << 8) | ptr[1];
         ptr += 2;
         length -= 2;
     }
     if (length) {
-        sum += (0xFF & *ptr) << 8;
+        sum += (uint16_t) ptr[0] << 8;
     }
+    return sum;
+}
+
+/**
+\brief Fold the carries of a running ones-complement sum.
+
+\param[in] sum The unfolded sum.
+
+\returns The 16-bit ones-complement sum.
+*/
+uint16_t onesComplementFold(uint32_t sum) {
     while (sum >> 16) {
         sum = (sum & 0xFFFF) + (sum >> 16);
     }
-    global_sum[0] = (sum >> 8) & 0xFF;
-    global_sum[1] = sum & 0xFF;
+    return (uint16_t) sum;
 }
 
 //======= endianness
@@ -63,6 +63,8 @@ bool packetfunctions_checkCRC(OpenQueueEntry_t *msg);
 // calculate checksum
 void packetfunctions_calculateChecksum(OpenQueueEntry_t *msg, uint8_t *checksum_ptr);
 
+void packetfunctions_updateChecksum(uint8_t *checksum_ptr, uint8_t *oldValue, uint8_t *newValue, uint8_t length);
+
 // endianness
 void packetfunctions_htons(uint16_t val, uint8_t *dest);
 
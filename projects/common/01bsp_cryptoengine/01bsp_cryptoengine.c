@@ -16,6 +16,7 @@ tests passed. If there was an error, we use the Error LED to signal.
 // bsp modules required
 #include "board.h"
 #include "cryptoengine.h"
+#include "openaes.h"
 #include "leds.h"
 #include "sctimer.h"
 
@@ -25,6 +26,7 @@ tests passed. If there was an error, we use the Error LED to signal.
 #define TEST_AES_CCMS_AUTH_FORWARD     1
 #define TEST_AES_CCMS_AUTH_INVERSE     1
 #define TEST_BENCHMARK_CCMS            1
+#define TEST_BENCHMARK_OPENAES         1
 
 typedef struct {
    uint8_t key[16];
@@ -430,6 +432,41 @@ int mote_main(void) {
    time1 = enc + dec; // to avoid compiler warnings
 #endif /* TEST_BENCHMARK_CCMS */
 
+#if TEST_BENCHMARK_OPENAES
+
+#define NUM_BLOCKS 64
+
+   // throughput of the software AES, whichever the board's cryptoengine
+   openaes_ctx_t aes_ctx;
+   uint8_t aes_key[16] = { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+   uint8_t aes_block[16];
+   uint8_t aes_i;
+
+   PORT_TIMER_WIDTH aes_start = 0;
+   PORT_TIMER_WIDTH aes_expandPerBlock = 0;
+   PORT_TIMER_WIDTH aes_expandOnce = 0;
+
+   memset(aes_block, 0xab, 16);
+
+   // key expanded for every block
+   aes_start = sctimer_readCounter();
+   for (aes_i = 0; aes_i < NUM_BLOCKS; aes_i++) {
+      openaes_ctxInit(&aes_ctx, aes_key);
+      openaes_ctxEnc(aes_block, &aes_ctx);
+   }
+   aes_expandPerBlock = sctimer_readCounter() - aes_start;
+
+   // key expanded once
+   aes_start = sctimer_readCounter();
+   openaes_ctxInit(&aes_ctx, aes_key);
+   for (aes_i = 0; aes_i < NUM_BLOCKS; aes_i++) {
+      openaes_ctxEnc(aes_block, &aes_ctx);
+   }
+   aes_expandOnce = sctimer_readCounter() - aes_start;
+
+   aes_start = aes_expandPerBlock + aes_expandOnce; // to avoid compiler warnings
+#endif /* TEST_BENCHMARK_OPENAES */
+
    return hang(fail);
 }
 
@@ -181,3 +181,6 @@ bool debugPrint_neighbors(void) {
 bool debugPrint_joined(void) {
    return FALSE;
 }
+bool debugPrint_macProfile(void) {
+   return FALSE;
+}
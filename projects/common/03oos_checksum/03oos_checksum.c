@@ -0,0 +1,258 @@
+/**
+\brief This program checks the CRC-16 and ones-complement checksum routines
+       of packetfunctions against straightforward reference implementations,
+       and benchmarks both.
+
+The reference implementations compute the CRC bit by bit and fold the
+ones-complement sum after every 16-bit word.
+
+Load this program on your boards. Radio LED will stay on indefinitely if all
+results are identical. If there was an error, we use the Error LED to signal.
+The durations measured (in sctimer ticks, for BENCHMARK_ROUNDS runs) are left
+in checksum_vars, to be read with a debugger.
+*/
+
+#include "stdint.h"
+#include "string.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+#include "sctimer.h"
+// stack modules required
+#include "opendefs.h"
+#include "scheduler.h"
+#include "openstack.h"
+#include "idmanager.h"
+#include "packetfunctions.h"
+
+#define TEST_VECTOR_MAXLEN             127
+#define BENCHMARK_ROUNDS               100
+
+//=========================== variables =======================================
+
+typedef struct {
+   uint8_t              buf[TEST_VECTOR_MAXLEN];
+   uint8_t              ref[TEST_VECTOR_MAXLEN];
+   PORT_TIMER_WIDTH     crcRef;
+   PORT_TIMER_WIDTH     crc;
+   PORT_TIMER_WIDTH     checksumRef;
+   PORT_TIMER_WIDTH     checksum;
+} checksum_vars_t;
+
+checksum_vars_t checksum_vars;
+
+//=========================== prototypes ======================================
+
+static int  hang(uint8_t error_code);
+static void fill(uint8_t* buf, uint8_t len, uint8_t seed);
+static void ref_calculateCRC(OpenQueueEntry_t* msg);
+static bool ref_checkCRC(OpenQueueEntry_t* msg);
+static void ref_calculateChecksum(OpenQueueEntry_t* msg, uint8_t* checksum_ptr);
+static void ref_onesComplementSum(uint8_t* global_sum, uint8_t* ptr, int length);
+
+//=========================== main ============================================
+
+int mote_main(void) {
+   OpenQueueEntry_t     pkt;
+   OpenQueueEntry_t     refPkt;
+   uint8_t              len;
+   uint8_t              i;
+   uint8_t              fail;
+   uint8_t              oldValue[2];
+   uint8_t              newValue[2];
+   PORT_TIMER_WIDTH     time1;
+
+   fail = 0;
+
+   board_init();
+   scheduler_init();
+   openstack_init();
+
+   leds_all_off();
+
+   memset(&pkt,0,sizeof(OpenQueueEntry_t));
+   pkt.l4_protocol                       = IANA_UDP;
+   pkt.l3_destinationAdd.type            = ADDR_128B;
+   memcpy(pkt.l3_destinationAdd.addr_128b,idmanager_getMyID(ADDR_PREFIX)->prefix,8);
+   fill(&pkt.l3_destinationAdd.addr_128b[8],8,0x5a);
+
+   //=== bit-exactness, for every length
+
+   for (len=4;len<TEST_VECTOR_MAXLEN;len++) {
+      fill(checksum_vars.buf,len,len);
+      memcpy(checksum_vars.ref,checksum_vars.buf,len);
+      pkt.payload          = checksum_vars.buf;
+      pkt.length           = len;
+      memcpy(&refPkt,&pkt,sizeof(OpenQueueEntry_t));
+      refPkt.payload       = checksum_vars.ref;
+
+      // CRC
+      packetfunctions_calculateCRC(&pkt);
+      ref_calculateCRC(&refPkt);
+      if (
+         memcmp(checksum_vars.buf,checksum_vars.ref,len)!=0 ||
+         packetfunctions_checkCRC(&pkt)!=ref_checkCRC(&refPkt)
+      ) {
+         fail++;
+      }
+
+      // checksum, written in the first two bytes
+      packetfunctions_calculateChecksum(&pkt,&checksum_vars.buf[0]);
+      ref_calculateChecksum(&refPkt,&checksum_vars.ref[0]);
+      if (memcmp(checksum_vars.buf,checksum_vars.ref,len)!=0) {
+         fail++;
+      }
+
+      // incremental update after rewriting the third and fourth bytes
+      memcpy(oldValue,&checksum_vars.buf[2],2);
+      newValue[0]             = oldValue[0]+len;
+      newValue[1]             = oldValue[1]^0xa5;
+      memcpy(&checksum_vars.buf[2],newValue,2);
+      packetfunctions_updateChecksum(&checksum_vars.buf[0],oldValue,newValue,2);
+      memcpy(&checksum_vars.ref[2],newValue,2);
+      ref_calculateChecksum(&refPkt,&checksum_vars.ref[0]);
+      if (memcmp(checksum_vars.buf,checksum_vars.ref,len)!=0) {
+         fail++;
+      }
+   }
+
+   //=== benchmark, on full-size frames
+
+   len                       = TEST_VECTOR_MAXLEN;
+   fill(checksum_vars.buf,len,0);
+   pkt.payload               = checksum_vars.buf;
+   pkt.length                = len;
+   memcpy(&refPkt,&pkt,sizeof(OpenQueueEntry_t));
+
+   time1 = sctimer_readCounter();
+   for (i=0;i<BENCHMARK_ROUNDS;i++) {
+      ref_calculateCRC(&refPkt);
+   }
+   checksum_vars.crcRef      = sctimer_readCounter()-time1;
+
+   time1 = sctimer_readCounter();
+   for (i=0;i<BENCHMARK_ROUNDS;i++) {
+      packetfunctions_calculateCRC(&pkt);
+   }
+   checksum_vars.crc         = sctimer_readCounter()-time1;
+
+   time1 = sctimer_readCounter();
+   for (i=0;i<BENCHMARK_ROUNDS;i++) {
+      ref_calculateChecksum(&refPkt,&checksum_vars.buf[0]);
+   }
+   checksum_vars.checksumRef = sctimer_readCounter()-time1;
+
+   time1 = sctimer_readCounter();
+   for (i=0;i<BENCHMARK_ROUNDS;i++) {
+      packetfunctions_calculateChecksum(&pkt,&checksum_vars.buf[0]);
+   }
+   checksum_vars.checksum    = sctimer_readCounter()-time1;
+
+   return hang(fail);
+}
+
+//=========================== private =========================================
+
+static int hang(uint8_t error_code) {
+
+   error_code ? leds_error_on() : leds_radio_on();
+
+   while (1);
+
+   return 0;
+}
+
+static void fill(uint8_t* buf, uint8_t len, uint8_t seed) {
+   uint8_t i;
+
+   for (i=0;i<len;i++) {
+      seed   = seed*13+7;
+      buf[i] = seed;
+   }
+}
+
+//=== reference implementations
+
+static void ref_calculateCRC(OpenQueueEntry_t* msg) {
+   uint16_t crc;
+   uint8_t  i;
+   uint8_t  count;
+
+   crc = 0;
+   for (count=1;count<msg->length-2;count++) {
+      crc = crc ^ (uint8_t)*(msg->payload+count);
+      for (i=0;i<8;i++) {
+         if (crc & 0x1) {
+            crc = crc>>1 ^ 0x8408;
+         } else {
+            crc = crc>>1;
+         }
+      }
+   }
+   *(msg->payload+(msg->length-2)) = crc%256;
+   *(msg->payload+(msg->length-1)) = crc/256;
+}
+
+static bool ref_checkCRC(OpenQueueEntry_t* msg) {
+   uint16_t crc;
+   uint8_t  i;
+   uint8_t  count;
+
+   crc = 0;
+   for (count=0;count<msg->length-2;count++) {
+      crc = crc ^ (uint8_t)*(msg->payload+count);
+      for (i=0;i<8;i++) {
+         if (crc & 0x1) {
+            crc = crc>>1 ^ 0x8408;
+         } else {
+            crc = crc>>1;
+         }
+      }
+   }
+   return *(msg->payload+(msg->length-2))==crc%256 &&
+          *(msg->payload+(msg->length-1))==crc/256;
+}
+
+static void ref_calculateChecksum(OpenQueueEntry_t* msg, uint8_t* checksum_ptr) {
+   uint8_t temp_checksum[2];
+   uint8_t little_helper[2];
+
+   temp_checksum[0] = 0;
+   temp_checksum[1] = 0;
+
+   // IPv6 pseudo header, unicast destination
+   ref_onesComplementSum(temp_checksum,(idmanager_getMyID(ADDR_PREFIX))->prefix,8);
+   ref_onesComplementSum(temp_checksum,(idmanager_getMyID(ADDR_64B))->addr_64b,8);
+   ref_onesComplementSum(temp_checksum,msg->l3_destinationAdd.addr_128b,16);
+   little_helper[0] = (msg->length & 0xFF00)>>8;
+   little_helper[1] = (msg->length & 0x00FF);
+   ref_onesComplementSum(temp_checksum,little_helper,2);
+   little_helper[0] = 0;
+   little_helper[1] = msg->l4_protocol;
+   ref_onesComplementSum(temp_checksum,little_helper,2);
+
+   // payload
+   *checksum_ptr     = 0;
+   *(checksum_ptr+1) = 0;
+   ref_onesComplementSum(temp_checksum,msg->payload,msg->length);
+   *checksum_ptr     = temp_checksum[0]^0xFF;
+   *(checksum_ptr+1) = temp_checksum[1]^0xFF;
+}
+
+static void ref_onesComplementSum(uint8_t* global_sum, uint8_t* ptr, int length) {
+   uint32_t sum = 0xFFFF & (global_sum[0]<<8 | global_sum[1]);
+
+   while (length>1) {
+      sum    += 0xFFFF & (*ptr<<8 | *(ptr+1));
+      ptr    += 2;
+      length -= 2;
+   }
+   if (length) {
+      sum    += (0xFF & *ptr)<<8;
+   }
+   while (sum>>16) {
+      sum = (sum & 0xFFFF)+(sum>>16);
+   }
+   global_sum[0] = (sum>>8) & 0xFF;
+   global_sum[1] = sum & 0xFF;
+}
@@ -216,6 +216,7 @@ void icmpv6echo_setIsReplyEnabled(bool isEnabled)                           {ret
 bool debugPrint_asn(void)       {return TRUE;}
 bool debugPrint_isSync(void)    {return TRUE;}
 bool debugPrint_macStats(void)  {return TRUE;}
+bool debugPrint_macProfile(void){return TRUE;}
 bool debugPrint_schedule(void)  {return TRUE;}
 bool debugPrint_backoff(void)   {return TRUE;}
 bool debugPrint_queue(void)     {return TRUE;}